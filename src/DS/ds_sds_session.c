@@ -51,6 +51,8 @@ struct ds_sds_session {
 	const char *datastream_id;              ///< ID of selected datastream
 	const char *checklist_id;               ///< ID of selected checklist
 	struct oscap_htable *component_sources;	///< oscap_source for parsed components
+	xmlDoc *datastream_doc;                 ///< Selected datastream extracted without the DOM of the source
+	char *datastream_doc_id;                ///< ID the datastream_doc was selected by
 	bool fetch_remote_resources;            ///< Allows loading of external components;
 	download_progress_calllback_t progress;	///< Callback to report progress of download.
 };
@@ -76,10 +78,19 @@ struct ds_sds_session *ds_sds_session_new_from_source(struct oscap_source *sourc
 	return sds_session;
 }
 
+static void ds_sds_session_free_datastream_doc(struct ds_sds_session *session)
+{
+	xmlFreeDoc(session->datastream_doc);
+	session->datastream_doc = NULL;
+	free(session->datastream_doc_id);
+	session->datastream_doc_id = NULL;
+}
+
 void ds_sds_session_free(struct ds_sds_session *sds_session)
 {
 	if (sds_session != NULL) {
 		ds_sds_index_free(sds_session->index);
+		ds_sds_session_free_datastream_doc(sds_session);
 		if (sds_session->temp_dir != NULL) {
 			oscap_acquire_cleanup_dir(&(sds_session->temp_dir));
 		}
@@ -93,6 +104,7 @@ void ds_sds_session_reset(struct ds_sds_session *session)
 	session->checklist_id = NULL;
 	session->datastream_id = NULL;
 	session->target_dir = NULL;
+	ds_sds_session_free_datastream_doc(session);
 	oscap_htable_free(session->component_sources, (oscap_destruct_func) oscap_source_free);
 	session->component_sources = oscap_htable_new();
 }
@@ -100,7 +112,9 @@ void ds_sds_session_reset(struct ds_sds_session *session)
 struct ds_sds_index *ds_sds_session_get_sds_idx(struct ds_sds_session *session)
 {
 	if (session->index == NULL) {
-		xmlTextReader *reader = oscap_source_get_xmlTextReader(session->source);
+		xmlTextReader *reader = oscap_source_get_streaming_xmlTextReader(session->source);
+		if (reader == NULL)
+			reader = oscap_source_get_xmlTextReader(session->source);
 		if (reader == NULL) {
 			return NULL;
 		}
@@ -230,10 +244,38 @@ struct oscap_source *ds_sds_session_select_tailoring(struct ds_sds_session *sess
 	return tailoring;
 }
 
+static xmlNode *ds_sds_session_stream_datastream(struct ds_sds_session *session, bool *streamed)
+{
+	xmlTextReader *reader;
+	xmlNode *node;
+
+	*streamed = true;
+	if (session->datastream_doc != NULL && oscap_streq(session->datastream_doc_id, session->datastream_id))
+		return xmlDocGetRootElement(session->datastream_doc);
+
+	if (ds_sds_stream_lookup(session->source, "data-stream", NULL, session->datastream_id, &reader, &node) != 0) {
+		*streamed = false;
+		return NULL;
+	}
+
+	ds_sds_session_free_datastream_doc(session);
+	if (node != NULL) {
+		session->datastream_doc = ds_doc_from_foreign_node(node, node->doc);
+		session->datastream_doc_id = oscap_strdup(session->datastream_id);
+	}
+	xmlFreeTextReader(reader);
+
+	return session->datastream_doc != NULL ? xmlDocGetRootElement(session->datastream_doc) : NULL;
+}
+
 xmlNode *ds_sds_session_get_selected_datastream(struct ds_sds_session *session)
 {
-	xmlDoc *doc = oscap_source_get_xmlDoc(session->source);
-	xmlNode *datastream = ds_sds_lookup_datastream_in_collection(doc, session->datastream_id);
+	bool streamed;
+	xmlNode *datastream = ds_sds_session_stream_datastream(session, &streamed);
+	if (!streamed) {
+		xmlDoc *doc = oscap_source_get_xmlDoc(session->source);
+		datastream = ds_sds_lookup_datastream_in_collection(doc, session->datastream_id);
+	}
 	if (datastream == NULL) {
 		char *error = session->datastream_id ?
 			oscap_sprintf("Could not find any datastream of id '%s'", session->datastream_id) :
@@ -249,6 +291,11 @@ xmlDoc *ds_sds_session_get_xmlDoc(struct ds_sds_session *session)
 	return oscap_source_get_xmlDoc(session->source);
 }
 
+int ds_sds_session_stream_component(struct ds_sds_session *session, const char *component_id, xmlTextReader **reader, xmlNode **component)
+{
+	return ds_sds_stream_lookup(session->source, "component", "extended-component", component_id, reader, component);
+}
+
 int ds_sds_session_register_component_source(struct ds_sds_session *session, const char *relative_filepath, struct oscap_source *component)
 {
 	if (!oscap_htable_add(session->component_sources, relative_filepath, component)) {
@@ -32,6 +32,7 @@
 #include "common/util.h"
 #include "common/list.h"
 #include "common/debug_priv.h"
+#include "common/elements.h"
 
 #include "ds_common.h"
 #include "ds_rds_session.h"
@@ -663,7 +664,7 @@ static void ds_rds_add_xccdf_test_results(xmlDocPtr doc, xmlNodePtr reports,
 	}
 }
 
-static int ds_rds_create_from_dom(xmlDocPtr* ret, xmlDocPtr sds_doc, xmlDocPtr tailoring_doc, const char* tailoring_filepath, char *tailoring_doc_timestamp, xmlDocPtr xccdf_result_file_doc, struct oscap_htable* oval_result_sources, struct oscap_htable* oval_result_mapping, struct oscap_htable *arf_report_mapping)
+static int ds_rds_create_from_dom(xmlDocPtr* ret, xmlDocPtr sds_doc, xmlDocPtr tailoring_doc, const char* tailoring_filepath, char *tailoring_doc_timestamp, xmlDocPtr xccdf_result_file_doc, struct oscap_htable* oval_result_sources, struct oscap_htable* oval_result_mapping, struct oscap_htable *arf_report_mapping, struct oscap_xml_stream *stream)
 {
 	*ret = NULL;
 
@@ -771,6 +772,15 @@ static int ds_rds_create_from_dom(xmlDocPtr* ret, xmlDocPtr sds_doc, xmlDocPtr t
 	ds_rds_add_xccdf_test_results(doc, reports, xccdf_result_file_doc,
 			relationships, assets, "collection1", arf_report_mapping);
 
+	/* Relationships and assets are complete once the XCCDF results are
+	 * added, so everything up to the reports can be written out now. */
+	oscap_xml_stream_start_element(stream, root);
+	oscap_xml_stream_flush(stream, root);
+
+	xmlAddChild(root, reports);
+	oscap_xml_stream_start_element(stream, reports);
+	oscap_xml_stream_flush(stream, reports);
+
 	struct oscap_htable_iterator *hit = oscap_htable_iterator_new(arf_report_mapping);
 	while (oscap_htable_iterator_has_more(hit)) {
 		const struct oscap_htable_item *report_mapping_item = oscap_htable_iterator_next(hit);
@@ -781,25 +791,29 @@ static int ds_rds_create_from_dom(xmlDocPtr* ret, xmlDocPtr sds_doc, xmlDocPtr t
 		xmlDoc *oval_result_doc = oscap_source_get_xmlDoc(oval_source);
 
 		ds_rds_create_report(doc, reports, oval_result_doc, report_id);
+		oscap_xml_stream_flush(stream, reports);
 	}
 	oscap_htable_iterator_free(hit);
 
-	xmlAddChild(root, reports);
+	oscap_xml_stream_end_element(stream, reports);
+	oscap_xml_stream_end_element(stream, root);
 
 	*ret = doc;
 	return 0;
 }
 
-struct oscap_source *ds_rds_create_source(struct oscap_source *sds_source, struct oscap_source *tailoring_source, struct oscap_source *xccdf_result_source, struct oscap_htable *oval_result_sources, struct oscap_htable *oval_result_mapping, struct oscap_htable *arf_report_mapping, const char *target_file)
+static int ds_rds_create_from_sources(xmlDocPtr *ret, struct oscap_source *sds_source, struct oscap_source *tailoring_source, struct oscap_source *xccdf_result_source, struct oscap_htable *oval_result_sources, struct oscap_htable *oval_result_mapping, struct oscap_htable *arf_report_mapping, struct oscap_xml_stream *stream)
 {
+	*ret = NULL;
+
 	xmlDoc *sds_doc = oscap_source_get_xmlDoc(sds_source);
 	if (sds_doc == NULL) {
-		return NULL;
+		return -1;
 	}
 
 	xmlDoc *result_file_doc = oscap_source_get_xmlDoc(xccdf_result_source);
 	if (result_file_doc == NULL) {
-		return NULL;
+		return -1;
 	}
 
 	xmlDoc *tailoring_doc = NULL;
@@ -808,7 +822,7 @@ struct oscap_source *ds_rds_create_source(struct oscap_source *sds_source, struc
 	if (tailoring_source) {
 		tailoring_doc = oscap_source_get_xmlDoc(tailoring_source);
 		if (tailoring_doc == NULL) {
-			return NULL;
+			return -1;
 		}
 		tailoring_filepath = oscap_source_get_filepath(tailoring_source);
 		struct stat file_stat;
@@ -819,17 +833,42 @@ struct oscap_source *ds_rds_create_source(struct oscap_source *sds_source, struc
 		}
 	}
 
+	int result = ds_rds_create_from_dom(ret, sds_doc, tailoring_doc, tailoring_filepath, tailoring_doc_timestamp, result_file_doc,
+			oval_result_sources, oval_result_mapping, arf_report_mapping, stream);
+	free(tailoring_doc_timestamp);
+	return result;
+}
+
+struct oscap_source *ds_rds_create_source(struct oscap_source *sds_source, struct oscap_source *tailoring_source, struct oscap_source *xccdf_result_source, struct oscap_htable *oval_result_sources, struct oscap_htable *oval_result_mapping, struct oscap_htable *arf_report_mapping, const char *target_file)
+{
 	xmlDocPtr rds_doc = NULL;
 
-	if (ds_rds_create_from_dom(&rds_doc, sds_doc, tailoring_doc, tailoring_filepath, tailoring_doc_timestamp, result_file_doc,
-				oval_result_sources, oval_result_mapping, arf_report_mapping) != 0) {
-		free(tailoring_doc_timestamp);
+	if (ds_rds_create_from_sources(&rds_doc, sds_source, tailoring_source, xccdf_result_source,
+				oval_result_sources, oval_result_mapping, arf_report_mapping, NULL) != 0) {
 		return NULL;
 	}
-	free(tailoring_doc_timestamp);
 	return oscap_source_new_from_xmlDoc(rds_doc, target_file);
 }
 
+int ds_rds_export(struct oscap_source *sds_source, struct oscap_source *tailoring_source, struct oscap_source *xccdf_result_source, struct oscap_htable *oval_result_sources, struct oscap_htable *oval_result_mapping, struct oscap_htable *arf_report_mapping, const char *target_file)
+{
+	/* The data stream and the reports are written out as soon as they are
+	 * copied in, the whole ARF is never kept in memory. */
+	struct oscap_xml_stream *stream = oscap_xml_stream_new(target_file);
+	if (stream == NULL) {
+		return -1;
+	}
+
+	xmlDocPtr rds_doc = NULL;
+	int result = ds_rds_create_from_sources(&rds_doc, sds_source, tailoring_source, xccdf_result_source,
+			oval_result_sources, oval_result_mapping, arf_report_mapping, stream);
+	xmlFreeDoc(rds_doc);
+	if (oscap_xml_stream_free(stream) != 1) {
+		result = -1;
+	}
+	return result;
+}
+
 int ds_rds_create(const char* sds_file, const char* xccdf_result_file, const char** oval_result_files, const char* target_file)
 {
 	struct oscap_source *sds_source = oscap_source_new_from_file(sds_file);
@@ -856,12 +895,7 @@ int ds_rds_create(const char* sds_file, const char* xccdf_result_file, const cha
 		}
 	}
 	if (result == 0) {
-		struct oscap_source *target_rds = ds_rds_create_source(sds_source, NULL, xccdf_result_source, oval_result_sources, oval_result_mapping, arf_report_mapping, target_file);
-		result = target_rds == NULL;
-		if (result == 0) {
-			result = oscap_source_save_as(target_rds, NULL);
-		}
-		oscap_source_free(target_rds);
+		result = ds_rds_export(sds_source, NULL, xccdf_result_source, oval_result_sources, oval_result_mapping, arf_report_mapping, target_file);
 	}
 	oscap_htable_free(oval_result_sources, (oscap_destruct_func) oscap_source_free);
 	oscap_htable_free(oval_result_mapping, (oscap_destruct_func) free);
@@ -291,6 +291,22 @@ static xmlNodePtr ds_sds_get_component_root_by_id(xmlDoc *doc, const char* compo
 
 static int ds_sds_dump_local_component(const char* component_id, struct ds_sds_session *session, const char *target_filename_dirname, const char *relative_filepath)
 {
+	xmlTextReader *reader;
+	xmlNode *component;
+
+	if (ds_sds_session_stream_component(session, component_id, &reader, &component) == 0) {
+		// only the component is built, it's released with the reader
+		int ret = -1;
+		if (component == NULL) {
+			oscap_seterr(OSCAP_EFAMILY_XML, "Component of given id '%s' was not found in the document.", component_id);
+		} else {
+			ret = ds_sds_register_component(session, component->doc, node_get_child_element(component, NULL),
+					component_id, target_filename_dirname, relative_filepath);
+		}
+		xmlFreeTextReader(reader);
+		return ret;
+	}
+
 	xmlDoc *doc = ds_sds_session_get_xmlDoc(session);
 
 	xmlNodePtr inner_root = ds_sds_get_component_root_by_id(doc, component_id);
@@ -572,6 +588,43 @@ xmlNodePtr ds_sds_lookup_datastream_in_collection(xmlDocPtr doc, const char *dat
 	return datastream;
 }
 
+int ds_sds_stream_lookup(struct oscap_source *source, const char *name, const char *alt_name, const char *id, xmlTextReader **reader, xmlNode **node)
+{
+	*node = NULL;
+	*reader = oscap_source_get_streaming_xmlTextReader(source);
+	if (*reader == NULL)
+		return -1;
+
+	// skip to the data-stream-collection element
+	int ret;
+	while ((ret = xmlTextReaderRead(*reader)) == 1 && xmlTextReaderNodeType(*reader) != XML_READER_TYPE_ELEMENT)
+		;
+	if (ret != 1 || xmlTextReaderIsEmptyElement(*reader))
+		return 0;
+
+	// walk its children, the skipped subtrees are never fully built
+	ret = xmlTextReaderRead(*reader);
+	while (ret == 1 && xmlTextReaderDepth(*reader) == 1) {
+		if (xmlTextReaderNodeType(*reader) == XML_READER_TYPE_ELEMENT) {
+			const char *local_name = (const char *) xmlTextReaderConstLocalName(*reader);
+
+			if (oscap_streq(local_name, name) || (alt_name != NULL && oscap_streq(local_name, alt_name))) {
+				char *candidate_id = (char *) xmlTextReaderGetAttribute(*reader, BAD_CAST "id");
+				bool match = id == NULL || oscap_streq(id, candidate_id);
+				xmlFree(candidate_id);
+
+				if (match) {
+					*node = xmlTextReaderExpand(*reader);
+					return 0;
+				}
+			}
+		}
+		ret = xmlTextReaderNext(*reader);
+	}
+
+	return 0;
+}
+
 static inline int ds_sds_compose_component_add_script_content(xmlNode *component, const char *filepath)
 {
 	FILE* f = fopen(filepath, "r");
@@ -52,4 +52,17 @@ char *ds_sds_mangle_filepath(const char *filepath);
 
 char *ds_sds_detect_version(xmlTextReader *reader);
 
+/**
+ * Find a child element of the data-stream-collection without building the
+ * DOM of the whole collection.
+ * @param source the source DataStream
+ * @param name local name of the element
+ * @param alt_name alternative local name of the element or NULL
+ * @param id ID of the element or NULL for the first element of that name
+ * @param reader the reader positioned at the element, to be freed by caller
+ * @param node the expanded element (valid until the reader is freed) or NULL if not found
+ * @returns 0 on success, -1 if the source can't be streamed
+ */
+int ds_sds_stream_lookup(struct oscap_source *source, const char *name, const char *alt_name, const char *id, xmlTextReader **reader, xmlNode **node);
+
 #endif
@@ -32,6 +32,7 @@
 #endif
 
 #include <stdlib.h>
+#include <string.h>
 #include <stdio.h>
 
 #include "oval_adt.h"
@@ -42,30 +43,57 @@
 /* Variable definitions
  * */
 
-typedef struct _oval_collection_item_frame {
-	struct _oval_collection_item_frame *next;
-	void *item;
-} _oval_collection_item_frame_t;
+/*
+ * Both collections and iterators keep their items in a contiguous array.
+ * An iterator is a snapshot of the collection, it stores the items in the
+ * reverse order and hands them out from the end of the array.
+ */
+
+#define OVAL_COLLECTION_INITSIZE 4
 
 typedef struct oval_collection {
-	struct _oval_collection_item_frame *item_collection_frame;
+	void **items;
+	int count;
+	int capacity;
 } oval_collection_t;
 
 typedef struct oval_iterator {
-	struct _oval_collection_item_frame *item_iterator_frame;
+	void **items;
+	int count;
+	int capacity;
 } oval_iterator_t;
 
 /* End of variable definitions
  * */
 /***************************************************************************/
 
+static bool _oval_items_reserve(void ***items, int *capacity, int count)
+{
+	if (count <= *capacity)
+		return true;
+
+	int new_capacity = *capacity ? *capacity : OVAL_COLLECTION_INITSIZE;
+	while (new_capacity < count)
+		new_capacity *= 2;
+
+	void **new_items = realloc(*items, new_capacity * sizeof(void *));
+	if (new_items == NULL)
+		return false;
+
+	*items = new_items;
+	*capacity = new_capacity;
+	return true;
+}
+
 struct oval_collection *oval_collection_new()
 {
 	struct oval_collection *collection = (struct oval_collection *)malloc(sizeof(oval_collection_t));
 	if (collection == NULL)
 		return NULL;
 
-	collection->item_collection_frame = NULL;
+	collection->items = NULL;
+	collection->count = 0;
+	collection->capacity = 0;
 	return collection;
 }
 
@@ -77,19 +105,14 @@ void oval_collection_free(struct oval_collection *collection)
 void oval_collection_free_items(struct oval_collection *collection, oscap_destruct_func free_func)
 {
 	if (collection) {
-		struct _oval_collection_item_frame *frame = collection->item_collection_frame;
-		while (frame != NULL) {
-			if (free_func != NULL) {
-				void *item = frame->item;
+		if (free_func != NULL) {
+			for (int i = 0; i < collection->count; i++) {
+				void *item = collection->items[i];
 				if (item)
 					(*free_func) (item);
-				frame->item = NULL;
 			}
-			struct _oval_collection_item_frame *temp = frame;
-			frame = frame->next;
-			temp->next = NULL;
-			free(temp);
 		}
+		free(collection->items);
 		free(collection);
 	}
 }
@@ -97,42 +120,66 @@ void oval_collection_free_items(struct oval_collection *collection, oscap_destru
 int oval_collection_is_empty(struct oval_collection *collection)
 {
 	__attribute__nonnull__(collection);
-	return collection->item_collection_frame == NULL;
+	return collection->count == 0;
 }
 
 void oval_collection_add(struct oval_collection *collection, void *item)
 {
 	__attribute__nonnull__(collection);
 
-	struct _oval_collection_item_frame *next = malloc(sizeof(_oval_collection_item_frame_t));
-	if (next == NULL)
+	if (!_oval_items_reserve(&collection->items, &collection->capacity, collection->count + 1))
 		return;
 
-	next->next = collection->item_collection_frame;
-	collection->item_collection_frame = next;
-	next->item = item;
+	collection->items[collection->count++] = item;
+}
+
+bool oval_collection_contains(struct oval_collection *collection, void *item)
+{
+	__attribute__nonnull__(collection);
+
+	for (int i = 0; i < collection->count; i++) {
+		if (collection->items[i] == item)
+			return true;
+	}
+	return false;
+}
+
+bool oval_collection_remove(struct oval_collection *collection, void *item)
+{
+	__attribute__nonnull__(collection);
+
+	for (int i = 0; i < collection->count; i++) {
+		if (collection->items[i] == item) {
+			memmove(collection->items + i, collection->items + i + 1,
+				(collection->count - i - 1) * sizeof(void *));
+			collection->count--;
+			return true;
+		}
+	}
+	return false;
+}
+
+void *oval_collection_last(struct oval_collection *collection)
+{
+	__attribute__nonnull__(collection);
+
+	return collection->count ? collection->items[collection->count - 1] : NULL;
 }
 
 struct oval_iterator *oval_collection_iterator(struct oval_collection *collection)
 {
 	__attribute__nonnull__(collection);
 
-	struct oval_iterator *iterator = (struct oval_iterator *)malloc(sizeof(oval_iterator_t));
+	struct oval_iterator *iterator = oval_collection_iterator_new();
 	if (iterator == NULL)
 		return NULL;
 
-	iterator->item_iterator_frame = NULL;
-	struct _oval_collection_item_frame *collection_frame = collection->item_collection_frame;
-
-	while (collection_frame != NULL) {
-		struct _oval_collection_item_frame *iterator_frame =
-		    (struct _oval_collection_item_frame *)malloc(sizeof(_oval_collection_item_frame_t));
+	if (!_oval_items_reserve(&iterator->items, &iterator->capacity, collection->count))
+		return iterator;
 
-		iterator_frame->next = iterator->item_iterator_frame;
-		iterator_frame->item = collection_frame->item;
-		iterator->item_iterator_frame = iterator_frame;
-		collection_frame = collection_frame->next;
-	}
+	for (int i = 0; i < collection->count; i++)
+		iterator->items[i] = collection->items[collection->count - 1 - i];
+	iterator->count = collection->count;
 	return iterator;
 }
 
@@ -140,53 +187,30 @@ bool oval_collection_iterator_has_more(struct oval_iterator * iterator)
 {
 	__attribute__nonnull__(iterator);
 
-	return iterator->item_iterator_frame != NULL;
+	return iterator->count > 0;
 }
 
 int oval_collection_iterator_remaining(struct oval_iterator *iterator)
 {
 	__attribute__nonnull__(iterator);
 
-	int remaining;
-	struct _oval_collection_item_frame *next = iterator->item_iterator_frame;
-
-	for (remaining = 0; next; remaining++)
-		next = next->next;
-
-	return remaining;
+	return iterator->count;
 }
 
 void *oval_collection_iterator_next(struct oval_iterator *iterator)
 {
 	__attribute__nonnull__(iterator);
 
-	struct _oval_collection_item_frame *oc_next = iterator->item_iterator_frame;
-	void *next;
-
-	if (oc_next == NULL) {
-		next = NULL;
-	} else {
-		next = oc_next->item;
-		iterator->item_iterator_frame = oc_next->next;
-		oc_next->item = NULL;
-		oc_next->next = NULL;
-		free(oc_next);
-	}
-	return next;
+	if (iterator->count == 0)
+		return NULL;
+
+	return iterator->items[--iterator->count];
 }
 
 void oval_collection_iterator_free(struct oval_iterator *iterator)
 {
 	if (iterator) {		//NOOP if iterator is NULL
-		while (iterator->item_iterator_frame) {
-			struct _oval_collection_item_frame *oc_this;
-			oc_this = iterator->item_iterator_frame;
-			iterator->item_iterator_frame = oc_this->next;
-			oc_this->item = NULL;
-			oc_this->next = NULL;
-			free(oc_this);
-		}
-		iterator->item_iterator_frame = NULL;
+		free(iterator->items);
 		free(iterator);
 	}
 }
@@ -197,7 +221,9 @@ struct oval_iterator *oval_collection_iterator_new()
 	if (iterator == NULL)
 		return NULL;
 
-	iterator->item_iterator_frame = NULL;
+	iterator->items = NULL;
+	iterator->count = 0;
+	iterator->capacity = 0;
 	return iterator;
 }
 
@@ -205,14 +231,11 @@ void oval_collection_iterator_add(struct oval_iterator *iterator, void *item)
 {
 	__attribute__nonnull__(iterator);
 
-	struct _oval_collection_item_frame *newframe =
-	    (struct _oval_collection_item_frame *)malloc(sizeof(_oval_collection_item_frame_t));
-	if (newframe == NULL)	/* We don't have any information that error occured ! */
+	/* We don't have any information that error occured ! */
+	if (!_oval_items_reserve(&iterator->items, &iterator->capacity, iterator->count + 1))
 		return;
 
-	newframe->next = iterator->item_iterator_frame;
-	newframe->item = item;
-	iterator->item_iterator_frame = newframe;
+	iterator->items[iterator->count++] = item;
 }
 
 bool oval_string_iterator_has_more(struct oval_string_iterator * iterator)
@@ -40,6 +40,9 @@ void oval_collection_free(struct oval_collection *);
 void oval_collection_free_items(struct oval_collection *, oscap_destruct_func);
 int oval_collection_is_empty(struct oval_collection *collection);
 void oval_collection_add(struct oval_collection *, void *);
+bool oval_collection_contains(struct oval_collection *, void *);
+bool oval_collection_remove(struct oval_collection *, void *);
+void *oval_collection_last(struct oval_collection *);
 struct oval_iterator *oval_collection_iterator(struct oval_collection *);
 struct oval_iterator *oval_collection_iterator_new(void);
 void oval_collection_iterator_add(struct oval_iterator *, void *);
@@ -38,6 +38,12 @@ void oval_smc_put_last(struct oval_smc *map, const char *key, void *item);
 
 void oval_smc_put_last_if_not_exists(struct oval_smc *map, const char *key, void *item);
 
+/**
+ * Remove the item from the list of the key, the item isn't freed.
+ * @return true if the item was found
+ */
+bool oval_smc_remove(struct oval_smc *map, const char *key, void *item);
+
 struct oval_iterator *oval_smc_get_all_it(struct oval_smc *map, const char *key);
 
 void *oval_smc_get_last(struct oval_smc *map, const char *key);
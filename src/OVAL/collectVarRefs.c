@@ -27,6 +27,7 @@
 #include "collectVarRefs_impl.h"
 #include "oval_definitions_impl.h"
 #include "adt/oval_string_map_impl.h"
+#include "adt/oval_collection_impl.h"
 
 static void _var_collect_var_refs(struct oval_variable *var, struct oval_string_map *vm);
 
@@ -189,3 +190,73 @@ void oval_obj_collect_var_refs(struct oval_object *obj, struct oval_string_map *
 	}
 	oval_object_content_iterator_free(cont_itr);
 }
+
+static void _comp_collect_obj_refs(struct oval_component *comp, struct oval_string_map *om)
+{
+	struct oval_object *obj;
+	struct oval_component_iterator *cmp_itr;
+
+	switch (oval_component_get_type(comp)) {
+	case OVAL_COMPONENT_OBJECTREF:
+		obj = oval_component_get_object(comp);
+		if (obj != NULL)
+			oval_string_map_put(om, oval_object_get_id(obj), obj);
+		break;
+	case OVAL_FUNCTION_ARITHMETIC:
+	case OVAL_FUNCTION_BEGIN:
+	case OVAL_FUNCTION_CONCAT:
+	case OVAL_FUNCTION_END:
+	case OVAL_FUNCTION_ESCAPE_REGEX:
+	case OVAL_FUNCTION_REGEX_CAPTURE:
+	case OVAL_FUNCTION_SPLIT:
+	case OVAL_FUNCTION_SUBSTRING:
+	case OVAL_FUNCTION_TIMEDIF:
+		cmp_itr = oval_component_get_function_components(comp);
+		while (oval_component_iterator_has_more(cmp_itr)) {
+			struct oval_component *cmp;
+
+			cmp = oval_component_iterator_next(cmp_itr);
+			_comp_collect_obj_refs(cmp, om);
+		}
+		oval_component_iterator_free(cmp_itr);
+		break;
+	default:
+		/* variables referenced by OVAL_COMPONENT_VARREF are in the map of variables */
+		break;
+	}
+}
+
+static void _vars_collect_obj_refs(struct oval_string_map *vm, struct oval_string_map *om)
+{
+	struct oval_iterator *var_itr;
+
+	var_itr = oval_string_map_values(vm);
+	while (oval_collection_iterator_has_more(var_itr)) {
+		struct oval_variable *var;
+
+		var = oval_collection_iterator_next(var_itr);
+		if (oval_variable_get_type(var) == OVAL_VARIABLE_LOCAL)
+			_comp_collect_obj_refs(oval_variable_get_component(var), om);
+	}
+	oval_collection_iterator_free(var_itr);
+}
+
+void oval_obj_collect_obj_refs(struct oval_object *obj, struct oval_string_map *om)
+{
+	struct oval_string_map *vm;
+
+	vm = oval_string_map_new();
+	oval_obj_collect_var_refs(obj, vm);
+	_vars_collect_obj_refs(vm, om);
+	oval_string_map_free(vm, NULL);
+}
+
+void oval_ste_collect_obj_refs(struct oval_state *ste, struct oval_string_map *om)
+{
+	struct oval_string_map *vm;
+
+	vm = oval_string_map_new();
+	oval_ste_collect_var_refs(ste, vm);
+	_vars_collect_obj_refs(vm, om);
+	oval_string_map_free(vm, NULL);
+}
@@ -34,5 +34,14 @@
 void oval_obj_collect_var_refs(struct oval_object *obj, struct oval_string_map *vm);
 void oval_ste_collect_var_refs(struct oval_state *ste, struct oval_string_map *vm);
 
+/* Collect the objects which have to be collected before the respective
+ * argument can be evaluated, i.e. the objects referenced by object_component
+ * of the variables it refers to, recursively. The objects of set objects
+ * are collected by the probes themselves and aren't included. They are
+ * stored as pairs of (object id, object pointer).
+ */
+void oval_obj_collect_obj_refs(struct oval_object *obj, struct oval_string_map *om);
+void oval_ste_collect_obj_refs(struct oval_state *ste, struct oval_string_map *om);
+
 
 #endif
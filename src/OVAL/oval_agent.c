@@ -32,8 +32,10 @@
 #include <config.h>
 #endif
 
+#include <errno.h>
 #include <string.h>
 #include <time.h>
+#include <pthread.h>
 
 #include "oval_agent_api.h"
 #include "oval_definitions_impl.h"
@@ -62,7 +64,18 @@ struct oval_agent_session {
 #if defined(OVAL_PROBES_ENABLED)
 	struct oval_results_model    * res_model;
 	oval_probe_session_t  * psess;
+
+	/* Concurrent evaluation of XCCDF rules, see oval_agent_eval_rule */
+	pthread_mutex_t eval_lock;		///< Protects the members below
+	pthread_cond_t eval_cond;		///< Signalled whenever the members below change
+	struct oval_agent_eval_request *eval_queue;	///< Definitions waiting for the collection of their objects
+	struct oval_agent_eval_request **eval_queue_tail;
+	unsigned int evaluating;		///< Number of definitions being evaluated
+	unsigned int exclusive_waiting;		///< Number of threads waiting for the exclusive access
+	bool collecting;			///< Objects of the queued definitions are being collected
+	bool exclusive;				///< A thread changes the variables of the session
 #endif
+	unsigned int jobs;			///< Number of worker threads evaluating the definitions
 };
 
 
@@ -135,6 +148,17 @@ oval_agent_session_t * oval_agent_new_session(struct oval_definition_model *mode
 #endif
 
 	ag_sess->product_name = NULL;
+	ag_sess->jobs = 0;
+#if defined(OVAL_PROBES_ENABLED)
+	pthread_mutex_init(&ag_sess->eval_lock, NULL);
+	pthread_cond_init(&ag_sess->eval_cond, NULL);
+	ag_sess->eval_queue = NULL;
+	ag_sess->eval_queue_tail = &ag_sess->eval_queue;
+	ag_sess->evaluating = 0;
+	ag_sess->exclusive_waiting = 0;
+	ag_sess->collecting = false;
+	ag_sess->exclusive = false;
+#endif
 
 	return ag_sess;
 }
@@ -158,6 +182,13 @@ void oval_agent_set_product_name(oval_agent_session_t *ag_sess, char * product_n
 #endif
 }
 
+void oval_agent_set_jobs(oval_agent_session_t *ag_sess, unsigned int jobs)
+{
+	__attribute__nonnull__(ag_sess);
+
+	ag_sess->jobs = jobs;
+}
+
 static struct oval_result_system *_oval_agent_get_first_result_system(oval_agent_session_t *ag_sess)
 {
 	struct oval_results_model *rmodel = oval_agent_get_results_model(ag_sess);
@@ -170,15 +201,33 @@ static struct oval_result_system *_oval_agent_get_first_result_system(oval_agent
 	return rsystem;
 }
 
-int oval_agent_eval_definition(oval_agent_session_t *ag_sess, const char *id)
-{
 #if defined(OVAL_PROBES_ENABLED)
-	int ret;
+static int _oval_agent_eval_definition(oval_agent_session_t *ag_sess, const char *id)
+{
 	struct oval_result_system *rsystem;
 
 	rsystem = _oval_agent_get_first_result_system(ag_sess);
 	/* eval */
-	ret = oval_result_system_eval_definition(rsystem, id);
+	return oval_result_system_eval_definition(rsystem, id);
+}
+#endif
+
+int oval_agent_eval_definition(oval_agent_session_t *ag_sess, const char *id)
+{
+#if defined(OVAL_PROBES_ENABLED)
+	int ret;
+	struct oval_probe_plan *plan;
+
+	/* collect all the objects of the definition first */
+	plan = oval_probe_plan_new(ag_sess->psess);
+	oval_probe_plan_definition(plan, oval_definition_model_get_definition(ag_sess->def_model, id));
+	oval_probe_plan_collect(plan);
+	oval_probe_plan_free(plan);
+
+	ret = _oval_agent_eval_definition(ag_sess, id);
+
+	/* collect the objects which weren't queried by the evaluation */
+	oval_probe_collect_pending(ag_sess->psess);
 	return ret;
 #else
 	/* TODO */
@@ -270,6 +319,175 @@ int oval_agent_abort_session(oval_agent_session_t *ag_sess)
 #endif
 }
 
+#if defined(OVAL_PROBES_ENABLED)
+/**
+ * Evaluation of a single definition scheduled for a worker thread.
+ */
+struct oval_agent_eval_job {
+	struct oval_result_definition *rdef;
+	char *error;				///< error raised in the worker thread
+	bool created;				///< rdef was created for this evaluation
+	bool done;
+};
+
+/**
+ * Scheduler of parallel definition evaluation. Workers pick the definitions
+ * in the document order while the main thread reports the finished ones in
+ * the same order, so the output of the callback is the same as in the
+ * serial evaluation.
+ */
+struct oval_agent_scheduler {
+	struct oval_agent_eval_job *jobs;
+	size_t count;
+	size_t next;				///< index of the next job to be picked by a worker
+	bool cancel;				///< set by the main thread to stop the workers
+	pthread_mutex_t lock;			///< protects next, cancel and done flags of the jobs
+	pthread_cond_t done_cond;		///< signalled whenever a job is finished
+};
+
+static void *_oval_agent_scheduler_worker(void *arg)
+{
+	struct oval_agent_scheduler *sched = (struct oval_agent_scheduler *) arg;
+
+#if defined(HAVE_PTHREAD_SETNAME_NP)
+# if defined(OS_APPLE)
+	pthread_setname_np("oval_worker");
+# else
+	pthread_setname_np(pthread_self(), "oval_worker");
+# endif
+#endif
+	for (;;) {
+		pthread_mutex_lock(&sched->lock);
+		if (sched->cancel || sched->next >= sched->count) {
+			pthread_mutex_unlock(&sched->lock);
+			break;
+		}
+		struct oval_agent_eval_job *job = &sched->jobs[sched->next++];
+		pthread_mutex_unlock(&sched->lock);
+
+		oval_result_definition_eval(job->rdef);
+		/* The error queue is thread local, hand the errors over to the main thread */
+		job->error = oscap_err_get_full_error();
+
+		pthread_mutex_lock(&sched->lock);
+		job->done = true;
+		pthread_cond_broadcast(&sched->done_cond);
+		pthread_mutex_unlock(&sched->lock);
+	}
+	return NULL;
+}
+
+/**
+ * Evaluate all the definitions of the session by the worker threads.
+ * The objects have to be collected already.
+ */
+static int _oval_agent_eval_system_parallel(oval_agent_session_t *ag_sess, agent_reporter cb, void *arg)
+{
+	struct oval_result_system *rsystem = _oval_agent_get_first_result_system(ag_sess);
+	struct oval_definition_iterator *oval_def_it;
+	struct oval_agent_scheduler sched = {
+		.count = 0,
+		.next = 0,
+		.cancel = false,
+	};
+	size_t capacity = 0;
+
+	/* Create the result definitions together with their criteria and
+	 * result tests up front, the workers then only evaluate them. */
+	oval_def_it = oval_definition_model_get_definitions(ag_sess->def_model);
+	while (oval_definition_iterator_has_more(oval_def_it)) {
+		const char *id = oval_definition_get_id(oval_definition_iterator_next(oval_def_it));
+		struct oval_result_definition *prev = oval_result_system_get_definition(rsystem, id);
+		struct oval_result_definition *rdef = oval_result_system_prepare_definition(rsystem, id);
+
+		if (rdef == NULL) {
+			oval_definition_iterator_free(oval_def_it);
+			free(sched.jobs);
+			return -1;
+		}
+		if (sched.count == capacity) {
+			size_t new_capacity = capacity ? capacity * 2 : 64;
+			struct oval_agent_eval_job *jobs = realloc(sched.jobs, new_capacity * sizeof(struct oval_agent_eval_job));
+			if (jobs == NULL) {
+				oscap_seterr(OSCAP_EFAMILY_GLIBC, "Failed to allocate memory for the OVAL evaluation.");
+				oval_definition_iterator_free(oval_def_it);
+				free(sched.jobs);
+				return -1;
+			}
+			sched.jobs = jobs;
+			capacity = new_capacity;
+		}
+		sched.jobs[sched.count++] = (struct oval_agent_eval_job) {
+			.rdef = rdef,
+			.created = rdef != prev,
+		};
+	}
+	oval_definition_iterator_free(oval_def_it);
+
+	pthread_mutex_init(&sched.lock, NULL);
+	pthread_cond_init(&sched.done_cond, NULL);
+
+	size_t workers = ag_sess->jobs < sched.count ? ag_sess->jobs : sched.count;
+	pthread_t *threads = malloc((workers + 1) * sizeof(pthread_t));
+	size_t started = 0;
+	while (threads != NULL && started < workers) {
+		int err = pthread_create(&threads[started], NULL, _oval_agent_scheduler_worker, &sched);
+		if (err != 0) {
+			dW("Failed to start the OVAL worker thread: %s", strerror(err));
+			break;
+		}
+		++started;
+	}
+	dI("Evaluating %zu definitions by %zu worker threads.", sched.count, started);
+	if (started == 0) {
+		/* Fall back to the evaluation in the main thread */
+		_oval_agent_scheduler_worker(&sched);
+	}
+
+	int ret = 0;
+	size_t reported = 0;
+	for (size_t i = 0; i < sched.count && ret == 0; ++i) {
+		struct oval_agent_eval_job *job = &sched.jobs[i];
+
+		pthread_mutex_lock(&sched.lock);
+		while (!job->done)
+			pthread_cond_wait(&sched.done_cond, &sched.lock);
+		pthread_mutex_unlock(&sched.lock);
+
+		if (job->error != NULL) {
+			oscap_seterr(OSCAP_EFAMILY_OVAL, "%s", job->error);
+			free(job->error);
+			job->error = NULL;
+		}
+		/* callback, stop if it says so */
+		if (cb != NULL)
+			ret = cb(job->rdef, arg);
+		++reported;
+	}
+
+	pthread_mutex_lock(&sched.lock);
+	sched.cancel = true;
+	pthread_mutex_unlock(&sched.lock);
+	for (size_t i = 0; i < started; ++i)
+		pthread_join(threads[i], NULL);
+	free(threads);
+
+	/* The serial evaluation wouldn't have got past the definition the
+	 * callback stopped at, don't leave the results of the rest behind. */
+	for (size_t i = reported; i < sched.count; ++i) {
+		if (sched.jobs[i].created)
+			oval_result_system_drop_definition(rsystem, sched.jobs[i].rdef);
+	}
+
+	for (size_t i = 0; i < sched.count; ++i)
+		free(sched.jobs[i].error);
+	free(sched.jobs);
+	pthread_cond_destroy(&sched.done_cond);
+	pthread_mutex_destroy(&sched.lock);
+	return ret;
+}
+#endif
+
 int oval_agent_eval_system(oval_agent_session_t * ag_sess, agent_reporter cb, void *arg) {
 	struct oval_definition *oval_def;
 	struct oval_definition_iterator *oval_def_it;
@@ -277,13 +495,37 @@ int oval_agent_eval_system(oval_agent_session_t * ag_sess, agent_reporter cb, vo
 	int ret = 0;
 
 	dI("OVAL agent started to evaluate OVAL definitions on your system.");
+#if defined(OVAL_PROBES_ENABLED)
+	/*
+	 * Collect the objects of all the definitions up front, the
+	 * evaluation then only works with the collected data.
+	 */
+	struct oval_probe_plan *plan = oval_probe_plan_new(ag_sess->psess);
+	oval_def_it = oval_definition_model_get_definitions(ag_sess->def_model);
+	while (oval_definition_iterator_has_more(oval_def_it))
+		oval_probe_plan_definition(plan, oval_definition_iterator_next(oval_def_it));
+	oval_definition_iterator_free(oval_def_it);
+	oval_probe_plan_collect(plan);
+	oval_probe_plan_free(plan);
+
+	if (ag_sess->jobs > 1) {
+		ret = _oval_agent_eval_system_parallel(ag_sess, cb, arg);
+		oval_probe_collect_pending(ag_sess->psess);
+		dI("OVAL agent finished evaluation.");
+		return ret;
+	}
+#endif
 	oval_def_it = oval_definition_model_get_definitions(ag_sess->def_model);
 	while (oval_definition_iterator_has_more(oval_def_it)) {
 		oval_def = oval_definition_iterator_next(oval_def_it);
 		id = oval_definition_get_id(oval_def);
 
 		/* probe and eval */
+#if defined(OVAL_PROBES_ENABLED)
+		ret = _oval_agent_eval_definition(ag_sess, id);
+#else
 		ret = oval_agent_eval_definition(ag_sess, id);
+#endif
 		if (ret==-1) {
 			goto cleanup;
 		}
@@ -306,6 +548,9 @@ int oval_agent_eval_system(oval_agent_session_t * ag_sess, agent_reporter cb, vo
 
 cleanup:
 	oval_definition_iterator_free(oval_def_it);
+#if defined(OVAL_PROBES_ENABLED)
+	oval_probe_collect_pending(ag_sess->psess);
+#endif
 	dI("OVAL agent finished evaluation.");
 	return ret;
 }
@@ -332,6 +577,8 @@ void oval_agent_destroy_session(oval_agent_session_t * ag_sess) {
 #if defined(OVAL_PROBES_ENABLED)
 		oval_probe_session_destroy(ag_sess->psess);
 		oval_results_model_free(ag_sess->res_model);
+		pthread_cond_destroy(&ag_sess->eval_cond);
+		pthread_mutex_destroy(&ag_sess->eval_lock);
 #endif
 	        free(ag_sess->filename);
 		free(ag_sess);
@@ -594,6 +841,176 @@ oval_agent_eval_multi_check(oval_agent_session_t *sess)
 	return final_result;
 }
 
+#if defined(OVAL_PROBES_ENABLED)
+/**
+ * Tell whether binding the values would change the variables of the session,
+ * i.e. whether oval_agent_resolve_variables has something to do.
+ */
+static bool _oval_agent_bindings_change_variables(struct oval_agent_session *session, struct xccdf_value_binding_iterator *it)
+{
+	const char *var_name = NULL;
+	struct oscap_stringlist *value_list = NULL;
+	bool change = false;
+
+	if (!xccdf_value_binding_iterator_has_more(it))
+		return false;
+	if (session->cur_var_model == NULL)
+		return true;
+
+	struct oscap_htable *dict = _binding_iterator_to_dict(it);
+	struct oscap_htable_iterator *hit = oscap_htable_iterator_new(dict);
+	struct oval_definition_model *def_model =
+			oval_results_model_get_definition_model(oval_agent_get_results_model(session));
+	while (!change && oscap_htable_iterator_has_more(hit)) {
+		oscap_htable_iterator_next_kv(hit, &var_name, (void*) &value_list);
+		struct oval_variable *variable = oval_definition_model_get_variable(def_model, var_name);
+		if (variable == NULL)
+			continue;
+		struct oval_value_iterator *value_it = oval_variable_get_values(variable);
+		/* Either the values are added or they conflict with the bound ones */
+		change = !oval_value_iterator_has_more(value_it) ||
+			_stringlist_conflicts_with_value_it(value_list, value_it);
+		oval_value_iterator_free(value_it);
+	}
+	oscap_htable_iterator_free(hit);
+	oscap_htable_free(dict, (oscap_destruct_func) oscap_stringlist_free);
+	return change;
+}
+
+/**
+ * Definition of a rule waiting for the collection of its objects.
+ */
+struct oval_agent_eval_request {
+	const char *id;
+	struct oval_result_definition *rdef;	///< set when the objects are collected
+	bool collected;
+	struct oval_agent_eval_request *next;
+};
+
+/**
+ * Get the exclusive access to the session: no objects are collected and no
+ * definitions are evaluated until _oval_agent_exclusive_end is called.
+ * Called with eval_lock held.
+ */
+static void _oval_agent_exclusive_begin(struct oval_agent_session *sess)
+{
+	sess->exclusive_waiting++;
+	while (sess->exclusive || sess->collecting || sess->evaluating > 0 || sess->eval_queue != NULL)
+		pthread_cond_wait(&sess->eval_cond, &sess->eval_lock);
+	sess->exclusive_waiting--;
+	sess->exclusive = true;
+}
+
+static void _oval_agent_exclusive_end(struct oval_agent_session *sess)
+{
+	sess->exclusive = false;
+	pthread_cond_broadcast(&sess->eval_cond);
+}
+
+/**
+ * Collect the objects of all the queued definitions in one probe plan and
+ * prepare their result definitions. The definitions queued meanwhile by the
+ * other threads are collected by the next batch. Called with eval_lock held,
+ * when no definition is being evaluated.
+ */
+static void _oval_agent_collect_queue(struct oval_agent_session *sess)
+{
+	struct oval_agent_eval_request *batch = sess->eval_queue;
+	struct oval_agent_eval_request *req, *next;
+	unsigned int count = 0;
+
+	sess->eval_queue = NULL;
+	sess->eval_queue_tail = &sess->eval_queue;
+	sess->collecting = true;
+	pthread_mutex_unlock(&sess->eval_lock);
+
+	struct oval_probe_plan *plan = oval_probe_plan_new(sess->psess);
+	for (req = batch; req != NULL; req = req->next)
+		oval_probe_plan_definition(plan, oval_definition_model_get_definition(sess->def_model, req->id));
+	oval_probe_plan_collect(plan);
+	oval_probe_plan_free(plan);
+	oval_probe_collect_pending(sess->psess);
+
+	struct oval_result_system *rsystem = _oval_agent_get_first_result_system(sess);
+	for (req = batch; req != NULL; req = req->next, ++count)
+		req->rdef = oval_result_system_prepare_definition(rsystem, req->id);
+
+	pthread_mutex_lock(&sess->eval_lock);
+	sess->collecting = false;
+	/* The requests belong to the waiting threads, they may be gone
+	 * as soon as the lock is released. */
+	for (req = batch; req != NULL; req = next) {
+		next = req->next;
+		req->collected = true;
+	}
+	sess->evaluating += count;
+	pthread_cond_broadcast(&sess->eval_cond);
+}
+
+/**
+ * Evaluate the rule when the XCCDF policy is evaluated by more than one job.
+ * The objects of the definitions of the rules checked concurrently are
+ * collected in batches, then the definitions are evaluated in parallel.
+ * Collection and evaluation never overlap, the evaluation only reads the
+ * system characteristics. Binding new values to the variables of the session
+ * and multi-check rules need the exclusive access to the session, they wait
+ * until the running evaluations finish.
+ */
+static xccdf_test_result_type_t _oval_agent_eval_rule_concurrent(struct oval_agent_session *sess, const char *id, struct xccdf_value_binding_iterator *it)
+{
+	xccdf_test_result_type_t xccdf_result = XCCDF_RESULT_UNKNOWN;
+
+	pthread_mutex_lock(&sess->eval_lock);
+	while (sess->exclusive || sess->exclusive_waiting > 0)
+		pthread_cond_wait(&sess->eval_cond, &sess->eval_lock);
+
+	if (id == NULL || _oval_agent_bindings_change_variables(sess, it)) {
+		_oval_agent_exclusive_begin(sess);
+		pthread_mutex_unlock(&sess->eval_lock);
+		int retval = oval_agent_resolve_variables(sess, it);
+		if (retval == 0 && id == NULL)
+			xccdf_result = oval_agent_eval_multi_check(sess);
+		pthread_mutex_lock(&sess->eval_lock);
+		_oval_agent_exclusive_end(sess);
+		if (retval != 0 || id == NULL) {
+			pthread_mutex_unlock(&sess->eval_lock);
+			return xccdf_result;
+		}
+	}
+
+	struct oval_definition *definition = oval_definition_model_get_definition(sess->def_model, id);
+	/* If there is no such OVAL definition, return XCCDF_RESUL_NOT_CHECKED. XDCCDF should look for alternative definition in this case. */
+	if (definition == NULL) {
+		pthread_mutex_unlock(&sess->eval_lock);
+		return XCCDF_RESULT_NOT_CHECKED;
+	}
+
+	/* Queue the definition, the variables can't change until it's collected */
+	struct oval_agent_eval_request req = { .id = id };
+	*sess->eval_queue_tail = &req;
+	sess->eval_queue_tail = &req.next;
+	while (!req.collected) {
+		if (!sess->collecting && !sess->exclusive && sess->evaluating == 0)
+			_oval_agent_collect_queue(sess);
+		else
+			pthread_cond_wait(&sess->eval_cond, &sess->eval_lock);
+	}
+	pthread_mutex_unlock(&sess->eval_lock);
+
+	if (req.rdef != NULL) {
+		oval_result_t result = oval_result_definition_eval(req.rdef);
+		xccdf_result = xccdf_get_result_from_oval(oval_definition_get_class(definition), result);
+	}
+
+	pthread_mutex_lock(&sess->eval_lock);
+	if (--sess->evaluating == 0)
+		pthread_cond_broadcast(&sess->eval_cond);
+	pthread_mutex_unlock(&sess->eval_lock);
+
+	return xccdf_result;
+}
+#endif
+
 xccdf_test_result_type_t oval_agent_eval_rule(struct xccdf_policy *policy, const char *rule_id, const char *id,
 			       const char * href, struct xccdf_value_binding_iterator *it,
 			       struct xccdf_check_import_iterator * check_import_it,
@@ -607,6 +1024,11 @@ xccdf_test_result_type_t oval_agent_eval_rule(struct xccdf_policy *policy, const
         if (strcmp(sess->filename, href))
             return XCCDF_RESULT_NOT_CHECKED;
 
+#if defined(OVAL_PROBES_ENABLED)
+	if (policy != NULL && xccdf_policy_get_jobs(policy) > 1)
+		return _oval_agent_eval_rule_concurrent(sess, id, it);
+#endif
+
         /* Resolve variables */
         retval = oval_agent_resolve_variables(sess, it);
         if (retval != 0) return XCCDF_RESULT_UNKNOWN;
@@ -663,7 +1085,7 @@ _oval_agent_list_definitions(void *usr, xccdf_policy_engine_query_t query_type,
 bool xccdf_policy_model_register_engine_oval(struct xccdf_policy_model * model, struct oval_agent_session * usr)
 {
 
-    return xccdf_policy_model_register_engine_and_query_callback(model, "http://oval.mitre.org/XMLSchema/oval-definitions-5",
+    return xccdf_policy_model_register_reentrant_engine_and_query_callback(model, "http://oval.mitre.org/XMLSchema/oval-definitions-5",
 		oval_agent_eval_rule, (void *) usr, _oval_agent_list_definitions);
 }
 
@@ -43,11 +43,14 @@
 #include "common/util.h"
 #include "common/bfind.h"
 #include "common/debug_priv.h"
+#include "common/profiler_priv.h"
 
 #include "_oval_probe_session.h"
 #include "_oval_probe_handler.h"
 #include "oval_probe_ext.h"
 #include "collectVarRefs_impl.h"
+#include "adt/oval_collection_impl.h"
+#include "probe-table.h"
 
 #ifdef OS_WINDOWS
 #define X_OK 0
@@ -103,7 +106,9 @@ int oval_probe_query_object(oval_probe_session_t *psess, struct oval_object *obj
         oval_ph_t *ph;
 	struct oval_string_map *vm;
 	struct oval_syschar_model *model;
+	bool pending;
 	int ret;
+	oscap_prof_timer_t timer;
 
 	oid = oval_object_get_id(object);
 	model = psess->sys_model;
@@ -113,7 +118,10 @@ int oval_probe_query_object(oval_probe_session_t *psess, struct oval_object *obj
 	dI("Querying %s object '%s', flags: %u.", type_name, oid, flags);
 
 	sysc = oval_syschar_model_get_syschar(model, oid);
-	if (sysc != NULL) {
+	pending = sysc != NULL && oval_probe_ext_pending(psess->pext, sysc);
+	if (pending) {
+		dI("Collecting %s_object '%s' submitted in advance.", type_name, oid);
+	} else if (sysc != NULL) {
 		int variable_instance_hint = oval_syschar_get_variable_instance_hint(sysc);
 		if (oval_syschar_get_variable_instance_hint(sysc) != oval_syschar_get_variable_instance(sysc)) {
 			dI("Creating another syschar for variable_instance=%d)", variable_instance_hint);
@@ -153,11 +161,19 @@ int oval_probe_query_object(oval_probe_session_t *psess, struct oval_object *obj
 		return 1;
 	}
 
-	if ((ret = oval_probe_ext_handler(type, ph->uptr, PROBE_HANDLER_ACT_EVAL, sysc, flags)) != 0) {
+	oscap_prof_start(&timer);
+	ret = oval_probe_ext_handler(type, ph->uptr, PROBE_HANDLER_ACT_EVAL, sysc, flags);
+	if (timer.running) {
+		struct oval_sysitem_iterator *items = oval_syschar_get_sysitem(sysc);
+		oscap_prof_stop(&timer, OSCAP_PROF_OBJECT, oid, oval_collection_iterator_remaining((struct oval_iterator *)items));
+		oval_sysitem_iterator_free(items);
+	}
+	if (ret != 0) {
 		return ret;
 	}
 
-	if (!(flags & OVAL_PDFLAG_NOREPLY)) {
+	/* objects submitted in advance were requested with a reply */
+	if (pending || !(flags & OVAL_PDFLAG_NOREPLY)) {
 		vm = oval_string_map_new();
 		oval_obj_collect_var_refs(object, vm);
 		_syschar_add_bindings(sysc, vm);
@@ -167,6 +183,220 @@ int oval_probe_query_object(oval_probe_session_t *psess, struct oval_object *obj
 	return 0;
 }
 
+static int oval_probe_submit_object(oval_probe_session_t *psess, struct oval_object *object)
+{
+	struct oval_syschar *sysc;
+	oval_subtype_t type;
+	int ret;
+
+	if (oval_syschar_model_get_syschar(psess->sys_model, oval_object_get_id(object)) != NULL)
+		return 0;
+
+	type = oval_object_get_subtype(object);
+
+	if (oval_probe_handler_get(psess->ph, type) == NULL || !probe_table_exists(type))
+		return 0;
+
+	dI("Submitting %s_object '%s' in advance.", oval_subtype_get_text(type), oval_object_get_id(object));
+
+	sysc = oval_syschar_new(psess->sys_model, object);
+	ret = oval_probe_ext_submit(psess->pext, sysc, 0);
+
+	return ret < 0 ? -1 : 0;
+}
+
+struct oval_probe_plan_node {
+	struct oval_object *object;
+	int wave;			///< -1 while the dependencies of the object are being planned
+};
+
+struct oval_probe_plan {
+	oval_probe_session_t *psess;
+	struct oval_string_map *objects;	///< Planned objects by object id
+	struct oval_string_map *definitions;	///< Definitions already walked by definition id
+	struct oval_probe_plan_node **nodes;	///< Planned objects, dependencies first
+	size_t count;
+	int waves;
+};
+
+struct oval_probe_plan *oval_probe_plan_new(oval_probe_session_t *psess)
+{
+	struct oval_probe_plan *plan = calloc(1, sizeof(struct oval_probe_plan));
+
+	plan->psess = psess;
+	plan->objects = oval_string_map_new();
+	plan->definitions = oval_string_map_new();
+	return plan;
+}
+
+void oval_probe_plan_free(struct oval_probe_plan *plan)
+{
+	if (plan == NULL)
+		return;
+
+	oval_string_map_free(plan->objects, free);
+	oval_string_map_free(plan->definitions, NULL);
+	free(plan->nodes);
+	free(plan);
+}
+
+/*
+ * Plan the object after the objects it depends on and return its wave,
+ * i.e. the length of the longest chain of its dependencies.
+ */
+static int oval_probe_plan_object(struct oval_probe_plan *plan, struct oval_object *object)
+{
+	struct oval_probe_plan_node *node;
+	struct oval_string_map *deps;
+	struct oval_iterator *dep_itr;
+	const char *id = oval_object_get_id(object);
+	int wave = 0;
+
+	node = oval_string_map_get_value(plan->objects, id);
+	if (node != NULL) {
+		if (node->wave < 0) {
+			dW("Object '%s' depends on itself.", id);
+			return 0;
+		}
+		return node->wave;
+	}
+
+	node = malloc(sizeof(struct oval_probe_plan_node));
+	node->object = object;
+	node->wave = -1;
+	oval_string_map_put(plan->objects, id, node);
+
+	deps = oval_string_map_new();
+	oval_obj_collect_obj_refs(object, deps);
+	dep_itr = oval_string_map_values(deps);
+	while (oval_collection_iterator_has_more(dep_itr)) {
+		int dep_wave = oval_probe_plan_object(plan, oval_collection_iterator_next(dep_itr));
+		if (dep_wave + 1 > wave)
+			wave = dep_wave + 1;
+	}
+	oval_collection_iterator_free(dep_itr);
+	oval_string_map_free(deps, NULL);
+
+	node->wave = wave;
+	plan->nodes = realloc(plan->nodes, (plan->count + 1) * sizeof(struct oval_probe_plan_node *));
+	plan->nodes[plan->count++] = node;
+	if (wave + 1 > plan->waves)
+		plan->waves = wave + 1;
+
+	return wave;
+}
+
+static void oval_probe_plan_test(struct oval_probe_plan *plan, struct oval_test *test)
+{
+	struct oval_object *object = oval_test_get_object(test);
+	struct oval_state_iterator *ste_itr;
+
+	if (object == NULL || oval_test_get_subtype(test) != oval_object_get_subtype(object))
+		return;
+
+	oval_probe_plan_object(plan, object);
+
+	/* objects referenced like this: test->state->variable->object */
+	ste_itr = oval_test_get_states(test);
+	while (oval_state_iterator_has_more(ste_itr)) {
+		struct oval_string_map *deps = oval_string_map_new();
+		struct oval_iterator *dep_itr;
+
+		oval_ste_collect_obj_refs(oval_state_iterator_next(ste_itr), deps);
+		dep_itr = oval_string_map_values(deps);
+		while (oval_collection_iterator_has_more(dep_itr))
+			oval_probe_plan_object(plan, oval_collection_iterator_next(dep_itr));
+		oval_collection_iterator_free(dep_itr);
+		oval_string_map_free(deps, NULL);
+	}
+	oval_state_iterator_free(ste_itr);
+}
+
+static void oval_probe_plan_criteria(struct oval_probe_plan *plan, struct oval_criteria_node *cnode)
+{
+	switch (oval_criteria_node_get_type(cnode)) {
+	case OVAL_NODETYPE_CRITERION:{
+		struct oval_test *test = oval_criteria_node_get_test(cnode);
+		if (test != NULL)
+			oval_probe_plan_test(plan, test);
+		break;
+	}
+	case OVAL_NODETYPE_CRITERIA:{
+		struct oval_criteria_node_iterator *cnode_it = oval_criteria_node_get_subnodes(cnode);
+		if (cnode_it == NULL)
+			break;
+		while (oval_criteria_node_iterator_has_more(cnode_it))
+			oval_probe_plan_criteria(plan, oval_criteria_node_iterator_next(cnode_it));
+		oval_criteria_node_iterator_free(cnode_it);
+		break;
+	}
+	case OVAL_NODETYPE_EXTENDDEF:
+		oval_probe_plan_definition(plan, oval_criteria_node_get_definition(cnode));
+		break;
+	default:
+		break;
+	}
+}
+
+void oval_probe_plan_definition(struct oval_probe_plan *plan, struct oval_definition *definition)
+{
+	struct oval_criteria_node *cnode;
+	const char *id;
+
+	if (definition == NULL)
+		return;
+
+	id = oval_definition_get_id(definition);
+	if (oval_string_map_get_value(plan->definitions, id) != NULL)
+		return;
+	oval_string_map_put(plan->definitions, id, definition);
+
+	cnode = oval_definition_get_criteria(definition);
+	if (cnode != NULL)
+		oval_probe_plan_criteria(plan, cnode);
+}
+
+int oval_probe_plan_collect(struct oval_probe_plan *plan)
+{
+	int ret = 0;
+
+	dI("Collecting %zu objects in %d waves.", plan->count, plan->waves);
+
+	for (int wave = 0; wave < plan->waves; ++wave) {
+		/*
+		 * All the objects of a wave are in flight at once, the
+		 * objects they depend on were collected by the previous waves.
+		 */
+		for (size_t i = 0; i < plan->count; ++i) {
+			if (plan->nodes[i]->wave != wave)
+				continue;
+			if (oval_probe_submit_object(plan->psess, plan->nodes[i]->object) != 0) {
+				ret = -1;
+				break;
+			}
+		}
+		/* failures of single objects are recorded in their syschars */
+		oval_probe_collect_pending(plan->psess);
+		if (ret != 0)
+			break;
+	}
+
+	return ret;
+}
+
+int oval_probe_collect_pending(oval_probe_session_t *psess)
+{
+	struct oval_syschar *sysc;
+	int ret = 0;
+
+	while ((sysc = oval_probe_ext_pending_next(psess->pext)) != NULL) {
+		if (oval_probe_query_object(psess, oval_syschar_get_object(sysc), 0, NULL) == -1)
+			ret = -1;
+	}
+
+	return ret;
+}
+
 int oval_probe_query_sysinfo(oval_probe_session_t *sess, struct oval_sysinfo **out_sysinfo)
 {
 	struct oval_sysinfo *sysinf;
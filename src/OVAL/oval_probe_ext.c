@@ -28,6 +28,7 @@
 #include <string.h>
 #include <errno.h>
 #include <limits.h>
+#include <inttypes.h>
 #include <sys/types.h>
 #include <sys/stat.h>
 #ifdef OS_WINDOWS
@@ -58,6 +59,11 @@ static oval_pd_t    *oval_pdtbl_get(oval_pdtbl_t *table, oval_subtype_t type);
 /*
  * oval_pext_
  */
+static void oval_pext_pending_free_cb(rbt_i64_node_t *n)
+{
+	free(n->data);
+}
+
 oval_pext_t *oval_pext_new(void)
 {
         oval_pext_t *pext = malloc(sizeof(oval_pext_t));
@@ -65,6 +71,10 @@ oval_pext_t *oval_pext_new(void)
         pext->do_init = true;
         pthread_mutex_init(&pext->lock, NULL);
         pext->pdtbl     = NULL;
+        pthread_mutex_init(&pext->pending_lock, NULL);
+        pext->pending      = rbt_i64_new();
+        pext->pending_head = NULL;
+        pext->pending_tail = NULL;
 
         return(pext);
 }
@@ -77,6 +87,8 @@ void oval_pext_free(oval_pext_t *pext)
         }
 
         pthread_mutex_destroy(&pext->lock);
+        rbt_i64_free_cb(pext->pending, oval_pext_pending_free_cb);
+        pthread_mutex_destroy(&pext->pending_lock);
         free(pext);
 }
 
@@ -93,6 +105,11 @@ static oval_pdtbl_t *oval_pdtbl_new(void)
 	return (p_tbl);
 }
 
+static void oval_pd_replies_free_cb(rbt_i64_node_t *n)
+{
+	SEAP_msg_free((SEAP_msg_t *)n->data);
+}
+
 static void oval_pdtbl_free(oval_pdtbl_t *tbl)
 {
         register size_t i;
@@ -100,6 +117,7 @@ static void oval_pdtbl_free(oval_pdtbl_t *tbl)
         for (i = 0; i < tbl->count; ++i) {
                 SEAP_close(tbl->ctx, tbl->memb[i]->sd);
                 free(tbl->memb[i]->uri);
+		rbt_i64_free_cb(tbl->memb[i]->replies, oval_pd_replies_free_cb);
 		free(tbl->memb[i]);
         }
 
@@ -136,11 +154,13 @@ static int oval_pdtbl_add(oval_pdtbl_t *tbl, oval_subtype_t type, int sd, const
 	pd->subtype = type;
 	pd->sd      = sd;
 	pd->uri     = oscap_strdup(uri);
+	pd->replies = rbt_i64_new();
 
 	tbl->memb = realloc(tbl->memb, sizeof(oval_pd_t *) * (++tbl->count));
 
 	if (tbl->memb == NULL) {
 		free(pd->uri);
+		rbt_i64_free(pd->replies);
 		free(pd);
 		return -1;
 	}
@@ -350,47 +370,31 @@ static inline const char *_probe_strerror(uint32_t error_code)
 	return codemsg;
 }
 
-static inline int _handle_SEAP_receive_failure(SEAP_CTX_t *ctx, oval_pd_t *pd, SEAP_msg_t *s_omsg, int flags)
+static int _handle_SEAP_error(oval_pd_t *pd, SEAP_err_t *err)
 {
-	protect_errno {
-		dW("Can't receive message: %u, %s.", errno, strerror(errno));
+	/*
+	 * decide what to do based on the error code/type
+	 */
+	switch (err->type) {
+	case SEAP_ETYPE_USER:
+	{
+		oscap_seterr(OSCAP_EFAMILY_OVAL, "Probe at sd=%d (%s) reported an error: %s",
+				pd->sd, oval_subtype_to_str(pd->subtype), _probe_strerror(err->code));
+		break;
+	}
+	case SEAP_ETYPE_INT:
+		oscap_seterr(OSCAP_EFAMILY_OVAL, "Internal error");
+		break;
 	}
 
-	if (errno == ECANCELED) {
-		SEAP_err_t *err = NULL;
-
-		switch(SEAP_recverr_byid(ctx, pd->sd, &err,
-					 SEAP_msg_id(s_omsg)))
-		{
-		case  0:
-			break;
-		case  1: /* no error found */
-			dE("Internal error: An error was signaled on sd=%d but the error queue is empty.", pd->sd);
-			oscap_seterr(OSCAP_EFAMILY_OVAL, "SEAP_recverr_byid: internal error: empty error queue.");
-			return (-1);
-		case -1: /* internal error */
-			dE("Internal error: SEAP_recverr_byid returned -1");
-			oscap_seterr(OSCAP_EFAMILY_OVAL, "SEAP_recverr_byid: internal error.");
-			return (-1);
-		}
-
-		/*
-		 * decide what to do based on the error code/type
-		 */
-		switch (err->type) {
-		case SEAP_ETYPE_USER:
-		{
-			oscap_seterr(OSCAP_EFAMILY_OVAL, "Probe at sd=%d (%s) reported an error: %s",
-					pd->sd, oval_subtype_to_str(pd->subtype), _probe_strerror(err->code));
-			break;
-		}
-		case SEAP_ETYPE_INT:
-			oscap_seterr(OSCAP_EFAMILY_OVAL, "Internal error");
-			break;
-		}
+	SEAP_error_free(err);
+	return (-1);
+}
 
-		SEAP_error_free(err);
-		return (-1);
+static inline int _handle_SEAP_receive_failure(SEAP_CTX_t *ctx, oval_pd_t *pd, int flags)
+{
+	protect_errno {
+		dW("Can't receive message: %u, %s.", errno, strerror(errno));
 	}
 
 	if (flags & OVAL_PDFLAG_SLAVE) {
@@ -421,174 +425,254 @@ static inline int _handle_SEAP_receive_failure(SEAP_CTX_t *ctx, oval_pd_t *pd, S
 	return (-1);
 }
 
-static int oval_probe_comm(SEAP_CTX_t *ctx, oval_pd_t *pd, const SEXP_t *s_iobj, int flags, SEXP_t **out_sexp)
+/*
+ * Drop replies which were received for requests sent over a closed
+ * connection; nobody can collect them anymore.
+ */
+static void oval_pd_replies_reset(oval_pd_t *pd)
 {
-	int retry, ret;
+	rbt_i64_free_cb(pd->replies, oval_pd_replies_free_cb);
+	pd->replies = rbt_i64_new();
+}
 
-	SEAP_msg_t *s_imsg, *s_omsg;
-	SEXP_t *s_oobj;
+/*
+ * Send the object to the probe without waiting for the reply. The ID of
+ * the request message is stored in `out_id' and can be used to collect
+ * the reply using oval_probe_comm_collect.
+ */
+static int oval_probe_comm_submit(SEAP_CTX_t *ctx, oval_pd_t *pd, const SEXP_t *s_iobj, int flags, SEAP_msgid_t *out_id)
+{
+	int ret;
+
+	SEAP_msg_t *s_omsg;
 
 	if (pd == NULL || s_iobj == NULL) {
 		return -1;
 	}
 
 	ctx->subtype = pd->subtype;
-	for (retry = 0;;) {
-		/*
-		 * Establish connection to probe. The connection may be
-		 * already set up by previous calls to this function or
-		 * by the probe context handling functions.
-		 */
-		if (pd->sd == -1) {
-			pd->sd = SEAP_connect(ctx);
-
-			if (pd->sd < 0) {
-                                protect_errno {
-                                        dW("Can't connect: %u, %s.", errno, strerror(errno));
-                                }
-
-				if (++retry <= OVAL_PROBE_MAXRETRY) {
-					dD("Connect: retry %u/%u.", retry, OVAL_PROBE_MAXRETRY);
-					continue;
-				} else {
-                                        char errbuf[__ERRBUF_SIZE];
-
-                                        protect_errno {
-                                                dE("Connect: retry limit (%u) reached.", OVAL_PROBE_MAXRETRY);
-                                        }
-
-                                        if (oscap_strerror_r (errno, errbuf, sizeof errbuf - 1) != 0)
-                                                oscap_seterr (OSCAP_EFAMILY_OVAL, "Can't connect to the probe");
-                                        else
-                                                oscap_seterr (OSCAP_EFAMILY_OVAL, errbuf);
-
-					return (-1);
-				}
+
+	/*
+	 * Establish connection to probe. The connection may be
+	 * already set up by previous calls to this function or
+	 * by the probe context handling functions.
+	 */
+	if (pd->sd == -1) {
+		pd->sd = SEAP_connect(ctx);
+
+		if (pd->sd < 0) {
+			char errbuf[__ERRBUF_SIZE];
+
+			protect_errno {
+				dE("Can't connect: %u, %s.", errno, strerror(errno));
 			}
-		}
 
-		s_omsg = SEAP_msg_new();
-		SEAP_msg_set(s_omsg, (SEXP_t *) s_iobj);
+			if (oscap_strerror_r (errno, errbuf, sizeof errbuf - 1) != 0)
+				oscap_seterr (OSCAP_EFAMILY_OVAL, "Can't connect to the probe");
+			else
+				oscap_seterr (OSCAP_EFAMILY_OVAL, errbuf);
 
-		if (flags & OVAL_PDFLAG_NOREPLY) {
-			if (SEAP_msgattr_set(s_omsg, "no-reply", NULL) != 0) {
-                                protect_errno {
-                                        dE("Can't set no-reply attribute.");
-                                }
+			return (-1);
+		}
+	}
 
-                                SEAP_msg_free(s_omsg);
-                                oscap_seterr (OSCAP_EFAMILY_OVAL, "OVAL_EPROBEUNKNOWN");
+	s_omsg = SEAP_msg_new();
+	SEAP_msg_set(s_omsg, (SEXP_t *) s_iobj);
 
-				return (-1);
+	if (flags & OVAL_PDFLAG_NOREPLY) {
+		if (SEAP_msgattr_set(s_omsg, "no-reply", NULL) != 0) {
+			protect_errno {
+				dE("Can't set no-reply attribute.");
 			}
-		}
 
-		dD("Sending message.");
+			SEAP_msg_free(s_omsg);
+			oscap_seterr (OSCAP_EFAMILY_OVAL, "OVAL_EPROBEUNKNOWN");
 
-		ret = SEAP_sendmsg(ctx, pd->sd, s_omsg);
-		if (ret != 0) {
-                        protect_errno {
-                                dW("Can't send message: %u, %s.", errno, strerror(errno));
-                        }
+			return (-1);
+		}
+	}
 
-			if (flags & OVAL_PDFLAG_SLAVE) {
-                                char errbuf[__ERRBUF_SIZE];
+	dD("Sending message.");
 
-                                if (oscap_strerror_r (errno, errbuf, sizeof errbuf - 1) != 0)
-                                        oscap_seterr (OSCAP_EFAMILY_OVAL, "Unable to send a message to probe");
-                                else
-					oscap_seterr (OSCAP_EFAMILY_OVAL, errbuf);
+	ret = SEAP_sendmsg(ctx, pd->sd, s_omsg);
+	if (ret != 0) {
+		char errbuf[__ERRBUF_SIZE];
 
-				SEAP_msg_free(s_omsg);
-				return (-1);
-			}
+		protect_errno {
+			dE("Can't send message: %u, %s.", errno, strerror(errno));
+			SEAP_msg_free(s_omsg);
+		}
 
+		if (!(flags & OVAL_PDFLAG_SLAVE)) {
+			/*
+			 * The connection is unusable, the next request
+			 * opens a new one.
+			 */
 			if (SEAP_close(ctx, pd->sd) != 0) {
-                                char errbuf[__ERRBUF_SIZE];
-
-                                protect_errno {
-                                        dE("Can't close sd: %u, %s.", errno, strerror(errno));
-                                        SEAP_msg_free(s_omsg);
-                                }
+				protect_errno {
+					dE("Can't close sd: %u, %s.", errno, strerror(errno));
+				}
 
-                                if (oscap_strerror_r (errno, errbuf, sizeof errbuf - 1) != 0)
-                                        oscap_seterr (OSCAP_EFAMILY_OVAL, "Can't close sd");
-                                else
-                                        oscap_seterr (OSCAP_EFAMILY_OVAL, errbuf);
+				if (oscap_strerror_r (errno, errbuf, sizeof errbuf - 1) != 0)
+					oscap_seterr (OSCAP_EFAMILY_OVAL, "Can't close sd");
+				else
+					oscap_seterr (OSCAP_EFAMILY_OVAL, errbuf);
 
 				pd->sd = -1;
 				return (-1);
 			}
 
 			pd->sd = -1;
+			oval_pd_replies_reset(pd);
+		}
 
-			if (++retry <= OVAL_PROBE_MAXRETRY) {
-				dD("Send: retry %u/%u.", retry, OVAL_PROBE_MAXRETRY);
-				continue;
-			} else {
-                                char errbuf[__ERRBUF_SIZE];
+		if (oscap_strerror_r (errno, errbuf, sizeof errbuf - 1) != 0)
+			oscap_seterr (OSCAP_EFAMILY_OVAL, "Unable to send a message to probe");
+		else
+			oscap_seterr (OSCAP_EFAMILY_OVAL, errbuf);
 
-                                protect_errno {
-                                        dE("Send: retry limit (%u) reached.", OVAL_PROBE_MAXRETRY);
-                                        SEAP_msg_free(s_omsg);
-                                }
+		return (-1);
+	}
 
-                                if (oscap_strerror_r (errno, errbuf, sizeof errbuf - 1) != 0)
-                                        oscap_seterr (OSCAP_EFAMILY_OVAL, "Unable to send a message to probe");
-                                else
-                                        oscap_seterr (OSCAP_EFAMILY_OVAL, errbuf);
+	*out_id = SEAP_msg_id(s_omsg);
+	SEAP_msg_free(s_omsg);
 
-				return (ret);
-			}
+	return (0);
+}
+
+/*
+ * Return the ID of the request the message is a reply to.
+ */
+static int oval_probe_comm_reply_id(SEAP_msg_t *msg, SEAP_msgid_t *out_id)
+{
+	SEXP_t *rid;
+
+	rid = SEAP_msgattr_get(msg, "reply-id");
+
+	if (rid == NULL)
+		return (-1);
+
+	if (!SEXP_numberp(rid)) {
+		SEXP_free(rid);
+		return (-1);
+	}
+#if SEAP_MSGID_BITS == 64
+	*out_id = SEXP_number_getu_64(rid);
+#else
+	*out_id = SEXP_number_getu_32(rid);
+#endif
+	SEXP_free(rid);
+
+	return (0);
+}
+
+/*
+ * Wait for the reply to the request `id'. Replies to other requests which
+ * are received in the meantime are stored in the probe descriptor so that
+ * they can be collected later, in any order. An error reported by the probe
+ * stays in the SEAP error queue until the request it belongs to is collected.
+ */
+static int oval_probe_comm_collect(SEAP_CTX_t *ctx, oval_pd_t *pd, SEAP_msgid_t id, int flags, SEXP_t **out_sexp)
+{
+	int ret;
+	void *stored;
+	SEAP_err_t *err;
+	SEAP_msg_t *s_imsg;
+	SEAP_msgid_t rid;
+
+	for (;;) {
+		stored = NULL;
+
+		if (rbt_i64_del(pd->replies, (int64_t)id, &stored) == 0) {
+			dD("Found a stored reply.");
+			s_imsg = (SEAP_msg_t *)stored;
+			break;
+		}
+
+		err = NULL;
+
+		switch (SEAP_recverr_byid(ctx, pd->sd, &err, id)) {
+		case  0:
+			ret = _handle_SEAP_error(pd, err);
+			oscap_seterr(OSCAP_EFAMILY_OVAL, "Unable to receive a message from probe");
+			return (ret);
+		case  1: /* no error found */
+			break;
+		case -1: /* internal error */
+			dE("Internal error: SEAP_recverr_byid returned -1");
+			oscap_seterr(OSCAP_EFAMILY_OVAL, "SEAP_recverr_byid: internal error.");
+			return (-1);
 		}
 
 		dD("Waiting for reply.");
 
-		/* recv_retry: */
 		s_imsg = NULL;
 
 		ret = SEAP_recvmsg(ctx, pd->sd, &s_imsg);
 		if (ret != 0) {
+			if (errno == ECANCELED) {
+				/*
+				 * An error was queued; it's checked against the
+				 * ID of our request at the beginning of the loop.
+				 */
+				SEAP_msg_free(s_imsg);
+				continue;
+			}
+
 			protect_errno {
-				ret = _handle_SEAP_receive_failure(ctx, pd, s_omsg, flags);
+				ret = _handle_SEAP_receive_failure(ctx, pd, flags);
 				SEAP_msg_free(s_imsg);
-				SEAP_msg_free(s_omsg);
 			}
+
+			if (pd->sd == -1)
+				oval_pd_replies_reset(pd);
+
 			if (errno == ECONNABORTED) {
 				dD("Connection was aborted.");
 				return (-2);
-			} else {
-				if (++retry <= OVAL_PROBE_MAXRETRY) {
-					dD("Recv: retry %u/%u.", retry, OVAL_PROBE_MAXRETRY);
-					continue;
-				} else {
-					protect_errno {
-						dE("Recv: retry limit (%u) reached.", OVAL_PROBE_MAXRETRY);
-					}
-
-					char errbuf[__ERRBUF_SIZE];
-					if (oscap_strerror_r (errno, errbuf, sizeof errbuf - 1) == 0)
-						oscap_seterr(OSCAP_EFAMILY_OVAL, errbuf);
-					oscap_seterr(OSCAP_EFAMILY_OVAL, "Unable to receive a message from probe");
-
-					return ret;
-				}
 			}
+
+			char errbuf[__ERRBUF_SIZE];
+			if (oscap_strerror_r (errno, errbuf, sizeof errbuf - 1) == 0)
+				oscap_seterr(OSCAP_EFAMILY_OVAL, errbuf);
+			oscap_seterr(OSCAP_EFAMILY_OVAL, "Unable to receive a message from probe");
+
+			return ret;
 		}
 
 		dD("Message received.");
-		break;
-	}
 
-	s_oobj = SEAP_msg_get(s_imsg);
+		if (oval_probe_comm_reply_id(s_imsg, &rid) != 0 || rid == id)
+			break;
+
+		dD("Storing a reply to another request (ID=%"PRIu64").", (uint64_t)rid);
+
+		stored = NULL;
+		if (rbt_i64_add(pd->replies, (int64_t)rid, s_imsg, &stored) != 0) {
+			dW("Dropping a duplicate reply (ID=%"PRIu64").", (uint64_t)rid);
+			SEAP_msg_free(s_imsg);
+		}
+	}
 
+	*out_sexp = SEAP_msg_get(s_imsg);
 	SEAP_msg_free(s_imsg);
-	SEAP_msg_free(s_omsg);
 
-	*out_sexp = s_oobj;
 	return (0);
 }
 
+static int oval_probe_comm(SEAP_CTX_t *ctx, oval_pd_t *pd, const SEXP_t *s_iobj, int flags, SEXP_t **out_sexp)
+{
+	SEAP_msgid_t id;
+	int ret;
+
+	ret = oval_probe_comm_submit(ctx, pd, s_iobj, flags, &id);
+
+	if (ret != 0)
+		return (ret);
+
+	return oval_probe_comm_collect(ctx, pd, id, flags, out_sexp);
+}
+
 static int oval_probe_sys_eval(SEAP_CTX_t *ctx, oval_pd_t *pd, struct oval_syschar_model *model, struct oval_sysinfo **out_sysinf)
 {
 	struct oval_sysinfo *sysinf;
@@ -795,6 +879,11 @@ int oval_probe_sys_handler(oval_subtype_t type, void *ptr, int act, ...)
         return(ret);
 }
 
+static oval_pending_t *oval_pext_pending_take(oval_pext_t *pext, struct oval_syschar *syschar);
+static void oval_pext_pending_clear(oval_pext_t *pext);
+static int oval_probe_ext_complete(oval_pext_t *pext, oval_pending_t *p, int flags);
+static int oval_probe_ext_getpd(oval_pext_t *pext, oval_subtype_t subtype, oval_pd_t **out_pd);
+
 int oval_probe_ext_handler(oval_subtype_t type, void *ptr, int act, ...)
 {
         int          ret = 0;
@@ -813,50 +902,31 @@ int oval_probe_ext_handler(oval_subtype_t type, void *ptr, int act, ...)
 
 		sys = va_arg(ap, struct oval_syschar *);
 		flags = va_arg(ap, int);
-		obj = oval_syschar_get_object(sys);
-		oval_subtype_t obj_subtype = oval_object_get_subtype(obj);
-		pd = oval_pdtbl_get(pext->pdtbl, obj_subtype);
-
-                if (pd == NULL) {
-                        char         probe_uri[PATH_MAX + 1];
-                        size_t       probe_urilen;
-
-			if (!probe_table_exists(obj_subtype)) {
-				oval_syschar_add_new_message(sys, "OVAL object not supported", OVAL_MESSAGE_LEVEL_WARNING);
-				oval_syschar_set_flag(sys, SYSCHAR_FLAG_NOT_COLLECTED);
-				va_end(ap);
-				return (1);
-			}
-
-			probe_urilen = snprintf(probe_uri, sizeof probe_uri, "%s://%s",
-					OVAL_PROBE_SCHEME, oval_subtype_get_text(obj_subtype));
-
-                        if (probe_urilen >= sizeof probe_uri) {
-                                oscap_seterr (OSCAP_EFAMILY_GLIBC, "probe URI too long");
-				va_end(ap);
-                                return (-1);
-                        }
-
-                        dI("Starting probe on URI '%s'.", probe_uri);
+		oval_pending_t *pending = oval_pext_pending_take(pext, sys);
 
-                        if (oval_pdtbl_add(pext->pdtbl, obj_subtype, -1, probe_uri) != 0) {
-				oval_syschar_add_new_message(sys, "OVAL object not supported", OVAL_MESSAGE_LEVEL_WARNING);
-				oval_syschar_set_flag(sys, SYSCHAR_FLAG_NOT_COLLECTED);
-				va_end(ap);
-                                return (1);
-			}
+		if (pending != NULL) {
+			ret = oval_probe_ext_complete(pext, pending, flags);
+			goto eval_done;
+		}
 
-			pd = oval_pdtbl_get(pext->pdtbl, obj_subtype);
+		obj = oval_syschar_get_object(sys);
+		oval_subtype_t obj_subtype = oval_object_get_subtype(obj);
 
-                        if (pd == NULL) {
-                                oscap_seterr (OSCAP_EFAMILY_OVAL, "internal error");
-				va_end(ap);
-                                return (-1);
-                        }
-                }
+		switch (oval_probe_ext_getpd(pext, obj_subtype, &pd)) {
+		case 0:
+			break;
+		case 1:
+			oval_syschar_add_new_message(sys, "OVAL object not supported", OVAL_MESSAGE_LEVEL_WARNING);
+			oval_syschar_set_flag(sys, SYSCHAR_FLAG_NOT_COLLECTED);
+			va_end(ap);
+			return (1);
+		default:
+			va_end(ap);
+			return (-1);
+		}
 
 		ret = oval_probe_ext_eval(pext->pdtbl->ctx, pd, pext, sys, flags);
-
+	eval_done:
 		if (ret >= 0)
 			ret = 0;
 
@@ -869,6 +939,9 @@ int oval_probe_ext_handler(oval_subtype_t type, void *ptr, int act, ...)
 				pext->do_init  = true;
 				pext->pdtbl    = NULL;
 
+				/* the pending requests were lost with the probes */
+				oval_pext_pending_clear(pext);
+
 				oval_probe_ext_init(pext);
 
 				errno = ECONNABORTED;
@@ -960,9 +1033,22 @@ int oval_probe_ext_init(oval_pext_t *pext)
         return(ret);
 }
 
-int oval_probe_ext_eval(SEAP_CTX_t *ctx, oval_pd_t *pd, oval_pext_t *pext, struct oval_syschar *syschar, int flags)
+static void oval_probe_ext_aborted(SEAP_CTX_t *ctx, oval_pd_t *pd)
+{
+	switch (errno) {
+	case ECONNABORTED:
+		dD("Closing sd=%d (pd=%p) after abort", pd->sd, pd);
+
+		SEAP_close(ctx, pd->sd);
+		pd->sd = -1;
+		oval_pd_replies_reset(pd);
+		errno  = ECONNABORTED;
+	}
+}
+
+static int oval_probe_ext_send(SEAP_CTX_t *ctx, oval_pd_t *pd, oval_pext_t *pext, struct oval_syschar *syschar, int flags, SEAP_msgid_t *out_id)
 {
-        SEXP_t *s_obj, *s_sys;
+	SEXP_t *s_obj;
 	struct oval_object *object;
 	int ret;
 
@@ -977,18 +1063,21 @@ int oval_probe_ext_eval(SEAP_CTX_t *ctx, oval_pd_t *pd, oval_pext_t *pext, struc
 	if (ret != 0)
 		return (1);
 
-	ret = oval_probe_comm(ctx, pd, s_obj, flags, &s_sys);
+	ret = oval_probe_comm_submit(ctx, pd, s_obj, flags, out_id);
 	SEXP_free(s_obj);
 
-	if (ret != 0) {
-		switch (errno) {
-		case ECONNABORTED:
-			dD("Closing sd=%d (pd=%p) after abort", pd->sd, pd);
+	return (ret);
+}
 
-			SEAP_close(ctx, pd->sd);
-			pd->sd = -1;
-			errno  = ECONNABORTED;
-		}
+static int oval_probe_ext_recv(SEAP_CTX_t *ctx, oval_pd_t *pd, struct oval_syschar *syschar, SEAP_msgid_t id, int flags)
+{
+	SEXP_t *s_sys;
+	int ret;
+
+	ret = oval_probe_comm_collect(ctx, pd, id, flags, &s_sys);
+
+	if (ret != 0) {
+		oval_probe_ext_aborted(ctx, pd);
 		return (ret);
 	}
 
@@ -1013,6 +1102,240 @@ int oval_probe_ext_eval(SEAP_CTX_t *ctx, oval_pd_t *pd, oval_pext_t *pext, struc
 	return (ret);
 }
 
+static void oval_probe_ext_prof_stop(oscap_prof_timer_t *timer, struct oval_syschar *syschar)
+{
+	if (timer->running) {
+		oval_subtype_t subtype = oval_object_get_subtype(oval_syschar_get_object(syschar));
+		oscap_prof_stop(timer, OSCAP_PROF_ROUNDTRIP, oval_subtype_get_text(subtype), 0);
+	}
+}
+
+int oval_probe_ext_eval(SEAP_CTX_t *ctx, oval_pd_t *pd, oval_pext_t *pext, struct oval_syschar *syschar, int flags)
+{
+	SEAP_msgid_t id;
+	oscap_prof_timer_t timer;
+	int ret;
+
+	oscap_prof_start(&timer);
+	ret = oval_probe_ext_send(ctx, pd, pext, syschar, flags, &id);
+
+	if (ret != 0) {
+		if (ret < 0)
+			oval_probe_ext_aborted(ctx, pd);
+		return (ret);
+	}
+
+	ret = oval_probe_ext_recv(ctx, pd, syschar, id, flags);
+	oval_probe_ext_prof_stop(&timer, syschar);
+
+	return (ret);
+}
+
+static inline int64_t oval_pext_pending_key(struct oval_syschar *syschar)
+{
+	return (int64_t)(intptr_t)syschar;
+}
+
+/*
+ * Remove the pending submission of the syschar and return it, or NULL if
+ * the object of the syschar wasn't submitted.
+ */
+static oval_pending_t *oval_pext_pending_take(oval_pext_t *pext, struct oval_syschar *syschar)
+{
+	void *data = NULL;
+	oval_pending_t *p;
+
+	pthread_mutex_lock(&pext->pending_lock);
+
+	if (rbt_i64_del(pext->pending, oval_pext_pending_key(syschar), &data) != 0) {
+		pthread_mutex_unlock(&pext->pending_lock);
+		return (NULL);
+	}
+
+	p = (oval_pending_t *)data;
+
+	if (p->prev != NULL)
+		p->prev->next = p->next;
+	else
+		pext->pending_head = p->next;
+	if (p->next != NULL)
+		p->next->prev = p->prev;
+	else
+		pext->pending_tail = p->prev;
+
+	pthread_mutex_unlock(&pext->pending_lock);
+
+	return (p);
+}
+
+/*
+ * Forget all the pending submissions.
+ */
+static void oval_pext_pending_clear(oval_pext_t *pext)
+{
+	pthread_mutex_lock(&pext->pending_lock);
+	rbt_i64_free_cb(pext->pending, oval_pext_pending_free_cb);
+	pext->pending      = rbt_i64_new();
+	pext->pending_head = NULL;
+	pext->pending_tail = NULL;
+	pthread_mutex_unlock(&pext->pending_lock);
+}
+
+bool oval_probe_ext_pending(oval_pext_t *pext, struct oval_syschar *syschar)
+{
+	void *data = NULL;
+	int ret;
+
+	pthread_mutex_lock(&pext->pending_lock);
+	ret = rbt_i64_get(pext->pending, oval_pext_pending_key(syschar), &data);
+	pthread_mutex_unlock(&pext->pending_lock);
+
+	return (ret == 0);
+}
+
+/*
+ * Collect the result of a pending submission removed from the list.
+ */
+static int oval_probe_ext_complete(oval_pext_t *pext, oval_pending_t *p, int flags)
+{
+	int ret;
+
+	if (p->ret != 0) {
+		ret = p->ret;
+		free(p);
+		return (ret);
+	}
+
+	ret = oval_probe_ext_recv(pext->pdtbl->ctx, p->pd, p->syschar, p->id,
+	                          (p->flags & OVAL_PDFLAG_NOREPLY) | (flags & ~OVAL_PDFLAG_NOREPLY));
+	oval_probe_ext_prof_stop(&p->timer, p->syschar);
+	free(p);
+
+	return (ret);
+}
+
+/*
+ * Find the descriptor of the probe evaluating objects of the given subtype
+ * and create it if it doesn't exist yet.
+ * @retval 0 on success
+ * @retval 1 if there's no such probe
+ * @retval -1 on error
+ */
+static int oval_probe_ext_getpd(oval_pext_t *pext, oval_subtype_t subtype, oval_pd_t **out_pd)
+{
+	oval_pd_t *pd;
+	char       probe_uri[PATH_MAX + 1];
+	size_t     probe_urilen;
+
+	pd = oval_pdtbl_get(pext->pdtbl, subtype);
+
+	if (pd != NULL) {
+		*out_pd = pd;
+		return (0);
+	}
+
+	if (!probe_table_exists(subtype))
+		return (1);
+
+	probe_urilen = snprintf(probe_uri, sizeof probe_uri, "%s://%s",
+	                        OVAL_PROBE_SCHEME, oval_subtype_get_text(subtype));
+
+	if (probe_urilen >= sizeof probe_uri) {
+		oscap_seterr (OSCAP_EFAMILY_GLIBC, "probe URI too long");
+		return (-1);
+	}
+
+	dI("Starting probe on URI '%s'.", probe_uri);
+
+	if (oval_pdtbl_add(pext->pdtbl, subtype, -1, probe_uri) != 0)
+		return (1);
+
+	pd = oval_pdtbl_get(pext->pdtbl, subtype);
+
+	if (pd == NULL) {
+		oscap_seterr (OSCAP_EFAMILY_OVAL, "internal error");
+		return (-1);
+	}
+
+	*out_pd = pd;
+	return (0);
+}
+
+int oval_probe_ext_submit(oval_pext_t *pext, struct oval_syschar *syschar, int flags)
+{
+	oval_pending_t *p;
+	oval_pd_t *pd;
+	SEAP_msgid_t id;
+	oscap_prof_timer_t timer;
+	int ret;
+
+	if (oval_probe_ext_pending(pext, syschar))
+		return (0);
+
+	if (oval_probe_ext_init(pext) != 0)
+		return (-1);
+
+	ret = oval_probe_ext_getpd(pext, oval_object_get_subtype(oval_syschar_get_object(syschar)), &pd);
+
+	if (ret != 0)
+		return (ret);
+
+	oscap_prof_start(&timer);
+	ret = oval_probe_ext_send(pext->pdtbl->ctx, pd, pext, syschar, flags, &id);
+
+	if (ret < 0)
+		return (ret);
+
+	p = malloc(sizeof(oval_pending_t));
+
+	if (p == NULL)
+		return (-1);
+
+	/*
+	 * The conversion of the object has already modified the syschar;
+	 * remember the result so that the collection reports it exactly
+	 * as the synchronous evaluation would.
+	 */
+	p->syschar = syschar;
+	p->pd      = pd;
+	p->id      = ret == 0 ? id : 0;
+	p->flags   = flags;
+	p->ret     = ret;
+	p->timer   = timer;
+	p->next    = NULL;
+
+	pthread_mutex_lock(&pext->pending_lock);
+
+	if (rbt_i64_add(pext->pending, oval_pext_pending_key(syschar), p, NULL) != 0) {
+		/* submitted by another thread meanwhile, its reply is collected instead */
+		pthread_mutex_unlock(&pext->pending_lock);
+		free(p);
+		return (0);
+	}
+
+	p->prev = pext->pending_tail;
+	if (pext->pending_tail != NULL)
+		pext->pending_tail->next = p;
+	else
+		pext->pending_head = p;
+	pext->pending_tail = p;
+
+	pthread_mutex_unlock(&pext->pending_lock);
+
+	return (0);
+}
+
+struct oval_syschar *oval_probe_ext_pending_next(oval_pext_t *pext)
+{
+	struct oval_syschar *syschar;
+
+	pthread_mutex_lock(&pext->pending_lock);
+	syschar = pext->pending_head != NULL ? pext->pending_head->syschar : NULL;
+	pthread_mutex_unlock(&pext->pending_lock);
+
+	return (syschar);
+}
+
 int oval_probe_ext_reset(SEAP_CTX_t *ctx, oval_pd_t *pd, oval_pext_t *pext)
 {
         SEAP_cmd_exec(ctx, pd->sd, SEAP_EXEC_RECV, PROBECMD_RESET, NULL, SEAP_CMDTYPE_SYNC, NULL, NULL);
@@ -28,11 +28,14 @@
 #include "oval_probe_impl.h"
 #include "oval_system_characteristics_impl.h"
 #include "common/util.h"
+#include "common/profiler_priv.h"
+#include "probes/SEAP/generic/rbt/rbt.h"
 
 typedef struct {
 	oval_subtype_t subtype;
 	int sd;
 	char *uri;
+	rbt_t *replies; /**< received replies which weren't collected yet, keyed by the request ID */
 } oval_pd_t;
 
 typedef struct {
@@ -41,6 +44,20 @@ typedef struct {
 	SEAP_CTX_t *ctx;
 } oval_pdtbl_t;
 
+/**
+ * An object submitted to a probe whose result wasn't collected yet.
+ */
+typedef struct oval_pending {
+	struct oval_syschar *syschar; /**< syschar the result belongs to */
+	oval_pd_t           *pd;      /**< probe evaluating the object */
+	SEAP_msgid_t         id;      /**< ID of the request message */
+	int                  flags;   /**< OVAL_PDFLAG_* flags used for the submission */
+	int                  ret;     /**< non-zero if nothing was sent; returned on collection */
+	oscap_prof_timer_t   timer;   /**< measures the round trip for the profiler */
+	struct oval_pending *prev;    /**< previous submission in the submission order */
+	struct oval_pending *next;    /**< next submission in the submission order */
+} oval_pending_t;
+
 struct oval_pext {
         pthread_mutex_t lock;
         bool            do_init;
@@ -48,6 +65,11 @@ struct oval_pext {
         SEAP_CTX_t   *sctx;
         oval_pdtbl_t *pdtbl;
 
+        pthread_mutex_t pending_lock; /**< protects the pending submissions */
+        rbt_t          *pending;      /**< objects submitted by oval_probe_ext_submit, keyed by the syschar */
+        oval_pending_t *pending_head; /**< the oldest pending submission */
+        oval_pending_t *pending_tail; /**< the newest pending submission */
+
         void *sess_ptr;
         struct oval_syschar_model **model;
 };
@@ -58,6 +80,23 @@ oval_pext_t *oval_pext_new(void);
 void oval_pext_free(oval_pext_t *pext);
 int oval_probe_ext_init(oval_pext_t *pext);
 int oval_probe_ext_eval(SEAP_CTX_t *ctx, oval_pd_t *pd, oval_pext_t *pext, struct oval_syschar *syschar, int flags);
+
+/**
+ * Send the object of the syschar to its probe without waiting for the result.
+ * The result is collected by the next PROBE_HANDLER_ACT_EVAL action invoked on
+ * on the same syschar.
+ * @retval 0 the object was submitted
+ * @retval 1 the object can't be submitted asynchronously
+ * @retval -1 error
+ */
+int oval_probe_ext_submit(oval_pext_t *pext, struct oval_syschar *syschar, int flags);
+bool oval_probe_ext_pending(oval_pext_t *pext, struct oval_syschar *syschar);
+
+
+/**
+ * Get the syschar of the oldest pending submission or NULL if there's none.
+ */
+struct oval_syschar *oval_probe_ext_pending_next(oval_pext_t *pext);
 int oval_probe_ext_reset(SEAP_CTX_t *ctx, oval_pd_t *pd, oval_pext_t *pext);
 int oval_probe_ext_abort(SEAP_CTX_t *ctx, oval_pd_t *pd, oval_pext_t *pext);
 
@@ -46,8 +46,6 @@
 
 #define OVAL_PROBE_SCHEME "queue"
 
-#define OVAL_PROBE_MAXRETRY 0
-
 int oval_probe_query_test(oval_probe_session_t *sess, struct oval_test *test);
 
 
@@ -61,6 +59,37 @@ typedef struct {
 void oval_probe_tblinit(void);
 const char *oval_subtype_to_str(oval_subtype_t subtype);
 
+/*
+ * Collection plan. The objects of the tests of the planned definitions
+ * (including the extended definitions) and the objects they depend on
+ * through variables are deduplicated and split into waves: an object is
+ * in the wave after the last of its dependencies. All the objects of a
+ * wave are submitted to the probes at once and collected before the next
+ * wave, so the evaluation of the definitions doesn't wait for the probes.
+ */
+struct oval_probe_plan;
+
+struct oval_probe_plan *oval_probe_plan_new(oval_probe_session_t *sess);
+void oval_probe_plan_free(struct oval_probe_plan *plan);
+
+/**
+ * Add the objects needed to evaluate the definition to the plan.
+ */
+void oval_probe_plan_definition(struct oval_probe_plan *plan, struct oval_definition *definition);
+
+/**
+ * Collect all the planned objects wave by wave.
+ * @returns 0 on success; -1 if the objects couldn't be submitted
+ */
+int oval_probe_plan_collect(struct oval_probe_plan *plan);
+
+/**
+ * Collect the results of all the objects submitted in advance
+ * which weren't queried yet.
+ * @returns 0 on success; -1 on error
+ */
+int oval_probe_collect_pending(oval_probe_session_t *sess);
+
 int oval_probe_hint_definition(oval_probe_session_t *sess, struct oval_definition *definition, int variable_instance_hint);
 
 #endif /* OVAL_PROBE_IMPL_H */
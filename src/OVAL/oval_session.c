@@ -84,6 +84,7 @@ struct oval_session {
 	bool full_validation;
 	bool fetch_remote_resources;
 	download_progress_calllback_t progress;
+	unsigned int jobs;
 };
 
 struct oval_session *oval_session_new(const char *filename)
@@ -183,6 +184,13 @@ void oval_session_set_xml_reporter(struct oval_session *session, xml_reporter fn
 	session->reporter.xml_fn = fn;
 }
 
+void oval_session_set_jobs(struct oval_session *session, unsigned int jobs)
+{
+	__attribute__nonnull__(session);
+
+	session->jobs = jobs;
+}
+
 static bool oval_session_validate(struct oval_session *session, struct oscap_source *source, oscap_document_type_t type)
 {
 	if (oscap_source_get_scap_type(source) == type) {
@@ -332,6 +340,7 @@ static int oval_session_setup_agent(struct oval_session *session)
 	free(path_clone);
 
 	oval_agent_set_product_name(session->sess, (char *)oscap_productname);
+	oval_agent_set_jobs(session->sess, session->jobs);
 	return 0;
 }
 
@@ -400,7 +409,14 @@ int oval_session_export(struct oval_session *session)
 
 	/* Get OVAL Results if evaluation or analyse has been done and apply
 	 * directives to them */
-	if (session->res_model && (session->export.results || session->export.report)) {
+	if (session->res_model && session->export.results && !session->export.report &&
+			!(session->validation && session->full_validation)) {
+		/* Nothing else needs the document, write it out while it's being built */
+		oval_results_model_set_export_system_characteristics(session->res_model, session->export_sys_chars);
+		if (oval_results_model_export(session->res_model, dir_model, session->export.results) != 0)
+			goto cleanup;
+	}
+	else if (session->res_model && (session->export.results || session->export.report)) {
 		oval_results_model_set_export_system_characteristics(session->res_model, session->export_sys_chars);
 		result = oval_results_model_export_source(session->res_model, dir_model, NULL);
 		filename = session->export.results;
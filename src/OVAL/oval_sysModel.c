@@ -306,7 +306,8 @@ struct oval_sysitem *oval_syschar_model_get_new_sysitem(struct oval_syschar_mode
 }
 
 xmlNode *oval_syschar_model_to_dom(struct oval_syschar_model * syschar_model, xmlDocPtr doc, xmlNode * parent, 
-			           oval_syschar_resolver resolver, void *user_arg, bool export_syschar)
+			           oval_syschar_resolver resolver, void *user_arg, bool export_syschar,
+			           struct oscap_xml_stream *stream)
 {
 
 	xmlNodePtr root_node = NULL;
@@ -332,6 +333,7 @@ xmlNode *oval_syschar_model_to_dom(struct oval_syschar_model * syschar_model, xm
 	xmlSetNs(root_node, ns_lin);
 	xmlSetNs(root_node, ns_win);
 	xmlSetNs(root_node, ns_syschar);
+	oscap_xml_stream_start_element(stream, root_node);
 
         /* Always report the generator */
 	oval_generator_to_dom(syschar_model->generator, doc, root_node);
@@ -340,8 +342,10 @@ xmlNode *oval_syschar_model_to_dom(struct oval_syschar_model * syschar_model, xm
 	oval_sysinfo_to_dom(oval_syschar_model_get_sysinfo(syschar_model), doc, root_node);
 
 	if (!export_syschar) {
-		return root_node;
+		oscap_xml_stream_end_element(stream, root_node);
+		return stream ? NULL : root_node;
 	}
+	oscap_xml_stream_flush(stream, root_node);
 
 	struct oval_smc *resolved_smc = NULL;
 	struct oval_syschar_iterator *syschars = oval_syschar_model_get_syschars(syschar_model);
@@ -360,6 +364,7 @@ xmlNode *oval_syschar_model_to_dom(struct oval_syschar_model * syschar_model, xm
 	struct oval_string_map *sysitem_map = oval_string_map_new();
 	if (oval_syschar_iterator_has_more(syschars)) {
 		xmlNode *tag_objects = xmlNewTextChild(root_node, ns_syschar, BAD_CAST "collected_objects", NULL);
+		oscap_xml_stream_start_element(stream, tag_objects);
 
 		while (oval_syschar_iterator_has_more(syschars)) {
 			struct oval_syschar *syschar = oval_syschar_iterator_next(syschars);
@@ -368,6 +373,7 @@ xmlNode *oval_syschar_model_to_dom(struct oval_syschar_model * syschar_model, xm
 			    || oval_object_get_base_obj(object)) /* Skip internal objects */
 				continue;
 			oval_syschar_to_dom(syschar, doc, tag_objects);
+			oscap_xml_stream_flush(stream, tag_objects);
 			struct oval_sysitem_iterator *sysitems = oval_syschar_get_sysitem(syschar);
 			while (oval_sysitem_iterator_has_more(sysitems)) {
 				struct oval_sysitem *sysitem = oval_sysitem_iterator_next(sysitems);
@@ -375,6 +381,7 @@ xmlNode *oval_syschar_model_to_dom(struct oval_syschar_model * syschar_model, xm
 			}
 			oval_sysitem_iterator_free(sysitems);
 		}
+		oscap_xml_stream_end_element(stream, tag_objects);
 	}
 	oval_smc_free0(resolved_smc);
 	oval_syschar_iterator_free(syschars);
@@ -382,16 +389,20 @@ xmlNode *oval_syschar_model_to_dom(struct oval_syschar_model * syschar_model, xm
 	struct oval_iterator *sysitems = oval_string_map_values(sysitem_map);
 	if (oval_collection_iterator_has_more(sysitems)) {
 		xmlNode *tag_items = xmlNewTextChild(root_node, ns_syschar, BAD_CAST "system_data", NULL);
+		oscap_xml_stream_start_element(stream, tag_items);
 		while (oval_collection_iterator_has_more(sysitems)) {
 			struct oval_sysitem *sysitem = (struct oval_sysitem *)
 			    oval_collection_iterator_next(sysitems);
 			oval_sysitem_to_dom(sysitem, doc, tag_items);
+			oscap_xml_stream_flush(stream, tag_items);
 		}
+		oscap_xml_stream_end_element(stream, tag_items);
 	}
 	oval_collection_iterator_free(sysitems);
 	oval_string_map_free(sysitem_map, NULL);
 
-	return root_node;
+	oscap_xml_stream_end_element(stream, root_node);
+	return stream ? NULL : root_node;
 }
 
 int oval_syschar_model_export(struct oval_syschar_model *model, const char *file)
@@ -407,7 +418,15 @@ int oval_syschar_model_export(struct oval_syschar_model *model, const char *file
 		return -1;
 	}
 
-	oval_syschar_model_to_dom(model, doc, NULL, NULL, NULL, true);
-	return oscap_xml_save_filename_free(file, doc);
+	/* Items are written out as soon as they are serialized */
+	struct oscap_xml_stream *stream = oscap_xml_stream_new(file);
+	if (stream == NULL) {
+		xmlFreeDoc(doc);
+		return -1;
+	}
+
+	oval_syschar_model_to_dom(model, doc, NULL, NULL, NULL, true, stream);
+	xmlFreeDoc(doc);
+	return oscap_xml_stream_free(stream);
 }
 
@@ -62,5 +62,6 @@ SEXP_t *SEAP_msg_get(SEAP_msg_t *msg);
 
 int SEAP_msgattr_set(SEAP_msg_t *msg, const char *name, SEXP_t *value);
 bool SEAP_msgattr_exists(SEAP_msg_t *msg, const char *name);
+SEXP_t *SEAP_msgattr_get(SEAP_msg_t *msg, const char *name);
 
 #endif /* _SEAP_MESSAGE_H */
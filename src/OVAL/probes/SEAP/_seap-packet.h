@@ -48,12 +48,16 @@ struct SEAP_packet {
                 SEAP_msg_t msg;
                 SEAP_err_t err;
                 SEAP_cmd_t cmd;
+                SEXP_t    *raw; /* list of packets in the S-exp form */
         } data;
+        struct SEAP_packet *next; /* link in the queue of the receiver */
 };
 typedef struct SEAP_packet SEAP_packet_t;
 
 SEAP_packet_t *SEAP_packet_new(void);
 void SEAP_packet_free(SEAP_packet_t *packet);
+/* Free the packet together with the data it references. */
+void SEAP_packet_discard(SEAP_packet_t *packet);
 
 void *SEAP_packet_settype(SEAP_packet_t *packet, uint8_t type);
 uint8_t SEAP_packet_gettype(SEAP_packet_t *packet);
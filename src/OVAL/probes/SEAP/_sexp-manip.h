@@ -50,5 +50,12 @@ SEXP_t *SEXP_lstack_top (const SEXP_lstack_t *stack);
 SEXP_t *SEXP_lstack_list (SEXP_lstack_t *stack);
 size_t  SEXP_lstack_depth (SEXP_lstack_t *stack);
 
+/*
+ * Attribute lists of entities and objects, i.e. `(name :attr1 val1 flag ...)'.
+ * The members are compared in place, no references are created.
+ */
+SEXP_t *SEXP_list_attrval (const SEXP_t *list, const char *name);
+bool    SEXP_list_attrexists (const SEXP_t *list, const char *name);
+
 
 #endif /* _SEXP_MANIP_H */
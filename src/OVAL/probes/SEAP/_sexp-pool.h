@@ -0,0 +1,56 @@
+/*
+ * Copyright 2026 Red Hat Inc., Durham, North Carolina.
+ * All Rights Reserved.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+#pragma once
+#ifndef _SEXP_POOL_H
+#define _SEXP_POOL_H
+
+#include <stddef.h>
+
+/*
+ * Size-class pool for S-exp values and list blocks. Freed memory is kept
+ * on per-thread free lists and reused by the following allocations of the
+ * same size class instead of going through malloc/free every time. A thread
+ * never caches more than about 1 MiB, the free lists are trimmed once it is
+ * exceeded. The pool can be disabled by setting OSCAP_SEXP_POOL=0.
+ */
+
+#define SEXP_POOL_ALIGN     16
+#define SEXP_POOL_MAXSIZE   512  /* larger blocks are not pooled */
+#define SEXP_POOL_CACHE_MAX (1024 * 1024) /* max. cached bytes of one thread */
+
+/**
+ * Allocate a block aligned to SEXP_POOL_ALIGN bytes.
+ */
+void *SEXP_pool_alloc(size_t size);
+
+/**
+ * Return a block to the pool. The size has to be the same as the one
+ * used to allocate the block, the block may be freed by another thread.
+ */
+void SEXP_pool_free(void *ptr, size_t size);
+
+/**
+ * Give the memory cached by the calling thread back to the system, except
+ * for a few blocks of each size class, and account the allocations done by
+ * the thread in the global counters (see oscap_alloc_memusage). Called at
+ * the end of every probe request.
+ */
+void SEXP_pool_release(void);
+
+#endif /* _SEXP_POOL_H */
@@ -56,6 +56,7 @@ typedef struct {
 #define SEXP_VALP_HDR(p) ((SEXP_valhdr_t *)(((uintptr_t)(p)) & SEXP_VALP_MASK))
 
 int       SEXP_val_new (SEXP_val_t *dst, size_t vmemsize, SEXP_valtype_t type);
+void      SEXP_val_free (SEXP_val_t *dsc);
 void      SEXP_val_dsc (SEXP_val_t *dst, uintptr_t ptr);
 uintptr_t SEXP_val_ptr (SEXP_val_t *dsc);
 
@@ -116,9 +117,13 @@ void      SEXP_rawval_lblk_free (uintptr_t lblkp, void (*func) (SEXP_t *));
 void      SEXP_rawval_lblk_free1 (uintptr_t lblkp, void (*func) (SEXP_t *));
 
 #define SEXP_LBLK_ALIGN (16 > sizeof(void *) ? 16 : sizeof(void *))
+#define SEXP_LBLK_SIZE(sz) (sizeof(uintptr_t) + (2 * sizeof(uint16_t)) + (sizeof(SEXP_t) * (1 << (sz))))
 #define SEXP_LBLKP_MASK (UINTPTR_MAX << 4)
 #define SEXP_LBLKS_MASK 0x0f
 
+#define SEXP_LBLK_INITSZ  2  /* the first block of a list has room for 4 members */
+#define SEXP_LBLK_CONTMAX 15 /* lists up to 2^15 members are kept in one block */
+
 #define SEXP_VALP_LBLK(valp) ((struct SEXP_val_lblk *)((uintptr_t)(valp) & SEXP_LBLKP_MASK))
 
 uintptr_t SEXP_rawval_copy(uintptr_t s_valp);
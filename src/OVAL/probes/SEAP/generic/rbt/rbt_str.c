@@ -336,11 +336,14 @@ int rbt_str_del(rbt_t *rbt, const char *key, void **n)
                  */
 		if (rbt_node_ptr(fake._chld[RBT_NODE_SR]) != h[0]
 				&& rbt_node_getcolor(h[0]) != RBT_NODE_CR) {
+			rbt_wunlock(rbt);
 			return -1;
 		}
                 if (n != NULL)
                         *n = rbt_str_node(save)->data;
 
+                /* the key is owned by the tree, see rbt_str_free */
+                free(rbt_str_node(save)->key);
                 rbt_str_node(save)->data = rbt_str_node(h[0])->data;
                 rbt_str_node(save)->key  = rbt_str_node(h[0])->key;
 
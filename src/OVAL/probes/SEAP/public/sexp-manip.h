@@ -299,7 +299,9 @@ OSCAP_API char  *SEXP_string_cstrp (const SEXP_t *s_exp);
  * Get a C substring from a sexp object.
  * @param s_sexp the queried sexp object
  * @param beg the position of the fisrt character of the substring
- * @param len the length of the substring
+ * @param len the length of the substring, 0 for the rest of the string
+ * @note Up to openscap 1.3.2, a length of 0 returned NULL instead of
+ * the rest of the string.
  */
 OSCAP_API char *SEXP_string_subcstr (const SEXP_t *s_exp, size_t beg, size_t len);
 
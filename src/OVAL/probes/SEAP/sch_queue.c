@@ -25,6 +25,7 @@
 #endif
 
 #include <stdlib.h>
+#include <pthread.h>
 
 #include "_sexp-types.h"
 #include "_seap-types.h"
@@ -35,21 +36,166 @@
 #include "oval_definitions.h"
 
 
+#define SCH_QUEUE_SPIN 256 /* attempts to take a packet before going to sleep */
+
+static void sch_packetq_init(sch_packetq_t *queue)
+{
+	queue->stub.next = NULL;
+	queue->first = &queue->stub;
+	queue->last = &queue->stub;
+	queue->waiters = 0;
+	pthread_mutex_init(&queue->mutex, NULL);
+	pthread_cond_init(&queue->cond, NULL);
+}
+
+/* The receiving thread may be cancelled while it sleeps. */
+static void sch_packetq_unlock(void *mutex)
+{
+	pthread_mutex_unlock((pthread_mutex_t *)mutex);
+}
+
+#if defined(HAVE_ATOMIC_BUILTINS)
+static void sch_packetq_link(sch_packetq_t *queue, SEAP_packet_t *packet)
+{
+	SEAP_packet_t *prev;
+
+	packet->next = NULL;
+	prev = __atomic_exchange_n(&queue->last, packet, __ATOMIC_SEQ_CST);
+	/* The packet isn't reachable by the receiver until it's linked here. */
+	__atomic_store_n(&prev->next, packet, __ATOMIC_SEQ_CST);
+}
+
+static SEAP_packet_t *sch_packetq_tryget(sch_packetq_t *queue)
+{
+	SEAP_packet_t *first = queue->first;
+	SEAP_packet_t *next = __atomic_load_n(&first->next, __ATOMIC_SEQ_CST);
+
+	if (first == &queue->stub) {
+		if (next == NULL)
+			return NULL;
+		queue->first = first = next;
+		next = __atomic_load_n(&first->next, __ATOMIC_SEQ_CST);
+	}
+	if (next != NULL) {
+		queue->first = next;
+		return first;
+	}
+	/* Some sender has already replaced the last packet but hasn't linked it yet. */
+	if (first != __atomic_load_n(&queue->last, __ATOMIC_SEQ_CST))
+		return NULL;
+	/* The last packet can be taken out only if there's something behind it. */
+	sch_packetq_link(queue, &queue->stub);
+	next = __atomic_load_n(&first->next, __ATOMIC_SEQ_CST);
+	if (next != NULL) {
+		queue->first = next;
+		return first;
+	}
+	return NULL;
+}
+
+static void sch_packetq_put(sch_packetq_t *queue, SEAP_packet_t *packet)
+{
+	sch_packetq_link(queue, packet);
+	/*
+	 * The receiver announces itself before it checks the queue for the
+	 * last time, so either it finds the packet or it's counted here.
+	 */
+	if (__atomic_load_n(&queue->waiters, __ATOMIC_SEQ_CST) > 0) {
+		pthread_mutex_lock(&queue->mutex);
+		pthread_cond_signal(&queue->cond);
+		pthread_mutex_unlock(&queue->mutex);
+	}
+}
+
+static SEAP_packet_t *sch_packetq_get(sch_packetq_t *queue)
+{
+	SEAP_packet_t *packet;
+	int spin;
+
+	/* Replies of the probes usually come soon, don't sleep right away. */
+	for (spin = 0; spin < SCH_QUEUE_SPIN; ++spin) {
+		if ((packet = sch_packetq_tryget(queue)) != NULL)
+			return packet;
+	}
+
+	pthread_mutex_lock(&queue->mutex);
+	pthread_cleanup_push(sch_packetq_unlock, &queue->mutex);
+	__atomic_add_fetch(&queue->waiters, 1, __ATOMIC_SEQ_CST);
+	while ((packet = sch_packetq_tryget(queue)) == NULL)
+		pthread_cond_wait(&queue->cond, &queue->mutex);
+	__atomic_sub_fetch(&queue->waiters, 1, __ATOMIC_SEQ_CST);
+	pthread_cleanup_pop(1);
+
+	return packet;
+}
+#else
+/* Without the atomic builtins the links are guarded by the mutex. */
+static SEAP_packet_t *sch_packetq_tryget_locked(sch_packetq_t *queue)
+{
+	SEAP_packet_t *packet = queue->stub.next;
+
+	if (packet != NULL) {
+		queue->stub.next = packet->next;
+		if (queue->last == packet)
+			queue->last = &queue->stub;
+	}
+	return packet;
+}
+
+static SEAP_packet_t *sch_packetq_tryget(sch_packetq_t *queue)
+{
+	SEAP_packet_t *packet;
+
+	pthread_mutex_lock(&queue->mutex);
+	packet = sch_packetq_tryget_locked(queue);
+	pthread_mutex_unlock(&queue->mutex);
+
+	return packet;
+}
+
+static void sch_packetq_put(sch_packetq_t *queue, SEAP_packet_t *packet)
+{
+	packet->next = NULL;
+	pthread_mutex_lock(&queue->mutex);
+	queue->last->next = packet;
+	queue->last = packet;
+	pthread_cond_signal(&queue->cond);
+	pthread_mutex_unlock(&queue->mutex);
+}
+
+static SEAP_packet_t *sch_packetq_get(sch_packetq_t *queue)
+{
+	SEAP_packet_t *packet;
+
+	pthread_mutex_lock(&queue->mutex);
+	pthread_cleanup_push(sch_packetq_unlock, &queue->mutex);
+	while ((packet = sch_packetq_tryget_locked(queue)) == NULL)
+		pthread_cond_wait(&queue->cond, &queue->mutex);
+	pthread_cleanup_pop(1);
+
+	return packet;
+}
+#endif /* HAVE_ATOMIC_BUILTINS */
+
+static void sch_packetq_destroy(sch_packetq_t *queue)
+{
+	SEAP_packet_t *packet;
+
+	while ((packet = sch_packetq_tryget(queue)) != NULL)
+		SEAP_packet_discard(packet);
+
+	pthread_cond_destroy(&queue->cond);
+	pthread_mutex_destroy(&queue->mutex);
+}
+
 int sch_queue_connect(SEAP_desc_t *desc)
 {
 	sch_queuedata_t *data = malloc(sizeof(sch_queuedata_t));
 
-	data->from_probe_queue = oscap_queue_new();
-	data->from_probe_cnt = 0;
-	pthread_cond_init(&data->from_probe_cond, NULL);
-	pthread_mutex_init(&data->from_probe_mutex, NULL);
-
-	data->to_probe_queue = oscap_queue_new();
-	data->to_probe_cnt = 0;
-	pthread_cond_init(&data->to_probe_cond, NULL);
-	pthread_mutex_init(&data->to_probe_mutex, NULL);
+	sch_packetq_init(&data->from_probe);
+	sch_packetq_init(&data->to_probe);
 
-	data->parent_thread_id = pthread_self();
+	data->parent_desc = desc;
 
 	struct probe_common_main_argument *arg = malloc(sizeof(struct probe_common_main_argument));
 	arg->subtype = desc->subtype;
@@ -68,59 +214,24 @@ int sch_queue_connect(SEAP_desc_t *desc)
 	return 0;
 }
 
-SEXP_t *sch_queue_recvsexp(SEAP_desc_t *desc)
+SEAP_packet_t *sch_queue_recvpacket(SEAP_desc_t *desc)
 {
 	sch_queuedata_t *data = (sch_queuedata_t *)desc->scheme_data;
-	struct oscap_queue *queue;
-	pthread_mutex_t *mutex;
-	pthread_cond_t *cond;
-	int *cnt;
-	if (pthread_equal(pthread_self(), data->parent_thread_id)) {
-		queue = data->from_probe_queue;
-		mutex = &data->from_probe_mutex;
-		cond = &data->from_probe_cond;
-		cnt = &data->from_probe_cnt;
-	} else {
-		queue = data->to_probe_queue;
-		mutex = &data->to_probe_mutex;
-		cond = &data->to_probe_cond;
-		cnt = &data->to_probe_cnt;
-	}
-	pthread_mutex_lock(mutex);
-	while (*cnt == 0) {
-		pthread_cond_wait(cond, mutex);
-	}
-	SEXP_t *sexp = oscap_queue_remove(queue);
-	(*cnt)--;
-	pthread_mutex_unlock(mutex);
-	return sexp;
+
+	if (desc == data->parent_desc)
+		return sch_packetq_get(&data->from_probe);
+	else
+		return sch_packetq_get(&data->to_probe);
 }
 
-ssize_t sch_queue_sendsexp(SEAP_desc_t *desc, SEXP_t *sexp, uint32_t flags)
+int sch_queue_sendpacket(SEAP_desc_t *desc, SEAP_packet_t *packet)
 {
 	sch_queuedata_t *data = (sch_queuedata_t *) desc->scheme_data;
-	struct oscap_queue *queue;
-	pthread_mutex_t *mutex;
-	pthread_cond_t *cond;
-	int *cnt;
-	if (pthread_equal(pthread_self(), data->parent_thread_id)) {
-		queue = data->to_probe_queue;
-		mutex = &data->to_probe_mutex;
-		cond = &data->to_probe_cond;
-		cnt = &data->to_probe_cnt;
-	} else {
-		queue = data->from_probe_queue;
-		mutex = &data->from_probe_mutex;
-		cond = &data->from_probe_cond;
-		cnt = &data->from_probe_cnt;
-	}
-	/* We want to send a SEXP, but the receiver expects a list of SEXPs. */
-	SEXP_t *sexp_list = SEXP_list_new(sexp, NULL);
-	pthread_mutex_lock(mutex);
-	oscap_queue_add(queue, (void *) sexp_list);
-	(*cnt)++;
-	pthread_cond_broadcast(cond);
-	pthread_mutex_unlock(mutex);
+
+	if (desc == data->parent_desc)
+		sch_packetq_put(&data->to_probe, packet);
+	else
+		sch_packetq_put(&data->from_probe, packet);
 	return 0;
 }
 
@@ -138,7 +249,7 @@ int sch_queue_close(SEAP_desc_t *desc, uint32_t flags)
 	if (ret != 0) {
 		dE("Return code of %s_probe main thread is %d.", subtype_str, ret);
 	}
-	oscap_queue_free(data->to_probe_queue, NULL);
-	oscap_queue_free(data->from_probe_queue, NULL);
+	sch_packetq_destroy(&data->to_probe);
+	sch_packetq_destroy(&data->from_probe);
 	return ret;
 }
@@ -23,26 +23,48 @@
 #ifndef OPENSCAP_SCH_QUEUE_H
 #define OPENSCAP_SCH_QUEUE_H
 
+#include <pthread.h>
 #include "util.h"
-#include "oscap_queue.h"
+#include "_seap-packet.h"
 #include "seap-descriptor.h"
 
+/*
+ * Unbounded queue of the packets passed from one side of the channel
+ * to the other. Packets are linked through their next pointer and put
+ * into the queue without any locking, any number of threads can send
+ * at the same time. Only one thread at a time takes the packets out,
+ * the receiver holds the read lock of its descriptor. The mutex and
+ * the condition are used only to sleep while the queue is empty.
+ */
+typedef struct {
+	SEAP_packet_t *first;    /**< receiving end, owned by the receiver */
+	SEAP_packet_t *last;     /**< sending end */
+	SEAP_packet_t stub;      /**< keeps the queue non-empty */
+	uint32_t waiters;        /**< number of receivers sleeping on cond */
+	pthread_mutex_t mutex;
+	pthread_cond_t cond;
+} sch_packetq_t;
+
 typedef struct {
 	pthread_t probe_thread_id;
-	pthread_t parent_thread_id;
-	struct oscap_queue *to_probe_queue;
-	struct oscap_queue *from_probe_queue;
-	pthread_cond_t to_probe_cond;
-	pthread_mutex_t to_probe_mutex;
-	pthread_cond_t from_probe_cond;
-	pthread_mutex_t from_probe_mutex;
-	int to_probe_cnt;
-	int from_probe_cnt;
+	SEAP_desc_t *parent_desc; /**< descriptor of the library side of the queue */
+	sch_packetq_t to_probe;
+	sch_packetq_t from_probe;
 } sch_queuedata_t;
 
 int sch_queue_connect(SEAP_desc_t *desc);
-ssize_t sch_queue_sendsexp(SEAP_desc_t *desc, SEXP_t *sexp, uint32_t flags);
-SEXP_t *sch_queue_recvsexp(SEAP_desc_t *desc);
+
+/**
+ * Pass a packet to the other side of the channel. The packet and the
+ * data it references are owned by the receiver from now on.
+ */
+int sch_queue_sendpacket(SEAP_desc_t *desc, SEAP_packet_t *packet);
+
+/**
+ * Take the oldest packet sent by the other side of the channel, wait
+ * for one if there's none yet.
+ */
+SEAP_packet_t *sch_queue_recvpacket(SEAP_desc_t *desc);
 int sch_queue_close(SEAP_desc_t *desc, uint32_t flags);
 
 #endif /* OPENSCAP_SCH_QUEUE_H */
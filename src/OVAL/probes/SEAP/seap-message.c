@@ -53,7 +53,7 @@ SEAP_msg_t *SEAP_msg_clone (SEAP_msg_t *msg)
 	new->attrs = malloc(sizeof(SEAP_attr_t) * new->attrs_cnt);
 
         for (i = 0; i < new->attrs_cnt; ++i) {
-                new->attrs[i].name  = strdup (msg->attrs[i].name);
+                new->attrs[i].name  = msg->attrs[i].name != NULL ? strdup (msg->attrs[i].name) : NULL;
                 new->attrs[i].value = SEXP_ref (msg->attrs[i].value);
         }
 
@@ -126,6 +126,23 @@ int SEAP_msgattr_set (SEAP_msg_t *msg, const char *attr, SEXP_t *value)
         return (0);
 }
 
+SEXP_t *SEAP_msgattr_get (SEAP_msg_t *msg, const char *name)
+{
+        uint16_t i;
+
+        _A(msg  != NULL);
+        _A(name != NULL);
+
+        for (i = 0; i < msg->attrs_cnt; ++i) {
+                if (msg->attrs[i].name == NULL)
+                        continue;
+                if (strcmp (name, msg->attrs[i].name) == 0)
+                        return (msg->attrs[i].value != NULL ? SEXP_ref (msg->attrs[i].value) : NULL);
+        }
+
+        return (NULL);
+}
+
 bool SEAP_msgattr_exists (SEAP_msg_t *msg, const char *name)
 {
         uint16_t i;
@@ -137,6 +154,8 @@ bool SEAP_msgattr_exists (SEAP_msg_t *msg, const char *name)
 
         /* FIXME: this is stupid */
         for (i = 0; i < msg->attrs_cnt; ++i) {
+                if (msg->attrs[i].name == NULL)
+                        continue;
                 dD("%s ?= %s", name, msg->attrs[i].name);
                 if (strcmp (name, msg->attrs[i].name) == 0)
                         return (true);
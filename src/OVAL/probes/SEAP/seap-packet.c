@@ -27,6 +27,8 @@
 #include <stdlib.h>
 #include <string.h>
 #include <errno.h>
+#include <stdbool.h>
+#include <pthread.h>
 
 #include "generic/common.h"
 #include "public/sexp-manip.h"
@@ -51,6 +53,33 @@ void SEAP_packet_free (SEAP_packet_t *packet)
 	free(packet);
 }
 
+void SEAP_packet_discard (SEAP_packet_t *packet)
+{
+        uint16_t i;
+
+        switch (packet->type) {
+        case SEAP_PACKET_MSG:
+                for (i = 0; i < packet->data.msg.attrs_cnt; ++i) {
+                        free(packet->data.msg.attrs[i].name);
+                        SEXP_free (packet->data.msg.attrs[i].value);
+                }
+                free(packet->data.msg.attrs);
+                SEXP_free (packet->data.msg.sexp);
+                break;
+        case SEAP_PACKET_CMD:
+                SEXP_free (packet->data.cmd.args);
+                break;
+        case SEAP_PACKET_ERR:
+                SEXP_free (packet->data.err.data);
+                break;
+        case SEAP_PACKET_RAW:
+                SEXP_free (packet->data.raw);
+                break;
+        }
+
+        SEAP_packet_free (packet);
+}
+
 void *SEAP_packet_settype (SEAP_packet_t *packet, uint8_t type)
 {
         _A(packet != NULL);
@@ -596,6 +625,116 @@ static SEXP_t *SEAP_packet2sexp (SEAP_packet_t *packet)
         return (sexp);
 }
 
+static pthread_once_t SEAP_packet_sexp_once = PTHREAD_ONCE_INIT;
+static bool           SEAP_packet_sexp_enabled = false;
+
+static void SEAP_packet_sexp_init (void)
+{
+        /* Allows to compare the performance with the S-exp transport */
+        if (getenv ("OSCAP_SEAP_PACKET_SEXP") != NULL)
+                SEAP_packet_sexp_enabled = true;
+}
+
+/*
+ * Copy of the packet for the receiver. The S-exps are shared by reference
+ * and the copy looks exactly like the packet the receiver would parse out
+ * of the S-exp form of the packet.
+ */
+static SEAP_packet_t *SEAP_packet_clone (SEAP_packet_t *packet)
+{
+        SEAP_packet_t *copy;
+        SEAP_msg_t *msg;
+        uint16_t i;
+
+        copy = SEAP_packet_new ();
+        copy->type = packet->type;
+
+        switch (packet->type) {
+        case SEAP_PACKET_MSG:
+                msg = &(copy->data.msg);
+                msg->id        = packet->data.msg.id;
+                msg->attrs_cnt = packet->data.msg.attrs_cnt;
+                msg->attrs     = NULL;
+
+                if (msg->attrs_cnt > 0) {
+                        msg->attrs = malloc(sizeof(SEAP_attr_t) * msg->attrs_cnt);
+
+                        if (msg->attrs == NULL)
+                                goto fail;
+
+                        for (i = 0; i < msg->attrs_cnt; ++i) {
+                                msg->attrs[i].name  = strdup(packet->data.msg.attrs[i].name);
+
+                                if (msg->attrs[i].name == NULL) {
+                                        while (i-- > 0) {
+                                                free(msg->attrs[i].name);
+                                                SEXP_free (msg->attrs[i].value);
+                                        }
+                                        free(msg->attrs);
+                                        goto fail;
+                                }
+
+                                msg->attrs[i].value = packet->data.msg.attrs[i].value != NULL ?
+                                        SEXP_ref (packet->data.msg.attrs[i].value) : NULL;
+                        }
+                }
+
+                if (packet->data.msg.sexp != NULL)
+                        msg->sexp = SEXP_ref (packet->data.msg.sexp);
+                else
+                        msg->sexp = SEXP_list_new (NULL);
+                break;
+        case SEAP_PACKET_CMD:
+                copy->data.cmd = packet->data.cmd;
+                copy->data.cmd.flags &= SEAP_CMDFLAG_REPLY | SEAP_CMDFLAG_SYNC;
+
+                if (!(copy->data.cmd.flags & SEAP_CMDFLAG_REPLY))
+                        copy->data.cmd.rid = 0;
+                if (packet->data.cmd.args != NULL)
+                        copy->data.cmd.args = SEXP_ref (packet->data.cmd.args);
+                break;
+        case SEAP_PACKET_ERR:
+                copy->data.err = packet->data.err;
+
+                if (packet->data.err.data != NULL)
+                        copy->data.err.data = SEXP_ref (packet->data.err.data);
+                break;
+        default:
+                SEAP_packet_free (copy);
+                errno = EINVAL;
+                return (NULL);
+        }
+
+        return (copy);
+fail:
+        SEAP_packet_free (copy);
+        errno = ENOMEM;
+        return (NULL);
+}
+
+/*
+ * Packet for the receiver in the S-exp form. It's the way the packets
+ * were transported before they were passed by reference.
+ */
+static SEAP_packet_t *SEAP_packet_sexp (SEAP_packet_t *packet)
+{
+        SEAP_packet_t *raw;
+        SEXP_t *packet_sexp;
+
+        packet_sexp = SEAP_packet2sexp (packet);
+
+        if (packet_sexp == NULL)
+                return (NULL);
+
+        raw = SEAP_packet_new ();
+        raw->type = SEAP_PACKET_RAW;
+        /* The receiver expects a list of packets. */
+        raw->data.raw = SEXP_list_new (packet_sexp, NULL);
+        SEXP_free (packet_sexp);
+
+        return (raw);
+}
+
 int SEAP_packet_recv (SEAP_CTX_t *ctx, int sd, SEAP_packet_t **packet)
 {
         SEAP_desc_t *dsc;
@@ -658,7 +797,15 @@ int SEAP_packet_recv (SEAP_CTX_t *ctx, int sd, SEAP_packet_t **packet)
         }
 eloop_exit:
 
-	sexp_buffer = sch_queue_recvsexp(dsc);
+	_packet = sch_queue_recvpacket(dsc);
+
+	if (_packet->type != SEAP_PACKET_RAW) {
+		(*packet) = _packet;
+		return (0);
+	}
+
+	sexp_buffer = _packet->data.raw;
+	SEAP_packet_free(_packet);
 	SEXP_VALIDATE(sexp_buffer);
 
 	(*packet) = NULL;
@@ -844,49 +991,37 @@ int SEAP_packet_recv_bytype (SEAP_CTX_t *ctx, int sd, SEAP_packet_t **packet, ui
 
 int SEAP_packet_send (SEAP_CTX_t *ctx, int sd, SEAP_packet_t *packet)
 {
-        SEXP_t *packet_sexp;
+        SEAP_packet_t *queued;
         SEAP_desc_t *dsc;
-        int ret;
 
-        ret = -1;
         dsc = SEAP_desc_get (ctx->sd_table, sd);
 
         if (dsc == NULL)
                 return (-1);
 
-        packet_sexp = SEAP_packet2sexp (packet);
+        pthread_once (&SEAP_packet_sexp_once, &SEAP_packet_sexp_init);
 
-        if (packet_sexp == NULL) {
-                dD("Can't convert S-exp to packet");
+        if (SEAP_packet_sexp_enabled)
+                queued = SEAP_packet_sexp (packet);
+        else
+                queued = SEAP_packet_clone (packet);
+
+        if (queued == NULL) {
+                dD("Can't copy the packet for the receiver");
                 return (-1);
         }
 
-	if (DESC_WLOCK(dsc) == 1) {
-                ret = 0;
-
-		if (sch_queue_sendsexp(dsc, packet_sexp, 0) < 0) {
-                        ret = -1;
-
-                        protect_errno {
-                                dD("FAIL: errno=%u, %s.", errno, strerror (errno));
-                        }
+        /* The queue doesn't need the write lock, any thread can send. */
+        if (sch_queue_sendpacket(dsc, queued) < 0) {
+                protect_errno {
+                        dD("FAIL: errno=%u, %s.", errno, strerror (errno));
+                        SEAP_packet_discard (queued);
                 }
 
-		if (DESC_WUNLOCK(dsc) != 1) {
-			dE("DESC_WUNLOCK failed to unlock a mutex: %s", strerror(errno));
-			ret = -1;
-		}
-	} else {
-		dE("DESC_WLOCK failed to lock a mutex: %s", strerror(errno));
-		ret = -1;
-	}
-
-
-        protect_errno {
-                SEXP_free (packet_sexp);
+                return (-1);
         }
 
-        return (ret);
+        return (0);
 }
 
 int SEAP_packet_enqueue (SEAP_CTX_t *ctx, int sd, SEAP_packet_t *packet)
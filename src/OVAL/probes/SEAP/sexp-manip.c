@@ -841,11 +841,10 @@ char *SEXP_string_subcstr (const SEXP_t *s_exp, size_t beg, size_t len)
 
         s_len -= beg;
 
-        if (s_len > len)
+        if (len > 0 && s_len > len)
                 s_len = len;
 
         if (s_len > 0) {
-                s_len = v_dsc.hdr->size / sizeof (char);
 		s_str = malloc(s_len + 1);
 
                 memcpy (s_str, ((char *) v_dsc.mem) + beg, sizeof (char) * s_len);
@@ -1219,8 +1218,7 @@ SEXP_t *SEXP_list_add (SEXP_t *list, const SEXP_t *s_exp)
                 list->s_valp = uptr;
                 SEXP_val_dsc (&v_dsc, list->s_valp);
 
-                uptr = SEXP_rawval_lblk_last ((uintptr_t)SEXP_LCASTP(v_dsc.mem)->b_addr);
-                SEXP_rawval_lblk_add1 (uptr, s_exp);
+                SEXP_LCASTP(v_dsc.mem)->b_addr = (void *)SEXP_rawval_lblk_add ((uintptr_t)SEXP_LCASTP(v_dsc.mem)->b_addr, s_exp);
         } else {
                 /*
                  * Only one reference exists to the value.
@@ -1371,6 +1369,80 @@ void SEXP_list_it_free(SEXP_list_it *it)
 	free(it);
 }
 
+static void SEXP_list_it_init(SEXP_list_it *it, SEXP_val_t *v_dsc)
+{
+        it->block = SEXP_LCASTP(v_dsc->mem)->b_addr;
+        it->index = SEXP_LCASTP(v_dsc->mem)->offset;
+        it->count = it->block != NULL ? it->block->real : 0;
+}
+
+/*
+ * Look up an attribute in an attribute list `(name :attr1 val1 flag ...)'
+ * without creating a reference to each member. Returns the member that
+ * follows `:name', or the `name' flag itself if `flag' is true.
+ */
+static SEXP_t *SEXP_list_attr_lookup(const SEXP_t *list, const char *name, bool flag)
+{
+        SEXP_val_t   v_dsc, m_dsc;
+        SEXP_list_it it;
+        SEXP_t      *memb;
+        size_t       nlen;
+
+        if (list == NULL || name == NULL) {
+                errno = EFAULT;
+                return (NULL);
+        }
+
+        SEXP_VALIDATE(list);
+        SEXP_val_dsc (&v_dsc, list->s_valp);
+
+        if (v_dsc.type != SEXP_VALTYPE_LIST) {
+                errno = EINVAL;
+                return (NULL);
+        }
+
+        nlen = strlen (name);
+        SEXP_list_it_init (&it, &v_dsc);
+
+        /* skip the name of the entity */
+        if (SEXP_list_it_next (&it) == NULL)
+                return (NULL);
+
+        while ((memb = SEXP_list_it_next (&it)) != NULL) {
+                SEXP_val_dsc (&m_dsc, memb->s_valp);
+
+                if (m_dsc.type != SEXP_VALTYPE_STRING)
+                        continue;
+
+                if (m_dsc.hdr->size > 0 && ((char *)m_dsc.mem)[0] == ':') {
+                        if (m_dsc.hdr->size == nlen + 1 &&
+                            memcmp ((char *)m_dsc.mem + 1, name, nlen) == 0)
+                                return (flag ? memb : SEXP_list_it_next (&it));
+
+                        /* skip the value */
+                        if (SEXP_list_it_next (&it) == NULL)
+                                break;
+                } else if (flag && m_dsc.hdr->size == nlen &&
+                           memcmp (m_dsc.mem, name, nlen) == 0) {
+                        return (memb);
+                }
+        }
+
+        return (NULL);
+}
+
+SEXP_t *SEXP_list_attrval(const SEXP_t *list, const char *name)
+{
+        SEXP_t *val = SEXP_list_attr_lookup (list, name, false);
+
+        return (val == NULL ? NULL : SEXP_ref (val));
+}
+
+bool SEXP_list_attrexists(const SEXP_t *list, const char *name)
+{
+        return (SEXP_list_attr_lookup (list, name, true) != NULL);
+}
+
 SEXP_t *SEXP_list_sort(SEXP_t *list, int(*compare)(const SEXP_t *, const SEXP_t *))
 {
         SEXP_val_t v_dsc;
@@ -1638,16 +1710,16 @@ SEXP_t *SEXP_unref (SEXP_t *s_exp_o)
 
                         switch (v_dsc.type) {
                         case SEXP_VALTYPE_STRING:
-				oscap_aligned_free(v_dsc.hdr);
+				SEXP_val_free(&v_dsc);
                                 break;
                         case SEXP_VALTYPE_NUMBER:
-				oscap_aligned_free(v_dsc.hdr);
+				SEXP_val_free(&v_dsc);
                                 break;
                         case SEXP_VALTYPE_LIST:
                                 if (SEXP_LCASTP(v_dsc.mem)->b_addr != NULL)
                                         SEXP_rawval_lblk_free ((uintptr_t)SEXP_LCASTP(v_dsc.mem)->b_addr, SEXP_free_lmemb);
 
-				oscap_aligned_free(v_dsc.hdr);
+				SEXP_val_free(&v_dsc);
                                 break;
                         default:
                                 abort ();
@@ -1833,16 +1905,16 @@ static void SEXP_free_lmemb (SEXP_t *s_exp)
                 if (SEXP_rawval_decref (s_exp->s_valp)) {
                         switch (v_dsc.type) {
                         case SEXP_VALTYPE_STRING:
-				oscap_aligned_free(v_dsc.hdr);
+				SEXP_val_free(&v_dsc);
                                 break;
                         case SEXP_VALTYPE_NUMBER:
-				oscap_aligned_free(v_dsc.hdr);
+				SEXP_val_free(&v_dsc);
                                 break;
                         case SEXP_VALTYPE_LIST:
                                 if (SEXP_LCASTP(v_dsc.mem)->b_addr != NULL)
                                         SEXP_rawval_lblk_free ((uintptr_t)SEXP_LCASTP(v_dsc.mem)->b_addr, SEXP_free_lmemb);
 
-				oscap_aligned_free(v_dsc.hdr);
+				SEXP_val_free(&v_dsc);
                                 break;
                         default:
                                 abort ();
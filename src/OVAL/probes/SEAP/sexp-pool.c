@@ -0,0 +1,191 @@
+/*
+ * Copyright 2026 Red Hat Inc., Durham, North Carolina.
+ * All Rights Reserved.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+#include <pthread.h>
+
+#include "_sexp-pool.h"
+#include "common/util.h"
+#include "common/memusage.h"
+#include "debug_priv.h"
+
+#define SEXP_POOL_CLASSES   (SEXP_POOL_MAXSIZE / SEXP_POOL_ALIGN)
+#define SEXP_POOL_CLASS_KEEP 64  /* cached blocks of one class kept after a trim */
+
+#define SEXP_POOL_CLASS(size)     (((size) + SEXP_POOL_ALIGN - 1) / SEXP_POOL_ALIGN - 1)
+#define SEXP_POOL_CLASS_SIZE(cls) (((cls) + 1) * SEXP_POOL_ALIGN)
+
+struct SEXP_pool_block {
+	struct SEXP_pool_block *next;
+};
+
+typedef struct {
+	struct SEXP_pool_block *head[SEXP_POOL_CLASSES];
+	uint32_t                count[SEXP_POOL_CLASSES];
+	size_t                  cached; /* bytes on the free lists */
+	struct alloc_memusage   stats; /* not yet accounted in the global counters */
+} SEXP_pool_t;
+
+static pthread_key_t  SEXP_pool_key;
+static pthread_once_t SEXP_pool_once = PTHREAD_ONCE_INIT;
+static bool           SEXP_pool_enabled = false;
+
+static void SEXP_pool_trim(SEXP_pool_t *pool, uint32_t keep)
+{
+	size_t cls;
+
+	for (cls = 0; cls < SEXP_POOL_CLASSES; ++cls) {
+		while (pool->count[cls] > keep) {
+			struct SEXP_pool_block *block = pool->head[cls];
+
+			pool->head[cls] = block->next;
+			pool->count[cls]--;
+			pool->cached -= SEXP_POOL_CLASS_SIZE(cls);
+			pool->stats.mu_cached -= SEXP_POOL_CLASS_SIZE(cls);
+			pool->stats.mu_frees++;
+			oscap_aligned_free(block);
+		}
+	}
+
+	oscap_alloc_memusage_add(&pool->stats);
+	memset(&pool->stats, 0, sizeof pool->stats);
+}
+
+static void SEXP_pool_destroy(void *arg)
+{
+	SEXP_pool_t *pool = (SEXP_pool_t *)arg;
+
+	SEXP_pool_trim(pool, 0);
+	free(pool);
+}
+
+static void SEXP_pool_init(void)
+{
+	const char *env = getenv("OSCAP_SEXP_POOL");
+
+	if (env != NULL && strcmp(env, "0") == 0) {
+		dD("The S-exp pool is disabled.");
+		return;
+	}
+	if (pthread_key_create(&SEXP_pool_key, &SEXP_pool_destroy) != 0) {
+		dW("Can't create the S-exp pool key, the pool is disabled.");
+		return;
+	}
+	SEXP_pool_enabled = true;
+}
+
+static SEXP_pool_t *SEXP_pool_get(void)
+{
+	SEXP_pool_t *pool;
+
+	pthread_once(&SEXP_pool_once, &SEXP_pool_init);
+
+	if (!SEXP_pool_enabled)
+		return (NULL);
+
+	pool = pthread_getspecific(SEXP_pool_key);
+
+	if (pool == NULL) {
+		pool = calloc(1, sizeof(SEXP_pool_t));
+
+		if (pool != NULL && pthread_setspecific(SEXP_pool_key, pool) != 0) {
+			free(pool);
+			pool = NULL;
+		}
+	}
+
+	return (pool);
+}
+
+void *SEXP_pool_alloc(size_t size)
+{
+	SEXP_pool_t *pool;
+	size_t cls;
+
+	if (size > SEXP_POOL_MAXSIZE)
+		return oscap_aligned_malloc(size, SEXP_POOL_ALIGN);
+
+	/*
+	 * Always allocate the whole size class, the block may end up
+	 * in a free list even if it wasn't allocated from the pool.
+	 */
+	cls  = SEXP_POOL_CLASS(size);
+	pool = SEXP_pool_get();
+
+	if (pool != NULL) {
+		struct SEXP_pool_block *block = pool->head[cls];
+
+		if (block != NULL) {
+			pool->head[cls] = block->next;
+			pool->count[cls]--;
+			pool->cached -= SEXP_POOL_CLASS_SIZE(cls);
+			pool->stats.mu_cached -= SEXP_POOL_CLASS_SIZE(cls);
+			pool->stats.mu_reused++;
+			return (block);
+		}
+		pool->stats.mu_allocs++;
+	}
+
+	return oscap_aligned_malloc(SEXP_POOL_CLASS_SIZE(cls), SEXP_POOL_ALIGN);
+}
+
+void SEXP_pool_free(void *ptr, size_t size)
+{
+	SEXP_pool_t *pool;
+	size_t cls;
+
+	if (ptr == NULL)
+		return;
+
+	if (size <= SEXP_POOL_MAXSIZE && (pool = SEXP_pool_get()) != NULL) {
+		struct SEXP_pool_block *block = (struct SEXP_pool_block *)ptr;
+
+		cls = SEXP_POOL_CLASS(size);
+		block->next = pool->head[cls];
+		pool->head[cls] = block;
+		pool->count[cls]++;
+		pool->cached += SEXP_POOL_CLASS_SIZE(cls);
+		pool->stats.mu_cached += SEXP_POOL_CLASS_SIZE(cls);
+
+		/*
+		 * Only the workers call SEXP_pool_release, keep the other
+		 * threads from holding on to everything they have ever freed.
+		 */
+		if (pool->cached > SEXP_POOL_CACHE_MAX)
+			SEXP_pool_trim(pool, SEXP_POOL_CLASS_KEEP);
+		return;
+	}
+
+	oscap_aligned_free(ptr);
+}
+
+void SEXP_pool_release(void)
+{
+	SEXP_pool_t *pool = SEXP_pool_get();
+
+	if (pool != NULL)
+		SEXP_pool_trim(pool, SEXP_POOL_CLASS_KEEP);
+}
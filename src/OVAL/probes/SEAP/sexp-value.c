@@ -29,11 +29,12 @@
 
 #include "_sexp-atomic.h"
 #include "_sexp-value.h"
+#include "_sexp-pool.h"
 #include "debug_priv.h"
 
 int SEXP_val_new (SEXP_val_t *dst, size_t vmemsize, SEXP_type_t type)
 {
-	void *s_val = oscap_aligned_malloc(sizeof(SEXP_valhdr_t) + vmemsize, SEXP_VALP_ALIGN);
+	void *s_val = SEXP_pool_alloc(sizeof(SEXP_valhdr_t) + vmemsize);
 
         SEXP_val_dsc (dst, (uintptr_t) s_val);
 
@@ -48,6 +49,11 @@ int SEXP_val_new (SEXP_val_t *dst, size_t vmemsize, SEXP_type_t type)
         return (0);
 }
 
+void SEXP_val_free (SEXP_val_t *dsc)
+{
+	SEXP_pool_free(dsc->hdr, sizeof(SEXP_valhdr_t) + dsc->hdr->size);
+}
+
 void SEXP_val_dsc (SEXP_val_t *dst, uintptr_t ptr)
 {
         dst->ptr  = ptr;
@@ -102,14 +108,33 @@ size_t SEXP_rawval_list_length (struct SEXP_val_list *list)
         return (length - list->offset);
 }
 
+/*
+ * Move the members of a full block to a new block twice
+ * the size. The block must not be shared with other lists.
+ */
+static uintptr_t SEXP_rawval_lblk_grow (uintptr_t lblkp)
+{
+        struct SEXP_val_lblk *lb_old, *lb_new;
+        uint8_t sz;
+
+        lb_old = SEXP_VALP_LBLK(lblkp);
+        sz     = lb_old->nxsz & SEXP_LBLKS_MASK;
+        lb_new = SEXP_VALP_LBLK(SEXP_rawval_lblk_new (sz + 1));
+
+        memcpy (lb_new->memb, lb_old->memb, sizeof (SEXP_t) * lb_old->real);
+        lb_new->real = lb_old->real;
+        lb_new->nxsz = (lb_old->nxsz & SEXP_LBLKP_MASK) | (lb_new->nxsz & SEXP_LBLKS_MASK);
+
+        SEXP_pool_free (lb_old, SEXP_LBLK_SIZE(sz));
+
+        return ((uintptr_t)lb_new);
+}
+
 uintptr_t SEXP_rawval_lblk_new (uint8_t sz)
 {
         _A(sz < 16);
 
-	struct SEXP_val_lblk *lblk = oscap_aligned_malloc(
-		sizeof(uintptr_t) + (2 * sizeof(uint16_t)) + (sizeof(SEXP_t) * (1 << sz)),
-		SEXP_LBLK_ALIGN
-	);
+	struct SEXP_val_lblk *lblk = SEXP_pool_alloc(SEXP_LBLK_SIZE(sz));
 
         lblk->nxsz = ((uintptr_t)(NULL) & SEXP_LBLKP_MASK) | ((uintptr_t)sz & SEXP_LBLKS_MASK);
         lblk->refs = 1;
@@ -181,7 +206,7 @@ uintptr_t SEXP_rawval_lblk_add (uintptr_t lblkp, const SEXP_t *s_exp)
         lblk = SEXP_VALP_LBLK(lblkp);
 
         if (lblk == NULL) {
-                lb_head = SEXP_rawval_lblk_new (1);
+                lb_head = SEXP_rawval_lblk_new (SEXP_LBLK_INITSZ);
                 lb_prev = lb_head;
         } else {
                 lb_head = lblkp;
@@ -227,6 +252,23 @@ uintptr_t SEXP_rawval_lblk_add (uintptr_t lblkp, const SEXP_t *s_exp)
         _A(lb_prev != 0);
         _A(lb_head != 0);
 
+        /*
+         * Lists which fit into one block are kept contiguous: when the
+         * block is full, the members are moved to a bigger one instead
+         * of chaining a new block. Only longer lists consist of more
+         * blocks.
+         */
+        if (SEXP_VALP_LBLK(lb_prev) == SEXP_VALP_LBLK(lb_head)) {
+                lblk = SEXP_VALP_LBLK(lb_head);
+
+                if (lblk->real == (1 << (lblk->nxsz & SEXP_LBLKS_MASK)) &&
+                    (lblk->nxsz & SEXP_LBLKS_MASK) < SEXP_LBLK_CONTMAX && lblk->refs < 2)
+                {
+                        lb_head = SEXP_rawval_lblk_grow (lb_head);
+                        lb_prev = lb_head;
+                }
+        }
+
         (void)SEXP_rawval_lblk_add1 (lb_prev, s_exp);
 
         return (lb_head);
@@ -444,12 +486,13 @@ uintptr_t SEXP_rawval_list_copy (uintptr_t s_valp)
 
 uintptr_t SEXP_rawval_lblk_copy (uintptr_t lblkp, uint16_t n_skip)
 {
-        struct SEXP_val_lblk *lb_new, *lb_old;
+        struct SEXP_val_lblk *lb_new, *lb_old, *lblk;
         uintptr_t lb_next;
         uintptr_t lb_head;
         uint16_t  off_n;  /* offset in the new block */
         uint16_t  off_o;  /* offset in the old block */
         uint8_t  cur_sz;  /* size of the new block */
+        size_t    count;  /* number of members to copy */
 
         lb_head = 0;
         off_n   = 0;
@@ -459,7 +502,18 @@ uintptr_t SEXP_rawval_lblk_copy (uintptr_t lblkp, uint16_t n_skip)
         if (lb_old == NULL)
                 return ((uintptr_t) NULL);
 
-        cur_sz  = 0;
+        /* Make the copy contiguous if it fits into one block */
+        count = 0;
+
+        for (lblk = lb_old; lblk != NULL; lblk = SEXP_VALP_LBLK(lblk->nxsz))
+                count += lblk->real;
+
+        count  = count > n_skip ? count - n_skip : 0;
+        cur_sz = 0;
+
+        while (cur_sz < SEXP_LBLK_CONTMAX && ((size_t)1 << cur_sz) < count)
+                ++cur_sz;
+
         lb_new  = (struct SEXP_val_lblk *)SEXP_rawval_lblk_new (cur_sz);
         lb_head = (uintptr_t)lb_new;
 
@@ -480,7 +534,10 @@ uintptr_t SEXP_rawval_lblk_copy (uintptr_t lblkp, uint16_t n_skip)
                  * allocate new block
                  */
                 if (lb_new->real >= (1 << (cur_sz))) {
-                        lb_next = SEXP_rawval_lblk_new (++cur_sz);
+                        if (cur_sz < SEXP_LBLK_CONTMAX)
+                                ++cur_sz;
+
+                        lb_next = SEXP_rawval_lblk_new (cur_sz);
                         lb_new->nxsz = (lb_next & SEXP_LBLKP_MASK) | (lb_new->nxsz & SEXP_LBLKS_MASK);
                         lb_new  = SEXP_VALP_LBLK(lb_next);
                         off_n   = 0;
@@ -519,7 +576,7 @@ void SEXP_rawval_lblk_free (uintptr_t lblkp, void (*func) (SEXP_t *))
                         func (lblk->memb + lblk->real);
                 }
 
-		oscap_aligned_free(lblk);
+		SEXP_pool_free(lblk, SEXP_LBLK_SIZE(lblk->nxsz & SEXP_LBLKS_MASK));
 
                 if (next != NULL)
                         SEXP_rawval_lblk_free ((uintptr_t)next, func);
@@ -540,7 +597,7 @@ void SEXP_rawval_lblk_free1 (uintptr_t lblkp, void (*func) (SEXP_t *))
                         func (lblk->memb + lblk->real);
                 }
 
-		oscap_aligned_free(lblk);
+		SEXP_pool_free(lblk, SEXP_LBLK_SIZE(lblk->nxsz & SEXP_LBLKS_MASK));
         }
 
         return;
@@ -71,118 +71,154 @@ int crapi_digest_fd (int fd, crapi_alg_t alg, void *dst, size_t *size)
         return (-1);
 }
 
-int crapi_mdigest_fd (int fd, int num, ... /* crapi_alg_t alg, void *dst, size_t *size, ...*/)
+static int crapi_ctbl_set (struct digest_ctbl_t *ctbl, crapi_alg_t alg)
+{
+        switch (alg) {
+        case CRAPI_DIGEST_MD5:
+                ctbl->init   = &crapi_md5_init;
+                ctbl->update = &crapi_md5_update;
+                ctbl->fini   = &crapi_md5_fini;
+                ctbl->free   = &crapi_md5_free;
+                break;
+        case CRAPI_DIGEST_SHA1:
+                ctbl->init   = &crapi_sha1_init;
+                ctbl->update = &crapi_sha1_update;
+                ctbl->fini   = &crapi_sha1_fini;
+                ctbl->free   = &crapi_sha1_free;
+                break;
+        case CRAPI_DIGEST_SHA224:
+                ctbl->init   = &crapi_sha224_init;
+                ctbl->update = &crapi_sha224_update;
+                ctbl->fini   = &crapi_sha224_fini;
+                ctbl->free   = &crapi_sha224_free;
+                break;
+        case CRAPI_DIGEST_SHA256:
+                ctbl->init   = &crapi_sha256_init;
+                ctbl->update = &crapi_sha256_update;
+                ctbl->fini   = &crapi_sha256_fini;
+                ctbl->free   = &crapi_sha256_free;
+                break;
+        case CRAPI_DIGEST_SHA384:
+                ctbl->init   = &crapi_sha384_init;
+                ctbl->update = &crapi_sha384_update;
+                ctbl->fini   = &crapi_sha384_fini;
+                ctbl->free   = &crapi_sha384_free;
+                break;
+        case CRAPI_DIGEST_SHA512:
+                ctbl->init   = &crapi_sha512_init;
+                ctbl->update = &crapi_sha512_update;
+                ctbl->fini   = &crapi_sha512_fini;
+                ctbl->free   = &crapi_sha512_free;
+                break;
+        case CRAPI_DIGEST_RMD160:
+                ctbl->init   = &crapi_rmd160_init;
+                ctbl->update = &crapi_rmd160_update;
+                ctbl->fini   = &crapi_rmd160_fini;
+                ctbl->free   = &crapi_rmd160_free;
+                break;
+        default:
+                return (-1);
+        }
+
+        return (0);
+}
+
+/*
+ * Feed a block of data to all the active digest contexts
+ */
+static int crapi_ctbl_update (struct digest_ctbl_t *ctbl, int num, void *buf, size_t len)
 {
         register int i;
-        va_list ap;
-        struct digest_ctbl_t *ctbl = malloc(num * sizeof(struct digest_ctbl_t));
 
-        crapi_alg_t alg;
-        void       *dst;
-        size_t     *size;
+        for (i = 0; i < num; ++i) {
+                if (ctbl[i].ctx == NULL)
+                        continue;
+                if (ctbl[i].update (ctbl[i].ctx, buf, len) != 0)
+                        return (-1);
+        }
 
-        uint8_t fd_buf[CRAPI_IO_BUFSZ];
-        ssize_t ret;
+        return (0);
+}
 
-	if (num <= 0 || fd <= 0) {
-		errno = EINVAL;
-		free(ctbl);
-		return -1;
-	}
-        for (i = 0; i < num; ++i)
-                ctbl[i].ctx = NULL;
+static int crapi_ctbl_update_read (struct digest_ctbl_t *ctbl, int num, int fd)
+{
+        uint8_t *buf;
+        ssize_t  ret;
 
-        va_start (ap, num);
+        buf = malloc (CRAPI_MDIGEST_CHUNKSZ);
+        if (buf == NULL)
+                return (-1);
 
-        for (i = 0; i < num; ++i) {
-                alg  = va_arg (ap, crapi_alg_t);
-                dst  = va_arg (ap, void *);
-                size = va_arg (ap, size_t *);
-
-                switch (alg) {
-                case CRAPI_DIGEST_MD5:
-                        ctbl[i].init   = &crapi_md5_init;
-                        ctbl[i].update = &crapi_md5_update;
-                        ctbl[i].fini   = &crapi_md5_fini;
-                        ctbl[i].free   = &crapi_md5_free;
-                        break;
-                case CRAPI_DIGEST_SHA1:
-                        ctbl[i].init   = &crapi_sha1_init;
-                        ctbl[i].update = &crapi_sha1_update;
-                        ctbl[i].fini   = &crapi_sha1_fini;
-                        ctbl[i].free   = &crapi_sha1_free;
-                        break;
-                case CRAPI_DIGEST_SHA224:
-                        ctbl[i].init   = &crapi_sha224_init;
-                        ctbl[i].update = &crapi_sha224_update;
-                        ctbl[i].fini   = &crapi_sha224_fini;
-                        ctbl[i].free   = &crapi_sha224_free;
-                        break;
-                case CRAPI_DIGEST_SHA256:
-                        ctbl[i].init   = &crapi_sha256_init;
-                        ctbl[i].update = &crapi_sha256_update;
-                        ctbl[i].fini   = &crapi_sha256_fini;
-                        ctbl[i].free   = &crapi_sha256_free;
-                        break;
-                case CRAPI_DIGEST_SHA384:
-                        ctbl[i].init   = &crapi_sha384_init;
-                        ctbl[i].update = &crapi_sha384_update;
-                        ctbl[i].fini   = &crapi_sha384_fini;
-                        ctbl[i].free   = &crapi_sha384_free;
-                        break;
-                case CRAPI_DIGEST_SHA512:
-                        ctbl[i].init   = &crapi_sha512_init;
-                        ctbl[i].update = &crapi_sha512_update;
-                        ctbl[i].fini   = &crapi_sha512_fini;
-                        ctbl[i].free   = &crapi_sha512_free;
+        while ((ret = read (fd, buf, CRAPI_MDIGEST_CHUNKSZ)) != 0) {
+                if (ret < 0) {
+                        if (errno == EINTR)
+                                continue;
                         break;
-                case CRAPI_DIGEST_RMD160:
-                        ctbl[i].init   = &crapi_rmd160_init;
-                        ctbl[i].update = &crapi_rmd160_update;
-                        ctbl[i].fini   = &crapi_rmd160_fini;
-                        ctbl[i].free   = &crapi_rmd160_free;
+                }
+                if (crapi_ctbl_update (ctbl, num, buf, (size_t)ret) != 0) {
+                        ret = -1;
                         break;
-                default:
-                        va_end (ap);
-                        goto fail;
                 }
-
-                if ((ctbl[i].ctx = ctbl[i].init (dst, size)) == NULL)
-			*size = 0;
         }
 
-        va_end (ap);
+        free (buf);
+        return (ret == 0 ? 0 : -1);
+}
 
-        while ((ret = read (fd, fd_buf, sizeof fd_buf)) == sizeof fd_buf) {
-                for (i = 0; i < num; ++i) {
-			if (ctbl[i].ctx == NULL)
-				continue;
-                        if (ctbl[i].update (ctbl[i].ctx, fd_buf, sizeof fd_buf) != 0) {
-                                goto fail;
-                        }
-                }
+int crapi_digest_buf (const void *buf, size_t len, crapi_alg_t alg, void *dst, size_t *size)
+{
+        struct digest_ctbl_t ctbl;
+
+	if (buf == NULL || dst == NULL || size == NULL) {
+		errno = EFAULT;
+		return -1;
+	}
+
+        if (crapi_ctbl_set (&ctbl, alg) != 0) {
+                errno = EINVAL;
+                return (-1);
         }
+        if ((ctbl.ctx = ctbl.init (dst, size)) == NULL)
+                return (-1);
 
-        switch (ret) {
-        case 0:
-                break;
-        case -1:
-                goto fail;
-        default:
-		if (ret <= 0) {
-			free(ctbl);
-			return -1;
-		}
+        if (ctbl.update (ctbl.ctx, (void *)buf, len) != 0) {
+                ctbl.free (ctbl.ctx);
+                return (-1);
+        }
 
-                for (i = 0; i < num; ++i) {
-			if (ctbl[i].ctx == NULL)
-				continue;
-                        if (ctbl[i].update (ctbl[i].ctx, fd_buf, (size_t)ret) != 0) {
-                                goto fail;
-                        }
+        return ctbl.fini (ctbl.ctx);
+}
+
+int crapi_mdigest_fdv (int fd, int num, const crapi_alg_t *alg, void **dst, size_t **size)
+{
+        register int i;
+        struct digest_ctbl_t *ctbl;
+
+	if (num <= 0 || fd < 0 || alg == NULL || dst == NULL || size == NULL) {
+		errno = EINVAL;
+		return -1;
+	}
+
+        ctbl = calloc (num, sizeof(struct digest_ctbl_t));
+        if (ctbl == NULL)
+                return (-1);
+
+        for (i = 0; i < num; ++i) {
+                if (crapi_ctbl_set (&ctbl[i], alg[i]) != 0) {
+                        errno = EINVAL;
+                        goto fail;
                 }
+                if ((ctbl[i].ctx = ctbl[i].init (dst[i], size[i])) == NULL)
+			*size[i] = 0;
         }
 
+        /*
+         * Files are read rather than mapped: a mapped file which is
+         * truncated while it's hashed raises SIGBUS.
+         */
+        if (crapi_ctbl_update_read (ctbl, num, fd) != 0)
+                goto fail;
+
         for (i = 0; i < num; ++i) {
 		if (ctbl[i].ctx == NULL)
 			continue;
@@ -198,3 +234,42 @@ fail:
         free(ctbl);
         return (-1);
 }
+
+int crapi_mdigest_fd (int fd, int num, ... /* crapi_alg_t alg, void *dst, size_t *size, ...*/)
+{
+        register int i;
+        va_list ap;
+        crapi_alg_t *alg;
+        void       **dst;
+        size_t     **size;
+        int ret = -1;
+
+	if (num <= 0 || fd < 0) {
+		errno = EINVAL;
+		return -1;
+	}
+
+        alg  = malloc (num * sizeof(crapi_alg_t));
+        dst  = malloc (num * sizeof(void *));
+        size = malloc (num * sizeof(size_t *));
+
+        if (alg != NULL && dst != NULL && size != NULL) {
+                va_start (ap, num);
+
+                for (i = 0; i < num; ++i) {
+                        alg[i]  = va_arg (ap, crapi_alg_t);
+                        dst[i]  = va_arg (ap, void *);
+                        size[i] = va_arg (ap, size_t *);
+                }
+
+                va_end (ap);
+
+                ret = crapi_mdigest_fdv (fd, num, alg, dst, size);
+        }
+
+        free (alg);
+        free (dst);
+        free (size);
+
+        return (ret);
+}
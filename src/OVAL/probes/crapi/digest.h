@@ -45,6 +45,11 @@ typedef enum {
 
 int crapi_digest_fd (int fd, crapi_alg_t alg, void *dst, size_t *size);
 
+/*
+ * Same as crapi_digest_fd() for a buffer in memory
+ */
+int crapi_digest_buf (const void *buf, size_t len, crapi_alg_t alg, void *dst, size_t *size);
+
 struct digest_ctbl_t {
         void *ctx;
         void *(*init)  (void *, void *);
@@ -53,6 +58,16 @@ struct digest_ctbl_t {
         void  (*free)  (void *);
 };
 
+/* size of the blocks read and fed to the digest functions at a time */
+#define CRAPI_MDIGEST_CHUNKSZ (256 * 1024)
+
 int crapi_mdigest_fd (int fd, int num, ... /*crapi_alg_t alg, void *dst, size_t *size, ...*/);
 
+/*
+ * Compute several digests of the file in a single pass. Same as
+ * crapi_mdigest_fd() except that the algorithms, destination buffers
+ * and sizes are passed in arrays of num elements.
+ */
+int crapi_mdigest_fdv (int fd, int num, const crapi_alg_t *alg, void **dst, size_t **size);
+
 #endif /* CRAPI_DIGEST_H */
@@ -0,0 +1,1757 @@
+/**
+ * @file   fscache.c
+ * @brief  filesystem metadata cache of the file probes
+ */
+/*
+ * Copyright 2026 Red Hat Inc., Durham, North Carolina.
+ * All Rights Reserved.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <string.h>
+#include <errno.h>
+#include <pthread.h>
+#include <dirent.h>
+#include <sys/types.h>
+#include <sys/stat.h>
+
+#if defined(OS_SOLARIS) || defined(OS_AIX)
+#include "fts_sun.h"
+#else
+#include <fts.h>
+#endif
+
+#include "_sexp-atomic.h"
+#include "SEAP/generic/rbt/rbt.h"
+#include "debug_priv.h"
+#include "fscache.h"
+
+#define FSCACHE_DEFAULT_SIZE 262144
+#define FSCACHE_DIR_INITSIZE 16
+#define FSCACHE_OBJECT_SHARE 4 /* a traversal caches at most 1/4 of the entries */
+
+/*
+ * Result of lstat of a path, and of stat if the path is a symlink.
+ * Cached results are never modified.
+ */
+struct fscache_stat {
+	int lerr;          /**< errno of lstat, 0 on success */
+	int err;           /**< errno of stat, 0 on success */
+	struct stat lst;
+	struct stat st;    /**< the same as lst unless lst is a symlink */
+};
+
+/*
+ * Entries of a directory except for "." and "..", in the order
+ * returned by readdir. Listings with an error are never cached.
+ */
+struct fscache_dir {
+	int err;           /**< errno of opendir or readdir, 0 on success */
+	size_t count;
+	char **names;
+	struct fscache_stat *stats; /**< of the names if read ahead, never cached */
+	bool cached;       /**< owned by the cache, otherwise by the reader */
+};
+
+struct fscache {
+	rbt_t *stats;              /**< path -> struct fscache_stat */
+	rbt_t *dirs;               /**< path -> struct fscache_dir */
+	pthread_rwlock_t lock;     /**< guards the trees and entries */
+	uint32_t entries;
+	uint32_t max_entries;
+	uint32_t refs;             /**< guarded by fscache_lock */
+	volatile uint32_t stat_lookups;
+	volatile uint32_t stat_hits;
+	volatile uint32_t dir_lookups;
+	volatile uint32_t dir_hits;
+	volatile uint32_t prefetch_hits;
+};
+
+struct fscache_fts {
+	fscache_t *cache;          /**< NULL if the cache is disabled */
+	int options;
+	dev_t dev;                 /**< device of the root */
+	uint32_t budget;           /**< entries the traversal may still cache */
+	fscache_ftsent_t *root;
+	fscache_ftsent_t *cur;     /**< the entry returned last */
+	fscache_prefetch_t *prefetch; /**< reading the directories ahead, may be NULL */
+	bool started;
+};
+
+static pthread_mutex_t fscache_lock = PTHREAD_MUTEX_INITIALIZER;
+static fscache_t *fscache_current = NULL;
+static uint32_t fscache_users = 0;
+
+static void fscache_pool_stop(void);
+static struct fscache_dir *fscache_prefetch_take(fscache_prefetch_t *pf, const char *path);
+static void fscache_prefetch_skip(fscache_prefetch_t *pf, const char *path);
+
+static uint32_t fscache_max_entries(void)
+{
+	const char *env = getenv("OSCAP_FS_CACHE_SIZE");
+	char *end;
+	unsigned long val;
+
+	if (env == NULL || *env == '\0')
+		return FSCACHE_DEFAULT_SIZE;
+
+	errno = 0;
+	val = strtoul(env, &end, 10);
+	if (errno != 0 || *end != '\0' || val > UINT32_MAX) {
+		dW("Invalid value of OSCAP_FS_CACHE_SIZE: '%s', using %u.", env, FSCACHE_DEFAULT_SIZE);
+		return FSCACHE_DEFAULT_SIZE;
+	}
+
+	return (uint32_t)val;
+}
+
+static fscache_t *fscache_new(void)
+{
+	fscache_t *cache;
+	uint32_t max_entries;
+
+	max_entries = fscache_max_entries();
+	if (max_entries == 0)
+		return NULL;
+
+	cache = calloc(1, sizeof(fscache_t));
+	if (cache == NULL)
+		return NULL;
+
+	cache->stats = rbt_str_new();
+	cache->dirs = rbt_str_new();
+	pthread_rwlock_init(&cache->lock, NULL);
+	cache->max_entries = max_entries;
+
+	return cache;
+}
+
+static void fscache_dir_free(struct fscache_dir *dir)
+{
+	size_t i;
+
+	for (i = 0; i < dir->count; ++i)
+		free(dir->names[i]);
+	free(dir->names);
+	free(dir->stats);
+	free(dir);
+}
+
+static void fscache_free_stat_node(struct rbt_str_node *n)
+{
+	free(n->key);
+	free(n->data);
+}
+
+static void fscache_free_dir_node(struct rbt_str_node *n)
+{
+	free(n->key);
+	fscache_dir_free(n->data);
+}
+
+static void fscache_free(fscache_t *cache)
+{
+	dI("Filesystem cache: %u of %u stat lookups and %u of %u directory lookups hit, "
+	   "%u directories read ahead, %u entries.",
+	   cache->stat_hits, cache->stat_lookups, cache->dir_hits, cache->dir_lookups,
+	   cache->prefetch_hits, cache->entries);
+
+	rbt_str_free_cb(cache->stats, &fscache_free_stat_node);
+	rbt_str_free_cb(cache->dirs, &fscache_free_dir_node);
+	pthread_rwlock_destroy(&cache->lock);
+	free(cache);
+}
+
+fscache_t *fscache_get(void)
+{
+	fscache_t *cache;
+
+	pthread_mutex_lock(&fscache_lock);
+	if (fscache_current == NULL) {
+		fscache_current = fscache_new();
+		if (fscache_current != NULL)
+			fscache_current->refs = 1; /* the cache of the current scan */
+	}
+	cache = fscache_current;
+	if (cache != NULL)
+		cache->refs++;
+	pthread_mutex_unlock(&fscache_lock);
+
+	return cache;
+}
+
+void fscache_release(fscache_t *cache)
+{
+	bool last;
+
+	if (cache == NULL)
+		return;
+
+	pthread_mutex_lock(&fscache_lock);
+	last = --cache->refs == 0;
+	pthread_mutex_unlock(&fscache_lock);
+
+	if (last)
+		fscache_free(cache);
+}
+
+static void fscache_reset_locked(void)
+{
+	fscache_t *cache = fscache_current;
+
+	fscache_current = NULL;
+	if (cache != NULL && --cache->refs == 0)
+		fscache_free(cache);
+}
+
+void fscache_reset(void)
+{
+	pthread_mutex_lock(&fscache_lock);
+	fscache_reset_locked();
+	pthread_mutex_unlock(&fscache_lock);
+}
+
+void fscache_hold(void)
+{
+	pthread_mutex_lock(&fscache_lock);
+	fscache_users++;
+	pthread_mutex_unlock(&fscache_lock);
+}
+
+void fscache_drop(void)
+{
+	bool last;
+
+	pthread_mutex_lock(&fscache_lock);
+	last = --fscache_users == 0;
+	if (last)
+		fscache_reset_locked();
+	pthread_mutex_unlock(&fscache_lock);
+
+	if (last)
+		fscache_pool_stop();
+}
+
+void fscache_stats(fscache_stats_t *stats)
+{
+	fscache_t *cache;
+
+	memset(stats, 0, sizeof(fscache_stats_t));
+
+	cache = fscache_get();
+	if (cache == NULL)
+		return;
+
+	stats->stat_lookups = cache->stat_lookups;
+	stats->stat_hits = cache->stat_hits;
+	stats->dir_lookups = cache->dir_lookups;
+	stats->dir_hits = cache->dir_hits;
+	stats->prefetch_hits = cache->prefetch_hits;
+	pthread_rwlock_rdlock(&cache->lock);
+	stats->entries = cache->entries;
+	pthread_rwlock_unlock(&cache->lock);
+
+	fscache_release(cache);
+}
+
+static void *fscache_find(fscache_t *cache, rbt_t *tree, const char *path)
+{
+	void *found;
+
+	pthread_rwlock_rdlock(&cache->lock);
+	if (rbt_str_get(tree, path, &found) != 0)
+		found = NULL;
+	pthread_rwlock_unlock(&cache->lock);
+
+	return found;
+}
+
+/*
+ * Store a result in the cache unless it's full or the budget of the
+ * traversal storing it is spent; the budget, guarded by the lock of the
+ * cache, may be NULL. Returns false if the result wasn't stored, the
+ * caller keeps the ownership then. If some other thread stored the path
+ * in the meantime, its result is returned in place of the data.
+ */
+static bool fscache_insert(fscache_t *cache, rbt_t *tree, const char *path, void **data, uint32_t size, uint32_t *budget)
+{
+	char *key;
+	void *found;
+	bool stored = false;
+
+	pthread_rwlock_wrlock(&cache->lock);
+	if (rbt_str_get(tree, path, &found) == 0) {
+		*data = found;
+		stored = true;
+	} else if (cache->entries + size <= cache->max_entries &&
+	           (budget == NULL || *budget >= size)) {
+		key = strdup(path);
+		if (key != NULL && rbt_str_add(tree, key, *data) == 0) {
+			cache->entries += size;
+			if (budget != NULL)
+				*budget -= size;
+			stored = true;
+		} else {
+			free(key);
+		}
+	}
+	pthread_rwlock_unlock(&cache->lock);
+
+	return stored;
+}
+
+static void fscache_read_stat(const char *path, struct fscache_stat *fs)
+{
+	fs->lerr = fs->err = 0;
+	if (lstat(path, &fs->lst) != 0) {
+		fs->lerr = errno;
+		memset(&fs->lst, 0, sizeof(struct stat));
+		memset(&fs->st, 0, sizeof(struct stat));
+		return;
+	}
+
+	if (!S_ISLNK(fs->lst.st_mode)) {
+		memcpy(&fs->st, &fs->lst, sizeof(struct stat));
+		return;
+	}
+
+	if (stat(path, &fs->st) != 0) {
+		fs->err = errno;
+		memset(&fs->st, 0, sizeof(struct stat));
+	}
+}
+
+/*
+ * Store a copy of the stat results, returns the cached results or NULL
+ * if the cache is full.
+ */
+static const struct fscache_stat *fscache_add_stat(fscache_t *cache, const char *path, const struct fscache_stat *buf, uint32_t *budget)
+{
+	struct fscache_stat *fs;
+	void *found;
+
+	fs = malloc(sizeof(struct fscache_stat));
+	if (fs == NULL)
+		return NULL;
+	memcpy(fs, buf, sizeof(struct fscache_stat));
+
+	found = fs;
+	if (!fscache_insert(cache, cache->stats, path, &found, 1, budget)) {
+		free(fs);
+		return NULL;
+	}
+	if (found != fs)
+		free(fs);
+
+	return found;
+}
+
+/*
+ * Look up the stat results of the path, the result is either the cached
+ * one, valid as long as the cache, or it's read into the buffer.
+ */
+static const struct fscache_stat *fscache_lookup_stat(fscache_t *cache, const char *path, struct fscache_stat *buf, uint32_t *budget)
+{
+	const struct fscache_stat *fs;
+
+	if (cache == NULL) {
+		fscache_read_stat(path, buf);
+		return buf;
+	}
+
+	SEXP_atomic_inc_u32(&cache->stat_lookups);
+
+	fs = fscache_find(cache, cache->stats, path);
+	if (fs != NULL) {
+		SEXP_atomic_inc_u32(&cache->stat_hits);
+		return fs;
+	}
+
+	fscache_read_stat(path, buf);
+	fs = fscache_add_stat(cache, path, buf, budget);
+
+	return fs != NULL ? fs : buf;
+}
+
+static bool fscache_dir_add_name(struct fscache_dir *dir, size_t *size, const char *name)
+{
+	char **names;
+
+	if (name[0] == '.' && (name[1] == '\0' || (name[1] == '.' && name[2] == '\0')))
+		return true;
+
+	if (dir->count == *size) {
+		*size = *size == 0 ? FSCACHE_DIR_INITSIZE : *size * 2;
+		names = realloc(dir->names, *size * sizeof(char *));
+		if (names == NULL)
+			return false;
+		dir->names = names;
+	}
+	dir->names[dir->count] = strdup(name);
+	if (dir->names[dir->count] == NULL)
+		return false;
+	dir->count++;
+
+	return true;
+}
+
+/* Drop the entries read so far, a partial listing is never used */
+static void fscache_dir_fail(struct fscache_dir *dir, int err)
+{
+	size_t i;
+
+	for (i = 0; i < dir->count; ++i)
+		free(dir->names[i]);
+	free(dir->names);
+	dir->names = NULL;
+	dir->count = 0;
+	dir->err = err;
+}
+
+static struct fscache_dir *fscache_read_dir(const char *path)
+{
+	struct fscache_dir *dir;
+	struct dirent *de;
+	size_t size = 0;
+	DIR *dp;
+
+	dir = calloc(1, sizeof(struct fscache_dir));
+	if (dir == NULL)
+		return NULL;
+
+	dp = opendir(path);
+	if (dp == NULL) {
+		dir->err = errno;
+		return dir;
+	}
+
+	for (;;) {
+		errno = 0;
+		if ((de = readdir(dp)) == NULL) {
+			if (errno != 0)
+				fscache_dir_fail(dir, errno);
+			break;
+		}
+		if (!fscache_dir_add_name(dir, &size, de->d_name)) {
+			fscache_dir_fail(dir, ENOMEM);
+			break;
+		}
+	}
+
+	closedir(dp);
+
+	return dir;
+}
+
+/*
+ * Store the directory entries, returns the cached entries or NULL if the
+ * cache is full or the listing failed, the caller keeps the ownership of
+ * the entries then.
+ */
+static struct fscache_dir *fscache_add_dir(fscache_t *cache, const char *path, struct fscache_dir *dir, uint32_t *budget)
+{
+	void *found;
+
+	if (dir->err != 0)
+		return NULL;
+
+	dir->cached = true;
+	found = dir;
+	if (!fscache_insert(cache, cache->dirs, path, &found, (uint32_t)dir->count + 1, budget)) {
+		dir->cached = false;
+		return NULL;
+	}
+	if (found != dir)
+		fscache_dir_free(dir);
+
+	return found;
+}
+
+/*
+ * Look up the entries of the directory. The result is owned by the cache
+ * if its cached flag is set, otherwise the caller frees it by
+ * fscache_dir_free. If the directory was read ahead by the prefetch, the
+ * stat results of its entries are returned in stats, freed by the caller,
+ * otherwise it's set to NULL.
+ */
+static struct fscache_dir *fscache_lookup_dir(fscache_t *cache, const char *path,
+		fscache_prefetch_t *pf, uint32_t *budget, struct fscache_stat **stats)
+{
+	struct fscache_dir *dir, *cached;
+
+	*stats = NULL;
+	/* taken before the cache is looked up, so that the prefetch drops the subtree otherwise */
+	dir = fscache_prefetch_take(pf, path);
+
+	if (cache == NULL)
+		return dir != NULL ? dir : fscache_read_dir(path);
+
+	SEXP_atomic_inc_u32(&cache->dir_lookups);
+
+	if (dir != NULL) {
+		SEXP_atomic_inc_u32(&cache->prefetch_hits);
+		*stats = dir->stats;
+		dir->stats = NULL;
+	} else {
+		dir = fscache_find(cache, cache->dirs, path);
+		if (dir != NULL) {
+			SEXP_atomic_inc_u32(&cache->dir_hits);
+			return dir;
+		}
+
+		dir = fscache_read_dir(path);
+		if (dir == NULL)
+			return NULL;
+	}
+
+	cached = fscache_add_dir(cache, path, dir, budget);
+
+	return cached != NULL ? cached : dir;
+}
+
+static void fscache_dir_release(struct fscache_dir *dir)
+{
+	if (dir != NULL && !dir->cached)
+		fscache_dir_free(dir);
+}
+
+static int fscache_stat_path(const char *path, struct stat *st, bool follow)
+{
+	const struct fscache_stat *fs;
+	struct fscache_stat buf;
+	fscache_t *cache;
+	int ret = 0, err;
+
+	cache = fscache_get();
+	fs = fscache_lookup_stat(cache, path, &buf, NULL);
+
+	err = fs->lerr;
+	if (err == 0 && follow)
+		err = fs->err;
+
+	if (err != 0) {
+		ret = -1;
+	} else {
+		memcpy(st, follow ? &fs->st : &fs->lst, sizeof(struct stat));
+	}
+
+	fscache_release(cache);
+
+	if (ret != 0)
+		errno = err;
+	return ret;
+}
+
+int fscache_stat(const char *path, struct stat *st)
+{
+	return fscache_stat_path(path, st, true);
+}
+
+int fscache_lstat(const char *path, struct stat *st)
+{
+	return fscache_stat_path(path, st, false);
+}
+
+/*
+ * Traversal
+ */
+
+/*
+ * Length of the part of a directory path preceding the slash of the paths
+ * of its entries. A path ending with a slash, e.g. "/", doesn't get
+ * another one, like in fts(3).
+ */
+static size_t fscache_path_dirlen(const char *path, size_t pathlen)
+{
+	if (pathlen > 0 && path[pathlen - 1] == '/')
+		return pathlen - 1;
+	return pathlen;
+}
+
+static fscache_ftsent_t *fscache_ftsent_new(fscache_ftsent_t *parent, const char *name, size_t namelen)
+{
+	fscache_ftsent_t *ent;
+	size_t dirlen = 0;
+
+	if (parent != NULL)
+		dirlen = fscache_path_dirlen(parent->fts_path, parent->fts_pathlen);
+
+	ent = calloc(1, sizeof(fscache_ftsent_t) + dirlen + namelen + 2);
+	if (ent == NULL)
+		return NULL;
+
+	ent->fts_path = (char *)(ent + 1);
+	if (parent != NULL) {
+		memcpy(ent->fts_path, parent->fts_path, dirlen);
+		ent->fts_path[dirlen++] = '/';
+		ent->fts_level = parent->fts_level + 1;
+	}
+	memcpy(ent->fts_path + dirlen, name, namelen);
+	ent->fts_path[dirlen + namelen] = '\0';
+	ent->fts_pathlen = (int)(dirlen + namelen);
+	ent->fts_name = ent->fts_path + dirlen;
+	ent->fts_namelen = (int)namelen;
+	ent->fts_parent = parent;
+	ent->fts_instr = FTS_NOINSTR;
+	ent->fts_statp = &ent->statb;
+
+	return ent;
+}
+
+static void fscache_ftsent_release_dir(fscache_ftsent_t *ent)
+{
+	fscache_dir_release(ent->dir);
+	free(ent->dir_stats);
+	ent->dir = NULL;
+	ent->dir_stats = NULL;
+}
+
+static void fscache_ftsent_free(fscache_ftsent_t *ent)
+{
+	fscache_ftsent_release_dir(ent);
+	free(ent);
+}
+
+/*
+ * Get the fts_info of the entry the same way fts(3) does. The stat
+ * results read ahead by the prefetch are cached and used if given.
+ */
+static unsigned short fscache_fts_stat(fscache_fts_t *fts, fscache_ftsent_t *ent,
+		const struct fscache_stat *ahead, bool follow)
+{
+	const struct fscache_stat *fs;
+	struct fscache_stat buf;
+	const struct stat *st;
+	fscache_ftsent_t *t;
+
+	if (ahead != NULL) {
+		fs = ahead;
+		if (fts->cache != NULL)
+			fscache_add_stat(fts->cache, ent->fts_path, ahead, &fts->budget);
+	} else {
+		fs = fscache_lookup_stat(fts->cache, ent->fts_path, &buf, &fts->budget);
+	}
+
+	if (fs->lerr != 0) {
+		ent->fts_errno = fs->lerr;
+		goto err;
+	}
+	st = &fs->lst;
+	if (follow && S_ISLNK(fs->lst.st_mode)) {
+		if (fs->err != 0) {
+			memcpy(&ent->statb, &fs->lst, sizeof(struct stat));
+			errno = 0;
+			return FTS_SLNONE;
+		}
+		st = &fs->st;
+	}
+	memcpy(&ent->statb, st, sizeof(struct stat));
+
+	if (S_ISDIR(st->st_mode)) {
+		ent->fts_dev = st->st_dev;
+		ent->fts_ino = st->st_ino;
+
+		for (t = ent->fts_parent; t != NULL; t = t->fts_parent) {
+			if (t->fts_ino == st->st_ino && t->fts_dev == st->st_dev)
+				return FTS_DC;
+		}
+		return FTS_D;
+	}
+	if (S_ISLNK(st->st_mode))
+		return FTS_SL;
+	if (S_ISREG(st->st_mode))
+		return FTS_F;
+	return FTS_DEFAULT;
+err:
+	memset(&ent->statb, 0, sizeof(struct stat));
+	return FTS_NS;
+}
+
+fscache_fts_t *fscache_fts_open(const char *path, int options)
+{
+	fscache_fts_t *fts;
+	fscache_ftsent_t *root;
+	size_t pathlen;
+	char *name;
+
+	pathlen = strlen(path);
+	if (pathlen == 0) {
+		errno = ENOENT;
+		return NULL;
+	}
+
+	fts = calloc(1, sizeof(fscache_fts_t));
+	if (fts == NULL)
+		return NULL;
+	root = fscache_ftsent_new(NULL, path, pathlen);
+	if (root == NULL) {
+		free(fts);
+		return NULL;
+	}
+
+	/* the name of the root is the last component of the path, like in fts(3) */
+	name = strrchr(root->fts_path, '/');
+	if (name != NULL && (name != root->fts_path || name[1] != '\0')) {
+		root->fts_name = name + 1;
+		root->fts_namelen = (int)strlen(root->fts_name);
+	}
+
+	fts->cache = fscache_get();
+	if (fts->cache != NULL)
+		fts->budget = fts->cache->max_entries / FSCACHE_OBJECT_SHARE;
+	fts->options = options;
+	fts->root = root;
+
+	root->fts_info = fscache_fts_stat(fts, root, NULL, options & (FTS_COMFOLLOW | FTS_LOGICAL));
+	if (root->fts_info == FTS_NS) {
+		errno = root->fts_errno;
+		fscache_fts_close(fts);
+		return NULL;
+	}
+	fts->dev = root->fts_dev;
+
+	return fts;
+}
+
+/* Visit the next entry of the directory, or the directory itself in postorder */
+static fscache_ftsent_t *fscache_fts_next(fscache_fts_t *fts, fscache_ftsent_t *parent)
+{
+	const struct fscache_stat *ahead = NULL;
+	fscache_ftsent_t *ent;
+	const char *name;
+
+	if (parent->dir_pos < parent->dir->count) {
+		if (parent->dir_stats != NULL)
+			ahead = &parent->dir_stats[parent->dir_pos];
+		name = parent->dir->names[parent->dir_pos++];
+		ent = fscache_ftsent_new(parent, name, strlen(name));
+		if (ent == NULL)
+			return NULL;
+		ent->fts_info = fscache_fts_stat(fts, ent, ahead, false);
+		return fts->cur = ent;
+	}
+
+	fscache_ftsent_release_dir(parent);
+	parent->fts_info = parent->fts_errno ? FTS_ERR : FTS_DP;
+
+	return fts->cur = parent;
+}
+
+fscache_ftsent_t *fscache_fts_read(fscache_fts_t *fts)
+{
+	fscache_ftsent_t *ent, *parent;
+	unsigned short instr;
+
+	ent = fts->cur;
+	if (ent == NULL) {
+		if (fts->started || fts->root == NULL) {
+			errno = 0;
+			return NULL;
+		}
+		fts->started = true;
+		return fts->cur = fts->root;
+	}
+
+	instr = ent->fts_instr;
+	ent->fts_instr = FTS_NOINSTR;
+
+	if (instr == FTS_AGAIN) {
+		ent->fts_info = fscache_fts_stat(fts, ent, NULL, false);
+		return ent;
+	}
+
+	if (instr == FTS_FOLLOW && (ent->fts_info == FTS_SL || ent->fts_info == FTS_SLNONE)) {
+		ent->fts_info = fscache_fts_stat(fts, ent, NULL, true);
+		return ent;
+	}
+
+	if (ent->fts_info == FTS_D) {
+		if (instr == FTS_SKIP || ((fts->options & FTS_XDEV) && ent->fts_dev != fts->dev)) {
+			fscache_prefetch_skip(fts->prefetch, ent->fts_path);
+			ent->fts_info = FTS_DP;
+			return ent;
+		}
+
+		ent->dir = fscache_lookup_dir(fts->cache, ent->fts_path, fts->prefetch,
+				&fts->budget, &ent->dir_stats);
+		if (ent->dir == NULL)
+			return NULL;
+		if (ent->dir->err != 0) {
+			ent->fts_errno = ent->dir->err;
+			ent->fts_info = FTS_DNR;
+			fscache_ftsent_release_dir(ent);
+			return ent;
+		}
+		ent->dir_pos = 0;
+
+		return fscache_fts_next(fts, ent);
+	}
+
+	/* the entry is left, continue with its siblings */
+	parent = ent->fts_parent;
+	fscache_ftsent_free(ent);
+	if (parent == NULL) {
+		fts->root = fts->cur = NULL;
+		errno = 0;
+		return NULL;
+	}
+
+	return fscache_fts_next(fts, parent);
+}
+
+int fscache_fts_set(fscache_fts_t *fts, fscache_ftsent_t *ent, int instr)
+{
+	(void)fts;
+
+	if (instr != 0 && instr != FTS_AGAIN && instr != FTS_FOLLOW &&
+	    instr != FTS_NOINSTR && instr != FTS_SKIP) {
+		errno = EINVAL;
+		return 1;
+	}
+	ent->fts_instr = instr;
+
+	return 0;
+}
+
+int fscache_fts_close(fscache_fts_t *fts)
+{
+	fscache_ftsent_t *ent, *parent;
+
+	if (fts == NULL)
+		return 0;
+
+	fscache_prefetch_stop(fts->prefetch);
+
+	/* the entries on the path from the current one up to the root */
+	ent = fts->cur != NULL ? fts->cur : fts->root;
+	while (ent != NULL) {
+		parent = ent->fts_parent;
+		fscache_ftsent_free(ent);
+		ent = parent;
+	}
+
+	fscache_release(fts->cache);
+	free(fts);
+
+	return 0;
+}
+
+/*
+ * Prefetch
+ */
+
+#if defined(OS_LINUX)
+
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/syscall.h>
+
+#define FSCACHE_PREFETCH_MAX_THREADS 16
+#define FSCACHE_PREFETCH_BUFSIZE     32768 /* getdents64 buffer */
+#define FSCACHE_PREFETCH_QUEUE_INIT  64
+
+struct fscache_linux_dirent64 {
+	uint64_t d_ino;
+	int64_t d_off;
+	unsigned short d_reclen;
+	unsigned char d_type;
+	char d_name[];
+};
+
+/*
+ * Directory to read. A node keeps its parent, used to detect cycles,
+ * until the nodes of all its subdirectories are released.
+ */
+struct fscache_walk_node {
+	struct fscache_walk_node *parent;
+	dev_t dev;
+	ino_t ino;
+	int level;
+	volatile uint32_t refs;
+	size_t pathlen;
+	char path[];
+};
+
+/* Buffers of a thread of the pool */
+struct fscache_walker {
+	char *dents;             /**< getdents64 buffer */
+	char *path;              /**< path of the entry looked up */
+	size_t path_size;
+	struct fscache_walk_node **children; /**< subdirectories of the directory read */
+	size_t children_size;
+};
+
+#define FSCACHE_AHEAD_QUEUED  0
+#define FSCACHE_AHEAD_READING 1
+#define FSCACHE_AHEAD_READY   2
+
+/*
+ * Directory of the prefetch not taken by the traversal yet. A directory
+ * the traversal gets to before it's read, or skips, is removed together
+ * with its subdirectories, the prefetch doesn't read them then.
+ */
+struct fscache_ahead {
+	int state;
+	struct fscache_dir *dir; /**< the entries and their stat results if ready */
+};
+
+/*
+ * Directories of a hierarchy to read. The nodes are taken in the reverse
+ * order of queuing, the subdirectories are queued in the reverse order
+ * of their entries, so the walk goes deep first like the traversal.
+ */
+struct fscache_prefetch {
+	fscache_fts_t *fts;
+	fscache_t *cache;
+	int max_depth;
+	fscache_prefetch_descend_t descend;
+	void *arg;
+	pthread_mutex_t lock;    /**< guards dirs and ahead */
+	pthread_cond_t ready;    /**< broadcast when a directory is read */
+	rbt_t *dirs;             /**< path -> struct fscache_ahead */
+	volatile uint32_t ahead; /**< entries of the ready directories, see fscache_prefetch_paused */
+	uint32_t max_ahead;
+	struct fscache_walk_node **nodes; /**< queued nodes, guarded by the pool lock */
+	size_t count;
+	size_t size;
+	uint32_t busy;           /**< nodes being read, guarded by the pool lock */
+	volatile bool stop;      /**< see fscache_prefetch_stopped */
+	struct fscache_prefetch *next; /**< in the list of the pool */
+};
+
+/*
+ * Threads shared by all the prefetches of the probe threads. They are
+ * started by the first prefetch and stopped when the last probe thread
+ * exits. Each thread takes the next node of the prefetches in turns.
+ */
+static struct {
+	pthread_mutex_t lock;
+	pthread_cond_t work;     /**< signaled when a node is queued, a prefetch resumes or the pool stops */
+	pthread_cond_t idle;     /**< signaled when a node of a stopped prefetch is read */
+	fscache_prefetch_t *prefetches;
+	uint32_t nthreads;
+	pthread_t *threads;
+	struct fscache_walker *walkers;
+	bool stop;
+} fscache_pool = {
+	.lock = PTHREAD_MUTEX_INITIALIZER,
+	.work = PTHREAD_COND_INITIALIZER,
+	.idle = PTHREAD_COND_INITIALIZER,
+};
+
+/* The flag is set by the threads reading the prefetch without the pool lock */
+static bool fscache_prefetch_stopped(fscache_prefetch_t *pf)
+{
+#if defined(HAVE_ATOMIC_BUILTINS)
+	return __atomic_load_n(&pf->stop, __ATOMIC_RELAXED);
+#else
+	return pf->stop;
+#endif
+}
+
+static void fscache_prefetch_set_stopped(fscache_prefetch_t *pf)
+{
+#if defined(HAVE_ATOMIC_BUILTINS)
+	__atomic_store_n(&pf->stop, true, __ATOMIC_RELAXED);
+#else
+	pf->stop = true;
+#endif
+}
+
+/*
+ * No more directories are read while the ready ones hold the share of
+ * the cache of a traversal. The count is changed with the lock of the
+ * prefetch held and read by the threads of the pool without it.
+ */
+static bool fscache_prefetch_paused(fscache_prefetch_t *pf)
+{
+#if defined(HAVE_ATOMIC_BUILTINS)
+	return __atomic_load_n(&pf->ahead, __ATOMIC_RELAXED) >= pf->max_ahead;
+#else
+	return pf->ahead >= pf->max_ahead;
+#endif
+}
+
+static void fscache_prefetch_set_ahead(fscache_prefetch_t *pf, uint32_t ahead)
+{
+#if defined(HAVE_ATOMIC_BUILTINS)
+	__atomic_store_n(&pf->ahead, ahead, __ATOMIC_RELAXED);
+#else
+	pf->ahead = ahead;
+#endif
+}
+
+/* Entries of a ready directory counted like in the cache */
+static uint32_t fscache_ahead_size(const struct fscache_dir *dir)
+{
+	return (uint32_t)dir->count * 2 + 1;
+}
+
+/*
+ * Number of threads of the pool; the core count up to
+ * FSCACHE_PREFETCH_MAX_THREADS unless overridden by the
+ * OSCAP_FS_PREFETCH_THREADS environment variable.
+ */
+static uint32_t fscache_prefetch_max_threads(void)
+{
+	const char *env = getenv("OSCAP_FS_PREFETCH_THREADS");
+	unsigned long val;
+	long ncpu;
+
+	if (env != NULL) {
+		if (sscanf(env, "%lu", &val) == 1 && val <= FSCACHE_PREFETCH_MAX_THREADS * 4)
+			return (uint32_t)val;
+
+		dW("Ignoring invalid value of OSCAP_FS_PREFETCH_THREADS: '%s'", env);
+	}
+
+	/* a single CPU is kept busy by the traversal itself */
+	ncpu = sysconf(_SC_NPROCESSORS_ONLN);
+
+	if (ncpu < 2)
+		return 0;
+	if (ncpu > FSCACHE_PREFETCH_MAX_THREADS)
+		return FSCACHE_PREFETCH_MAX_THREADS;
+
+	return (uint32_t)ncpu;
+}
+
+static struct fscache_walk_node *fscache_walk_node_new(struct fscache_walk_node *parent,
+		const char *path, size_t pathlen, const struct stat *st)
+{
+	struct fscache_walk_node *node;
+
+	node = malloc(sizeof(struct fscache_walk_node) + pathlen + 1);
+	if (node == NULL)
+		return NULL;
+
+	node->parent = parent;
+	node->dev = st->st_dev;
+	node->ino = st->st_ino;
+	node->level = parent != NULL ? parent->level + 1 : 0;
+	node->refs = 1;
+	node->pathlen = pathlen;
+	memcpy(node->path, path, pathlen);
+	node->path[pathlen] = '\0';
+
+	if (parent != NULL)
+		SEXP_atomic_inc_u32(&parent->refs);
+
+	return node;
+}
+
+static void fscache_walk_node_release(struct fscache_walk_node *node)
+{
+	struct fscache_walk_node *parent;
+
+	while (node != NULL && SEXP_atomic_dec_u32(&node->refs) == 0) {
+		parent = node->parent;
+		free(node);
+		node = parent;
+	}
+}
+
+static bool fscache_walk_node_cycle(struct fscache_walk_node *node, const struct stat *st)
+{
+	for (; node != NULL; node = node->parent) {
+		if (node->ino == st->st_ino && node->dev == st->st_dev)
+			return true;
+	}
+	return false;
+}
+
+static bool fscache_walk_push(fscache_prefetch_t *pf, struct fscache_walk_node *node)
+{
+	struct fscache_walk_node **nodes;
+	size_t size;
+	bool pushed = true;
+
+	pthread_mutex_lock(&fscache_pool.lock);
+	if (pf->count == pf->size) {
+		size = pf->size == 0 ? FSCACHE_PREFETCH_QUEUE_INIT : pf->size * 2;
+		nodes = realloc(pf->nodes, size * sizeof(struct fscache_walk_node *));
+		if (nodes == NULL) {
+			pushed = false;
+		} else {
+			pf->nodes = nodes;
+			pf->size = size;
+		}
+	}
+	if (pushed) {
+		pf->nodes[pf->count++] = node;
+		pthread_cond_signal(&fscache_pool.work);
+	}
+	pthread_mutex_unlock(&fscache_pool.lock);
+
+	return pushed;
+}
+
+/*
+ * Take a node of the first prefetch having some and move the prefetch to
+ * the end of the list, so that the prefetches are served in turns. Called
+ * with the pool locked.
+ */
+static struct fscache_walk_node *fscache_walk_take(fscache_prefetch_t **pfp)
+{
+	fscache_prefetch_t **link, *pf, **tail;
+
+	for (link = &fscache_pool.prefetches; *link != NULL; link = &(*link)->next) {
+		if ((*link)->count > 0 && !fscache_prefetch_stopped(*link) &&
+		    !fscache_prefetch_paused(*link))
+			break;
+	}
+	pf = *link;
+	if (pf == NULL)
+		return NULL;
+
+	*link = pf->next;
+	pf->next = NULL;
+	for (tail = link; *tail != NULL; tail = &(*tail)->next)
+		;
+	*tail = pf;
+
+	pf->busy++;
+	*pfp = pf;
+
+	return pf->nodes[--pf->count];
+}
+
+/* Read the directory entries by getdents64, in the same order as readdir */
+static struct fscache_dir *fscache_walk_read_dir(struct fscache_walker *w, int fd)
+{
+	struct fscache_linux_dirent64 *de;
+	struct fscache_dir *dir;
+	size_t size = 0;
+	long len, pos;
+
+	dir = calloc(1, sizeof(struct fscache_dir));
+	if (dir == NULL)
+		return NULL;
+
+	if (fd < 0) {
+		dir->err = errno;
+		return dir;
+	}
+
+	for (;;) {
+		len = syscall(SYS_getdents64, fd, w->dents, FSCACHE_PREFETCH_BUFSIZE);
+		if (len < 0 && errno == EINTR)
+			continue;
+		if (len < 0) {
+			fscache_dir_fail(dir, errno);
+			break;
+		}
+		if (len == 0)
+			break;
+
+		for (pos = 0; pos < len; pos += de->d_reclen) {
+			de = (struct fscache_linux_dirent64 *)(w->dents + pos);
+			if (!fscache_dir_add_name(dir, &size, de->d_name)) {
+				fscache_dir_fail(dir, ENOMEM);
+				return dir;
+			}
+		}
+	}
+
+	return dir;
+}
+
+static bool fscache_walker_path(struct fscache_walker *w, struct fscache_walk_node *node, const char *name, size_t *pathlen)
+{
+	size_t dirlen, namelen, size;
+	char *path;
+
+	dirlen = fscache_path_dirlen(node->path, node->pathlen);
+	namelen = strlen(name);
+	size = dirlen + namelen + 2;
+	if (size > w->path_size) {
+		path = realloc(w->path, size);
+		if (path == NULL)
+			return false;
+		w->path = path;
+		w->path_size = size;
+	}
+
+	memcpy(w->path, node->path, dirlen);
+	w->path[dirlen] = '/';
+	memcpy(w->path + dirlen + 1, name, namelen + 1);
+	*pathlen = dirlen + namelen + 1;
+
+	return true;
+}
+
+/* The same as fscache_read_stat, relative to the directory */
+static void fscache_walk_read_stat(int fd, const char *name, const char *path, struct fscache_stat *fs)
+{
+	if (fd < 0) {
+		fscache_read_stat(path, fs);
+		return;
+	}
+
+	fs->lerr = fs->err = 0;
+	if (fstatat(fd, name, &fs->lst, AT_SYMLINK_NOFOLLOW) != 0) {
+		fs->lerr = errno;
+		memset(&fs->lst, 0, sizeof(struct stat));
+		memset(&fs->st, 0, sizeof(struct stat));
+		return;
+	}
+
+	if (!S_ISLNK(fs->lst.st_mode)) {
+		memcpy(&fs->st, &fs->lst, sizeof(struct stat));
+		return;
+	}
+
+	if (fstatat(fd, name, &fs->st, 0) != 0) {
+		fs->err = errno;
+		memset(&fs->st, 0, sizeof(struct stat));
+	}
+}
+
+/* Start reading the directory unless the traversal got to it or skipped it */
+static bool fscache_walk_begin(fscache_prefetch_t *pf, struct fscache_walk_node *node)
+{
+	struct fscache_ahead *ahead;
+	bool begun = false;
+
+	pthread_mutex_lock(&pf->lock);
+	if (rbt_str_get(pf->dirs, node->path, (void **)&ahead) == 0 &&
+	    ahead->state == FSCACHE_AHEAD_QUEUED) {
+		ahead->state = FSCACHE_AHEAD_READING;
+		begun = true;
+	}
+	pthread_mutex_unlock(&pf->lock);
+
+	return begun;
+}
+
+static bool fscache_walker_add_child(struct fscache_walker *w, size_t *count, struct fscache_walk_node *child)
+{
+	struct fscache_walk_node **children;
+	size_t size;
+
+	if (*count == w->children_size) {
+		size = w->children_size == 0 ? FSCACHE_PREFETCH_QUEUE_INIT : w->children_size * 2;
+		children = realloc(w->children, size * sizeof(struct fscache_walk_node *));
+		if (children == NULL)
+			return false;
+		w->children = children;
+		w->children_size = size;
+	}
+	w->children[(*count)++] = child;
+
+	return true;
+}
+
+/*
+ * Hand the directory read over to the traversal, or drop it if it has no
+ * entries to hand over, and queue its subdirectories. If the traversal
+ * got to the directory meanwhile, the subdirectories are dropped too.
+ */
+static void fscache_walk_finish(struct fscache_walker *w, fscache_prefetch_t *pf,
+		struct fscache_walk_node *node, struct fscache_dir *dir, size_t count)
+{
+	struct fscache_ahead *ahead, *queued;
+	struct fscache_walk_node *child;
+	size_t i, queue = 0;
+	bool taken = false;
+	char *key;
+
+	pthread_mutex_lock(&pf->lock);
+	if (rbt_str_get(pf->dirs, node->path, (void **)&ahead) != 0) {
+		taken = true;
+	} else if (dir != NULL) {
+		ahead->state = FSCACHE_AHEAD_READY;
+		ahead->dir = dir;
+		fscache_prefetch_set_ahead(pf, pf->ahead + fscache_ahead_size(dir));
+		dir = NULL;
+	} else if (rbt_str_del(pf->dirs, node->path, NULL) == 0) {
+		free(ahead);
+	}
+
+	for (i = 0; i < count; ++i) {
+		child = w->children[i];
+		if (!taken) {
+			queued = calloc(1, sizeof(struct fscache_ahead));
+			key = strdup(child->path);
+			if (queued != NULL && key != NULL && rbt_str_add(pf->dirs, key, queued) == 0) {
+				w->children[queue++] = child;
+				continue;
+			}
+			free(queued);
+			free(key);
+		}
+		fscache_walk_node_release(child);
+	}
+	pthread_cond_broadcast(&pf->ready);
+	pthread_mutex_unlock(&pf->lock);
+
+	if (dir != NULL)
+		fscache_dir_free(dir);
+
+	/* a node failed to be queued is removed by the traversal */
+	for (i = queue; i-- > 0;) {
+		if (!fscache_walk_push(pf, w->children[i]))
+			fscache_walk_node_release(w->children[i]);
+	}
+}
+
+/*
+ * Read the entries of the directory and stat them, the subdirectories
+ * the traversal descends into are queued. The entries of a directory
+ * found in the cache aren't handed over, only its subdirectories are
+ * queued.
+ */
+static void fscache_walk_dir(struct fscache_walker *w, fscache_prefetch_t *pf, struct fscache_walk_node *node)
+{
+	const struct fscache_stat *fs;
+	struct fscache_stat buf, *res;
+	struct fscache_walk_node *child;
+	struct fscache_dir *dir, *read = NULL;
+	size_t i, pathlen, count = 0;
+	bool descend;
+	int fd = -1;
+
+	if (!fscache_walk_begin(pf, node))
+		return;
+
+	dir = fscache_find(pf->cache, pf->cache->dirs, node->path);
+	if (dir == NULL) {
+		fd = open(node->path, O_RDONLY | O_NONBLOCK | O_DIRECTORY | O_CLOEXEC);
+		read = fscache_walk_read_dir(w, fd);
+		if (read != NULL && read->err == 0 && read->count > 0) {
+			read->stats = malloc(read->count * sizeof(struct fscache_stat));
+			if (read->stats == NULL)
+				fscache_dir_fail(read, ENOMEM);
+		}
+		if (read == NULL || read->err != 0) {
+			/* left to the traversal, it reports the error */
+			if (read != NULL)
+				fscache_dir_free(read);
+			read = NULL;
+			goto out;
+		}
+		dir = read;
+	}
+
+	descend = pf->max_depth == -1 || node->level < pf->max_depth;
+
+	for (i = 0; i < dir->count && !fscache_prefetch_stopped(pf); ++i) {
+		if (!fscache_walker_path(w, node, dir->names[i], &pathlen))
+			break;
+
+		fs = fscache_find(pf->cache, pf->cache->stats, w->path);
+		if (fs == NULL) {
+			res = read != NULL ? &read->stats[i] : &buf;
+			if (fd < 0)
+				fd = open(node->path, O_RDONLY | O_NONBLOCK | O_DIRECTORY | O_CLOEXEC);
+			fscache_walk_read_stat(fd, dir->names[i], w->path, res);
+			fs = res;
+		} else if (read != NULL) {
+			memcpy(&read->stats[i], fs, sizeof(struct fscache_stat));
+		}
+
+		if (!descend || fs->lerr != 0 || !S_ISDIR(fs->lst.st_mode))
+			continue;
+		if (fscache_walk_node_cycle(node, &fs->lst))
+			continue;
+		if (pf->descend != NULL && !pf->descend(pf->arg, w->path, &fs->lst))
+			continue;
+
+		child = fscache_walk_node_new(node, w->path, pathlen, &fs->lst);
+		if (child == NULL)
+			break;
+		if (!fscache_walker_add_child(w, &count, child)) {
+			fscache_walk_node_release(child);
+			break;
+		}
+	}
+	if (read != NULL && i < read->count) {
+		/* a partial listing is never handed over */
+		fscache_dir_free(read);
+		read = NULL;
+	}
+out:
+	if (fd >= 0)
+		close(fd);
+	fscache_walk_finish(w, pf, node, read, count);
+}
+
+static void *fscache_prefetch_worker(void *arg)
+{
+	struct fscache_walker *w = arg;
+	struct fscache_walk_node *node;
+	fscache_prefetch_t *pf;
+
+	pthread_mutex_lock(&fscache_pool.lock);
+	for (;;) {
+		node = NULL;
+		while (!fscache_pool.stop && (node = fscache_walk_take(&pf)) == NULL)
+			pthread_cond_wait(&fscache_pool.work, &fscache_pool.lock);
+		if (node == NULL)
+			break;
+		pthread_mutex_unlock(&fscache_pool.lock);
+
+		if (!fscache_prefetch_stopped(pf))
+			fscache_walk_dir(w, pf, node);
+		fscache_walk_node_release(node);
+
+		pthread_mutex_lock(&fscache_pool.lock);
+		if (--pf->busy == 0 && fscache_prefetch_stopped(pf))
+			pthread_cond_broadcast(&fscache_pool.idle);
+	}
+	pthread_mutex_unlock(&fscache_pool.lock);
+
+	return NULL;
+}
+
+/* Start the threads of the pool, called with the pool locked */
+static bool fscache_pool_start(void)
+{
+	uint32_t nthreads, i;
+	int ret;
+
+	if (fscache_pool.nthreads > 0)
+		return !fscache_pool.stop;
+
+	nthreads = fscache_prefetch_max_threads();
+	if (nthreads == 0)
+		return false;
+
+	fscache_pool.threads = calloc(nthreads, sizeof(pthread_t));
+	fscache_pool.walkers = calloc(nthreads, sizeof(struct fscache_walker));
+	if (fscache_pool.threads == NULL || fscache_pool.walkers == NULL)
+		goto fail;
+	for (i = 0; i < nthreads; ++i) {
+		fscache_pool.walkers[i].dents = malloc(FSCACHE_PREFETCH_BUFSIZE);
+		if (fscache_pool.walkers[i].dents == NULL)
+			goto fail;
+	}
+
+	for (i = 0; i < nthreads; ++i) {
+		ret = pthread_create(&fscache_pool.threads[i], NULL, &fscache_prefetch_worker, &fscache_pool.walkers[i]);
+		if (ret != 0) {
+			dW("Can't start the prefetch threads: %s", strerror(ret));
+			break;
+		}
+	}
+	if (i == 0)
+		goto fail;
+
+	fscache_pool.nthreads = i;
+	dD("Started %u prefetch threads.", i);
+
+	return true;
+fail:
+	for (i = 0; fscache_pool.walkers != NULL && i < nthreads; ++i)
+		free(fscache_pool.walkers[i].dents);
+	free(fscache_pool.walkers);
+	free(fscache_pool.threads);
+	fscache_pool.walkers = NULL;
+	fscache_pool.threads = NULL;
+	return false;
+}
+
+static void fscache_pool_stop(void)
+{
+	pthread_t *threads;
+	struct fscache_walker *walkers;
+	uint32_t nthreads, i;
+
+	pthread_mutex_lock(&fscache_pool.lock);
+	nthreads = fscache_pool.nthreads;
+	threads = fscache_pool.threads;
+	walkers = fscache_pool.walkers;
+	if (nthreads > 0) {
+		fscache_pool.stop = true;
+		pthread_cond_broadcast(&fscache_pool.work);
+	}
+	pthread_mutex_unlock(&fscache_pool.lock);
+
+	if (nthreads == 0)
+		return;
+
+	for (i = 0; i < nthreads; ++i)
+		pthread_join(threads[i], NULL);
+	for (i = 0; i < nthreads; ++i) {
+		free(walkers[i].dents);
+		free(walkers[i].path);
+		free(walkers[i].children);
+	}
+	free(walkers);
+	free(threads);
+
+	pthread_mutex_lock(&fscache_pool.lock);
+	fscache_pool.threads = NULL;
+	fscache_pool.walkers = NULL;
+	fscache_pool.nthreads = 0;
+	fscache_pool.stop = false;
+	pthread_mutex_unlock(&fscache_pool.lock);
+}
+
+static void fscache_free_ahead_node(struct rbt_str_node *n)
+{
+	struct fscache_ahead *ahead = n->data;
+
+	free(n->key);
+	if (ahead->dir != NULL)
+		fscache_dir_free(ahead->dir);
+	free(ahead);
+}
+
+static void fscache_prefetch_free(fscache_prefetch_t *pf)
+{
+	size_t i;
+
+	for (i = 0; i < pf->count; ++i)
+		fscache_walk_node_release(pf->nodes[i]);
+	free(pf->nodes);
+	rbt_str_free_cb(pf->dirs, &fscache_free_ahead_node);
+	pthread_cond_destroy(&pf->ready);
+	pthread_mutex_destroy(&pf->lock);
+	fscache_release(pf->cache);
+	free(pf);
+}
+
+fscache_prefetch_t *fscache_prefetch_start(fscache_fts_t *fts, int max_depth,
+		fscache_prefetch_descend_t descend, void *arg)
+{
+	fscache_prefetch_t *pf;
+	fscache_ftsent_t *ent;
+	struct fscache_walk_node *root;
+	struct fscache_ahead *ahead;
+	char *key;
+
+	if (fts == NULL || fts->started || fts->prefetch != NULL || fts->cache == NULL)
+		return NULL;
+	ent = fts->root;
+	if (max_depth == 0 || ent->fts_info != FTS_D)
+		return NULL;
+	if (descend != NULL && !descend(arg, ent->fts_path, ent->fts_statp))
+		return NULL;
+
+	pf = calloc(1, sizeof(fscache_prefetch_t));
+	if (pf == NULL)
+		return NULL;
+	pf->cache = fscache_get();
+	if (pf->cache == NULL) {
+		free(pf);
+		return NULL;
+	}
+	pf->fts = fts;
+	pf->max_depth = max_depth;
+	pf->descend = descend;
+	pf->arg = arg;
+	pthread_mutex_init(&pf->lock, NULL);
+	pthread_cond_init(&pf->ready, NULL);
+	pf->dirs = rbt_str_new();
+	pf->max_ahead = pf->cache->max_entries / FSCACHE_OBJECT_SHARE;
+
+	root = fscache_walk_node_new(NULL, ent->fts_path, (size_t)ent->fts_pathlen, ent->fts_statp);
+	if (root == NULL) {
+		fscache_prefetch_free(pf);
+		return NULL;
+	}
+	pf->nodes = malloc(FSCACHE_PREFETCH_QUEUE_INIT * sizeof(struct fscache_walk_node *));
+	ahead = calloc(1, sizeof(struct fscache_ahead));
+	key = strdup(ent->fts_path);
+	if (pf->nodes == NULL || ahead == NULL || key == NULL ||
+	    rbt_str_add(pf->dirs, key, ahead) != 0) {
+		free(ahead);
+		free(key);
+		free(root);
+		fscache_prefetch_free(pf);
+		return NULL;
+	}
+	pf->size = FSCACHE_PREFETCH_QUEUE_INIT;
+	pf->nodes[pf->count++] = root;
+
+	pthread_mutex_lock(&fscache_pool.lock);
+	if (!fscache_pool_start()) {
+		pthread_mutex_unlock(&fscache_pool.lock);
+		fscache_prefetch_free(pf);
+		return NULL;
+	}
+	pf->next = fscache_pool.prefetches;
+	fscache_pool.prefetches = pf;
+	pthread_cond_signal(&fscache_pool.work);
+	pthread_mutex_unlock(&fscache_pool.lock);
+
+	fts->prefetch = pf;
+	dD("Prefetching '%s'.", ent->fts_path);
+
+	return pf;
+}
+
+void fscache_prefetch_stop(fscache_prefetch_t *pf)
+{
+	fscache_prefetch_t **link;
+
+	if (pf == NULL)
+		return;
+
+	pthread_mutex_lock(&fscache_pool.lock);
+	fscache_prefetch_set_stopped(pf);
+	for (link = &fscache_pool.prefetches; *link != NULL; link = &(*link)->next) {
+		if (*link == pf) {
+			*link = pf->next;
+			break;
+		}
+	}
+	while (pf->busy > 0)
+		pthread_cond_wait(&fscache_pool.idle, &fscache_pool.lock);
+	pthread_mutex_unlock(&fscache_pool.lock);
+
+	pf->fts->prefetch = NULL;
+	fscache_prefetch_free(pf);
+}
+
+/*
+ * Remove the directory, returns its entries if they were ready. Called
+ * with the prefetch locked.
+ */
+static struct fscache_dir *fscache_prefetch_remove(fscache_prefetch_t *pf, const char *path)
+{
+	struct fscache_ahead *ahead;
+	struct fscache_dir *dir;
+
+	if (rbt_str_get(pf->dirs, path, (void **)&ahead) != 0)
+		return NULL;
+
+	dir = ahead->dir;
+	if (dir != NULL)
+		fscache_prefetch_set_ahead(pf, pf->ahead - fscache_ahead_size(dir));
+	if (rbt_str_del(pf->dirs, path, NULL) == 0)
+		free(ahead);
+
+	return dir;
+}
+
+/* Remove the directory and its subdirectories, called with the prefetch locked */
+static void fscache_prefetch_drop(fscache_prefetch_t *pf, const char *path)
+{
+	struct fscache_dir *dir;
+	size_t i, dirlen, namelen;
+	char *subdir;
+
+	dir = fscache_prefetch_remove(pf, path);
+	if (dir == NULL)
+		return;
+
+	/* the subdirectories were queued when the directory was read */
+	dirlen = fscache_path_dirlen(path, strlen(path));
+	for (i = 0; i < dir->count; ++i) {
+		if (dir->stats[i].lerr != 0 || !S_ISDIR(dir->stats[i].lst.st_mode))
+			continue;
+		namelen = strlen(dir->names[i]);
+		subdir = malloc(dirlen + namelen + 2);
+		if (subdir == NULL)
+			continue;
+		memcpy(subdir, path, dirlen);
+		subdir[dirlen] = '/';
+		memcpy(subdir + dirlen + 1, dir->names[i], namelen + 1);
+		fscache_prefetch_drop(pf, subdir);
+		free(subdir);
+	}
+	fscache_dir_free(dir);
+}
+
+/* Wake the pool up if the prefetch was paused before the lock was taken */
+static void fscache_prefetch_resume(fscache_prefetch_t *pf, bool paused)
+{
+	if (!paused || fscache_prefetch_paused(pf))
+		return;
+
+	pthread_mutex_lock(&fscache_pool.lock);
+	pthread_cond_broadcast(&fscache_pool.work);
+	pthread_mutex_unlock(&fscache_pool.lock);
+}
+
+/*
+ * Take the entries of the directory read ahead, wait for them if the
+ * directory is being read. Returns NULL if the traversal reads the
+ * directory by itself, the prefetch drops its subdirectories then.
+ */
+static struct fscache_dir *fscache_prefetch_take(fscache_prefetch_t *pf, const char *path)
+{
+	struct fscache_ahead *ahead;
+	struct fscache_dir *dir;
+	bool paused;
+
+	if (pf == NULL)
+		return NULL;
+
+	pthread_mutex_lock(&pf->lock);
+	while (rbt_str_get(pf->dirs, path, (void **)&ahead) == 0 &&
+	       ahead->state == FSCACHE_AHEAD_READING)
+		pthread_cond_wait(&pf->ready, &pf->lock);
+	paused = pf->ahead >= pf->max_ahead;
+	dir = fscache_prefetch_remove(pf, path);
+	pthread_mutex_unlock(&pf->lock);
+
+	fscache_prefetch_resume(pf, paused);
+
+	return dir;
+}
+
+/* Drop the directory skipped by the traversal and its subdirectories */
+static void fscache_prefetch_skip(fscache_prefetch_t *pf, const char *path)
+{
+	bool paused;
+
+	if (pf == NULL)
+		return;
+
+	pthread_mutex_lock(&pf->lock);
+	paused = pf->ahead >= pf->max_ahead;
+	fscache_prefetch_drop(pf, path);
+	pthread_mutex_unlock(&pf->lock);
+
+	fscache_prefetch_resume(pf, paused);
+}
+
+#else
+
+fscache_prefetch_t *fscache_prefetch_start(fscache_fts_t *fts, int max_depth,
+		fscache_prefetch_descend_t descend, void *arg)
+{
+	return NULL;
+}
+
+void fscache_prefetch_stop(fscache_prefetch_t *pf)
+{
+}
+
+static void fscache_pool_stop(void)
+{
+}
+
+static struct fscache_dir *fscache_prefetch_take(fscache_prefetch_t *pf, const char *path)
+{
+	return NULL;
+}
+
+static void fscache_prefetch_skip(fscache_prefetch_t *pf, const char *path)
+{
+}
+
+#endif
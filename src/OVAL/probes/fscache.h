@@ -0,0 +1,173 @@
+/**
+ * @file   fscache.h
+ * @brief  filesystem metadata cache of the file probes
+ */
+/*
+ * Copyright 2026 Red Hat Inc., Durham, North Carolina.
+ * All Rights Reserved.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+#pragma once
+#ifndef FSCACHE_H
+#define FSCACHE_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <sys/types.h>
+#include <sys/stat.h>
+
+/*
+ * Cache of the directory entries and of the results of stat and lstat,
+ * keyed by the path. The cache lives for the duration of a scan, the
+ * entries are never invalidated, so every traversal of a subtree after
+ * the first one and every repeated stat of a path are memory lookups.
+ * The cache is dropped when the probes are reset and when the last
+ * probe thread exits. The number of cached paths is limited by the
+ * OSCAP_FS_CACHE_SIZE environment variable, 0 disables the cache.
+ * A single traversal caches at most a quarter of the limit, so that
+ * one large object doesn't take the room of the others. Directories
+ * which can't be read completely aren't cached.
+ */
+
+typedef struct fscache fscache_t;
+
+typedef struct {
+	uint32_t stat_lookups;
+	uint32_t stat_hits;
+	uint32_t dir_lookups;
+	uint32_t dir_hits;
+	uint32_t prefetch_hits; /**< directories read ahead by a prefetch */
+	uint32_t entries;      /**< cached paths and directory entries */
+} fscache_stats_t;
+
+/**
+ * Get the cache of the current scan, create it if there's none.
+ * Release it by fscache_release.
+ */
+fscache_t *fscache_get(void);
+void fscache_release(fscache_t *cache);
+
+/**
+ * Register a probe thread using the cache. The cache is dropped after
+ * the last probe thread calls fscache_drop.
+ */
+void fscache_hold(void);
+void fscache_drop(void);
+
+/**
+ * Drop the cache of the current scan, the next fscache_get creates
+ * an empty one.
+ */
+void fscache_reset(void);
+
+/**
+ * Get the hit counters of the cache of the current scan.
+ */
+void fscache_stats(fscache_stats_t *stats);
+
+/**
+ * stat(2) and lstat(2) through the cache of the current scan.
+ */
+int fscache_stat(const char *path, struct stat *st);
+int fscache_lstat(const char *path, struct stat *st);
+
+/*
+ * Traversal of a file hierarchy reading through the cache. It behaves
+ * like fts(3) with the FTS_PHYSICAL, FTS_COMFOLLOW, FTS_NOCHDIR and
+ * FTS_XDEV options used by oval_fts, the entries are visited in the
+ * same order and have the fts_info values and fts_set instructions of
+ * fts(3). Unlike fts(3), the path of an entry stays valid until the
+ * entry is left.
+ */
+
+typedef struct fscache_ftsent {
+	struct fscache_ftsent *fts_parent;
+	char *fts_path;
+	int fts_pathlen;
+	char *fts_name;            /**< the last component of fts_path */
+	int fts_namelen;
+	int fts_level;             /**< 0 for the root */
+	unsigned short fts_info;   /**< FTS_D, FTS_F, ... */
+	unsigned short fts_instr;  /**< set by fscache_fts_set */
+	int fts_errno;
+	dev_t fts_dev;             /**< directories only */
+	ino_t fts_ino;             /**< directories only */
+	struct stat *fts_statp;
+	/* private */
+	struct fscache_dir *dir;
+	struct fscache_stat *dir_stats; /**< of the entries of dir if read ahead */
+	size_t dir_pos;
+	struct stat statb;
+} fscache_ftsent_t;
+
+typedef struct fscache_fts fscache_fts_t;
+
+/**
+ * Start a traversal of the hierarchy under the path.
+ * @param options FTS_PHYSICAL, FTS_COMFOLLOW, FTS_NOCHDIR and FTS_XDEV
+ * @return NULL and errno set if the path can't be stat'ed
+ */
+fscache_fts_t *fscache_fts_open(const char *path, int options);
+fscache_ftsent_t *fscache_fts_read(fscache_fts_t *fts);
+int fscache_fts_set(fscache_fts_t *fts, fscache_ftsent_t *ent, int instr);
+int fscache_fts_close(fscache_fts_t *fts);
+
+/*
+ * Parallel read of the hierarchy of a traversal ahead of it. The
+ * directories are read by a pool of threads shared by all the prefetches,
+ * each thread reads the entries of a directory, stats them relative to
+ * it and hands both over to the traversal, which takes them instead of
+ * reading the directory itself and caches them within its own share.
+ * The traversal waits for a directory being read, the directories the
+ * prefetch hasn't reached yet and those reached by symlinks it reads by
+ * itself, and the prefetch drops the subtrees the traversal reads or
+ * skips. The prefetch doesn't stop on large trees, it pauses while the
+ * directories read ahead hold the share of the cache of a traversal.
+ * The pool is started by the first prefetch and stopped by fscache_drop
+ * of the last probe thread, its size is set by the
+ * OSCAP_FS_PREFETCH_THREADS environment variable, 0 disables prefetching.
+ */
+
+typedef struct fscache_prefetch fscache_prefetch_t;
+
+/**
+ * Tell whether the traversal descends into the directory.
+ * Called by the prefetch threads concurrently.
+ */
+typedef bool (*fscache_prefetch_descend_t)(void *arg, const char *path, const struct stat *st);
+
+/**
+ * Start reading the hierarchy of the traversal in the background,
+ * before its first fscache_fts_read.
+ * @param fts the traversal taking the directories read
+ * @param max_depth the deepest level of the directories read, -1 for no limit
+ * @param descend filter of the directories, may be NULL
+ * @return the prefetch, or NULL if it isn't possible or the pool
+ *         can't be started
+ */
+fscache_prefetch_t *fscache_prefetch_start(fscache_fts_t *fts, int max_depth,
+		fscache_prefetch_descend_t descend, void *arg);
+
+/**
+ * Stop the prefetch and wait for the threads reading its directories.
+ * The prefetch is stopped by fscache_fts_close of its traversal if it's
+ * still running.
+ */
+void fscache_prefetch_stop(fscache_prefetch_t *pf);
+
+#endif /* FSCACHE_H */
@@ -41,6 +41,7 @@
 
 #if defined(OS_LINUX)
 # include <mntent.h>
+# include <limits.h>
 # include <unistd.h>
 #elif defined(OS_SOLARIS)
 # include <sys/mnttab.h>
@@ -168,6 +169,11 @@ static fsdev_t *__fsdev_init(fsdev_t *lfs)
 
 	struct mntent *ment;
 	struct stat st;
+#if defined(OS_LINUX)
+	/* file probes may run concurrently, use the reentrant variant */
+	struct mntent ment_buf;
+	char ment_strbuf[PATH_MAX * 2];
+#endif
 
 	fp = setmntent(_PATH_MOUNTED, "r");
 	if (fp == NULL) {
@@ -190,7 +196,11 @@ static fsdev_t *__fsdev_init(fsdev_t *lfs)
 	lfs->cnt = DEVID_ARRAY_SIZE;
 	i = 0;
 
+#if defined(OS_LINUX)
+	while ((ment = getmntent_r(fp, &ment_buf, ment_strbuf, sizeof ment_strbuf)) != NULL) {
+#else
 	while ((ment = getmntent(fp)) != NULL) {
+#endif
 		if (!is_local_fs(ment))
 			continue;
 		if (stat(ment->mnt_dir, &st) != 0)
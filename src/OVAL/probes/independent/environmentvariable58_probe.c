@@ -56,44 +56,32 @@
 #include "probe-api.h"
 #include "probe/entcmp.h"
 #include "common/debug_priv.h"
+#include "probe/proctable.h"
 #include "environmentvariable58_probe.h"
 
-#define BUFFER_SIZE 256
 #define VAR_OFFLINE_PREFIX "OSCAP_OFFLINE_"
 
 extern char **environ;
 
 static int read_environment(SEXP_t *pid_ent, SEXP_t *name_ent, probe_ctx *ctx)
 {
-	int err = 1, pid, fd;
-	bool empty;
-	size_t env_name_size;
+	int err = 1;
+	size_t i, count, env_name_size;
 	SEXP_t *env_name, *env_value, *item, *pid_sexp;
-	DIR *d;
-	struct dirent *d_entry;
-	char *buffer, env_file[256], *null_char;
-	ssize_t buffer_used;
-	size_t buffer_size;
-
-	d = opendir("/proc");
-	if (d == NULL) {
+	probe_proctable_t *table;
+	char *entry, *end, *next, *eq_char;
+
+	table = probe_proctable_get();
+	if (table == NULL) {
 		dE("Can't read /proc: errno=%d, %s.", errno, strerror (errno));
 		return PROBE_EACCESS;
 	}
 
-	if ((buffer = realloc(NULL, BUFFER_SIZE)) == NULL) {
-		dE("Can't allocate memory");
-		closedir(d);
-		return PROBE_EFAULT;
-	}
-	buffer_size = BUFFER_SIZE;
+	count = probe_proctable_count(table);
+	for (i = 0; i < count; ++i) {
+		probe_proc_t *proc = probe_proctable_at(table, i);
 
-	while ((d_entry = readdir(d))) {
-		if (strspn(d_entry->d_name, "0123456789") != strlen(d_entry->d_name))
-			continue;
-
-		pid = atoi(d_entry->d_name);
-		pid_sexp = SEXP_number_newi_32(pid);
+		pid_sexp = SEXP_number_newi_32(proc->pid);
 
 		if (probe_entobj_cmp(pid_ent, pid_sexp) != OVAL_RESULT_TRUE) {
 			SEXP_free(pid_sexp);
@@ -101,100 +89,67 @@ static int read_environment(SEXP_t *pid_ent, SEXP_t *name_ent, probe_ctx *ctx)
 		}
 		SEXP_free(pid_sexp);
 
-		sprintf(env_file, "/proc/%d/environ", pid);
+		probe_proctable_load(table, proc, PROBE_PROC_ENVIRON);
 
-		if ((fd = open(env_file, O_RDONLY)) == -1) {
-			dE("Can't open \"%s\": errno=%d, %s.", env_file, errno, strerror (errno));
+		if (proc->environ == NULL) {
+			dE("Can't open \"/proc/%d/environ\": errno=%d, %s.", proc->pid,
+			   proc->environ_errno, strerror (proc->environ_errno));
 			item = probe_item_create(
 					OVAL_INDEPENDENT_ENVIRONMENT_VARIABLE58, NULL,
-					"pid", OVAL_DATATYPE_INTEGER, (int64_t)pid,
+					"pid", OVAL_DATATYPE_INTEGER, (int64_t)proc->pid,
 					NULL
 			);
 
 			probe_item_setstatus(item, SYSCHAR_STATUS_ERROR);
 			probe_item_add_msg(item, OVAL_MESSAGE_LEVEL_ERROR,
-					   "Can't open \"%s\": errno=%d, %s.", env_file, errno, strerror (errno));
+					   "Can't open \"/proc/%d/environ\": errno=%d, %s.", proc->pid,
+					   proc->environ_errno, strerror (proc->environ_errno));
 			probe_item_collect(ctx, item);
 			continue;
 		}
 
-		empty = true;
-
-		if ((buffer_used = read(fd, buffer, buffer_size - 1)) > 0) {
-			empty = false;
-		}
-
-		while (! empty) {
-			while (! (null_char = memchr(buffer, 0, buffer_used))) {
-				ssize_t s;
-				if ((size_t)buffer_used >= buffer_size) {
-					buffer_size += BUFFER_SIZE;
-					buffer = realloc(buffer, buffer_size);
-					if (buffer == NULL) {
-						dE("Can't allocate memory");
-						exit(ENOMEM);
-					}
-
-				}
-				s = read(fd, buffer + buffer_used, buffer_size - buffer_used);
-				if (s <= 0) {
-					empty = true;
-					buffer[buffer_used++] = 0;
-				}
-				else {
-					buffer_used += s;
-				}
+		/* the variables are separated by zeros, the snapshot is terminated by one */
+		end = proc->environ + proc->environ_len;
+		for (entry = proc->environ; entry < end; entry = next) {
+			next = entry + strlen(entry) + 1;
+
+			eq_char = strchr(entry, '=');
+			if (eq_char == NULL) {
+				/* strange but possible:
+				 * $ strings /proc/1218/environ
+				 /dev/input/event0 /dev/input/event1 /dev/input/event4 /dev/input/event3
+				*/
+				continue;
 			}
 
-			do {
-				char *eq_char = strchr(buffer, '=');
-				if (eq_char == NULL) {
-					/* strange but possible:
-					 * $ strings /proc/1218/environ
- 					/dev/input/event0 /dev/input/event1 /dev/input/event4 /dev/input/event3
-					*/
-					buffer_used -= null_char + 1 - buffer;
-					memmove(buffer, null_char + 1, buffer_used);
+			env_name_size = eq_char - entry;
+			if (ctx->offline_mode == PROBE_OFFLINE_OWN) {
+				// We are not processing unprefixed (i.e. originated from the host) variables in offline mode
+				if (memmem(entry, env_name_size, VAR_OFFLINE_PREFIX, strlen(VAR_OFFLINE_PREFIX)) != entry
+					|| strlen(VAR_OFFLINE_PREFIX) >= env_name_size) {
 					continue;
 				}
+				env_name = SEXP_string_new(entry + strlen(VAR_OFFLINE_PREFIX), env_name_size - strlen(VAR_OFFLINE_PREFIX));
+			} else {
+				env_name = SEXP_string_new(entry, env_name_size);
+			}
+			env_value = SEXP_string_newf("%s", eq_char + 1);
 
-				env_name_size = eq_char - buffer;
-				if (ctx->offline_mode == PROBE_OFFLINE_OWN) {
-					// We are not processing unprefixed (i.e. originated from the host) variables in offline mode
-					if (memmem(buffer, env_name_size, VAR_OFFLINE_PREFIX, strlen(VAR_OFFLINE_PREFIX)) != buffer
-						|| strlen(VAR_OFFLINE_PREFIX) >= env_name_size) {
-						buffer_used -= null_char + 1 - buffer;
-						memmove(buffer, null_char + 1, buffer_used);
-						continue;
-					}
-					env_name = SEXP_string_new(buffer + strlen(VAR_OFFLINE_PREFIX), env_name_size - strlen(VAR_OFFLINE_PREFIX));
-				} else {
-					env_name = SEXP_string_new(buffer, env_name_size);
-				}
-				env_value = SEXP_string_newf("%s", buffer + env_name_size + 1);
-
-				if (probe_entobj_cmp(name_ent, env_name) == OVAL_RESULT_TRUE) {
-					item = probe_item_create(
-						OVAL_INDEPENDENT_ENVIRONMENT_VARIABLE58, NULL,
-						"pid", OVAL_DATATYPE_INTEGER, (int64_t)pid,
-						"name",  OVAL_DATATYPE_SEXP, env_name,
-						"value", OVAL_DATATYPE_SEXP, env_value,
-						NULL);
-					probe_item_collect(ctx, item);
-					err = 0;
-				}
-				SEXP_free(env_name);
-				SEXP_free(env_value);
-
-				buffer_used -= null_char + 1 - buffer;
-				memmove(buffer, null_char + 1, buffer_used);
-			} while ((null_char = memchr(buffer, 0, buffer_used)));
+			if (probe_entobj_cmp(name_ent, env_name) == OVAL_RESULT_TRUE) {
+				item = probe_item_create(
+					OVAL_INDEPENDENT_ENVIRONMENT_VARIABLE58, NULL,
+					"pid", OVAL_DATATYPE_INTEGER, (int64_t)proc->pid,
+					"name",  OVAL_DATATYPE_SEXP, env_name,
+					"value", OVAL_DATATYPE_SEXP, env_value,
+					NULL);
+				probe_item_collect(ctx, item);
+				err = 0;
+			}
+			SEXP_free(env_name);
+			SEXP_free(env_value);
 		}
-
-		close(fd);
 	}
-	closedir(d);
-	free(buffer);
+	probe_proctable_release(table);
 	if (err) {
 		SEXP_t *msg = probe_msg_creatf(OVAL_MESSAGE_LEVEL_ERROR,
 				"Can't find process with requested PID.");
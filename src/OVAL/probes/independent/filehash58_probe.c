@@ -43,8 +43,8 @@
 #include <sys/stat.h>
 #include <fcntl.h>
 #include <limits.h>
-#include <pthread.h>
 #include <errno.h>
+#include <pthread.h>
 #include <crapi/crapi.h>
 #include <probe/probe.h>
 #include <probe/option.h>
@@ -102,14 +102,118 @@ static int mem2hex (uint8_t *mem, size_t mlen, char *str, size_t slen)
 	return (0);
 }
 
-static int filehash58_cb(const char *prefix, const char *p, const char *f, const char *h, probe_ctx *ctx)
+/* number of hash types in CRAPI_ALG_MAP */
+#define FILEHASH58_ALG_CNT 6
+/* longest digest in CRAPI_ALG_MAP_SIZE */
+#define FILEHASH58_DIGEST_MAX 64
+
+#define FILEHASH58_MEMO_HSIZE 4096
+/* maximum number of files in the memo, new files aren't memoized above it */
+#define FILEHASH58_MEMO_MAX 16384
+
+/*
+ * Digests of a file computed during the scan. A file is identified by its
+ * device and inode and the entry is valid as long as the file's size and
+ * modification time don't change.
+ */
+struct filehash58_memo {
+	dev_t    dev;
+	ino_t    ino;
+	off_t    size;
+	uint64_t mtime_sec;
+	uint64_t mtime_nsec;
+	uint8_t  have; /* bit i is set if digest[i] is valid */
+	uint8_t  digest[FILEHASH58_ALG_CNT][FILEHASH58_DIGEST_MAX];
+	struct filehash58_memo *next;
+};
+
+struct filehash58_state {
+	pthread_mutex_t lock;
+	struct filehash58_memo *table[FILEHASH58_MEMO_HSIZE];
+	size_t count;
+};
+
+/*
+ * The memo is shared by all the objects until the probe is reset, like the
+ * process table and the filesystem cache.
+ */
+static struct filehash58_state filehash58_memo = {
+	.lock = PTHREAD_MUTEX_INITIALIZER
+};
+
+static void filehash58_memo_key(const struct stat *st, struct filehash58_memo *key)
+{
+	key->dev  = st->st_dev;
+	key->ino  = st->st_ino;
+	key->size = st->st_size;
+#if defined(OS_FREEBSD)
+	key->mtime_sec  = (uint64_t) st->st_mtimespec.tv_sec;
+	key->mtime_nsec = (uint64_t) st->st_mtimespec.tv_nsec;
+#elif defined(OS_LINUX) || defined(OS_SOLARIS)
+	key->mtime_sec  = (uint64_t) st->st_mtim.tv_sec;
+	key->mtime_nsec = (uint64_t) st->st_mtim.tv_nsec;
+#else /* Use the legacy field */
+	key->mtime_sec  = (uint64_t) st->st_mtime;
+	key->mtime_nsec = 0;
+#endif
+}
+
+static size_t filehash58_memo_hash(const struct filehash58_memo *key)
+{
+	uint64_t h = (uint64_t)key->ino * 0x9e3779b97f4a7c15ULL ^ (uint64_t)key->dev;
+	return (size_t)(h ^ (h >> 29)) & (FILEHASH58_MEMO_HSIZE - 1);
+}
+
+/*
+ * Find the entry of the file, a stale entry (the file changed since it was
+ * hashed) is reset. Has to be called with the state locked.
+ */
+static struct filehash58_memo *filehash58_memo_get(struct filehash58_state *state, const struct filehash58_memo *key, bool create)
+{
+	struct filehash58_memo *m;
+	size_t h = filehash58_memo_hash(key);
+
+	for (m = state->table[h]; m != NULL; m = m->next) {
+		if (m->dev == key->dev && m->ino == key->ino) {
+			if (m->size != key->size || m->mtime_sec != key->mtime_sec || m->mtime_nsec != key->mtime_nsec) {
+				m->size = key->size;
+				m->mtime_sec  = key->mtime_sec;
+				m->mtime_nsec = key->mtime_nsec;
+				m->have = 0;
+			}
+			return (m);
+		}
+	}
+
+	if (!create || state->count >= FILEHASH58_MEMO_MAX)
+		return (NULL);
+
+	m = malloc(sizeof(struct filehash58_memo));
+	if (m == NULL)
+		return (NULL);
+
+	memcpy(m, key, sizeof(struct filehash58_memo));
+	m->have = 0;
+	m->next = state->table[h];
+	state->table[h] = m;
+	++state->count;
+
+	return (m);
+}
+
+/*
+ * Collect the items of a file for the hash types given by indexes to
+ * CRAPI_ALG_MAP. All the digests which aren't memoized already are
+ * computed in a single pass over the file.
+ */
+static int filehash58_cb(const char *prefix, const char *p, const char *f, const int *algs, int alg_cnt, probe_ctx *ctx, struct filehash58_state *state)
 {
 	SEXP_t *itm;
 
 	char   pbuf[PATH_MAX+1];
 	size_t plen, flen;
 
-	int fd;
+	int fd, i;
 
 	if (f == NULL)
 		return (0);
@@ -145,61 +249,117 @@ static int filehash58_cb(const char *prefix, const char *p, const char *f, const
 	}
 
 	if (fd < 0) {
-		strerror_r (errno, pbuf, PATH_MAX);
+		int e = errno;
+
+		strerror_r (e, pbuf, PATH_MAX);
 		pbuf[PATH_MAX] = '\0';
 
-		itm = probe_item_create (OVAL_INDEPENDENT_FILE_HASH58, NULL,
-					"filepath", OVAL_DATATYPE_STRING, pbuf,
-					"path",     OVAL_DATATYPE_STRING, p,
-					"filename", OVAL_DATATYPE_STRING, f,
-					"hash_type",OVAL_DATATYPE_STRING, h,
-					NULL);
-		probe_item_add_msg(itm, OVAL_MESSAGE_LEVEL_ERROR,
-			"Can't open \"%s\": errno=%d, %s.", pbuf, errno, strerror (errno));
-		probe_item_setstatus(itm, SYSCHAR_STATUS_ERROR);
+		for (i = 0; i < alg_cnt; ++i) {
+			itm = probe_item_create (OVAL_INDEPENDENT_FILE_HASH58, NULL,
+						"filepath", OVAL_DATATYPE_STRING, pbuf,
+						"path",     OVAL_DATATYPE_STRING, p,
+						"filename", OVAL_DATATYPE_STRING, f,
+						"hash_type",OVAL_DATATYPE_STRING, CRAPI_ALG_MAP[algs[i]].string,
+						NULL);
+			probe_item_add_msg(itm, OVAL_MESSAGE_LEVEL_ERROR,
+				"Can't open \"%s\": errno=%d, %s.", pbuf, e, strerror (e));
+			probe_item_setstatus(itm, SYSCHAR_STATUS_ERROR);
+			probe_item_collect(ctx, itm);
+		}
 	} else {
-		uint8_t hash_dst[1025];
-		size_t  hash_dstlen = sizeof hash_dst;
-		char    hash_str[2051];
+		uint8_t hash_dst[FILEHASH58_ALG_CNT][FILEHASH58_DIGEST_MAX];
+		size_t  hash_dstlen[FILEHASH58_ALG_CNT];
+		char    hash_str[(FILEHASH58_DIGEST_MAX * 2) + 1];
 
-		crapi_alg_t hash_type;
+		crapi_alg_t md_alg[FILEHASH58_ALG_CNT];
+		void       *md_dst[FILEHASH58_ALG_CNT];
+		size_t     *md_size[FILEHASH58_ALG_CNT];
+		int         md_idx[FILEHASH58_ALG_CNT];
+		int         md_cnt = 0;
 
-		hash_type = oscap_string_to_enum(CRAPI_ALG_MAP, h);
-		hash_dstlen = oscap_string_to_enum(CRAPI_ALG_MAP_SIZE, h);
+		struct filehash58_memo key, *memo = NULL;
+		struct stat st;
+		bool memoize = fstat(fd, &st) == 0 && S_ISREG(st.st_mode);
 
 		/*
-		 * Compute hash value
+		 * Take the digests computed by other objects from the memo
 		 */
-		if (crapi_mdigest_fd (fd, 1, hash_type, hash_dst, &hash_dstlen) != 0) {
-			close (fd);
-			return (-1);
+		if (memoize) {
+			filehash58_memo_key(&st, &key);
+			pthread_mutex_lock(&state->lock);
+			memo = filehash58_memo_get(state, &key, false);
 		}
+		for (i = 0; i < alg_cnt; ++i) {
+			int a = algs[i];
 
-		close (fd);
+			hash_dstlen[a] = oscap_string_to_enum(CRAPI_ALG_MAP_SIZE, CRAPI_ALG_MAP[a].string);
+			if (memo != NULL && (memo->have & (1 << a))) {
+				memcpy(hash_dst[a], memo->digest[a], hash_dstlen[a]);
+				continue;
+			}
+			md_alg[md_cnt]  = CRAPI_ALG_MAP[a].value;
+			md_dst[md_cnt]  = hash_dst[a];
+			md_size[md_cnt] = &hash_dstlen[a];
+			md_idx[md_cnt]  = a;
+			++md_cnt;
+		}
+		if (memoize)
+			pthread_mutex_unlock(&state->lock);
+
+		/*
+		 * Compute the rest of the hash values
+		 */
+		if (md_cnt > 0) {
+			if (crapi_mdigest_fdv (fd, md_cnt, md_alg, md_dst, md_size) != 0) {
+				close (fd);
+				return (-1);
+			}
+
+			if (memoize) {
+				pthread_mutex_lock(&state->lock);
+				memo = filehash58_memo_get(state, &key, true);
+				for (i = 0; memo != NULL && i < md_cnt; ++i) {
+					int a = md_idx[i];
+
+					if (hash_dstlen[a] == 0)
+						continue;
+					memcpy(memo->digest[a], hash_dst[a], hash_dstlen[a]);
+					memo->have |= 1 << a;
+				}
+				pthread_mutex_unlock(&state->lock);
+			}
+		}
 
-		hash_str[0] = '\0';
-		mem2hex (hash_dst, hash_dstlen, hash_str, sizeof hash_str);
+		close (fd);
 
 		/*
-		 * Create and add the item
+		 * Create and add the items
 		 */
-		itm = probe_item_create(OVAL_INDEPENDENT_FILE_HASH58, NULL,
-					"filepath", OVAL_DATATYPE_STRING, pbuf,
-					"path",     OVAL_DATATYPE_STRING, p,
-					"filename", OVAL_DATATYPE_STRING, f,
-					"hash_type",OVAL_DATATYPE_STRING, h,
-					"hash",     OVAL_DATATYPE_STRING, hash_str,
-					NULL);
-
-		if (hash_dstlen == 0) {
-			probe_item_add_msg(itm, OVAL_MESSAGE_LEVEL_ERROR,
-					   "Unable to compute %s hash value of \"%s\".", h, pbuf);
-			probe_item_setstatus(itm, SYSCHAR_STATUS_ERROR);
+		for (i = 0; i < alg_cnt; ++i) {
+			int a = algs[i];
+			const char *h = CRAPI_ALG_MAP[a].string;
+
+			hash_str[0] = '\0';
+			mem2hex (hash_dst[a], hash_dstlen[a], hash_str, sizeof hash_str);
+
+			itm = probe_item_create(OVAL_INDEPENDENT_FILE_HASH58, NULL,
+						"filepath", OVAL_DATATYPE_STRING, pbuf,
+						"path",     OVAL_DATATYPE_STRING, p,
+						"filename", OVAL_DATATYPE_STRING, f,
+						"hash_type",OVAL_DATATYPE_STRING, h,
+						"hash",     OVAL_DATATYPE_STRING, hash_str,
+						NULL);
+
+			if (hash_dstlen[a] == 0) {
+				probe_item_add_msg(itm, OVAL_MESSAGE_LEVEL_ERROR,
+						   "Unable to compute %s hash value of \"%s\".", h, pbuf);
+				probe_item_setstatus(itm, SYSCHAR_STATUS_ERROR);
+			}
+
+			probe_item_collect(ctx, itm);
 		}
 	}
 
-	probe_item_collect(ctx, itm);
-
 	return (0);
 }
 
@@ -211,34 +371,48 @@ int filehash58_probe_offline_mode_supported()
 void *filehash58_probe_init(void)
 {
 	/*
-	 * Initialize crypto API
+	 * Initialize crypto API. The digest functions are reentrant
+	 * afterwards so that objects can be collected concurrently.
 	 */
 	if (crapi_init (NULL) != 0)
 		return (NULL);
 
 	/*
-	 * Initialize mutex.
+	 * Digests are shared by all the objects of the scan
 	 */
-	pthread_mutex_t *filehash58_probe_mutex = malloc(sizeof(pthread_mutex_t));
-	switch (pthread_mutex_init(filehash58_probe_mutex, NULL)) {
-	case 0:
-		return ((void *)filehash58_probe_mutex);
-	default:
-		dD("Can't initialize mutex: errno=%u, %s.", errno, strerror (errno));
-		free(filehash58_probe_mutex);
-	}
+	return (&filehash58_memo);
+}
+
+/* Forget the digests computed by the previous objects */
+static void filehash58_memo_reset(void)
+{
+	struct filehash58_memo *m, *next;
+	size_t i;
 
-	return (NULL);
+	pthread_mutex_lock(&filehash58_memo.lock);
+	dD("Digest memo: %zu files.", filehash58_memo.count);
+
+	for (i = 0; i < FILEHASH58_MEMO_HSIZE; ++i) {
+		for (m = filehash58_memo.table[i]; m != NULL; m = next) {
+			next = m->next;
+			free(m);
+		}
+		filehash58_memo.table[i] = NULL;
+	}
+	filehash58_memo.count = 0;
+	pthread_mutex_unlock(&filehash58_memo.lock);
 }
 
 void filehash58_probe_fini(void *arg)
 {
-	/*
-	 * Destroy mutex.
-	 */
-	pthread_mutex_t *filehash58_probe_mutex = (pthread_mutex_t *)arg;
-	(void) pthread_mutex_destroy(filehash58_probe_mutex);
-	free(filehash58_probe_mutex);
+	(void) arg;
+	filehash58_memo_reset();
+}
+
+void filehash58_probe_reset(void *arg)
+{
+	(void) arg;
+	filehash58_memo_reset();
 }
 
 int filehash58_probe_main(probe_ctx *ctx, void *arg)
@@ -247,12 +421,12 @@ int filehash58_probe_main(probe_ctx *ctx, void *arg)
 	SEXP_t *path, *filename, *behaviors, *filepath, *hash_type;
 	char hash_type_str[128];
 	int err = 0;
+	int algs[FILEHASH58_ALG_CNT], alg_cnt = 0;
 
 	OVAL_FTS    *ofts;
 	OVAL_FTSENT *ofts_ent;
 
-	pthread_mutex_t *filehash58_probe_mutex = (pthread_mutex_t *)arg;
-	if (filehash58_probe_mutex == NULL) {
+	if (arg == NULL) {
 		return (PROBE_EINIT);
 	}
 
@@ -278,30 +452,22 @@ int filehash58_probe_main(probe_ctx *ctx, void *arg)
 
 	probe_filebehaviors_canonicalize(&behaviors);
 
-	switch (pthread_mutex_lock(filehash58_probe_mutex)) {
-	case 0:
-		break;
-	default:
-		dD("Can't lock mutex(%p): %u, %s.", filehash58_probe_mutex, errno, strerror(errno));
+	/* find hash types to compare with entity, think "not satisfy" */
+	for (int i = 0; CRAPI_ALG_MAP[i].value != CRAPI_INVALID; ++i) {
+		const char *h = CRAPI_ALG_MAP[i].string;
+		SEXP_t *crapi_hash_type_sexp = SEXP_string_new(h, strlen(h));
 
-		err = PROBE_EFATAL;
-		goto cleanup;
+		if (probe_entobj_cmp(hash_type, crapi_hash_type_sexp) == OVAL_RESULT_TRUE)
+			algs[alg_cnt++] = i;
+
+		SEXP_free(crapi_hash_type_sexp);
 	}
 
 	const char *prefix = getenv("OSCAP_PROBE_ROOT");
 	if ((ofts = oval_fts_open_prefixed(prefix, path, filename, filepath, behaviors, probe_ctx_getresult(ctx))) != NULL) {
 		while ((ofts_ent = oval_fts_read(ofts)) != NULL) {
-			/* find hash types to compare with entity, think "not satisfy" */
-			const struct oscap_string_map *p = CRAPI_ALG_MAP;
-			while (p->value != CRAPI_INVALID) {
-				SEXP_t *crapi_hash_type_sexp = SEXP_string_new(p->string, strlen(p->string));
-				if (probe_entobj_cmp(hash_type, crapi_hash_type_sexp) == OVAL_RESULT_TRUE) {
-					filehash58_cb(prefix, ofts_ent->path, ofts_ent->file, p->string, ctx);
-				}
-
-				SEXP_free(crapi_hash_type_sexp);
-				p++;
-			}
+			if (alg_cnt > 0)
+				filehash58_cb(prefix, ofts_ent->path, ofts_ent->file, algs, alg_cnt, ctx, arg);
 			oval_ftsent_free(ofts_ent);
 		}
 
@@ -315,14 +481,5 @@ cleanup:
 	SEXP_free (filepath);
         SEXP_free (hash_type);
 
-	switch (pthread_mutex_unlock(filehash58_probe_mutex)) {
-	case 0:
-		break;
-	default:
-		dD("Can't unlock mutex(%p): %u, %s.", filehash58_probe_mutex, errno, strerror(errno));
-
-		err = PROBE_EFATAL;
-	}
-
 	return err;
 }
@@ -29,5 +29,6 @@ int filehash58_probe_offline_mode_supported(void);
 void *filehash58_probe_init(void);
 int filehash58_probe_main(probe_ctx *ctx, void *arg);
 void filehash58_probe_fini(void *arg);
+void filehash58_probe_reset(void *arg);
 
 #endif /* OPENSCAP_FILEHASH58_PROBE_H */
@@ -43,6 +43,7 @@
 #include <fcntl.h>
 #include <unistd.h>
 #include <limits.h>
+#include <stdbool.h>
 #include <pcre.h>
 
 #include "_seap.h"
@@ -57,6 +58,14 @@
 
 #define FILE_SEPARATOR '/'
 
+/* size of the part of a file matched at once, grows for longer matches */
+#define TFC54_WINDOW_SIZE (1024 * 1024)
+/* bytes kept in front of the resume offset when the window moves */
+#define TFC54_WINDOW_CONTEXT 4096
+#define TFC54_OVECTOR_LEN 60
+/* environment variable limiting the number of bytes matched in each file */
+#define TFC54_MAX_SIZE_ENV "OSCAP_PROBE_TFC54_MAX_FILE_SIZE"
+
 static SEXP_t *create_item(const char *path, const char *filename, char *pattern,
 			   int instance, char **substrs, int substr_cnt, oval_schema_version_t over)
 {
@@ -116,16 +125,260 @@ struct pfdata {
 	SEXP_t *instance_ent;
         probe_ctx *ctx;
 	pcre *compiled_regex;
+	pcre_extra extra;
+	size_t max_size; /* number of bytes matched in each file, 0 means no limit */
+};
+
+/* State of matching a single file */
+struct pfmatch {
+	struct pfdata *pfd;
+	const char *path;
+	const char *file;
+	const char *whole_path;
+	oval_schema_version_t over;
+	int cur_inst;
+	int ret;
 };
 
+/*
+ * Number of bytes at the end of the buffer which form an incomplete
+ * UTF-8 character, i.e. which have to be left for the next window.
+ */
+static size_t utf8_incomplete_tail(const char *buf, size_t len)
+{
+	size_t i, need;
+
+	for (i = 1; i <= 3 && i <= len; ++i) {
+		unsigned char c = (unsigned char)buf[len - i];
+
+		if ((c & 0xC0) == 0x80)
+			continue; /* continuation byte */
+		if ((c & 0xE0) == 0xC0)
+			need = 2;
+		else if ((c & 0xF0) == 0xE0)
+			need = 3;
+		else if ((c & 0xF8) == 0xF0)
+			need = 4;
+		else
+			need = 1;
+		return need > i ? i : 0;
+	}
+
+	return 0;
+}
+
+static void collect_match(struct pfmatch *m, const char *buf, const int *ovector, int rc)
+{
+	char **substrs;
+	int i, substr_cnt = 0;
+	SEXP_t *item;
+
+	if (rc == 0) {
+		/* vector too small */
+		rc = TFC54_OVECTOR_LEN / 3;
+	}
+
+	substrs = malloc(rc * sizeof(char *));
+	for (i = 0; i < rc; ++i) {
+		int len;
+
+		if (ovector[2 * i] == -1)
+			continue;
+		len = ovector[2 * i + 1] - ovector[2 * i];
+		substrs[substr_cnt] = malloc(len + 1);
+		memcpy(substrs[substr_cnt], buf + ovector[2 * i], len);
+		substrs[substr_cnt][len] = '\0';
+		++substr_cnt;
+	}
+
+	item = create_item(m->path, m->file, m->pfd->pattern,
+			   m->cur_inst, substrs, substr_cnt, m->over);
+	probe_item_collect(m->pfd->ctx, item);
+
+	for (i = 0; i < substr_cnt; ++i)
+		free(substrs[i]);
+	free(substrs);
+}
+
+/*
+ * Match the pattern repeatedly against buf[0..len) starting at *ofs and
+ * collect the wanted instances. Unless eof is set, the buffer is a window
+ * of the file which continues past len. Matches which could be changed by
+ * the data following the window are left to the next window; in that case
+ * *ofs is set to the offset where matching has to be resumed. If notbol
+ * is set, the buffer doesn't start at the beginning of the file.
+ *
+ * @return 0 if the buffer was processed, -1 on error
+ */
+static int match_buffer(struct pfmatch *m, const char *buf, size_t len, size_t *ofs, bool eof, bool notbol)
+{
+	struct pfdata *pfd = m->pfd;
+	int ovector[TFC54_OVECTOR_LEN];
+	int opts, rc;
+
+	opts = (notbol ? PCRE_NOTBOL : 0) | (eof ? 0 : PCRE_PARTIAL_HARD);
+#if defined(OS_SOLARIS)
+	opts |= PCRE_NO_UTF8_CHECK;
+#endif
+
+	while (eof ? *ofs <= len : *ofs < len) {
+		SEXP_t *next_inst;
+		int want_instance;
+
+		rc = pcre_exec(pfd->compiled_regex, &pfd->extra, buf, len, *ofs, opts, ovector, TFC54_OVECTOR_LEN);
+
+		if (rc == PCRE_ERROR_NOMATCH) {
+			/* no match can start in this window */
+			*ofs = len;
+			return 0;
+		}
+		if (rc == PCRE_ERROR_PARTIAL) {
+			/* resume at the start of the partial match */
+			*ofs = ovector[0];
+			return 0;
+		}
+		if (rc < 0) {
+			SEXP_t *msg;
+
+			dE("Function pcre_exec() failed to match a regular expression with return code %d on file '%s'.", rc, m->whole_path);
+			msg = probe_msg_creatf(OVAL_MESSAGE_LEVEL_ERROR,
+				"Regular expression pattern match failed in file %s with error %d.",
+				m->whole_path, rc);
+			probe_cobj_add_msg(probe_ctx_getresult(pfd->ctx), msg);
+			SEXP_free(msg);
+			probe_cobj_set_flag(probe_ctx_getresult(pfd->ctx), SYSCHAR_FLAG_ERROR);
+			m->ret = -3;
+			return -1;
+		}
+
+		/* the subject was validated once, which is enough for this window */
+		opts |= PCRE_NO_UTF8_CHECK;
+
+		if ((size_t)ovector[1] == *ofs) {
+			/* skip the character after an empty match */
+			do
+				++*ofs;
+			while (*ofs < len && ((unsigned char)buf[*ofs] & 0xC0) == 0x80);
+		} else {
+			*ofs = ovector[1];
+		}
+
+		++m->cur_inst;
+		next_inst = SEXP_number_newi_32(m->cur_inst);
+		want_instance = probe_entobj_cmp(pfd->instance_ent, next_inst) == OVAL_RESULT_TRUE;
+		SEXP_free(next_inst);
+
+		if (want_instance)
+			collect_match(m, buf, ovector, rc);
+	}
+
+	return 0;
+}
+
+/*
+ * Match the file by reading it through a window which grows only when
+ * a single match doesn't fit into it. Files are read rather than mapped:
+ * a mapped file which is truncated while it's matched raises SIGBUS.
+ */
+static int match_fd(struct pfmatch *m, int fd)
+{
+	struct pfdata *pfd = m->pfd;
+	size_t buf_size = TFC54_WINDOW_SIZE, used = 0, ofs = 0, base = 0, want, keep, tail;
+	char *buf, *tmp;
+	bool eof = false;
+	ssize_t n;
+	SEXP_t *msg;
+
+	buf = malloc(buf_size);
+	if (buf == NULL) {
+		msg = probe_msg_creatf(OVAL_MESSAGE_LEVEL_ERROR, "Can't allocate memory to read '%s'.", m->whole_path);
+		probe_cobj_add_msg(probe_ctx_getresult(pfd->ctx), msg);
+		SEXP_free(msg);
+		probe_cobj_set_flag(probe_ctx_getresult(pfd->ctx), SYSCHAR_FLAG_ERROR);
+		return -2;
+	}
+
+	while (!eof) {
+		if (used == buf_size) {
+			tmp = realloc(buf, buf_size * 2);
+			if (tmp == NULL) {
+				msg = probe_msg_creatf(OVAL_MESSAGE_LEVEL_ERROR, "Can't allocate memory to read '%s'.", m->whole_path);
+				probe_cobj_add_msg(probe_ctx_getresult(pfd->ctx), msg);
+				SEXP_free(msg);
+				probe_cobj_set_flag(probe_ctx_getresult(pfd->ctx), SYSCHAR_FLAG_ERROR);
+				m->ret = -2;
+				break;
+			}
+			buf = tmp;
+			buf_size *= 2;
+		}
+
+		/* read one byte over the limit to find out whether the file is longer */
+		want = buf_size - used;
+		if (pfd->max_size > 0 && base + used + want > pfd->max_size + 1)
+			want = pfd->max_size + 1 - (base + used);
+
+		n = pread(fd, buf + used, want, (off_t)(base + used));
+		if (n == -1) {
+			if (errno == EINTR)
+				continue;
+			msg = probe_msg_creatf(OVAL_MESSAGE_LEVEL_ERROR, "read(): '%s' %s.", m->whole_path, strerror(errno));
+			probe_cobj_add_msg(probe_ctx_getresult(pfd->ctx), msg);
+			SEXP_free(msg);
+			probe_cobj_set_flag(probe_ctx_getresult(pfd->ctx), SYSCHAR_FLAG_ERROR);
+			m->ret = -2;
+			break;
+		}
+		if (n == 0) {
+			eof = true;
+		} else {
+			/* the content is matched up to the first NUL byte */
+			char *nul = memchr(buf + used, '\0', n);
+
+			if (nul != NULL) {
+				n = nul - (buf + used);
+				eof = true;
+			}
+			used += n;
+		}
+
+		if (pfd->max_size > 0 && base + used > pfd->max_size) {
+			msg = probe_msg_creatf(OVAL_MESSAGE_LEVEL_WARNING,
+				"File '%s' is larger than %zu bytes, only its beginning was matched.",
+				m->whole_path, pfd->max_size);
+			probe_cobj_add_msg(probe_ctx_getresult(pfd->ctx), msg);
+			SEXP_free(msg);
+			probe_cobj_set_flag(probe_ctx_getresult(pfd->ctx), SYSCHAR_FLAG_INCOMPLETE);
+			used = pfd->max_size - base;
+			eof = true;
+		}
+
+		tail = eof ? 0 : utf8_incomplete_tail(buf, used);
+		if (match_buffer(m, buf, used - tail, &ofs, eof, base > 0) != 0)
+			break;
+		if (eof)
+			break;
+
+		/* keep some context before the resume offset for lookbehinds */
+		keep = ofs > TFC54_WINDOW_CONTEXT ? ofs - TFC54_WINDOW_CONTEXT : 0;
+		if (keep > 0) {
+			memmove(buf, buf + keep, used - keep);
+			used -= keep;
+			ofs  -= keep;
+			base += keep;
+		}
+	}
+
+	free(buf);
+	return m->ret;
+}
+
 static int process_file(const char *prefix, const char *path, const char *file, void *arg, oval_schema_version_t over)
 {
 	struct pfdata *pfd = (struct pfdata *) arg;
-	int ret = 0, path_len, file_len, cur_inst = 0, fd = -1, substr_cnt,
-		buf_size = 0, buf_used = 0, ofs = 0, buf_inc = 4096;
-	char **substrs = NULL;
-	char *whole_path = NULL, *whole_path_with_prefix = NULL, *buf = NULL;
-	SEXP_t *next_inst = NULL;
+	int ret = 0, path_len, file_len, fd = -1;
+	char *whole_path = NULL, *whole_path_with_prefix = NULL;
+	struct pfmatch m;
 	struct stat st;
 
 	if (file == NULL)
@@ -154,11 +407,18 @@ static int process_file(const char *prefix, const char *path, const char *file,
 	 * be determined with stat().
 	 */
 	whole_path_with_prefix = oscap_path_join(prefix, whole_path);
-	if (stat(whole_path_with_prefix, &st) == -1)
+	if (fscache_stat(whole_path_with_prefix, &st) == -1)
 		goto cleanup;
 	if (!S_ISREG(st.st_mode))
 		goto cleanup;
 
+	memset(&m, 0, sizeof(m));
+	m.pfd        = pfd;
+	m.path       = path;
+	m.file       = file;
+	m.whole_path = whole_path;
+	m.over       = over;
+
 	fd = open(whole_path_with_prefix, O_RDONLY);
 	if (fd == -1) {
 		SEXP_t *msg;
@@ -171,80 +431,15 @@ static int process_file(const char *prefix, const char *path, const char *file,
 		goto cleanup;
 	}
 
-	do {
-		buf_size += buf_inc;
-		buf = realloc(buf, buf_size);
-		ret = read(fd, buf + buf_used, buf_inc);
-		if (ret == -1) {
-			SEXP_t *msg;
-
-			msg = probe_msg_creatf(OVAL_MESSAGE_LEVEL_ERROR, "read(): '%s' %s.", whole_path, strerror(errno));
-			probe_cobj_add_msg(probe_ctx_getresult(pfd->ctx), msg);
-			SEXP_free(msg);
-			probe_cobj_set_flag(probe_ctx_getresult(pfd->ctx), SYSCHAR_FLAG_ERROR);
-			ret = -2;
-			goto cleanup;
-		}
-		buf_used += ret;
-	} while (ret == buf_inc);
-
-	if (buf_used == buf_size)
-		buf = realloc(buf, ++buf_size);
-	buf[buf_used++] = '\0';
-
-	do {
-		int want_instance;
-
-		next_inst = SEXP_number_newi_32(cur_inst + 1);
-
-		if (probe_entobj_cmp(pfd->instance_ent, next_inst) == OVAL_RESULT_TRUE)
-			want_instance = 1;
-		else
-			want_instance = 0;
-
-		SEXP_free(next_inst);
-		substr_cnt = oscap_get_substrings(buf, &ofs, pfd->compiled_regex, want_instance, &substrs);
-
-		if (substr_cnt < 0) {
-			SEXP_t *msg;
-			msg = probe_msg_creatf(OVAL_MESSAGE_LEVEL_ERROR,
-				"Regular expression pattern match failed in file %s with error %d.",
-				whole_path, substr_cnt);
-			probe_cobj_add_msg(probe_ctx_getresult(pfd->ctx), msg);
-			SEXP_free(msg);
-			probe_cobj_set_flag(probe_ctx_getresult(pfd->ctx), SYSCHAR_FLAG_ERROR);
-			ret = -3;
-			goto cleanup;
-		}
-
-		if (substr_cnt > 0) {
-			++cur_inst;
-
-			if (want_instance) {
-				int k;
-				SEXP_t *item;
-
-				item = create_item(path, file, pfd->pattern,
-						cur_inst, substrs, substr_cnt, over);
-
-                                probe_item_collect(pfd->ctx, item);
-
-				for (k = 0; k < substr_cnt; ++k)
-					free(substrs[k]);
-				free(substrs);
-			}
-		}
-	} while (substr_cnt > 0 && ofs < buf_used);
+	ret = match_fd(&m, fd);
 
  cleanup:
 	if (fd != -1)
 		close(fd);
-	free(buf);
 	if (whole_path != NULL)
 		free(whole_path);
 	free(whole_path_with_prefix);
 
-	/* coverity[leaked_storage] - substrs is not leaked */
 	return ret;
 }
 
@@ -338,6 +533,15 @@ int textfilecontent54_probe_main(probe_ctx *ctx, void *arg)
 		goto cleanup;
 	}
 
+	pfd.extra.flags = PCRE_EXTRA_MATCH_LIMIT_RECURSION;
+	pfd.extra.match_limit_recursion = oscap_pcre_exec_recursion_limit();
+	char *env = getenv(TFC54_MAX_SIZE_ENV);
+	if (env != NULL) {
+		unsigned long long max_size;
+		if (sscanf(env, "%llu", &max_size) == 1)
+			pfd.max_size = max_size;
+	}
+
 	const char *prefix = getenv("OSCAP_PROBE_ROOT");
 
 	if ((ofts = oval_fts_open_prefixed(prefix, path_ent, file_ent, filepath_ent, bh_ent, probe_ctx_getresult(ctx))) != NULL) {
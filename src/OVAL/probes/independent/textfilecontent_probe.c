@@ -179,7 +179,7 @@ static int process_file(const char *prefix, const char *path, const char *filena
 	 * be determined with stat().
 	 */
 	whole_path_with_prefix = oscap_path_join(prefix, whole_path);
-	if (stat(whole_path_with_prefix, &st) == -1)
+	if (fscache_stat(whole_path_with_prefix, &st) == -1)
 		goto cleanup;
 	if (!S_ISREG(st.st_mode))
 		goto cleanup;
@@ -35,6 +35,7 @@
 #include "debug_priv.h"
 #include "oval_fts.h"
 #include "list.h"
+#include "oscap_pcre_cache.h"
 #include "probe/probe.h"
 
 #define OSCAP_YAML_STRING_TAG "tag:yaml.org,2002:str"
@@ -53,18 +54,16 @@ static bool match_regex(const char *pattern, const char *value)
 {
 	const char *errptr;
 	int erroroffset;
-	pcre *re = pcre_compile(pattern, 0, &errptr, &erroroffset, NULL);
+	struct oscap_pcre *re = oscap_pcre_cache_get(pattern, 0, &errptr, &erroroffset);
 	if (re == NULL) {
 		dE("pcre_compile failed on pattern '%s': %s at %d", pattern,
 			errptr, erroroffset);
 		return false;
 	}
 	int ovector[OVECCOUNT];
-	int rc = pcre_exec(re, NULL, value, strlen(value), 0, 0, ovector, OVECCOUNT);
-	if (rc > 0) {
-		return true;
-	}
-	return false;
+	int rc = oscap_pcre_exec(re, value, strlen(value), 0, 0, ovector, OVECCOUNT);
+	oscap_pcre_cache_release(re);
+	return rc > 0;
 }
 
 static SEXP_t *yaml_scalar_event_to_sexp(yaml_event_t *event)
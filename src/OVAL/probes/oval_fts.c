@@ -27,7 +27,10 @@
 
 #include <stdint.h>
 #include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
 #include <string.h>
+#include <ctype.h>
 #include <sys/types.h>
 #include <sys/stat.h>
 #include <limits.h>
@@ -35,6 +38,7 @@
 #include <pcre.h>
 
 #include "oscap_helpers.h"
+#include "oscap_pcre_cache.h"
 #include "fsdev.h"
 #include "_probe-api.h"
 #include "probe/entcmp.h"
@@ -66,10 +70,11 @@ static OVAL_FTS *OVAL_FTS_new()
 
 static void OVAL_FTS_free(OVAL_FTS *ofts)
 {
+	fscache_prefetch_stop(ofts->ofts_recurse_path_prefetch);
 	if (ofts->ofts_match_path_fts != NULL)
-		fts_close(ofts->ofts_match_path_fts);
+		fscache_fts_close(ofts->ofts_match_path_fts);
 	if (ofts->ofts_recurse_path_fts != NULL)
-		fts_close(ofts->ofts_recurse_path_fts);
+		fscache_fts_close(ofts->ofts_recurse_path_fts);
 
 	free(ofts);
 	return;
@@ -90,7 +95,7 @@ static int pathlen_from_ftse(int fts_pathlen, int fts_namelen)
 	return pathlen;
 }
 
-static OVAL_FTSENT *OVAL_FTSENT_new(OVAL_FTS *ofts, FTSENT *fts_ent)
+static OVAL_FTSENT *OVAL_FTSENT_new(OVAL_FTS *ofts, fscache_ftsent_t *fts_ent)
 {
 	OVAL_FTSENT *ofts_ent = calloc(1, sizeof(OVAL_FTSENT));
 
@@ -281,7 +286,7 @@ static bool OVAL_FTS_localp(OVAL_FTS *ofts, const char *path, void *id)
 	} else if (path != NULL) {
 		/* id was not set, because fts_read failed to stat the node */
 		struct stat sb;
-		if ((stat(path, &sb) == 0) && (valid_local_fs(sb.st_fstype))) {
+		if ((fscache_stat(path, &sb) == 0) && (valid_local_fs(sb.st_fstype))) {
 			/* if recurse is local , skip remote fs
 			   and non-global zones */
 			if (ofts->filesystem == OVAL_RECURSE_FS_LOCAL) {
@@ -381,19 +386,19 @@ static char *extract_fixed_path_prefix(char *path)
 
 static int badpartial_check_slash(const char *pattern)
 {
-	pcre *regex;
+	struct oscap_pcre *regex;
 	const char *errptr = NULL;
 	int errofs = 0, fb, ret;
 
-	regex = pcre_compile(pattern + 1 /* skip '^' */, 0, &errptr, &errofs, NULL);
+	regex = oscap_pcre_cache_get(pattern + 1 /* skip '^' */, 0, &errptr, &errofs);
 	if (regex == NULL) {
 		dE("Failed to validate the pattern: pcre_compile(): "
 		   "error: '%s', error offset: %d, pattern: '%s'.\n",
 		   errptr, errofs, pattern);
 		return -1;
 	}
-	ret = pcre_fullinfo(regex, NULL, PCRE_INFO_FIRSTBYTE, &fb);
-	pcre_free(regex);
+	ret = pcre_fullinfo(regex->re, regex->extra, PCRE_INFO_FIRSTBYTE, &fb);
+	oscap_pcre_cache_release(regex);
 	regex = NULL;
 	if (ret != 0) {
 		dE("Failed to validate the pattern: pcre_fullinfo(): "
@@ -413,7 +418,7 @@ static int badpartial_check_slash(const char *pattern)
 #define TEST_PATH1 "/"
 #define TEST_PATH2 "x"
 
-static int badpartial_transform_pattern(char *pattern, pcre **regex_out)
+static int badpartial_transform_pattern(char *pattern, struct oscap_pcre **regex_out)
 {
 	/*
 	  PCREPARTIAL(3)
@@ -438,7 +443,7 @@ static int badpartial_transform_pattern(char *pattern, pcre **regex_out)
 	const char *errptr = NULL;
 	char *s, *brkt_mark;
 	bool bracketed = false, found_regex = false;
-	pcre *regex;
+	struct oscap_pcre *regex;
 
 	/* The processing bellow builds upon the assumption that
 	   the pattern has been validated by pcre_compile() */
@@ -488,7 +493,7 @@ static int badpartial_transform_pattern(char *pattern, pcre **regex_out)
 	else
 		*s = '\0';
 
-	regex = pcre_compile(pattern, 0, &errptr, &errofs, NULL);
+	regex = oscap_pcre_cache_get(pattern, 0, &errptr, &errofs);
 	if (regex == NULL) {
 		dW("Nonfatal failure: can't transform the pattern for partial "
 		   "match optimization, error: '%s', error offset: %d, "
@@ -496,10 +501,10 @@ static int badpartial_transform_pattern(char *pattern, pcre **regex_out)
 		return -1;
 	}
 
-	ret = pcre_exec(regex, NULL, test_path1, strlen(test_path1), 0,
+	ret = oscap_pcre_exec(regex, test_path1, strlen(test_path1), 0,
 		PCRE_PARTIAL, NULL, 0);
 	if (ret != PCRE_ERROR_PARTIAL && ret < 0) {
-		pcre_free(regex);
+		oscap_pcre_cache_release(regex);
 		dW("Nonfatal failure: can't transform the pattern for partial "
 		   "match optimization, pcre_exec() return code: %d, pattern: "
 		   "'%s'.", ret, pattern);
@@ -515,14 +520,14 @@ static int badpartial_transform_pattern(char *pattern, pcre **regex_out)
 /* Verify that the path is usable and try to craft a regex to speed up
    the filesystem traversal. If the path to match is ill-designed, an
    ugly heuristic is employed to obtain something meaningfull. */
-static int process_pattern_match(const char *path, pcre **regex_out)
+static int process_pattern_match(const char *path, struct oscap_pcre **regex_out)
 {
 	int ret, errofs = 0;
 	char *pattern;
 	const char *test_path1 = TEST_PATH1;
 	//const char *test_path2 = TEST_PATH2;
 	const char *errptr = NULL;
-	pcre *regex;
+	struct oscap_pcre *regex;
 
 	if (path[0] != '^') {
 		/* Matching has to have a fixed starting point and thus
@@ -540,7 +545,7 @@ static int process_pattern_match(const char *path, pcre **regex_out)
 		pattern = strdup(path);
 	}
 
-	regex = pcre_compile(pattern, 0, &errptr, &errofs, NULL);
+	regex = oscap_pcre_cache_get(pattern, 0, &errptr, &errofs);
 	if (regex == NULL) {
 		dE("Failed to validate the pattern: pcre_compile(): "
 		   "error offset: %d, error: '%s', pattern: '%s'.\n",
@@ -548,7 +553,7 @@ static int process_pattern_match(const char *path, pcre **regex_out)
 		free(pattern);
 		return -1;
 	}
-	ret = pcre_exec(regex, NULL, test_path1, strlen(test_path1), 0,
+	ret = oscap_pcre_exec(regex, test_path1, strlen(test_path1), 0,
 		PCRE_PARTIAL, NULL, 0);
 
 	switch (ret) {
@@ -564,14 +569,14 @@ static int process_pattern_match(const char *path, pcre **regex_out)
 
 		dD("pcre_exec() returned PCRE_ERROR_PARTIAL for pattern '%s' "
 		   "and test path '%s'.\n", pattern, test_path1);
-		ret = pcre_exec(regex, NULL, test_path2, strlen(test_path2),
+		ret = oscap_pcre_exec(regex, test_path2, strlen(test_path2),
 			0, PCRE_PARTIAL, NULL, 0);
 		if (ret == PCRE_ERROR_PARTIAL || ret >= 0) {
 			dE("Failed to validate the pattern: test path '%s' "
 			   "matched by pattern '%s' - the pattern is too "
 			   "general, i.e. inefficient. This could take a "
 			   "lifetime to complete.\n", test_path2, pattern);
-			pcre_free(regex);
+			oscap_pcre_cache_release(regex);
 			free(pattern);
 			return -2;
 		}
@@ -581,7 +586,7 @@ static int process_pattern_match(const char *path, pcre **regex_out)
 		dD("pcre_exec() returned PCRE_ERROR_BADPARTIAL for pattern "
 		   "'%s' and a test path '%s'. Falling back to "
 		   "pcre_fullinfo().\n", pattern, test_path1);
-		pcre_free(regex);
+		oscap_pcre_cache_release(regex);
 		regex = NULL;
 
 		/* Fallback to first byte check to determin if
@@ -605,7 +610,7 @@ static int process_pattern_match(const char *path, pcre **regex_out)
 		   "PCRE_ERROR_NOMATCH for pattern '%s' and a test path '%s'. "
 		   "This indicates the pattern doesn't match a leading '/'.\n",
 		   pattern, test_path1);
-		pcre_free(regex);
+		oscap_pcre_cache_release(regex);
 		free(pattern);
 		return -2;
 	default:
@@ -619,14 +624,14 @@ static int process_pattern_match(const char *path, pcre **regex_out)
 			   their OVAL definitions that use ".*" as
 			   'path' and then uncomment this.
 
-			ret = pcre_exec(regex, NULL, test_path2, strlen(test_path2),
+			ret = oscap_pcre_exec(regex, test_path2, strlen(test_path2),
 					0, PCRE_PARTIAL, NULL, 0);
 			if (ret == PCRE_ERROR_PARTIAL || ret >= 0) {
 				dE("Failed to validate the pattern: test path '%s' "
 				   "matched by pattern '%s' - the pattern is too "
 				   "general, i.e. inefficient. This could take a "
 				   "lifetime to complete.\n", test_path2, pattern);
-				pcre_free(regex);
+				oscap_pcre_cache_release(regex);
 				free(pattern);
 				return -2;
 			}
@@ -637,7 +642,7 @@ static int process_pattern_match(const char *path, pcre **regex_out)
 		dE("Failed to validate the pattern: pcre_exec() return "
 		   "code: %d, pattern '%s', test path '%s'.\n", ret,
 		   pattern, test_path1);
-		pcre_free(regex);
+		oscap_pcre_cache_release(regex);
 		free(pattern);
 		return -1;
 	}
@@ -656,6 +661,348 @@ static int process_pattern_match(const char *path, pcre **regex_out)
 	return 0;
 }
 
+/*
+ * The directory names a pattern match path allows on the way to the
+ * matching paths. The pattern is split at the slashes outside of groups
+ * and classes, the leading components that can't match a slash are
+ * compared with the names of the directories, so that the subtrees the
+ * pattern can't match are skipped before they're read.
+ */
+#define OVAL_FTS_PATTERN_MAX_DEPTH 64
+
+struct oval_fts_segment {
+	char *name;                 /* a literal component */
+	size_t namelen;
+	struct oscap_pcre *regex;   /* any other component, anchored */
+};
+
+struct oval_fts_pattern {
+	int depth;                  /* the number of segments */
+	bool anchored;              /* the last segment ends the pattern */
+	struct oval_fts_segment segs[OVAL_FTS_PATTERN_MAX_DEPTH];
+};
+
+/* the verdicts of oval_fts_pattern_check() on a directory */
+#define OVAL_FTS_PATTERN_SKIP    0 /* nothing at or below the directory matches */
+#define OVAL_FTS_PATTERN_DESCEND 1 /* only paths below the directory match */
+#define OVAL_FTS_PATTERN_LEAF    2 /* only the directory itself matches */
+#define OVAL_FTS_PATTERN_UNKNOWN 3 /* deeper than the segments, use the regex */
+
+/* 1 if the class starting at *sp can match a slash, 0 if not, -1 if it's
+   not known, -2 if the class isn't terminated; *sp is moved to its ']' */
+static int oval_fts_class_match_slash(const char **sp)
+{
+	const char *s = *sp + 1;
+	bool negated = false, first = true, unknown = false;
+	int slash = 0, lo, hi;
+
+	if (*s == '^') {
+		negated = true;
+		s++;
+	}
+
+	for (;; first = false) {
+		if (*s == '\0')
+			return -2;
+		if (*s == ']' && !first)
+			break;
+
+		if (s[0] == '[' && s[1] == ':') {
+			const char *e = strstr(s + 2, ":]");
+
+			if (e == NULL)
+				return -2;
+			if (s[2] == '^')
+				unknown = true;
+			else if (strncmp(s + 2, "punct:", 6) == 0 || strncmp(s + 2, "graph:", 6) == 0
+			    || strncmp(s + 2, "print:", 6) == 0 || strncmp(s + 2, "ascii:", 6) == 0)
+				slash = 1;
+			s = e + 2;
+			continue;
+		}
+
+		if (*s == '\\') {
+			if (s[1] == '\0')
+				return -2;
+			lo = (unsigned char) s[1];
+			s += 2;
+			if (strchr("dswhv", lo) != NULL)
+				continue;
+			if (strchr("DSWHV", lo) != NULL) {
+				slash = 1;
+				continue;
+			}
+			if (isalnum(lo)) {
+				unknown = true;
+				continue;
+			}
+		} else {
+			lo = (unsigned char) *s++;
+		}
+
+		hi = lo;
+		if (s[0] == '-' && s[1] != ']' && s[1] != '\0') {
+			if (s[1] == '\\' || s[1] == '[') {
+				/* an escape or a class at the end of a range */
+				unknown = true;
+				continue;
+			}
+			hi = (unsigned char) s[1];
+			s += 2;
+		}
+		if (lo <= '/' && '/' <= hi)
+			slash = 1;
+	}
+
+	*sp = s;
+
+	if (unknown)
+		return -1;
+
+	return negated ? !slash : slash;
+}
+
+static bool oval_fts_pattern_add(struct oval_fts_pattern *pat, const char *comp, size_t len, bool literal)
+{
+	struct oval_fts_segment *seg;
+	const char *errptr = NULL;
+	int errofs = 0;
+	char *re;
+
+	if (pat->depth == OVAL_FTS_PATTERN_MAX_DEPTH)
+		return false;
+
+	seg = &pat->segs[pat->depth];
+
+	if (literal) {
+		seg->name = __string_unescape((char *) comp, len);
+		if (seg->name == NULL)
+			return false;
+		seg->namelen = strlen(seg->name);
+	} else {
+		re = malloc(len + sizeof("^(?:)$"));
+		if (re == NULL)
+			return false;
+		sprintf(re, "^(?:%.*s)$", (int) len, comp);
+		/* the same options as the comparison of the paths */
+		seg->regex = oscap_pcre_cache_get(re, PCRE_UTF8, &errptr, &errofs);
+		if (seg->regex == NULL) {
+			/* e.g. a back reference to another component */
+			dD("Can't compile the path component '%s': %s.", re, errptr);
+			free(re);
+			return false;
+		}
+		free(re);
+	}
+
+	pat->depth++;
+
+	return true;
+}
+
+static void oval_fts_pattern_free(struct oval_fts_pattern *pat)
+{
+	int i;
+
+	if (pat == NULL)
+		return;
+
+	for (i = 0; i < pat->depth; ++i) {
+		free(pat->segs[i].name);
+		if (pat->segs[i].regex != NULL)
+			oscap_pcre_cache_release(pat->segs[i].regex);
+	}
+
+	free(pat);
+}
+
+/* Split the pattern into the segments, NULL if no segment can be
+   derived from it. */
+static struct oval_fts_pattern *oval_fts_pattern_new(const char *pattern)
+{
+	struct oval_fts_pattern *pat;
+	const char *s, *start;
+	size_t step;
+	int level = 0, r;
+	bool bounded = true, literal = true, slashp = false, dollar = false, sep;
+
+	if (*pattern == '^')
+		pattern++;
+	if (pattern[0] == '/')
+		s = pattern + 1;
+	else if (pattern[0] == '\\' && pattern[1] == '/')
+		s = pattern + 2;
+	else
+		return NULL;
+
+	pat = calloc(1, sizeof(struct oval_fts_pattern));
+	if (pat == NULL)
+		return NULL;
+
+	/* scan the whole pattern to find an alternative at the top level */
+	for (start = s;; s += step) {
+		step = 1;
+		sep = false;
+
+		switch (*s) {
+		case '\0':
+			sep = true;
+			break;
+		case '\\':
+			if (s[1] == '\0')
+				goto fail;
+			step = 2;
+			if (s[1] == '/') {
+				if (level == 0)
+					sep = true;
+				else
+					slashp = true;
+			} else if (isalnum((unsigned char) s[1])) {
+				literal = false;
+				if (strchr("dswbB", s[1]) == NULL)
+					slashp = true;
+			}
+			break;
+		case '/':
+			if (level == 0)
+				sep = true;
+			else
+				slashp = true;
+			break;
+		case '[': {
+			const char *e = s;
+
+			r = oval_fts_class_match_slash(&e);
+			if (r == -2)
+				goto fail;
+			if (r != 0)
+				slashp = true;
+			literal = false;
+			step = e - s + 1;
+			break;
+		}
+		case '(':
+			/* lookarounds and options can reach other components */
+			if (s[1] == '?' && s[2] != ':')
+				slashp = true;
+			literal = false;
+			level++;
+			break;
+		case ')':
+			literal = false;
+			level--;
+			break;
+		case '|':
+			if (level == 0)
+				goto fail;
+			literal = false;
+			break;
+		case '.':
+			literal = false;
+			slashp = true;
+			break;
+		case '$':
+			if (s[1] == '\0' && level == 0)
+				dollar = true;
+			else
+				literal = false;
+			break;
+		case '^':
+		case '*':
+		case '+':
+		case '?':
+		case '{':
+			literal = false;
+			break;
+		}
+
+		if (!sep)
+			continue;
+
+		if (bounded) {
+			size_t len = s - start;
+
+			if (dollar)
+				--len;
+
+			if (slashp || len == 0) {
+				bounded = false;
+			} else if (*s != '\0') {
+				/* a quantified slash may not separate the components */
+				if (strchr("*+?{", s[step]) != NULL
+				    || !oval_fts_pattern_add(pat, start, len, literal))
+					bounded = false;
+			} else if (dollar) {
+				if (oval_fts_pattern_add(pat, start, len, literal))
+					pat->anchored = true;
+			}
+			/* the last component without a '$' matches any name prefix */
+		}
+
+		if (*s == '\0')
+			break;
+
+		start = s + step;
+		literal = true;
+		slashp = false;
+	}
+
+	if (pat->depth == 0)
+		goto fail;
+
+	return pat;
+fail:
+	oval_fts_pattern_free(pat);
+	return NULL;
+}
+
+static bool oval_fts_segment_match(const struct oval_fts_segment *seg, const char *name, size_t len)
+{
+	int ret;
+
+	if (seg->name != NULL) {
+		/* '$' matches before a trailing newline as well */
+		if (len == seg->namelen + 1 && name[seg->namelen] == '\n')
+			len--;
+		return (len == seg->namelen && memcmp(seg->name, name, len) == 0);
+	}
+
+	ret = oscap_pcre_exec(seg->regex, name, len, 0, 0, NULL, 0);
+
+	/* let the regex of the whole path handle the errors */
+	return (ret != PCRE_ERROR_NOMATCH);
+}
+
+/* Tell what may match at or below the directory. Only the last component
+   of the path is checked unless all is set, the parent directories have
+   been checked when they were visited. */
+static int oval_fts_pattern_check(const struct oval_fts_pattern *pat, const char *path, bool all)
+{
+	const char *name, *end, *next;
+	int depth = 0;
+
+	for (name = path; *name == '/'; ++name);
+
+	for (; *name != '\0'; name = next) {
+		end = strchr(name, '/');
+		if (end == NULL)
+			end = name + strlen(name);
+		for (next = end; *next == '/'; ++next);
+
+		++depth;
+		if (depth <= pat->depth && (all || *next == '\0')
+		    && !oval_fts_segment_match(&pat->segs[depth - 1], name, end - name))
+			return OVAL_FTS_PATTERN_SKIP;
+	}
+
+	if (depth < pat->depth)
+		return OVAL_FTS_PATTERN_DESCEND;
+	if (pat->anchored)
+		return (depth == pat->depth ? OVAL_FTS_PATTERN_LEAF : OVAL_FTS_PATTERN_SKIP);
+
+	return OVAL_FTS_PATTERN_UNKNOWN;
+}
+
 
 #undef TEST_PATH1
 #undef TEST_PATH2
@@ -685,7 +1032,8 @@ OVAL_FTS *oval_fts_open_prefixed(const char *prefix, SEXP_t *path, SEXP_t *filen
 
 	uint32_t path_op;
 	bool nilfilename = false;
-	pcre *regex = NULL;
+	struct oscap_pcre *regex = NULL;
+	struct oval_fts_pattern *pattern = NULL;
 	struct stat st;
 
 	if ((path != NULL || filename != NULL || filepath == NULL)
@@ -826,6 +1174,12 @@ OVAL_FTS *oval_fts_open_prefixed(const char *prefix, SEXP_t *path, SEXP_t *filen
 			return NULL;
 		paths[0] = extract_fixed_path_prefix(cstr_path);
 		dD("Extracted fixed path: '%s'.", paths[0]);
+		if (getenv("OSCAP_FTS_NO_PATTERN_PRUNING") == NULL) {
+			pattern = oval_fts_pattern_new(cstr_path);
+			if (pattern != NULL)
+				dD("Pruning the directories by %d components of the pattern%s.",
+				   pattern->depth, pattern->anchored ? ", anchored" : "");
+		}
 	} else {
 		paths[0] = strdup("/");
 	}
@@ -838,12 +1192,14 @@ OVAL_FTS *oval_fts_open_prefixed(const char *prefix, SEXP_t *path, SEXP_t *filen
 	dI("Opening file '%s'.", paths[0]);
 	/* Fail if the provided path doensn't actually exist. Symlinks
 	   without targets are accepted. */
-	if (lstat(paths[0], &st) == -1) {
+	if (fscache_lstat(paths[0], &st) == -1) {
 		if (errno) {
 			dD("lstat() failed: errno: %d, '%s'.",
 			   errno, strerror(errno));
 		}
 		free((void *) paths[0]);
+		oscap_pcre_cache_release(regex);
+		oval_fts_pattern_free(pattern);
 		return NULL;
 	}
 
@@ -852,24 +1208,22 @@ OVAL_FTS *oval_fts_open_prefixed(const char *prefix, SEXP_t *path, SEXP_t *filen
 
 	/* reset errno as fts_open() doesn't do it itself. */
 	errno = 0;
-	ofts->ofts_match_path_fts = fts_open((char * const *) paths, mtc_fts_options, NULL);
+	ofts->ofts_match_path_fts = fscache_fts_open(paths[0], mtc_fts_options);
 	free((void *) paths[0]);
 	/* fts_open() doesn't return NULL for all errors (e.g. nonexistent paths),
 	   so check errno to detect it. Far from being perfect. */
 	if (ofts->ofts_match_path_fts == NULL || errno != 0) {
 		dE("fts_open() failed, errno: %d \"%s\".", errno, strerror(errno));
 		OVAL_FTS_free(ofts);
+		oscap_pcre_cache_release(regex);
+		oval_fts_pattern_free(pattern);
 		return (NULL);
 	}
 
 	ofts->ofts_recurse_path_fts_opts = rec_fts_options;
 	ofts->ofts_path_op = path_op;
-	if (regex != NULL) {
-		const char *errptr = NULL;
-
-		ofts->ofts_path_regex = regex;
-		ofts->ofts_path_regex_extra = pcre_study(regex, 0, &errptr);
-	}
+	ofts->ofts_path_regex = regex;
+	ofts->ofts_path_pattern = pattern;
 
 	if (filesystem == OVAL_RECURSE_FS_LOCAL) {
 #if defined(OS_SOLARIS)
@@ -880,20 +1234,20 @@ OVAL_FTS *oval_fts_open_prefixed(const char *prefix, SEXP_t *path, SEXP_t *filen
 			dE("fsdev_init() failed.");
 			/* One dummy read to get rid of an uninitialized
 			 * value in the FTS data before calling
-			 * fts_close() on it. */
-			fts_read(ofts->ofts_match_path_fts);
+			 * fscache_fts_close() on it. */
+			fscache_fts_read(ofts->ofts_match_path_fts);
 			oval_fts_close(ofts);
 			return (NULL);
 		}
 #endif
 	} else if (filesystem == OVAL_RECURSE_FS_DEFINED) {
 		/* store the device id for future comparison */
-		FTSENT *fts_ent;
+		fscache_ftsent_t *fts_ent;
 
-		fts_ent = fts_read(ofts->ofts_match_path_fts);
+		fts_ent = fscache_fts_read(ofts->ofts_match_path_fts);
 		if (fts_ent != NULL) {
 			ofts->ofts_recurse_path_devid = fts_ent->fts_statp->st_dev;
-			fts_set(ofts->ofts_match_path_fts, fts_ent, FTS_AGAIN);
+			fscache_fts_set(ofts->ofts_match_path_fts, fts_ent, FTS_AGAIN);
 		}
 	}
 
@@ -923,7 +1277,7 @@ OVAL_FTS *oval_fts_open_prefixed(const char *prefix, SEXP_t *path, SEXP_t *filen
 	return (ofts);
 }
 
-static inline int _oval_fts_is_local(OVAL_FTS *ofts, FTSENT *fts_ent) {
+static inline int _oval_fts_is_local(OVAL_FTS *ofts, fscache_ftsent_t *fts_ent) {
 # if defined(OS_SOLARIS)
 	/* pseudo filesystems will be skipped */
 	/* don't recurse into remote fs if local is specified */
@@ -942,15 +1296,17 @@ static inline int _oval_fts_is_local(OVAL_FTS *ofts, FTSENT *fts_ent) {
 }
 
 /* find the first matching path or filepath */
-static FTSENT *oval_fts_read_match_path(OVAL_FTS *ofts)
+static fscache_ftsent_t *oval_fts_read_match_path(OVAL_FTS *ofts)
 {
-	FTSENT *fts_ent = NULL;
+	fscache_ftsent_t *fts_ent = NULL;
 	SEXP_t *stmp;
 	oval_result_t ores;
+	const size_t shift = ofts->prefix ? strlen(ofts->prefix) : 0;
+	int verdict;
 
 	/* iterate until a match is found or all elements have been traversed */
 	for (;;) {
-		fts_ent = fts_read(ofts->ofts_match_path_fts);
+		fts_ent = fscache_fts_read(ofts->ofts_match_path_fts);
 		if (fts_ent == NULL)
 			return NULL;
 		switch (fts_ent->fts_info) {
@@ -958,7 +1314,7 @@ static FTSENT *oval_fts_read_match_path(OVAL_FTS *ofts)
 			continue;
 		case FTS_DC:
 			dW("Filesystem tree cycle detected at '%s'.", fts_ent->fts_path);
-			fts_set(ofts->ofts_match_path_fts, fts_ent, FTS_SKIP);
+			fscache_fts_set(ofts->ofts_match_path_fts, fts_ent, FTS_SKIP);
 			continue;
 		}
 
@@ -973,34 +1329,56 @@ static FTSENT *oval_fts_read_match_path(OVAL_FTS *ofts)
 #if defined(OSCAP_FTS_DEBUG)
 			dD("Only the target of a symlink gets reported, skipping '%s'.", fts_ent->fts_path, fts_ent->fts_name);
 #endif
-			fts_set(ofts->ofts_match_path_fts, fts_ent, FTS_FOLLOW);
+			fscache_fts_set(ofts->ofts_match_path_fts, fts_ent, FTS_FOLLOW);
 			continue;
 		}
 		if (_oval_fts_is_local(ofts, fts_ent)) {
 			dI("Don't recurse into non-local filesystems, skipping '%s'.", fts_ent->fts_path);
-			fts_set(ofts->ofts_recurse_path_fts, fts_ent, FTS_SKIP);
+			fscache_fts_set(ofts->ofts_recurse_path_fts, fts_ent, FTS_SKIP);
 			continue;
 		}
 		/* don't recurse beyond the initial filesystem */
 		if (ofts->filesystem == OVAL_RECURSE_FS_DEFINED
 		    && (fts_ent->fts_info == FTS_D || fts_ent->fts_info == FTS_SL)
 		    && ofts->ofts_recurse_path_devid != fts_ent->fts_statp->st_dev) {
-			fts_set(ofts->ofts_recurse_path_fts, fts_ent, FTS_SKIP);
+			fscache_fts_set(ofts->ofts_recurse_path_fts, fts_ent, FTS_SKIP);
 			continue;
 		}
 
+		/* skip the directories and the files of a filepath the
+		   components of the pattern don't allow */
+		verdict = OVAL_FTS_PATTERN_UNKNOWN;
+		if (ofts->ofts_path_pattern != NULL
+		    && (fts_ent->fts_info == FTS_D || ofts->ofts_sfilepath != NULL)) {
+			verdict = oval_fts_pattern_check(ofts->ofts_path_pattern,
+					fts_ent->fts_path + shift, fts_ent->fts_level == 0);
+			switch (verdict) {
+			case OVAL_FTS_PATTERN_SKIP:
+				if (fts_ent->fts_info == FTS_D)
+					fscache_fts_set(ofts->ofts_match_path_fts, fts_ent, FTS_SKIP);
+				continue;
+			case OVAL_FTS_PATTERN_DESCEND:
+				continue;
+			case OVAL_FTS_PATTERN_LEAF:
+				if (fts_ent->fts_info == FTS_D)
+					fscache_fts_set(ofts->ofts_match_path_fts, fts_ent, FTS_SKIP);
+				break;
+			}
+		}
+
 		/* partial match optimization for OVAL_OPERATION_PATTERN_MATCH operation on path and filepath */
-		if (ofts->ofts_path_regex != NULL && fts_ent->fts_info == FTS_D) {
+		if (ofts->ofts_path_regex != NULL && fts_ent->fts_info == FTS_D
+		    && verdict == OVAL_FTS_PATTERN_UNKNOWN) {
 			int ret, svec[3];
 
-			ret = pcre_exec(ofts->ofts_path_regex, ofts->ofts_path_regex_extra,
+			ret = oscap_pcre_exec(ofts->ofts_path_regex,
 					fts_ent->fts_path, fts_ent->fts_pathlen, 0, PCRE_PARTIAL,
 					svec, sizeof(svec) / sizeof(svec[0]));
 			if (ret < 0) {
 				switch (ret) {
 				case PCRE_ERROR_NOMATCH:
 					dD("Partial match optimization: PCRE_ERROR_NOMATCH, skipping.");
-					fts_set(ofts->ofts_match_path_fts, fts_ent, FTS_SKIP);
+					fscache_fts_set(ofts->ofts_match_path_fts, fts_ent, FTS_SKIP);
 					continue;
 				case PCRE_ERROR_PARTIAL:
 					dD("Partial match optimization: PCRE_ERROR_PARTIAL, continuing.");
@@ -1016,7 +1394,6 @@ static FTSENT *oval_fts_read_match_path(OVAL_FTS *ofts)
 		    || (!ofts->ofts_sfilepath && fts_ent->fts_info != FTS_D))
 			continue;
 
-		const size_t shift = ofts->prefix ? strlen(ofts->prefix) : 0;
 		stmp = SEXP_string_newf("%s", fts_ent->fts_path + shift);
 
 		if (ofts->ofts_sfilepath)
@@ -1041,16 +1418,36 @@ static FTSENT *oval_fts_read_match_path(OVAL_FTS *ofts)
 	    ofts->ofts_sfilename == NULL &&
 	    ofts->ofts_sfilepath == NULL)
 	{
-		fts_set(ofts->ofts_match_path_fts, fts_ent, FTS_SKIP);
+		fscache_fts_set(ofts->ofts_match_path_fts, fts_ent, FTS_SKIP);
 	}
 
 	return fts_ent;
 }
 
+/* the directories the recursion below descends into, see fscache_prefetch_start() */
+static bool oval_fts_prefetch_descend(void *arg, const char *path, const struct stat *st)
+{
+	OVAL_FTS *ofts = arg;
+
+#if defined(OS_SOLARIS)
+	if (!OVAL_FTS_localp(ofts, path, (void *)st->st_fstype))
+		return (false);
+#else
+	if (ofts->filesystem == OVAL_RECURSE_FS_LOCAL
+	    && !OVAL_FTS_localp(ofts, path, (void *)&st->st_dev))
+		return (false);
+#endif
+	if (ofts->filesystem == OVAL_RECURSE_FS_DEFINED
+	    && ofts->ofts_recurse_path_devid != st->st_dev)
+		return (false);
+
+	return (true);
+}
+
 /* find the first matching file or directory */
-static FTSENT *oval_fts_read_recurse_path(OVAL_FTS *ofts)
+static fscache_ftsent_t *oval_fts_read_recurse_path(OVAL_FTS *ofts)
 {
-	FTSENT *out_fts_ent = NULL;
+	fscache_ftsent_t *out_fts_ent = NULL;
 	/* the condition below is correct because ofts_sfilepath is NULL here */
 	bool collect_dirs = (ofts->ofts_sfilename == NULL);
 
@@ -1076,8 +1473,8 @@ static FTSENT *oval_fts_read_recurse_path(OVAL_FTS *ofts)
 #endif
 			/* reset errno as fts_open() doesn't do it itself. */
 			errno = 0;
-			ofts->ofts_recurse_path_fts = fts_open(paths,
-				ofts->ofts_recurse_path_fts_opts, NULL);
+			ofts->ofts_recurse_path_fts = fscache_fts_open(paths[0],
+				ofts->ofts_recurse_path_fts_opts);
 			/* fts_open() doesn't return NULL for all errors
 			   (e.g. nonexistent paths), so check errno to detect it.
 			   Far from being perfect. */
@@ -1089,20 +1486,30 @@ static FTSENT *oval_fts_read_recurse_path(OVAL_FTS *ofts)
 					paths[0], ofts->ofts_recurse_path_fts_opts);
 #endif
 				if (ofts->ofts_recurse_path_fts != NULL) {
-					fts_close(ofts->ofts_recurse_path_fts);
+					fscache_fts_close(ofts->ofts_recurse_path_fts);
 					ofts->ofts_recurse_path_fts = NULL;
 				}
 				return (NULL);
 			}
+
+			/* read the directories ahead of the traversal */
+			if (ofts->direction == OVAL_RECURSE_DIRECTION_DOWN
+			    && (ofts->recurse & OVAL_RECURSE_DIRS)) {
+				ofts->ofts_recurse_path_prefetch = fscache_prefetch_start(
+					ofts->ofts_recurse_path_fts, ofts->max_depth,
+					oval_fts_prefetch_descend, ofts);
+			}
 		}
 
 		/* iterate until a match is found or all elements have been traversed */
 		while (out_fts_ent == NULL) {
-			FTSENT *fts_ent;
+			fscache_ftsent_t *fts_ent;
 
-			fts_ent = fts_read(ofts->ofts_recurse_path_fts);
+			fts_ent = fscache_fts_read(ofts->ofts_recurse_path_fts);
 			if (fts_ent == NULL) {
-				fts_close(ofts->ofts_recurse_path_fts);
+				fscache_prefetch_stop(ofts->ofts_recurse_path_prefetch);
+				ofts->ofts_recurse_path_prefetch = NULL;
+				fscache_fts_close(ofts->ofts_recurse_path_fts);
 				ofts->ofts_recurse_path_fts = NULL;
 
 				return NULL;
@@ -1113,7 +1520,7 @@ static FTSENT *oval_fts_read_recurse_path(OVAL_FTS *ofts)
 				continue;
 			case FTS_DC:
 				dW("Filesystem tree cycle detected at '%s'.", fts_ent->fts_path);
-				fts_set(ofts->ofts_recurse_path_fts, fts_ent, FTS_SKIP);
+				fscache_fts_set(ofts->ofts_recurse_path_fts, fts_ent, FTS_SKIP);
 				continue;
 			}
 
@@ -1156,7 +1563,7 @@ static FTSENT *oval_fts_read_recurse_path(OVAL_FTS *ofts)
 				/* limit recursion depth */
 				if (ofts->direction == OVAL_RECURSE_DIRECTION_NONE
 				    || (ofts->max_depth != -1 && fts_ent->fts_level > ofts->max_depth)) {
-					fts_set(ofts->ofts_recurse_path_fts, fts_ent, FTS_SKIP);
+					fscache_fts_set(ofts->ofts_recurse_path_fts, fts_ent, FTS_SKIP);
 					continue;
 				}
 
@@ -1164,30 +1571,30 @@ static FTSENT *oval_fts_read_recurse_path(OVAL_FTS *ofts)
 				switch (fts_ent->fts_info) {
 				case FTS_D:
 					if (!(ofts->recurse & OVAL_RECURSE_DIRS)) {
-						fts_set(ofts->ofts_recurse_path_fts, fts_ent, FTS_SKIP);
+						fscache_fts_set(ofts->ofts_recurse_path_fts, fts_ent, FTS_SKIP);
 						continue;
 					}
 					break;
 				case FTS_SL:
 					if (!(ofts->recurse & OVAL_RECURSE_SYMLINKS)) {
-						fts_set(ofts->ofts_recurse_path_fts, fts_ent, FTS_SKIP);
+						fscache_fts_set(ofts->ofts_recurse_path_fts, fts_ent, FTS_SKIP);
 						continue;
 					}
-					fts_set(ofts->ofts_recurse_path_fts, fts_ent, FTS_FOLLOW);
+					fscache_fts_set(ofts->ofts_recurse_path_fts, fts_ent, FTS_FOLLOW);
 					break;
 				default:
 					continue;
 				}
 			}
 			if (_oval_fts_is_local(ofts, fts_ent)) {
-				fts_set(ofts->ofts_recurse_path_fts, fts_ent, FTS_SKIP);
+				fscache_fts_set(ofts->ofts_recurse_path_fts, fts_ent, FTS_SKIP);
 				continue;
 			}
 			/* don't recurse beyond the initial filesystem */
 			if (ofts->filesystem == OVAL_RECURSE_FS_DEFINED
 			    && (fts_ent->fts_info == FTS_D || fts_ent->fts_info == FTS_SL)
 			    && ofts->ofts_recurse_path_devid != fts_ent->fts_statp->st_dev) {
-				fts_set(ofts->ofts_recurse_path_fts, fts_ent, FTS_SKIP);
+				fscache_fts_set(ofts->ofts_recurse_path_fts, fts_ent, FTS_SKIP);
 				continue;
 			}
 		}
@@ -1214,8 +1621,8 @@ static FTSENT *oval_fts_read_recurse_path(OVAL_FTS *ofts)
 				/* fts_open() doesn't return NULL for all errors
 				   (e.g. nonexistent paths), so check errno to
 				   detect it. Far from being perfect. */
-				ofts->ofts_recurse_path_fts = fts_open(paths,
-					ofts->ofts_recurse_path_fts_opts, NULL);
+				ofts->ofts_recurse_path_fts = fscache_fts_open(paths[0],
+					ofts->ofts_recurse_path_fts_opts);
 				if (ofts->ofts_recurse_path_fts == NULL || errno != 0) {
 					dE("fts_open() failed, errno: %d \"%s\".",
 						errno, strerror(errno));
@@ -1224,7 +1631,7 @@ static FTSENT *oval_fts_read_recurse_path(OVAL_FTS *ofts)
 						paths[0], ofts->ofts_recurse_path_fts_opts);
 #endif
 					if (ofts->ofts_recurse_path_fts != NULL) {
-						fts_close(ofts->ofts_recurse_path_fts);
+						fscache_fts_close(ofts->ofts_recurse_path_fts);
 						ofts->ofts_recurse_path_fts = NULL;
 					}
 					return (NULL);
@@ -1233,9 +1640,9 @@ static FTSENT *oval_fts_read_recurse_path(OVAL_FTS *ofts)
 
 			/* iterate until a match is found or all elements have been traversed */
 			while (out_fts_ent == NULL) {
-				FTSENT *fts_ent;
+				fscache_ftsent_t *fts_ent;
 
-				fts_ent = fts_read(ofts->ofts_recurse_path_fts);
+				fts_ent = fscache_fts_read(ofts->ofts_recurse_path_fts);
 				if (fts_ent == NULL)
 					break;
 
@@ -1269,7 +1676,7 @@ static FTSENT *oval_fts_read_recurse_path(OVAL_FTS *ofts)
 					/* only fts root is collected */
 					if (fts_ent->fts_level == 0 && fts_ent->fts_info == FTS_D) {
 						out_fts_ent = fts_ent;
-						fts_set(ofts->ofts_recurse_path_fts, fts_ent, FTS_SKIP);
+						fscache_fts_set(ofts->ofts_recurse_path_fts, fts_ent, FTS_SKIP);
 						break;
 					}
 				} else {
@@ -1284,16 +1691,16 @@ static FTSENT *oval_fts_read_recurse_path(OVAL_FTS *ofts)
 				}
 
 				if (fts_ent->fts_info == FTS_SL)
-					fts_set(ofts->ofts_recurse_path_fts, fts_ent, FTS_FOLLOW);
+					fscache_fts_set(ofts->ofts_recurse_path_fts, fts_ent, FTS_FOLLOW);
 				/* limit recursion only to fts root */
 				else if (fts_ent->fts_level > 0)
-					fts_set(ofts->ofts_recurse_path_fts, fts_ent, FTS_SKIP);
+					fscache_fts_set(ofts->ofts_recurse_path_fts, fts_ent, FTS_SKIP);
 			}
 
 			if (out_fts_ent != NULL)
 				break;
 
-			fts_close(ofts->ofts_recurse_path_fts);
+			fscache_fts_close(ofts->ofts_recurse_path_fts);
 			ofts->ofts_recurse_path_fts = NULL;
 
 			if (!strcmp(ofts->ofts_recurse_path_curpth, "/"))
@@ -1316,7 +1723,7 @@ static FTSENT *oval_fts_read_recurse_path(OVAL_FTS *ofts)
 
 OVAL_FTSENT *oval_fts_read(OVAL_FTS *ofts)
 {
-	FTSENT *fts_ent;
+	fscache_ftsent_t *fts_ent;
 
 #if defined(OSCAP_FTS_DEBUG)
 	dD("ofts: %p.", ofts);
@@ -1364,9 +1771,8 @@ int oval_fts_close(OVAL_FTS *ofts)
 		free(ofts->ofts_recurse_path_pthcpy);
 
 	if (ofts->ofts_path_regex)
-		pcre_free(ofts->ofts_path_regex);
-	if (ofts->ofts_path_regex_extra)
-		pcre_free(ofts->ofts_path_regex_extra);
+		oscap_pcre_cache_release(ofts->ofts_path_regex);
+	oval_fts_pattern_free(ofts->ofts_path_pattern);
 
 	if (ofts->ofts_spath != NULL)
 		SEXP_free(ofts->ofts_spath);
@@ -1375,6 +1781,9 @@ int oval_fts_close(OVAL_FTS *ofts)
 	if (ofts->ofts_sfilepath != NULL)
 		SEXP_free(ofts->ofts_sfilepath);
 
+	/* the prefetch threads may still be reading the local devices */
+	fscache_prefetch_stop(ofts->ofts_recurse_path_prefetch);
+	ofts->ofts_recurse_path_prefetch = NULL;
 	fsdev_free(ofts->localdevs);
 
 	OVAL_FTS_free(ofts);
@@ -32,6 +32,7 @@
 #endif
 #include <pcre.h>
 #include "fsdev.h"
+#include "fscache.h"
 
 #define ENT_GET_AREF(ent, dst, attr_name, mandatory)			\
 	do {								\
@@ -68,18 +69,19 @@
 
 typedef struct {
 	/* oval_fts_read_match_path() state */
-	FTS *ofts_match_path_fts;
-	FTSENT *ofts_match_path_fts_ent;
+	fscache_fts_t *ofts_match_path_fts;
+	fscache_ftsent_t *ofts_match_path_fts_ent;
 	/* oval_fts_read_recurse_path() state */
-	FTS *ofts_recurse_path_fts;
+	fscache_fts_t *ofts_recurse_path_fts;
+	fscache_prefetch_t *ofts_recurse_path_prefetch;
 	int ofts_recurse_path_fts_opts;
 	int ofts_recurse_path_curdepth;
 	char *ofts_recurse_path_pthcpy;
 	char *ofts_recurse_path_curpth;
 	dev_t ofts_recurse_path_devid;
 
-	pcre       *ofts_path_regex;
-	pcre_extra *ofts_path_regex_extra;
+	struct oscap_pcre *ofts_path_regex;
+	struct oval_fts_pattern *ofts_path_pattern;
 	uint32_t ofts_path_op;
 
 	SEXP_t *ofts_spath;
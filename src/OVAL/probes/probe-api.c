@@ -53,6 +53,7 @@
 #include "probe/entcmp.h"
 #include "probe/probe.h"
 #include "SEAP/generic/strto.h"
+#include "SEAP/_sexp-manip.h"
 #include "oscap_helpers.h"
 
 extern probe_rcache_t  *OSCAP_GSYM(pcache);
@@ -114,7 +115,7 @@ SEXP_t *probe_item_new(const char *name, SEXP_t * attrs)
 
         /*
          * Allocate space for the ID which will be generated
-         * in the icache worker
+         * by the item cache
          */
 	sid  = SEXP_string_new("", 0);
 	attr = probe_attr_creat("id", sid, NULL);
@@ -503,95 +504,25 @@ oval_schema_version_t probe_obj_get_platform_schema_version(const SEXP_t *obj)
 
 SEXP_t *probe_obj_getattrval(const SEXP_t * obj, const char *name)
 {
-	SEXP_t *obj_name;
+	SEXP_t *obj_name, *val;
 
 	obj_name = SEXP_list_first(obj);
-
-	if (SEXP_listp(obj_name)) {
-		uint32_t i;
-		SEXP_t *attr;
-		char *name_buf = NULL;
-
-		i = 2;
-
-		while ((attr = SEXP_list_nth(obj_name, i)) != NULL) {
-			if (SEXP_stringp(attr)) {
-				if (SEXP_string_nth(attr, 1) == ':') {
-					if (name_buf == NULL) {
-						name_buf = oscap_sprintf(":%s", name);
-					}
-					if (SEXP_strcmp(attr, name_buf) == 0) {
-						SEXP_t *val;
-
-						val = SEXP_list_nth(obj_name, i + 1);
-						free(name_buf);
-						SEXP_free(attr);
-						SEXP_free(obj_name);
-
-						return (val);
-					}
-
-					++i;
-				}
-
-				++i;
-			}
-
-			SEXP_free(attr);
-		}
-		free(name_buf);
-	}
-
+	val = SEXP_listp(obj_name) ? SEXP_list_attrval(obj_name, name) : NULL;
 	SEXP_free(obj_name);
 
-	return (NULL);
+	return (val);
 }
 
 bool probe_obj_attrexists(const SEXP_t * obj, const char *name)
 {
 	SEXP_t *obj_name;
-	obj_name = SEXP_list_first(obj);
-
-	if (SEXP_listp(obj_name)) {
-		uint32_t i;
-		SEXP_t *attr;
-		char *name_buf = NULL;
-
-		i = 2;
-
-		while ((attr = SEXP_list_nth(obj_name, i)) != NULL) {
-			if (SEXP_stringp(attr)) {
-				if (SEXP_string_nth(attr, 1) == ':') {
-					if (name_buf == NULL) {
-						name_buf = oscap_sprintf(":%s", name);
-					}
-					if (SEXP_strcmp(attr, name_buf) == 0) {
-						free(name_buf);
-						SEXP_free(attr);
-						SEXP_free(obj_name);
-
-						return (true);
-					}
-					++i;
-				} else {
-					if (SEXP_strcmp(attr, name) == 0) {
-						free(name_buf);
-                                        SEXP_free(attr);
-                                        SEXP_free(obj_name);
-                                        return true;
-                                    }
-                                }
-				++i;
-			}
-
-			SEXP_free(attr);
-		}
-		free(name_buf);
-	}
+	bool exists;
 
+	obj_name = SEXP_list_first(obj);
+	exists = SEXP_listp(obj_name) && SEXP_list_attrexists(obj_name, name);
 	SEXP_free(obj_name);
 
-	return (false);
+	return (exists);
 }
 
 int probe_obj_setstatus(SEXP_t * obj, oval_syschar_status_t status)
@@ -1078,7 +1009,7 @@ SEXP_t *probe_ent_getval(const SEXP_t * ent)
 
 SEXP_t *probe_ent_getattrval(const SEXP_t * ent, const char *name)
 {
-	SEXP_t *attrs;
+	SEXP_t *attrs, *val;
 
 	if (ent == NULL) {
 		errno = EFAULT;
@@ -1086,39 +1017,10 @@ SEXP_t *probe_ent_getattrval(const SEXP_t * ent, const char *name)
 	}
 
 	attrs = SEXP_list_first(ent);
-
-	if (SEXP_listp(attrs)) {
-		SEXP_t *attr;
-		uint32_t i;
-
-		i = 2;
-
-		while ((attr = SEXP_list_nth(attrs, i)) != NULL) {
-			if (SEXP_stringp(attr)) {
-				char attr_name[32 + 1];
-				size_t attr_nlen;
-
-				attr_nlen = SEXP_string_cstr_r(attr, attr_name, sizeof attr_name);
-
-				if (attr_nlen > 2) {
-					if (attr_name[0] == ':') {
-						if (strcmp(attr_name + 1, name) == 0) {
-							SEXP_free(attr);
-							attr = SEXP_list_nth(attrs, i + 1);
-							SEXP_free(attrs);
-							return attr;
-						}
-					}
-				}
-			}
-
-                        SEXP_free(attr);
-			++i;
-		}
-	}
-
+	val = SEXP_listp(attrs) ? SEXP_list_attrval(attrs, name) : NULL;
 	SEXP_free(attrs);
-	return (NULL);
+
+	return (val);
 }
 
 bool probe_ent_attrexists(const SEXP_t * ent, const char *name)
@@ -209,143 +209,144 @@ typedef struct probe_table_entry {
 	probe_main_function_t probe_main_function;
 	probe_fini_function_t probe_fini_function;
 	probe_offline_mode_function_t probe_offline_mode_function;
+	probe_reset_function_t probe_reset_function;
 } probe_table_entry_t;
 
 static const probe_table_entry_t probe_table[] = {
-	/* {type, init, main, fini, offline} */
+	/* {type, init, main, fini, offline, reset} */
 #ifdef OPENSCAP_PROBE_INDEPENDENT_ENVIRONMENTVARIABLE
-	{OVAL_INDEPENDENT_ENVIRONMENT_VARIABLE, NULL, environmentvariable_probe_main, NULL, NULL},
+	{OVAL_INDEPENDENT_ENVIRONMENT_VARIABLE, NULL, environmentvariable_probe_main, NULL, NULL, NULL},
 #endif
 #ifdef OPENSCAP_PROBE_INDEPENDENT_ENVIRONMENTVARIABLE58
-	{OVAL_INDEPENDENT_ENVIRONMENT_VARIABLE58, NULL, environmentvariable58_probe_main, NULL, environmentvariable58_probe_offline_mode_supported},
+	{OVAL_INDEPENDENT_ENVIRONMENT_VARIABLE58, NULL, environmentvariable58_probe_main, NULL, environmentvariable58_probe_offline_mode_supported, NULL},
 #endif
 #ifdef OPENSCAP_PROBE_INDEPENDENT_FAMILY
-	{OVAL_INDEPENDENT_FAMILY, NULL, family_probe_main, NULL, family_probe_offline_mode_supported},
+	{OVAL_INDEPENDENT_FAMILY, NULL, family_probe_main, NULL, family_probe_offline_mode_supported, NULL},
 #endif
 #ifdef OPENSCAP_PROBE_INDEPENDENT_FILEHASH
-	{OVAL_INDEPENDENT_FILE_HASH, filehash_probe_init, filehash_probe_main, filehash_probe_fini, filehash_probe_offline_mode_supported},
+	{OVAL_INDEPENDENT_FILE_HASH, filehash_probe_init, filehash_probe_main, filehash_probe_fini, filehash_probe_offline_mode_supported, NULL},
 #endif
 #ifdef OPENSCAP_PROBE_INDEPENDENT_FILEHASH58
-	{OVAL_INDEPENDENT_FILE_HASH58, filehash58_probe_init, filehash58_probe_main, filehash58_probe_fini, filehash58_probe_offline_mode_supported},
+	{OVAL_INDEPENDENT_FILE_HASH58, filehash58_probe_init, filehash58_probe_main, filehash58_probe_fini, filehash58_probe_offline_mode_supported, filehash58_probe_reset},
 #endif
 #ifdef OPENSCAP_PROBE_INDEPENDENT_SQL
-	{OVAL_INDEPENDENT_SQL, NULL, sql_probe_main, NULL, NULL},
+	{OVAL_INDEPENDENT_SQL, NULL, sql_probe_main, NULL, NULL, NULL},
 #endif
 #ifdef OPENSCAP_PROBE_INDEPENDENT_SQL57
-	{OVAL_INDEPENDENT_SQL57, NULL, sql57_probe_main, NULL, NULL},
+	{OVAL_INDEPENDENT_SQL57, NULL, sql57_probe_main, NULL, NULL, NULL},
 #endif
 #ifdef OPENSCAP_PROBE_INDEPENDENT_SYSTEM_INFO
-	{OVAL_INDEPENDENT_SYSCHAR_SUBTYPE, NULL, system_info_probe_main, NULL, system_info_probe_offline_mode_supported},
+	{OVAL_INDEPENDENT_SYSCHAR_SUBTYPE, NULL, system_info_probe_main, NULL, system_info_probe_offline_mode_supported, NULL},
 #endif
 #ifdef OPENSCAP_PROBE_INDEPENDENT_TEXTFILECONTENT
-	{OVAL_INDEPENDENT_TEXT_FILE_CONTENT, NULL, textfilecontent_probe_main, NULL, textfilecontent_probe_offline_mode_supported},
+	{OVAL_INDEPENDENT_TEXT_FILE_CONTENT, NULL, textfilecontent_probe_main, NULL, textfilecontent_probe_offline_mode_supported, NULL},
 #endif
 #ifdef OPENSCAP_PROBE_INDEPENDENT_TEXTFILECONTENT54
-	{OVAL_INDEPENDENT_TEXT_FILE_CONTENT_54, NULL, textfilecontent54_probe_main, NULL, textfilecontent54_probe_offline_mode_supported},
+	{OVAL_INDEPENDENT_TEXT_FILE_CONTENT_54, NULL, textfilecontent54_probe_main, NULL, textfilecontent54_probe_offline_mode_supported, NULL},
 #endif
 #ifdef OPENSCAP_PROBE_INDEPENDENT_VARIABLE
-	{OVAL_INDEPENDENT_VARIABLE, NULL, variable_probe_main, NULL, variable_probe_offline_mode_supported},
+	{OVAL_INDEPENDENT_VARIABLE, NULL, variable_probe_main, NULL, variable_probe_offline_mode_supported, NULL},
 #endif
 #ifdef OPENSCAP_PROBE_INDEPENDENT_XMLFILECONTENT
-	{OVAL_INDEPENDENT_XML_FILE_CONTENT, xmlfilecontent_probe_init, xmlfilecontent_probe_main, xmlfilecontent_probe_fini, xmlfilecontent_probe_offline_mode_supported},
+	{OVAL_INDEPENDENT_XML_FILE_CONTENT, xmlfilecontent_probe_init, xmlfilecontent_probe_main, xmlfilecontent_probe_fini, xmlfilecontent_probe_offline_mode_supported, NULL},
 #endif
 #ifdef OPENSCAP_PROBE_INDEPENDENT_YAMLFILECONTENT
-	{OVAL_INDEPENDENT_YAML_FILE_CONTENT, NULL, yamlfilecontent_probe_main, NULL, yamlfilecontent_probe_offline_mode_supported},
+	{OVAL_INDEPENDENT_YAML_FILE_CONTENT, NULL, yamlfilecontent_probe_main, NULL, yamlfilecontent_probe_offline_mode_supported, NULL},
 #endif
 #ifdef OPENSCAP_PROBE_LINUX_DPKGINFO
-	{OVAL_LINUX_DPKG_INFO, dpkginfo_probe_init, dpkginfo_probe_main, dpkginfo_probe_fini, dpkginfo_probe_offline_mode_supported},
+	{OVAL_LINUX_DPKG_INFO, dpkginfo_probe_init, dpkginfo_probe_main, dpkginfo_probe_fini, dpkginfo_probe_offline_mode_supported, NULL},
 #endif
 #ifdef OPENSCAP_PROBE_LINUX_IFLISTENERS
-	{OVAL_LINUX_IFLISTENERS, NULL, iflisteners_probe_main, NULL, NULL},
+	{OVAL_LINUX_IFLISTENERS, NULL, iflisteners_probe_main, NULL, NULL, NULL},
 #endif
 #ifdef OPENSCAP_PROBE_LINUX_INETLISTENINGSERVERS
-	{OVAL_LINUX_INET_LISTENING_SERVERS, NULL, inetlisteningservers_probe_main, NULL, NULL},
+	{OVAL_LINUX_INET_LISTENING_SERVERS, NULL, inetlisteningservers_probe_main, NULL, NULL, NULL},
 #endif
 #ifdef OPENSCAP_PROBE_LINUX_PARTITION
-	{OVAL_LINUX_PARTITION, partition_probe_init, partition_probe_main, NULL, NULL},
+	{OVAL_LINUX_PARTITION, partition_probe_init, partition_probe_main, NULL, NULL, NULL},
 #endif
 #ifdef OPENSCAP_PROBE_LINUX_RPMINFO
-	{OVAL_LINUX_RPM_INFO, rpminfo_probe_init, rpminfo_probe_main, rpminfo_probe_fini, rpminfo_probe_offline_mode_supported},
+	{OVAL_LINUX_RPM_INFO, rpminfo_probe_init, rpminfo_probe_main, rpminfo_probe_fini, rpminfo_probe_offline_mode_supported, rpminfo_probe_reset},
 #endif
 #ifdef OPENSCAP_PROBE_LINUX_RPMVERIFY
-	{OVAL_LINUX_RPMVERIFY, rpmverify_probe_init, rpmverify_probe_main, rpmverify_probe_fini, rpmverify_probe_offline_mode_supported},
+	{OVAL_LINUX_RPMVERIFY, rpmverify_probe_init, rpmverify_probe_main, rpmverify_probe_fini, rpmverify_probe_offline_mode_supported, rpmverify_probe_reset},
 #endif
 #ifdef OPENSCAP_PROBE_LINUX_RPMVERIFYFILE
-	{OVAL_LINUX_RPMVERIFYFILE, rpmverifyfile_probe_init, rpmverifyfile_probe_main, rpmverifyfile_probe_fini, rpmverifyfile_probe_offline_mode_supported},
+	{OVAL_LINUX_RPMVERIFYFILE, rpmverifyfile_probe_init, rpmverifyfile_probe_main, rpmverifyfile_probe_fini, rpmverifyfile_probe_offline_mode_supported, rpmverifyfile_probe_reset},
 #endif
 #ifdef OPENSCAP_PROBE_LINUX_RPMVERIFYPACKAGE
-	{OVAL_LINUX_RPMVERIFYPACKAGE, rpmverifypackage_probe_init, rpmverifypackage_probe_main, rpmverifypackage_probe_fini, rpmverifypackage_probe_offline_mode_supported},
+	{OVAL_LINUX_RPMVERIFYPACKAGE, rpmverifypackage_probe_init, rpmverifypackage_probe_main, rpmverifypackage_probe_fini, rpmverifypackage_probe_offline_mode_supported, rpmverifypackage_probe_reset},
 #endif
 #ifdef OPENSCAP_PROBE_LINUX_SELINUXBOOLEAN
-	{OVAL_LINUX_SELINUXBOOLEAN, NULL, selinuxboolean_probe_main, NULL, NULL},
+	{OVAL_LINUX_SELINUXBOOLEAN, NULL, selinuxboolean_probe_main, NULL, NULL, NULL},
 #endif
 #ifdef OPENSCAP_PROBE_LINUX_SELINUXSECURITYCONTEXT
-	{OVAL_LINUX_SELINUXSECURITYCONTEXT, NULL, selinuxsecuritycontext_probe_main, NULL, selinuxsecuritycontext_probe_offline_mode_supported},
+	{OVAL_LINUX_SELINUXSECURITYCONTEXT, NULL, selinuxsecuritycontext_probe_main, NULL, selinuxsecuritycontext_probe_offline_mode_supported, NULL},
 #endif
 #ifdef OPENSCAP_PROBE_LINUX_SYSTEMDUNITDEPENDENCY
-	{OVAL_LINUX_SYSTEMDUNITDEPENDENCY, NULL, systemdunitdependency_probe_main, NULL, NULL},
+	{OVAL_LINUX_SYSTEMDUNITDEPENDENCY, systemdunitdependency_probe_init, systemdunitdependency_probe_main, systemdunitdependency_probe_fini, NULL, systemdunitdependency_probe_reset},
 #endif
 #ifdef OPENSCAP_PROBE_LINUX_SYSTEMDUNITPROPERTY
-	{OVAL_LINUX_SYSTEMDUNITPROPERTY, NULL, systemdunitproperty_probe_main, NULL, NULL},
+	{OVAL_LINUX_SYSTEMDUNITPROPERTY, systemdunitproperty_probe_init, systemdunitproperty_probe_main, systemdunitproperty_probe_fini, NULL, systemdunitproperty_probe_reset},
 #endif
 #ifdef OPENSCAP_PROBE_SOLARIS_ISAINFO
-	{OVAL_SOLARIS_ISAINFO, NULL, isainfo_probe_main, NULL, NULL},
+	{OVAL_SOLARIS_ISAINFO, NULL, isainfo_probe_main, NULL, NULL, NULL},
 #endif
 #ifdef OPENSCAP_PROBE_UNIX_DNSCACHE
-	{OVAL_UNIX_DNSCACHE, NULL, dnscache_probe_main, NULL, NULL},
+	{OVAL_UNIX_DNSCACHE, NULL, dnscache_probe_main, NULL, NULL, NULL},
 #endif
 #ifdef OPENSCAP_PROBE_UNIX_FILE
-	{OVAL_UNIX_FILE, file_probe_init, file_probe_main, file_probe_fini, file_probe_offline_mode_supported},
+	{OVAL_UNIX_FILE, NULL, file_probe_main, NULL, file_probe_offline_mode_supported, NULL},
 #endif
 #ifdef OPENSCAP_PROBE_UNIX_FILEEXTENDEDATTRIBUTE
-	{OVAL_UNIX_FILEEXTENDEDATTRIBUTE, fileextendedattribute_probe_init, fileextendedattribute_probe_main, fileextendedattribute_probe_fini, fileextendedattribute_probe_offline_mode_supported},
+	{OVAL_UNIX_FILEEXTENDEDATTRIBUTE, fileextendedattribute_probe_init, fileextendedattribute_probe_main, fileextendedattribute_probe_fini, fileextendedattribute_probe_offline_mode_supported, NULL},
 #endif
 #ifdef OPENSCAP_PROBE_UNIX_GCONF
-	{OVAL_UNIX_GCONF, NULL, gconf_probe_main, NULL, NULL},
+	{OVAL_UNIX_GCONF, NULL, gconf_probe_main, NULL, NULL, NULL},
 #endif
 #ifdef OPENSCAP_PROBE_UNIX_INTERFACE
-	{OVAL_UNIX_INTERFACE, NULL, interface_probe_main, NULL, NULL},
+	{OVAL_UNIX_INTERFACE, NULL, interface_probe_main, NULL, NULL, NULL},
 #endif
 #ifdef OPENSCAP_PROBE_UNIX_PASSWORD
-	{OVAL_UNIX_PASSWORD, NULL, password_probe_main, NULL, NULL},
+	{OVAL_UNIX_PASSWORD, NULL, password_probe_main, NULL, NULL, NULL},
 #endif
 #ifdef OPENSCAP_PROBE_UNIX_PROCESS
-	{OVAL_UNIX_PROCESS, NULL, process_probe_main, NULL, NULL},
+	{OVAL_UNIX_PROCESS, NULL, process_probe_main, NULL, NULL, NULL},
 #endif
 #ifdef OPENSCAP_PROBE_UNIX_PROCESS58
-	{OVAL_UNIX_PROCESS58, NULL, process58_probe_main, NULL, NULL},
+	{OVAL_UNIX_PROCESS58, NULL, process58_probe_main, NULL, NULL, NULL},
 #endif
 #ifdef OPENSCAP_PROBE_UNIX_ROUTINGTABLE
-	{OVAL_UNIX_ROUTINGTABLE, NULL, routingtable_probe_main, NULL, NULL},
+	{OVAL_UNIX_ROUTINGTABLE, NULL, routingtable_probe_main, NULL, NULL, NULL},
 #endif
 #ifdef OPENSCAP_PROBE_UNIX_RUNLEVEL
-	{OVAL_UNIX_RUNLEVEL, NULL, runlevel_probe_main, NULL, runlevel_probe_offline_mode_supported},
+	{OVAL_UNIX_RUNLEVEL, NULL, runlevel_probe_main, NULL, runlevel_probe_offline_mode_supported, NULL},
 #endif
 #ifdef OPENSCAP_PROBE_UNIX_SHADOW
-	{OVAL_UNIX_SHADOW, NULL, shadow_probe_main, NULL, NULL},
+	{OVAL_UNIX_SHADOW, NULL, shadow_probe_main, NULL, NULL, NULL},
 #endif
 #ifdef OPENSCAP_PROBE_UNIX_SYMLINK
-	{OVAL_UNIX_SYMLINK, NULL, symlink_probe_main, NULL, symlink_probe_offline_mode_supported},
+	{OVAL_UNIX_SYMLINK, NULL, symlink_probe_main, NULL, symlink_probe_offline_mode_supported, NULL},
 #endif
 #ifdef OPENSCAP_PROBE_UNIX_SYSCTL
-	{OVAL_UNIX_SYSCTL, NULL, sysctl_probe_main, NULL, NULL},
+	{OVAL_UNIX_SYSCTL, NULL, sysctl_probe_main, NULL, NULL, NULL},
 #endif
 #ifdef OPENSCAP_PROBE_UNIX_UNAME
-	{OVAL_UNIX_UNAME, NULL, uname_probe_main, NULL, NULL},
+	{OVAL_UNIX_UNAME, NULL, uname_probe_main, NULL, NULL, NULL},
 #endif
 #ifdef OPENSCAP_PROBE_UNIX_XINETD
-	{OVAL_UNIX_XINETD, xinetd_probe_init, xinetd_probe_main, xinetd_probe_fini, xinetd_probe_offline_mode_supported},
+	{OVAL_UNIX_XINETD, xinetd_probe_init, xinetd_probe_main, xinetd_probe_fini, xinetd_probe_offline_mode_supported, NULL},
 #endif
 #ifdef OPENSCAP_PROBE_WINDOWS_ACCESSTOKEN
-	{OVAL_WINDOWS_ACCESS_TOKEN, NULL, accesstoken_probe_main, NULL, NULL},
+	{OVAL_WINDOWS_ACCESS_TOKEN, NULL, accesstoken_probe_main, NULL, NULL, NULL},
 #endif
 #ifdef OPENSCAP_PROBE_WINDOWS_REGISTRY
-	{OVAL_WINDOWS_REGISTRY, NULL, registry_probe_main, NULL, NULL},
+	{OVAL_WINDOWS_REGISTRY, NULL, registry_probe_main, NULL, NULL, NULL},
 #endif
 #ifdef OPENSCAP_PROBE_WINDOWS_WMI57
-	{OVAL_WINDOWS_WMI_57, NULL, wmi57_probe_main, NULL, NULL},
+	{OVAL_WINDOWS_WMI_57, NULL, wmi57_probe_main, NULL, NULL, NULL},
 #endif
-	{OVAL_SUBTYPE_UNKNOWN, NULL, NULL, NULL, NULL}
+	{OVAL_SUBTYPE_UNKNOWN, NULL, NULL, NULL, NULL, NULL}
 };
 
 static const probe_table_entry_t *probe_table_get(oval_subtype_t type)
@@ -382,6 +383,12 @@ probe_offline_mode_function_t probe_table_get_offline_mode_function(oval_subtype
 	return entry->probe_offline_mode_function;
 }
 
+probe_reset_function_t probe_table_get_reset_function(oval_subtype_t type)
+{
+	const probe_table_entry_t *entry = probe_table_get(type);
+	return entry->probe_reset_function;
+}
+
 void probe_table_list(FILE *output)
 {
 	const probe_table_entry_t *entry = probe_table;
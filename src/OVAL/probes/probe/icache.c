@@ -31,7 +31,6 @@
 #include <inttypes.h>
 #include <stdlib.h>
 
-#include "../SEAP/generic/rbt/rbt.h"
 #include "probe-api.h"
 #include "common/debug_priv.h"
 #include "common/memusage.h"
@@ -88,392 +87,221 @@ static void probe_icache_item_setID(SEXP_t *item, SEXP_ID_t item_ID)
         return;
 }
 
-static int icache_lookup(rbt_t *tree, int64_t item_id, probe_iqpair_t *pair) {
-
-	probe_citem_t *cached = NULL;
-
-	if (rbt_i64_get(tree, item_id, (void**)&cached) != 0) {
-		return -1;
-	}
-
-	/*
-	* Maybe a cache HIT
-	*/
-	dD("cache HIT #1");
-
-	register uint16_t i;
-	for (i = 0; i < cached->count; ++i) {
-		SEXP_t rest1;
-		SEXP_t* rest_r1 = SEXP_list_rest_r(&rest1, pair->p.item);
-
-		SEXP_t rest2;
-		SEXP_t* rest_r2 = SEXP_list_rest_r(&rest2, cached->item[i]);
-
-		if (SEXP_deepcmp(rest_r1, rest_r2)) {
-			SEXP_free_r(&rest1);
-			SEXP_free_r(&rest2);
-			break;
-		}
-
-		SEXP_free_r(&rest1);
-		SEXP_free_r(&rest2);
-	}
-
-	if (i == cached->count) {
-		/*
-		* Cache MISS
-		*/
-		dD("cache MISS");
-
-		cached->item = realloc(cached->item, sizeof(SEXP_t *) * ++cached->count);
-		cached->item[cached->count - 1] = pair->p.item;
-
-		/* Assign an unique item ID */
-		probe_icache_item_setID(pair->p.item, item_id);
-	} else {
-		/*
-		* Cache HIT
-		*/
-		dD("cache HIT #2 -> real HIT");
-		SEXP_free(pair->p.item);
-		pair->p.item = cached->item[i];
-	}
-	return 0;
+static probe_icache_shard_t *probe_icache_shard(probe_icache_t *cache, SEXP_ID_t id)
+{
+	return &cache->shard[(uint32_t)(id >> 32) & (PROBE_ICACHE_SHARDS - 1)];
 }
 
-static void icache_add_to_tree(rbt_t *tree, int64_t item_id, probe_iqpair_t *pair) {
-
-	probe_citem_t *cached = malloc(sizeof(probe_citem_t));
-	cached->item = malloc(sizeof(SEXP_t *));
-	cached->item[0] = pair->p.item;
-	cached->count = 1;
-
-	/* Assign an unique item ID */
-	probe_icache_item_setID(pair->p.item, item_id);
-
-	if (rbt_i64_add(tree, (int64_t)item_id, (void **)cached, NULL) != 0) {
-		dE("Can't add item (k=%"PRIi64" to the cache (%p)", item_id, tree);
-
-		free(cached->item);
-		free(cached);
-
-		/* now what? */
-		abort();
-	}
+static size_t probe_icache_bucket_idx(probe_icache_shard_t *shard, SEXP_ID_t id)
+{
+	return (size_t)(id & (shard->size - 1));
 }
 
-static void *probe_icache_worker(void *arg)
+static probe_citem_t *icache_lookup(probe_icache_shard_t *shard, SEXP_ID_t id)
 {
-        probe_icache_t *cache = (probe_icache_t *)(arg);
-        probe_iqpair_t *pair, pair_mem;
-        SEXP_ID_t       item_ID;
+	probe_citem_t *ci;
 
-	if (cache == NULL) {
-		return NULL;
+	for (ci = shard->bucket[probe_icache_bucket_idx(shard, id)]; ci != NULL; ci = ci->next) {
+		if (ci->id == id)
+			return ci;
 	}
 
-#if defined(HAVE_PTHREAD_SETNAME_NP)
-# if defined(OS_APPLE)
-	pthread_setname_np("icache_worker");
-# else
-	pthread_setname_np(pthread_self(), "icache_worker");
-# endif
-#endif
-
-        if (pthread_mutex_lock(&cache->queue_mutex) != 0) {
-                dE("An error ocured while locking the queue mutex: %u, %s",
-                   errno, strerror(errno));
-                return (NULL);
-        }
+	return NULL;
+}
 
-	pair = &pair_mem;
-        dD("icache worker ready");
-
-        switch (errno = pthread_barrier_wait(&OSCAP_GSYM(th_barrier)))
-        {
-        case 0:
-        case PTHREAD_BARRIER_SERIAL_THREAD:
-	        break;
-        default:
-	        dE("pthread_barrier_wait: %d, %s.",
-	           errno, strerror(errno));
-	        pthread_mutex_unlock(&cache->queue_mutex);
-	        return (NULL);
-        }
+/*
+ * Double the number of buckets of the shard. The shard lock has to be held.
+ */
+static void icache_grow(probe_icache_shard_t *shard)
+{
+	probe_citem_t **bucket, *ci, *next;
+	size_t i, size = shard->size * 2;
 
-        while(pthread_cond_wait(&cache->queue_notempty, &cache->queue_mutex) == 0) {
-			if (cache->queue_cnt <= 0) {
-				return NULL;
-			}
-        do {
-                dD("Extracting item from the cache queue: cnt=%"PRIu16", beg=%"PRIu16"", cache->queue_cnt, cache->queue_beg);
-                /*
-                 * Extract an item from the queue and update queue beg, end & cnt
-                 */
-                pair_mem = cache->queue[cache->queue_beg];
-#ifndef NDEBUG
-		memset(cache->queue + cache->queue_beg, 0, sizeof(probe_iqpair_t));
-#endif
-                --cache->queue_cnt;
-		++cache->queue_beg;
+	bucket = calloc(size, sizeof(probe_citem_t *));
 
-		if (cache->queue_beg == cache->queue_max)
-			cache->queue_beg = 0;
+	if (bucket == NULL)
+		return; /* keep the longer chains */
 
-		if (cache->queue_cnt == 0 ?
-			cache->queue_end != cache->queue_beg :
-			cache->queue_end == cache->queue_beg) {
-			return NULL;
+	for (i = 0; i < shard->size; ++i) {
+		for (ci = shard->bucket[i]; ci != NULL; ci = next) {
+			next = ci->next;
+			ci->next = bucket[ci->id & (size - 1)];
+			bucket[ci->id & (size - 1)] = ci;
 		}
+	}
 
-
-                dD("Signaling `notfull'");
-
-                if (pthread_cond_signal(&cache->queue_notfull) != 0) {
-                        dE("An error ocured while signaling the `notfull' condition: %u, %s",
-                           errno, strerror(errno));
-                        abort();
-                }
-                /*
-                 * Release the mutex
-                 */
-                if (pthread_mutex_unlock(&cache->queue_mutex) != 0) {
-                        dE("An error ocured while unlocking the queue mutex: %u, %s",
-                           errno, strerror(errno));
-                        abort();
-                }
-
-                if (pair->cobj == NULL) {
-                        /*
-                         * Handle NOP case (synchronization)
-                         */
-					if (pair->p.cond == NULL) {
-						return NULL;
-					}
-
-                        dD("Handling NOP");
-
-                        if (pthread_cond_signal(pair->p.cond) != 0) {
-                                dE("An error ocured while signaling NOP condition: %u, %s",
-                                   errno, strerror(errno));
-                                abort();
-                        }
-                } else {
-
-                        dD("Handling cache request");
-
-                        /*
-                         * Compute item ID
-                         */
-			dD("pair address: %"PRIu64, (uint64_t) pair);
-			dD("item address: %"PRIu64, (uint64_t) pair->p.item);
-                        item_ID = SEXP_ID_v(pair->p.item);
-                        dD("item ID=%"PRIu64"", item_ID);
-
-                        if (icache_lookup(cache->tree, item_ID, pair) != 0) {
-                                /*
-                                 * Cache MISS
-                                 */
-                                dD("cache MISS");
-                                icache_add_to_tree(cache->tree, item_ID, pair);
-                        }
-
-                        if (probe_cobj_add_item(pair->cobj, pair->p.item) != 0) {
-                            dW("An error ocured while adding the item to the collected object");
-                        }
-                }
-
-                if (pthread_mutex_lock(&cache->queue_mutex) != 0) {
-                        dE("An error ocured while re-locking the queue mutex: %u, %s",
-                           errno, strerror(errno));
-                        abort();
-                }
-
-                } while (cache->queue_cnt > 0);
-        }
-
-        return (NULL);
+	free(shard->bucket);
+	shard->bucket = bucket;
+	shard->size   = size;
 }
 
-probe_icache_t *probe_icache_new(void)
+/*
+ * Return a cached item equal to the given one or NULL if there's none. In
+ * the latter case, the item is added to the cache. The shard lock has to be
+ * held.
+ */
+static SEXP_t *icache_dedup(probe_icache_shard_t *shard, SEXP_ID_t id, SEXP_t *item)
 {
-        probe_icache_t *cache = malloc(sizeof(probe_icache_t));
-        cache->tree = rbt_i64_new();
+	probe_citem_t *cached;
+	uint16_t i;
 
-        if (pthread_mutex_init(&cache->queue_mutex, NULL) != 0) {
-                dE("Can't initialize icache mutex: %u, %s", errno, strerror(errno));
-                goto fail;
-        }
+	cached = icache_lookup(shard, id);
 
-        cache->queue_beg = 0;
-        cache->queue_end = 0;
-        cache->queue_cnt = 0;
-        cache->queue_max = PROBE_IQUEUE_CAPACITY;
+	if (cached == NULL) {
+		cached = malloc(sizeof(probe_citem_t));
+		cached->id    = id;
+		cached->item  = malloc(sizeof(SEXP_t *));
+		cached->item[0] = item;
+		cached->count = 1;
 
-        if (pthread_cond_init(&cache->queue_notempty, NULL) != 0) {
-                dE("Can't initialize icache queue condition variable (notempty): %u, %s",
-                   errno, strerror(errno));
-                goto fail;
-        }
-
-        if (pthread_cond_init(&cache->queue_notfull, NULL) != 0) {
-                dE("Can't initialize icache queue condition variable (notfull): %u, %s",
-                   errno, strerror(errno));
-                goto fail;
-        }
+		if (shard->count >= shard->size)
+			icache_grow(shard);
 
-        if (pthread_create(&cache->thid, NULL,
-                           probe_icache_worker, (void *)cache) != 0)
-        {
-                dE("Can't start the icache worker: %u, %s", errno, strerror(errno));
-                goto fail;
-        }
+		cached->next = shard->bucket[probe_icache_bucket_idx(shard, id)];
+		shard->bucket[probe_icache_bucket_idx(shard, id)] = cached;
+		++shard->count;
+		++shard->stats.items;
+		++shard->stats.misses;
 
-        return (cache);
-fail:
-        if (cache->tree != NULL)
-                rbt_i64_free(cache->tree);
+		return (NULL);
+	}
 
-        pthread_mutex_destroy(&cache->queue_mutex);
-        pthread_cond_destroy(&cache->queue_notempty);
-        free(cache);
+	/*
+	 * Maybe a cache HIT
+	 */
+	for (i = 0; i < cached->count; ++i) {
+		SEXP_t rest1;
+		SEXP_t* rest_r1 = SEXP_list_rest_r(&rest1, item);
 
-        return (NULL);
-}
+		SEXP_t rest2;
+		SEXP_t* rest_r2 = SEXP_list_rest_r(&rest2, cached->item[i]);
 
-static int __probe_icache_add_nolock(probe_icache_t *cache, SEXP_t *cobj, SEXP_t *item, pthread_cond_t *cond)
-{
-	if (!((cond == NULL) ^ (item == NULL))) {
-		return -1;
-	}
-retry:
-        if (cache->queue_cnt < cache->queue_max) {
-                cache->queue[cache->queue_end].cobj = cobj;
-
-                if (item != NULL) {
-					if (cobj == NULL) {
-						return -1;
-					}
-                        cache->queue[cache->queue_end].p.item = item;
-                } else {
-					if (item != NULL || cobj != NULL) {
-						return -1;
-					}
-                        cache->queue[cache->queue_end].p.cond = cond;
+		if (SEXP_deepcmp(rest_r1, rest_r2)) {
+			SEXP_free_r(&rest1);
+			SEXP_free_r(&rest2);
+			++shard->stats.hits;
+			return cached->item[i];
 		}
 
-                ++cache->queue_cnt;
-		++cache->queue_end;
-
-                if (cache->queue_end == cache->queue_max)
-                        cache->queue_end = 0;
-        } else {
-                /*
-                 * The queue is full, we have to wait
-                 */
-                if (pthread_cond_wait(&cache->queue_notfull, &cache->queue_mutex) == 0)
-                        goto retry;
-                else {
-                        dE("An error ocured while waiting for the `notfull' queue condition: %u, %s",
-                           errno, strerror(errno));
-                        return (-1);
-                }
-        }
+		SEXP_free_r(&rest1);
+		SEXP_free_r(&rest2);
+	}
 
-        return (0);
+	/*
+	 * Cache MISS, different items with the same hash
+	 */
+	cached->item = realloc(cached->item, sizeof(SEXP_t *) * ++cached->count);
+	cached->item[cached->count - 1] = item;
+	++shard->stats.items;
+	++shard->stats.misses;
+	++shard->stats.collisions;
+
+	return (NULL);
 }
 
-int probe_icache_add(probe_icache_t *cache, SEXP_t *cobj, SEXP_t *item)
+probe_icache_t *probe_icache_new(void)
 {
-        int ret;
+	probe_icache_t *cache = malloc(sizeof(probe_icache_t));
+	int i;
 
-        if (cache == NULL || cobj == NULL || item == NULL)
-                return (-1); /* XXX: EFAULT */
+	if (cache == NULL)
+		return (NULL);
 
-        if (pthread_mutex_lock(&cache->queue_mutex) != 0) {
-                dE("An error ocured while locking the queue mutex: %u, %s",
-                   errno, strerror(errno));
-                return (-1);
-        }
+	for (i = 0; i < PROBE_ICACHE_SHARDS; ++i) {
+		probe_icache_shard_t *shard = &cache->shard[i];
 
-        ret = __probe_icache_add_nolock(cache, cobj, item, NULL);
+		if (pthread_mutex_init(&shard->lock, NULL) != 0) {
+			dE("Can't initialize icache mutex: %u, %s", errno, strerror(errno));
+			goto fail;
+		}
 
-        if (pthread_cond_signal(&cache->queue_notempty) != 0) {
-                dE("An error ocured while signaling the `notempty' condition: %u, %s",
-                   errno, strerror(errno));
-                return (-1);
-        }
+		shard->size   = PROBE_ICACHE_SHARD_INITSIZE;
+		shard->count  = 0;
+		shard->bucket = calloc(shard->size, sizeof(probe_citem_t *));
+		memset(&shard->stats, 0, sizeof shard->stats);
 
-        if (pthread_mutex_unlock(&cache->queue_mutex) != 0) {
-                dE("An error ocured while unlocking the queue mutex: %u, %s",
-                   errno, strerror(errno));
-                abort();
-        }
+		if (shard->bucket == NULL) {
+			pthread_mutex_destroy(&shard->lock);
+			goto fail;
+		}
+	}
 
-        if (ret != 0)
-                return (-1);
+	return (cache);
+fail:
+	while (--i >= 0) {
+		pthread_mutex_destroy(&cache->shard[i].lock);
+		free(cache->shard[i].bucket);
+	}
+	free(cache);
 
-        return (0);
+	return (NULL);
 }
 
-int probe_icache_nop(probe_icache_t *cache)
+int probe_icache_add(probe_icache_t *cache, SEXP_t *cobj, SEXP_t *item)
 {
-        pthread_cond_t cond;
+	probe_icache_shard_t *shard;
+	SEXP_ID_t item_ID;
+	SEXP_t *cached;
 
-        dD("NOP");
+	if (cache == NULL || cobj == NULL || item == NULL)
+		return (-1); /* XXX: EFAULT */
 
-        if (pthread_mutex_lock(&cache->queue_mutex) != 0) {
-                dE("An error ocured while locking the queue mutex: %u, %s",
-                   errno, strerror(errno));
-                return (-1);
-        }
+	/*
+	 * Compute item ID
+	 */
+	item_ID = SEXP_ID_v(item);
+	dD("item ID=%"PRIu64"", item_ID);
 
-        if (pthread_cond_init(&cond, NULL) != 0) {
-                dE("Can't initialize icache queue condition variable (NOP): %u, %s",
-                   errno, strerror(errno));
-                return (-1);
-        }
+	shard = probe_icache_shard(cache, item_ID);
 
-        if (__probe_icache_add_nolock(cache, NULL, NULL, &cond) != 0) {
-                if (pthread_mutex_unlock(&cache->queue_mutex) != 0) {
-                        dE("An error ocured while unlocking the queue mutex: %u, %s",
-                           errno, strerror(errno));
-                        abort();
-                }
+	if (pthread_mutex_lock(&shard->lock) != 0) {
+		dE("An error ocured while locking the icache mutex: %u, %s",
+		   errno, strerror(errno));
+		return (-1);
+	}
 
-                pthread_cond_destroy(&cond);
-                return (-1);
-        }
+	cached = icache_dedup(shard, item_ID, item);
 
-        dD("Signaling `notempty'");
+	if (cached == NULL) {
+		/* Assign an unique item ID */
+		probe_icache_item_setID(item, item_ID);
+	}
 
-        if (pthread_cond_signal(&cache->queue_notempty) != 0) {
-                dE("An error ocured while signaling the `notempty' condition: %u, %s",
-                   errno, strerror(errno));
+	if (pthread_mutex_unlock(&shard->lock) != 0) {
+		dE("An error ocured while unlocking the icache mutex: %u, %s",
+		   errno, strerror(errno));
+		abort();
+	}
 
-                pthread_cond_destroy(&cond);
-                return (-1);
-        }
+	if (cached != NULL) {
+		dD("cache HIT");
+		SEXP_free(item);
+		item = cached;
+	}
 
-        dD("Waiting for icache worker to handle the NOP");
+	if (probe_cobj_add_item(cobj, item) != 0) {
+		dW("An error ocured while adding the item to the collected object");
+	}
 
-        if (pthread_cond_wait(&cond, &cache->queue_mutex) != 0) {
-                dE("An error ocured while waiting for the `NOP' queue condition: %u, %s",
-                   errno, strerror(errno));
-                return (-1);
-        }
+	return (0);
+}
 
-        dD("Sync");
+void probe_icache_get_stats(probe_icache_t *cache, probe_icache_stats_t *stats)
+{
+	int i;
 
-        if (pthread_mutex_unlock(&cache->queue_mutex) != 0) {
-                dE("An error ocured while unlocking the queue mutex: %u, %s",
-                   errno, strerror(errno));
-                abort();
-        }
+	memset(stats, 0, sizeof *stats);
 
-        pthread_cond_destroy(&cond);
+	for (i = 0; i < PROBE_ICACHE_SHARDS; ++i) {
+		probe_icache_shard_t *shard = &cache->shard[i];
 
-        return (0);
+		pthread_mutex_lock(&shard->lock);
+		stats->items      += shard->stats.items;
+		stats->hits       += shard->stats.hits;
+		stats->misses     += shard->stats.misses;
+		stats->collisions += shard->stats.collisions;
+		pthread_mutex_unlock(&shard->lock);
+	}
 }
 
 #define PROBE_RESULT_MEMCHECK_CTRESHOLD  32768  /* item count */
@@ -530,7 +358,7 @@ static int probe_cobj_memcheck(size_t item_cnt)
  *-1 ... unexpected/internal error
  *
  * The caller must not free the item, it's freed automatically
- * by this function or by the icache worker thread.
+ * by this function or by the item cache.
  */
 int probe_item_collect(struct probe_ctx *ctx, SEXP_t *item)
 {
@@ -553,12 +381,6 @@ int probe_item_collect(struct probe_ctx *ctx, SEXP_t *item)
 		 */
 		if (probe_cobj_get_flag(ctx->probe_out) != SYSCHAR_FLAG_INCOMPLETE) {
 			SEXP_t *msg;
-			/*
-			 * Sync with the icache thread before modifying the
-			 * collected object.
-			 */
-			if (probe_icache_nop(ctx->icache) != 0)
-				return -1;
 
 			msg = probe_msg_creat(OVAL_MESSAGE_LEVEL_WARNING,
 			                      "Object is incomplete due to memory constraints.");
@@ -586,10 +408,8 @@ int probe_item_collect(struct probe_ctx *ctx, SEXP_t *item)
         return (0);
 }
 
-static void probe_icache_free_node(struct rbt_i64_node *n)
+static void probe_icache_free_citem(probe_citem_t *ci)
 {
-        probe_citem_t *ci = (probe_citem_t *)n->data;
-
 	for ( ; ci->count > 0 ; --ci->count ) {
 		SEXP_free(ci->item[ci->count - 1]);
 	}
@@ -601,15 +421,32 @@ static void probe_icache_free_node(struct rbt_i64_node *n)
 
 void probe_icache_free(probe_icache_t *cache)
 {
-        void *ret = NULL;
+        probe_icache_stats_t stats;
+        probe_citem_t *ci, *next;
+        size_t i;
+        int s;
+
+        if (cache == NULL)
+                return;
+
+        probe_icache_get_stats(cache, &stats);
+        dI("Item cache: items=%"PRIu64", hits=%"PRIu64", misses=%"PRIu64", collisions=%"PRIu64,
+           stats.items, stats.hits, stats.misses, stats.collisions);
+
+        for (s = 0; s < PROBE_ICACHE_SHARDS; ++s) {
+                probe_icache_shard_t *shard = &cache->shard[s];
 
-        pthread_cancel(cache->thid);
-        pthread_join(cache->thid, &ret);
-        pthread_mutex_destroy(&cache->queue_mutex);
-        pthread_cond_destroy(&cache->queue_notempty);
-        pthread_cond_destroy(&cache->queue_notfull);
+                for (i = 0; i < shard->size; ++i) {
+                        for (ci = shard->bucket[i]; ci != NULL; ci = next) {
+                                next = ci->next;
+                                probe_icache_free_citem(ci);
+                        }
+                }
+
+                free(shard->bucket);
+                pthread_mutex_destroy(&shard->lock);
+        }
 
-        rbt_i64_free_cb(cache->tree, &probe_icache_free_node);
         free(cache);
         return;
 }
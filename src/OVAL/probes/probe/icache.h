@@ -23,44 +23,64 @@
 #define ICACHE_H
 
 #include <stddef.h>
+#include <stdint.h>
+#include <pthread.h>
 #include <sexp.h>
-#include "../SEAP/generic/rbt/rbt.h"
+#include "_sexp-ID.h"
 
-#ifndef PROBE_IQUEUE_CAPACITY
-#define PROBE_IQUEUE_CAPACITY 1024
+/*
+ * Number of independently locked parts of the item cache.
+ * Has to be a power of two.
+ */
+#ifndef PROBE_ICACHE_SHARDS
+#define PROBE_ICACHE_SHARDS 16
 #endif
 
-typedef struct {
-        SEXP_t *cobj;
-        union {
-                SEXP_t         *item;
-                pthread_cond_t *cond;
-        } p;
-} probe_iqpair_t;
+/* initial number of buckets of a shard, has to be a power of two */
+#define PROBE_ICACHE_SHARD_INITSIZE 64
 
-typedef struct {
-        rbt_t    *tree; /* XXX: rewrite to extensible or linear hashing */
-        pthread_t thid;
+/**
+ * Unique items sharing the same content hash.
+ */
+typedef struct probe_citem {
+        SEXP_ID_t  id;    /**< content hash of the items */
+        SEXP_t   **item;
+        uint16_t   count;
+        struct probe_citem *next; /**< next entry in the hash bucket */
+} probe_citem_t;
 
-        pthread_mutex_t queue_mutex;
-        pthread_cond_t  queue_notempty;
-        pthread_cond_t  queue_notfull;
+/**
+ * Snapshot of the item cache counters.
+ */
+typedef struct {
+        uint64_t items;      /**< number of unique items in the cache */
+        uint64_t hits;       /**< items replaced by an already cached item */
+        uint64_t misses;     /**< items added to the cache */
+        uint64_t collisions; /**< misses with a hash of an already cached item */
+} probe_icache_stats_t;
 
-        probe_iqpair_t  queue[PROBE_IQUEUE_CAPACITY];
-        uint16_t        queue_beg;
-        uint16_t        queue_end;
-        uint16_t        queue_cnt;
-        uint16_t        queue_max;
-} probe_icache_t;
+typedef struct {
+        pthread_mutex_t lock;
+        probe_citem_t **bucket;
+        size_t          size;  /**< number of buckets */
+        size_t          count; /**< number of entries */
+        probe_icache_stats_t stats;
+} probe_icache_shard_t;
 
 typedef struct {
-        SEXP_t  **item;
-        uint16_t  count;
-} probe_citem_t;
+        probe_icache_shard_t shard[PROBE_ICACHE_SHARDS];
+} probe_icache_t;
 
 probe_icache_t *probe_icache_new(void);
+
+/**
+ * Deduplicate the item and add it to the collected object. The item is
+ * replaced by an equal item if there's one in the cache already, otherwise
+ * it's assigned a unique ID and cached. The caller's reference to the item
+ * is consumed.
+ */
 int probe_icache_add(probe_icache_t *cache, SEXP_t *cobj, SEXP_t *item);
-int probe_icache_nop(probe_icache_t *cache);
+void probe_icache_get_stats(probe_icache_t *cache, probe_icache_stats_t *stats);
 void probe_icache_free(probe_icache_t *cache);
 
 #endif /* ICACHE_H */
@@ -36,22 +36,15 @@
 #include "worker.h"
 #include "rcache.h"
 #include "input_handler.h"
-#include "common/compat_pthread_barrier.h"
-
-static void pthread_attr_cleanup_handler(void *arg)
-{
-	pthread_attr_destroy(arg);
-}
 
 /*
  * The input handler waits for incomming eval requests and either returns
- * a result immediately if it is found in the result cache or spawns a new
- * worker thread which takes care of evaluating the request, caching the
- * result and sending it to the requestee.
+ * a result immediately if it is found in the result cache or queues it
+ * into the worker pool. A worker thread then takes care of evaluating the
+ * request, caching the result and sending it to the requestee.
  */
 void *probe_input_handler(void *arg)
 {
-        pthread_attr_t pth_attr;
         probe_t       *probe = (probe_t *)arg;
 
         int probe_ret, cstate; /* XXX */
@@ -71,27 +64,6 @@ void *probe_input_handler(void *arg)
 
         TH_CANCEL_OFF;
 
-        if (pthread_attr_init(&pth_attr))
-                return (NULL);
-
-        if (pthread_attr_setdetachstate(&pth_attr, PTHREAD_CREATE_JOINABLE)) {
-                pthread_attr_destroy(&pth_attr);
-                return (NULL);
-        }
-
-	pthread_cleanup_push(pthread_attr_cleanup_handler, (void *)&pth_attr);
-        
-        switch (errno = pthread_barrier_wait(&OSCAP_GSYM(th_barrier)))
-        {
-        case 0:
-        case PTHREAD_BARRIER_SERIAL_THREAD:
-	        break;
-        default:
-	        dE("pthread_barrier_wait: %d, %s.",
-	           errno, strerror(errno));
-	        return (NULL);
-        }
-
 	while(1) {
                 TH_CANCEL_ON;
 
@@ -176,9 +148,9 @@ void *probe_input_handler(void *arg)
 					} else {
 						/* OK */
 
-						if (pthread_create(&pair->pth->tid, &pth_attr, &probe_worker_runfn, pair))
+						if (probe_worker_pool_submit(probe->pool, pair) != 0)
 						{
-							dE("Cannot start a new worker thread: %d, %s.", errno, strerror(errno));
+							dE("Cannot queue the request (ID=%u) for evaluation.", pair->pth->sid);
 
 							if (rbt_i32_del(probe->workers, pair->pth->sid, NULL) != 0)
 								dE("rbt_i32_del: failed to remove worker thread (ID=%u)", pair->pth->sid);
@@ -246,6 +218,5 @@ void *probe_input_handler(void *arg)
 		SEAP_msg_free(seap_request);
 	} /* main loop */
 
-        pthread_cleanup_pop(1);
         return (NULL);
 }
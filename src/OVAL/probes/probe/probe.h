@@ -41,7 +41,8 @@
 #include "probe-common.h"
 #include "option.h"
 #include "common/util.h"
-#include "common/compat_pthread_barrier.h"
+
+typedef struct probe_worker_pool probe_worker_pool_t;
 
 typedef struct {
 	pthread_rwlock_t rwlock;
@@ -61,6 +62,7 @@ typedef struct {
         rbt_t    *workers;
         uint32_t  max_threads;
         uint32_t  max_chdepth;
+        probe_worker_pool_t *pool; /**< worker threads evaluating the requests */
 
 	probe_rcache_t *rcache; /**< probe result cache */
 	probe_ncache_t *ncache; /**< probe name cache */
@@ -92,6 +94,4 @@ typedef enum {
 	PROBE_OFFLINE_ALL = 0x0f
 } probe_offline_flags;
 
-extern pthread_barrier_t OSCAP_GSYM(th_barrier);
-
 #endif /* PROBE_H */
@@ -38,6 +38,7 @@
 #include "ncache.h"
 #include "rcache.h"
 #include "icache.h"
+#include "proctable.h"
 #include "worker.h"
 #include "input_handler.h"
 #include "probe-api.h"
@@ -50,6 +51,7 @@
 #define STDOUT_FILENO _fileno(stdout)
 #else
 #include <unistd.h>
+#include "fscache.h"
 #endif
 
 #include "probe_main.h"
@@ -67,8 +69,6 @@ bool   OSCAP_GSYM(varref_handling)    = true;
 char **OSCAP_GSYM(no_varref_ents)     = NULL;
 size_t OSCAP_GSYM(no_varref_ents_cnt) = 0;
 
-pthread_barrier_t OSCAP_GSYM(th_barrier);
-
 extern probe_ncache_t *OSCAP_GSYM(ncache);
 
 static int probe_optecmp(char **a, char **b)
@@ -87,6 +87,14 @@ static SEXP_t *probe_reset(SEXP_t *arg0, void *arg1)
 
         probe->rcache = probe_rcache_new();
         probe->ncache = probe_ncache_new();
+        probe_proctable_reset();
+#ifndef OS_WINDOWS
+        fscache_reset();
+#endif
+
+        probe_reset_function_t reset_function = probe_table_get_reset_function(probe->subtype);
+        if (reset_function != NULL)
+                reset_function(probe->probe_arg);
 
         return(NULL);
 }
@@ -130,6 +138,33 @@ static int probe_opthandler_rcache(int option, int op, va_list args)
 	return (0);
 }
 
+/*
+ * Number of concurrently running workers; the core count unless
+ * overridden by the OSCAP_PROBE_WORKERS environment variable.
+ */
+static uint32_t probe_worker_pool_size(void)
+{
+	const char *size_str = getenv(PROBE_WORKER_POOL_ENV);
+	unsigned long size;
+	long ncpu;
+
+	if (size_str != NULL) {
+		if (sscanf(size_str, "%lu", &size) == 1 && size > 0 && size <= PROBE_WORKER_DEFAULT_MAX_THREADS)
+			return (uint32_t)size;
+
+		dW("Ignoring invalid value of %s: '%s'", PROBE_WORKER_POOL_ENV, size_str);
+	}
+
+	ncpu = sysconf(_SC_NPROCESSORS_ONLN);
+
+	if (ncpu < 1)
+		return 1;
+	if (ncpu > PROBE_WORKER_DEFAULT_MAX_THREADS)
+		return PROBE_WORKER_DEFAULT_MAX_THREADS;
+
+	return (uint32_t)ncpu;
+}
+
 static void probe_common_main_cleanup(void *arg)
 {
 	dD("probe_common_main_cleanup started");
@@ -148,6 +183,12 @@ static void probe_common_main_cleanup(void *arg)
 	}
 	dD("probe_input_handler thread has joined with status %ld", (long) status);
 
+	probe_worker_pool_free(probe->pool);
+	probe_proctable_drop();
+#ifndef OS_WINDOWS
+	fscache_drop();
+#endif
+
 	probe_fini_function_t fini_function = probe_table_get_fini_function(probe->subtype);
 	if (fini_function != NULL) {
 		fini_function(probe->probe_arg);
@@ -183,11 +224,6 @@ void *probe_common_main(void *arg)
 
 	dD("probe_common_main started");
 
-	const unsigned thread_count = 2; // input and icache threads
-	if ((errno = pthread_barrier_init(&OSCAP_GSYM(th_barrier), NULL, thread_count)) != 0) {
-		fail(errno, "pthread_barrier_init", __LINE__ - 6);
-	}
-
 	probe.offline_mode = false;
 	probe.selected_offline_mode = PROBE_OFFLINE_NONE;
 	probe.flags = 0;
@@ -213,6 +249,9 @@ void *probe_common_main(void *arg)
 	probe.ncache = probe_ncache_new();
         probe.icache = probe_icache_new();
 
+        if (probe.icache == NULL)
+		fail(ENOMEM, "probe_icache_new", __LINE__ - 3);
+
         OSCAP_GSYM(ncache) = probe.ncache;
 
 	/*
@@ -236,12 +275,22 @@ void *probe_common_main(void *arg)
 	 * Create input handler (detached)
 	 */
         probe.workers   = rbt_i32_new();
+        probe.max_threads = probe_worker_pool_size();
+        probe.max_chdepth = PROBE_WORKER_DEFAULT_MAX_CHDEPTH;
+        probe.pool        = probe_worker_pool_new(&probe, probe.max_threads, PROBE_WORKER_DEFAULT_MAX_THREADS);
+
+        if (probe.pool == NULL)
+		fail(ENOMEM, "probe_worker_pool_new", __LINE__ - 3);
 
 	probe_init_function_t init_function = probe_table_get_init_function(probe.subtype);
 	if (init_function != NULL) {
 		probe.probe_arg = init_function();
 	}
 
+	probe_proctable_hold();
+#ifndef OS_WINDOWS
+	fscache_hold();
+#endif
 	pthread_cleanup_push(probe_common_main_cleanup, (void *) &probe);
 
 	pthread_attr_init(&th_attr);
@@ -0,0 +1,592 @@
+/*
+ * Copyright 2026 Red Hat Inc., Durham, North Carolina.
+ * All Rights Reserved.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <errno.h>
+#include <stdbool.h>
+#include <pthread.h>
+
+#include "common/debug_priv.h"
+#include "proctable.h"
+
+#if defined(OS_LINUX)
+
+#include <ctype.h>
+#include <dirent.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+#define PROBE_PROCTABLE_INITSIZE 256
+#define PROBE_PROCTABLE_CHUNK    4096 /* read size of the files of the processes */
+
+struct probe_proctable {
+	int proc_fd;           /**< /proc, the files are opened relative to it */
+	unsigned long boot;
+	probe_proc_t *procs;
+	size_t count;
+	uint32_t refs;         /**< guarded by probe_proctable_lock */
+	pthread_mutex_t lock;  /**< guards the loaded flags and the publishing of the files */
+};
+
+static pthread_mutex_t probe_proctable_lock = PTHREAD_MUTEX_INITIALIZER;
+static probe_proctable_t *probe_proctable_current = NULL;
+static uint32_t probe_proctable_users = 0;
+
+/*
+ * Read the whole file, the content is followed by an extra NUL.
+ * Returns NULL and sets errno if the file can't be read.
+ */
+static char *probe_proctable_read(probe_proctable_t *table, const char *path, size_t *len)
+{
+	char *buf = NULL;
+	size_t size = 0, used = 0;
+	ssize_t ret;
+	int fd, err;
+
+	fd = openat(table->proc_fd, path, O_RDONLY | O_CLOEXEC);
+	if (fd < 0)
+		return NULL;
+
+	for (;;) {
+		if (size - used < PROBE_PROCTABLE_CHUNK) {
+			char *tmp = realloc(buf, size + PROBE_PROCTABLE_CHUNK + 1);
+
+			if (tmp == NULL) {
+				err = ENOMEM;
+				goto fail;
+			}
+			buf = tmp;
+			size += PROBE_PROCTABLE_CHUNK;
+		}
+		ret = read(fd, buf + used, size - used);
+		if (ret < 0) {
+			if (errno == EINTR)
+				continue;
+			err = errno;
+			goto fail;
+		}
+		if (ret == 0)
+			break;
+		used += ret;
+	}
+	close(fd);
+
+	buf[used] = '\0';
+	if (len != NULL)
+		*len = used;
+	return buf;
+fail:
+	free(buf);
+	close(fd);
+	errno = err;
+	return NULL;
+}
+
+static char *probe_proc_read(probe_proctable_t *table, probe_proc_t *proc, const char *name, size_t *len)
+{
+	char path[64];
+
+	snprintf(path, sizeof(path), "%d/%s", proc->pid, name);
+	return probe_proctable_read(table, path, len);
+}
+
+static unsigned long probe_proctable_read_boot(probe_proctable_t *table)
+{
+	unsigned long boot = 0;
+	char *buf, *line;
+
+	buf = probe_proctable_read(table, "stat", NULL);
+	if (buf == NULL)
+		return 0;
+
+	for (line = buf; line != NULL; line = strchr(line, '\n')) {
+		if (*line == '\n')
+			++line;
+		if (strncmp(line, "btime", 5) == 0) {
+			sscanf(line, "btime %lu", &boot);
+			break;
+		}
+	}
+	free(buf);
+
+	return boot;
+}
+
+static bool probe_proc_parse_stat(probe_proc_t *proc, char *buf, size_t len)
+{
+	char *beg, *end;
+	size_t comm_len;
+
+	/* the command may contain anything, even parentheses */
+	beg = strchr(buf, '(');
+	end = strrchr(buf, ')');
+	if (len < 40 || beg == NULL || end == NULL || end < beg)
+		return false;
+
+	comm_len = end - beg - 1;
+	if (comm_len > sizeof(proc->comm) - 1)
+		comm_len = sizeof(proc->comm) - 1;
+	memcpy(proc->comm, beg + 1, comm_len);
+	proc->comm[comm_len] = '\0';
+
+	return sscanf(end + 2, "%c %d %*d %d %d %*d "
+			"%*u %*u %*u %*u %*u "
+			"%lu %lu %*d %*d %ld "
+			"%*d %*d %*d %llu",
+			&proc->state, &proc->ppid, &proc->session, &proc->tty_nr,
+			&proc->utime, &proc->stime, &proc->priority, &proc->start) >= 2;
+}
+
+static void probe_proc_load_status(probe_proctable_t *table, probe_proc_t *proc)
+{
+	unsigned long long cap_eff;
+	char *buf, *line;
+
+	buf = probe_proc_read(table, proc, "status", NULL);
+	if (buf == NULL)
+		return;
+
+	/* skip the first line, it's the name of the process */
+	for (line = strchr(buf, '\n'); line != NULL; line = strchr(line, '\n')) {
+		++line;
+		if (strncmp(line, "Uid:", 4) == 0) {
+			sscanf(line, "Uid: %d %d", &proc->ruid, &proc->euid);
+		} else if (strncmp(line, "CapEff:", 7) == 0) {
+			if (sscanf(line, "CapEff: %llx", &cap_eff) == 1) {
+				proc->cap_eff = cap_eff;
+				proc->cap_eff_known = true;
+			}
+		}
+	}
+	free(buf);
+}
+
+static void probe_proc_load_loginuid(probe_proctable_t *table, probe_proc_t *proc)
+{
+	char *buf;
+
+	buf = probe_proc_read(table, proc, "loginuid", NULL);
+	if (buf == NULL)
+		return;
+	if (sscanf(buf, "%u", &proc->loginuid) < 1)
+		dW("Can't read the loginuid of process %d", proc->pid);
+	free(buf);
+}
+
+/* Like ps, the arguments are separated by spaces and the non-printable characters replaced by dots. */
+static void probe_proc_load_cmdline(probe_proctable_t *table, probe_proc_t *proc)
+{
+	size_t len;
+	char *buf;
+	int i;
+
+	buf = probe_proc_read(table, proc, "cmdline", &len);
+	if (buf == NULL)
+		return;
+	if (len == 0) {
+		free(buf);
+		return;
+	}
+
+	/* skip the trailing zeros */
+	i = len - 1;
+	while (i > 0 && buf[i] == '\0')
+		--i;
+	buf[i + 1] = '\0';
+
+	for (; i >= 0; --i) {
+		if (buf[i] == '\0' || buf[i] == '\n')
+			buf[i] = ' ';
+		else if (!isprint(buf[i]))
+			buf[i] = '.';
+	}
+	proc->cmdline = buf;
+}
+
+static void probe_proc_load_environ(probe_proctable_t *table, probe_proc_t *proc)
+{
+	proc->environ = probe_proc_read(table, proc, "environ", &proc->environ_len);
+	if (proc->environ == NULL)
+		proc->environ_errno = errno;
+}
+
+static void probe_proc_load_selinux(probe_proctable_t *table, probe_proc_t *proc)
+{
+	size_t len;
+	char *buf;
+
+	buf = probe_proc_read(table, proc, "attr/current", &len);
+	if (buf == NULL)
+		return;
+	while (len > 0 && (buf[len - 1] == '\0' || buf[len - 1] == '\n'))
+		buf[--len] = '\0';
+	if (len == 0) {
+		free(buf);
+		return;
+	}
+	proc->selinux_label = buf;
+}
+
+/* exec shield status according to http://people.redhat.com/sgrubb/files/lsexec */
+static void probe_proc_load_maps(probe_proctable_t *table, probe_proc_t *proc)
+{
+	long unsigned low, high, inode;
+	long long unsigned offset;
+	int dev_min, dev_maj;
+	char perm[3], trim;
+	char *buf, *line, *next;
+
+	buf = probe_proc_read(table, proc, "maps", NULL);
+	if (buf == NULL)
+		return;
+
+	for (line = buf; *line != '\0'; line = next) {
+		next = strchr(line, '\n');
+		if (next != NULL)
+			*next++ = '\0';
+		else
+			next = line + strlen(line);
+
+		if (sscanf(line, "%lx-%lx rw%2s %llx %x:%x %lu %c",
+			   &low, &high, perm, &offset, &dev_min,
+			   &dev_maj, &inode, &trim) == 7) {
+			if (perm[0] == 'x' && offset != 0)
+				proc->exec_shield = 0;
+			else
+				proc->exec_shield = 1;
+		}
+	}
+	free(buf);
+}
+
+static void probe_proc_free(probe_proc_t *proc)
+{
+	free(proc->cmdline);
+	free(proc->environ);
+	free(proc->selinux_label);
+}
+
+static void probe_proc_init(probe_proc_t *proc, int pid)
+{
+	memset(proc, 0, sizeof(probe_proc_t));
+	proc->pid = pid;
+	proc->ruid = -1;
+	proc->euid = -1;
+	proc->loginuid = (unsigned int)-1;
+	proc->exec_shield = -1;
+}
+
+static probe_proctable_t *probe_proctable_new(void)
+{
+	probe_proctable_t *table;
+	struct dirent *ent;
+	size_t size, len;
+	char *buf;
+	DIR *dir;
+	int fd;
+
+	table = calloc(1, sizeof(probe_proctable_t));
+	if (table == NULL) {
+		dE("Can't allocate the process table");
+		return NULL;
+	}
+	table->proc_fd = open("/proc", O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+	if (table->proc_fd < 0 ||
+	    (fd = dup(table->proc_fd)) < 0) {
+		dE("Can't open /proc: %s", strerror(errno));
+		goto fail;
+	}
+	if ((dir = fdopendir(fd)) == NULL) {
+		dE("Can't read /proc: %s", strerror(errno));
+		close(fd);
+		goto fail;
+	}
+
+	table->boot = probe_proctable_read_boot(table);
+
+	size = PROBE_PROCTABLE_INITSIZE;
+	table->procs = malloc(size * sizeof(probe_proc_t));
+	if (table->procs == NULL) {
+		dE("Can't allocate the process table");
+		closedir(dir);
+		goto fail;
+	}
+
+	while ((ent = readdir(dir)) != NULL) {
+		probe_proc_t *proc;
+		char *end;
+		long pid;
+
+		if (ent->d_name[0] < '0' || ent->d_name[0] > '9')
+			continue;
+		errno = 0;
+		pid = strtol(ent->d_name, &end, 10);
+		if (errno != 0 || *end != '\0')
+			continue;
+
+		if (table->count == size) {
+			probe_proc_t *procs = realloc(table->procs, 2 * size * sizeof(probe_proc_t));
+
+			if (procs == NULL) {
+				dE("Can't allocate the process table");
+				closedir(dir);
+				goto fail;
+			}
+			table->procs = procs;
+			size *= 2;
+		}
+		proc = &table->procs[table->count++];
+		probe_proc_init(proc, pid);
+
+		/*
+		 * The process may have already exited. It's kept, the probes
+		 * not needing the stat file still report it.
+		 */
+		if ((buf = probe_proc_read(table, proc, "stat", &len)) == NULL)
+			continue;
+		if (probe_proc_parse_stat(proc, buf, len))
+			proc->loaded |= PROBE_PROC_STAT;
+		else
+			probe_proc_init(proc, pid);
+		free(buf);
+	}
+	closedir(dir);
+
+	pthread_mutex_init(&table->lock, NULL);
+	dI("Read %zu processes into the process table.", table->count);
+
+	return table;
+fail:
+	if (table->proc_fd >= 0)
+		close(table->proc_fd);
+	free(table->procs);
+	free(table);
+	return NULL;
+}
+
+static void probe_proctable_free(probe_proctable_t *table)
+{
+	size_t i;
+
+	for (i = 0; i < table->count; ++i)
+		probe_proc_free(&table->procs[i]);
+	free(table->procs);
+	close(table->proc_fd);
+	pthread_mutex_destroy(&table->lock);
+	free(table);
+}
+
+probe_proctable_t *probe_proctable_get(void)
+{
+	probe_proctable_t *table;
+
+	pthread_mutex_lock(&probe_proctable_lock);
+	if (probe_proctable_current == NULL) {
+		probe_proctable_current = probe_proctable_new();
+		if (probe_proctable_current != NULL)
+			probe_proctable_current->refs = 1; /* the current snapshot */
+	}
+	table = probe_proctable_current;
+	if (table != NULL)
+		table->refs++;
+	pthread_mutex_unlock(&probe_proctable_lock);
+
+	return table;
+}
+
+void probe_proctable_release(probe_proctable_t *table)
+{
+	bool last;
+
+	if (table == NULL)
+		return;
+
+	pthread_mutex_lock(&probe_proctable_lock);
+	last = --table->refs == 0;
+	pthread_mutex_unlock(&probe_proctable_lock);
+
+	if (last)
+		probe_proctable_free(table);
+}
+
+size_t probe_proctable_count(probe_proctable_t *table)
+{
+	return table->count;
+}
+
+probe_proc_t *probe_proctable_at(probe_proctable_t *table, size_t i)
+{
+	return &table->procs[i];
+}
+
+unsigned long probe_proctable_boot_time(probe_proctable_t *table)
+{
+	return table->boot;
+}
+
+/* Move the fields of the files in what from the scratch copy to the process */
+static void probe_proc_publish(probe_proc_t *proc, probe_proc_t *tmp, uint32_t what)
+{
+	if (what & PROBE_PROC_STATUS) {
+		proc->ruid = tmp->ruid;
+		proc->euid = tmp->euid;
+		proc->cap_eff = tmp->cap_eff;
+		proc->cap_eff_known = tmp->cap_eff_known;
+	}
+	if (what & PROBE_PROC_LOGINUID)
+		proc->loginuid = tmp->loginuid;
+	if (what & PROBE_PROC_CMDLINE) {
+		proc->cmdline = tmp->cmdline;
+		tmp->cmdline = NULL;
+	}
+	if (what & PROBE_PROC_ENVIRON) {
+		proc->environ = tmp->environ;
+		proc->environ_len = tmp->environ_len;
+		proc->environ_errno = tmp->environ_errno;
+		tmp->environ = NULL;
+	}
+	if (what & PROBE_PROC_SELINUX) {
+		proc->selinux_label = tmp->selinux_label;
+		tmp->selinux_label = NULL;
+	}
+	if (what & PROBE_PROC_MAPS)
+		proc->exec_shield = tmp->exec_shield;
+
+	proc->loaded |= what;
+}
+
+void probe_proctable_load(probe_proctable_t *table, probe_proc_t *proc, uint32_t what)
+{
+	probe_proc_t tmp;
+
+	pthread_mutex_lock(&table->lock);
+	what &= ~(proc->loaded | PROBE_PROC_STAT);
+	pthread_mutex_unlock(&table->lock);
+
+	if (what == 0)
+		return;
+
+	/*
+	 * The files are read into a scratch copy without the lock, other
+	 * threads may read the files of other processes meanwhile.
+	 */
+	probe_proc_init(&tmp, proc->pid);
+
+	if (what & PROBE_PROC_STATUS)
+		probe_proc_load_status(table, &tmp);
+	if (what & PROBE_PROC_LOGINUID)
+		probe_proc_load_loginuid(table, &tmp);
+	if (what & PROBE_PROC_CMDLINE)
+		probe_proc_load_cmdline(table, &tmp);
+	if (what & PROBE_PROC_ENVIRON)
+		probe_proc_load_environ(table, &tmp);
+	if (what & PROBE_PROC_SELINUX)
+		probe_proc_load_selinux(table, &tmp);
+	if (what & PROBE_PROC_MAPS)
+		probe_proc_load_maps(table, &tmp);
+
+	/* Another thread may have loaded some of the files first, its copy is kept */
+	pthread_mutex_lock(&table->lock);
+	probe_proc_publish(proc, &tmp, what & ~proc->loaded);
+	pthread_mutex_unlock(&table->lock);
+
+	probe_proc_free(&tmp);
+}
+
+static void probe_proctable_reset_locked(void)
+{
+	probe_proctable_t *table = probe_proctable_current;
+
+	probe_proctable_current = NULL;
+	if (table != NULL && --table->refs == 0)
+		probe_proctable_free(table);
+}
+
+void probe_proctable_reset(void)
+{
+	pthread_mutex_lock(&probe_proctable_lock);
+	probe_proctable_reset_locked();
+	pthread_mutex_unlock(&probe_proctable_lock);
+}
+
+void probe_proctable_hold(void)
+{
+	pthread_mutex_lock(&probe_proctable_lock);
+	probe_proctable_users++;
+	pthread_mutex_unlock(&probe_proctable_lock);
+}
+
+void probe_proctable_drop(void)
+{
+	pthread_mutex_lock(&probe_proctable_lock);
+	if (--probe_proctable_users == 0)
+		probe_proctable_reset_locked();
+	pthread_mutex_unlock(&probe_proctable_lock);
+}
+
+#else
+
+probe_proctable_t *probe_proctable_get(void)
+{
+	errno = ENOSYS;
+	return NULL;
+}
+
+void probe_proctable_release(probe_proctable_t *table)
+{
+}
+
+size_t probe_proctable_count(probe_proctable_t *table)
+{
+	return 0;
+}
+
+probe_proc_t *probe_proctable_at(probe_proctable_t *table, size_t i)
+{
+	return NULL;
+}
+
+unsigned long probe_proctable_boot_time(probe_proctable_t *table)
+{
+	return 0;
+}
+
+void probe_proctable_load(probe_proctable_t *table, probe_proc_t *proc, uint32_t what)
+{
+}
+
+void probe_proctable_hold(void)
+{
+}
+
+void probe_proctable_drop(void)
+{
+}
+
+void probe_proctable_reset(void)
+{
+}
+
+#endif /* OS_LINUX */
@@ -0,0 +1,119 @@
+/*
+ * Copyright 2026 Red Hat Inc., Durham, North Carolina.
+ * All Rights Reserved.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+#ifndef PROCTABLE_H
+#define PROCTABLE_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+/*
+ * Snapshot of the processes running on the system, shared by the probes
+ * looking at the processes (process, process58, environmentvariable58 and
+ * inetlisteningservers). The list of the processes and their stat files
+ * are read when the table is needed for the first time, processes whose
+ * stat file can't be read are kept without PROBE_PROC_STAT. Other files of
+ * a process are read when some probe asks for them for the first time.
+ * Nothing is read again, all the objects of a scan see the same state of
+ * every process. The table is dropped when the probes are reset and when
+ * the last probe thread exits.
+ */
+
+/* Files of a process, all but stat are read on demand */
+#define PROBE_PROC_STATUS   0x01 /**< status: ruid, euid, cap_eff */
+#define PROBE_PROC_LOGINUID 0x02 /**< loginuid */
+#define PROBE_PROC_CMDLINE  0x04 /**< cmdline */
+#define PROBE_PROC_ENVIRON  0x08 /**< environ */
+#define PROBE_PROC_SELINUX  0x10 /**< attr/current */
+#define PROBE_PROC_MAPS     0x20 /**< maps: exec_shield */
+#define PROBE_PROC_STAT     0x40 /**< stat: comm, state, ppid, times, ... */
+
+/**
+ * Process in the snapshot. The fields of the files listed in the loaded
+ * flags never change, the rest is valid after probe_proctable_load.
+ */
+typedef struct {
+	int pid;
+	/* stat */
+	char comm[16];
+	char state;
+	int ppid;
+	int session;
+	int tty_nr;
+	unsigned long utime;
+	unsigned long stime;
+	long priority;
+	unsigned long long start;
+
+	uint32_t loaded;      /**< PROBE_PROC_* flags of the files already read */
+	int ruid;             /**< -1 if unknown */
+	int euid;             /**< -1 if unknown */
+	uint64_t cap_eff;     /**< effective capabilities */
+	bool cap_eff_known;   /**< false if CapEff isn't in a readable status */
+	unsigned int loginuid; /**< (unsigned)-1 if unknown */
+	char *cmdline;        /**< ps-like command line, NULL if empty */
+	char *environ;        /**< NUL separated variables, NULL if not readable */
+	size_t environ_len;
+	int environ_errno;    /**< why environ isn't readable */
+	char *selinux_label;  /**< security context, NULL if unknown */
+	int exec_shield;      /**< -1 not detected, 0 disabled, 1 enabled */
+} probe_proc_t;
+
+typedef struct probe_proctable probe_proctable_t;
+
+/**
+ * Get the current snapshot, read the processes if there's none.
+ * @return the table, release it by probe_proctable_release, or NULL
+ *         if the processes can't be listed (errno is set)
+ */
+probe_proctable_t *probe_proctable_get(void);
+
+/**
+ * Release a table returned by probe_proctable_get.
+ */
+void probe_proctable_release(probe_proctable_t *table);
+
+size_t probe_proctable_count(probe_proctable_t *table);
+probe_proc_t *probe_proctable_at(probe_proctable_t *table, size_t i);
+
+/**
+ * Boot time of the system in seconds since the epoch (btime of /proc/stat).
+ */
+unsigned long probe_proctable_boot_time(probe_proctable_t *table);
+
+/**
+ * Read the files of the process which weren't read yet.
+ * @param what PROBE_PROC_* flags of the files
+ */
+void probe_proctable_load(probe_proctable_t *table, probe_proc_t *proc, uint32_t what);
+
+/**
+ * Register a probe thread using the table. The table is dropped after
+ * the last probe thread calls probe_proctable_drop.
+ */
+void probe_proctable_hold(void);
+void probe_proctable_drop(void);
+
+/**
+ * Drop the current snapshot, the next probe_proctable_get reads the
+ * processes again. Tables still in use are freed after their release.
+ */
+void probe_proctable_reset(void);
+
+#endif /* PROCTABLE_H */
@@ -31,9 +31,15 @@
 #include <string.h>
 #include <pthread.h>
 #include <errno.h>
+#include <inttypes.h>
+#include <time.h>
+#include <unistd.h>
 
 #include "probe-api.h"
 #include "common/debug_priv.h"
+#include "common/profiler_priv.h"
+#include "common/memusage.h"
+#include "_sexp-pool.h"
 #include "entcmp.h"
 
 #include "worker.h"
@@ -60,21 +66,14 @@ static void preload_libraries_before_chroot()
 	pthread_join(t, NULL);
 }
 
-void *probe_worker_runfn(void *arg)
+static void probe_worker_process(probe_pwpair_t *pair)
 {
-	dD("probe_worker_runfn has started");
-	probe_pwpair_t *pair = (probe_pwpair_t *)arg;
+	dD("probe_worker_process has started");
 
 	SEXP_t *probe_res, *obj, *oid;
 	int     probe_ret;
 
-#if defined(HAVE_PTHREAD_SETNAME_NP)
-# if defined(OS_APPLE)
-	pthread_setname_np("probe_worker");
-# else
-	pthread_setname_np(pthread_self(), "probe_worker");
-# endif
-#endif
+	pair->pth->tid = pthread_self();
 	dD("handling SEAP message ID %u", pair->pth->sid);
 	//
 	probe_ret = -1;
@@ -89,14 +88,12 @@ void *probe_worker_runfn(void *arg)
 		 * XXX: this is a possible deadlock; we can't send anything from
 		 * here because the signal handler replied to the message
 		 */
-		arg = NULL;
-
                 SEAP_msg_free(pair->pth->msg);
                 SEXP_free(probe_res);
                 free(pair);
 
-		dD("probe_worker_runfn has finished");
-                return (NULL);
+		dD("probe_worker_process has finished");
+                return;
 	} else {
                 SEXP_t *items;
 
@@ -158,12 +155,260 @@ void *probe_worker_runfn(void *arg)
         SEAP_msg_free(pair->pth->msg);
         free(pair->pth);
 	free(pair);
-	pthread_detach(pthread_self());
 
-	dD("probe_worker_runfn has finished");
+	/* Most of the values built during the request are gone by now */
+	SEXP_pool_release();
+
+	dD("probe_worker_process has finished");
+}
+
+
+struct probe_worker_pool {
+	pthread_mutex_t lock;
+	pthread_cond_t  cond; /**< signaled when a request is queued or on shutdown */
+	probe_t        *probe;
+
+	probe_pwpair_t *head; /**< first queued request */
+	probe_pwpair_t *tail; /**< last queued request */
+
+	pthread_t *threads;
+	uint32_t   max;
+	bool       shutdown;
+
+	probe_worker_pool_stats_t stats;
+};
+
+static uint64_t probe_worker_pool_usec(void)
+{
+#if defined(HAVE_CLOCK_GETTIME)
+	struct timespec ts;
+
+	if (clock_gettime(CLOCK_MONOTONIC, &ts) != 0)
+		return 0;
+
+	return (uint64_t)ts.tv_sec * 1000000 + (uint64_t)ts.tv_nsec / 1000;
+#else
+	return 0;
+#endif
+}
+
+static void *probe_worker_pool_runfn(void *arg)
+{
+	probe_worker_pool_t *pool = (probe_worker_pool_t *)arg;
+	probe_pwpair_t *pair;
+	uint64_t started, t0;
+
+#if defined(HAVE_PTHREAD_SETNAME_NP)
+# if defined(OS_APPLE)
+	pthread_setname_np("probe_worker");
+# else
+	pthread_setname_np(pthread_self(), "probe_worker");
+# endif
+#endif
+	dD("probe worker thread has started");
+	started = probe_worker_pool_usec();
+
+	pthread_mutex_lock(&pool->lock);
+
+	for (;;) {
+		while (pool->head == NULL && !pool->shutdown)
+			pthread_cond_wait(&pool->cond, &pool->lock);
+
+		if (pool->head == NULL)
+			break;
+
+		pair = pool->head;
+		pool->head = pair->next;
+
+		if (pool->head == NULL)
+			pool->tail = NULL;
+
+		pool->stats.queued--;
+		pool->stats.busy++;
+		pthread_mutex_unlock(&pool->lock);
+
+		t0 = probe_worker_pool_usec();
+		probe_worker_process(pair);
+
+		pthread_mutex_lock(&pool->lock);
+		pool->stats.busy--;
+		pool->stats.processed++;
+		pool->stats.busy_usec += probe_worker_pool_usec() - t0;
+	}
+
+	pool->stats.alive_usec += probe_worker_pool_usec() - started;
+	pthread_mutex_unlock(&pool->lock);
+
+	dD("probe worker thread has finished");
 	return (NULL);
 }
 
+/*
+ * Start a new worker thread if there are more queued requests than idle
+ * workers and the number of running (i.e. not blocked) workers is below
+ * the pool size. Must be called with the pool lock held.
+ */
+static int probe_worker_pool_spawn(probe_worker_pool_t *pool)
+{
+	uint32_t idle = pool->stats.threads - pool->stats.busy;
+
+	if (pool->stats.queued <= idle)
+		return (0);
+	if (pool->stats.threads - pool->stats.blocked >= pool->stats.size)
+		return (0);
+	if (pool->stats.threads >= pool->max)
+		return (0);
+
+	if ((errno = pthread_create(&pool->threads[pool->stats.threads], NULL,
+	                            &probe_worker_pool_runfn, pool)) != 0)
+	{
+		dE("Cannot start a new worker thread: %d, %s.", errno, strerror(errno));
+		return (-1);
+	}
+
+	pool->stats.threads++;
+	return (0);
+}
+
+probe_worker_pool_t *probe_worker_pool_new(probe_t *probe, uint32_t size, uint32_t max)
+{
+	probe_worker_pool_t *pool;
+
+	if (size == 0) {
+		long ncpu = sysconf(_SC_NPROCESSORS_ONLN);
+		size = ncpu > 0 ? (uint32_t)ncpu : 1;
+	}
+	if (max == 0)
+		max = PROBE_WORKER_DEFAULT_MAX_THREADS;
+	if (size > max)
+		size = max;
+
+	pool = calloc(1, sizeof(probe_worker_pool_t));
+	if (pool == NULL)
+		return (NULL);
+
+	pool->threads = calloc(max, sizeof(pthread_t));
+
+	if (pool->threads == NULL) {
+		free(pool);
+		return (NULL);
+	}
+
+	pthread_mutex_init(&pool->lock, NULL);
+	pthread_cond_init(&pool->cond, NULL);
+	pool->probe = probe;
+	pool->max = max;
+	pool->stats.size = size;
+
+	dD("probe worker pool: size=%u, max=%u", size, max);
+	return (pool);
+}
+
+int probe_worker_pool_submit(probe_worker_pool_t *pool, probe_pwpair_t *pair)
+{
+	pthread_mutex_lock(&pool->lock);
+
+	pair->next = NULL;
+
+	if (pool->tail != NULL)
+		pool->tail->next = pair;
+	else
+		pool->head = pair;
+
+	pool->tail = pair;
+
+	if (++pool->stats.queued > pool->stats.queue_peak)
+		pool->stats.queue_peak = pool->stats.queued;
+
+	if (probe_worker_pool_spawn(pool) != 0 && pool->stats.threads == 0) {
+		/*
+		 * There's nobody to handle the request; take it back
+		 * so that the caller can reply with an error.
+		 */
+		pool->head = pool->tail = NULL;
+		pool->stats.queued--;
+		pthread_mutex_unlock(&pool->lock);
+		return (-1);
+	}
+
+	pthread_cond_signal(&pool->cond);
+	pthread_mutex_unlock(&pool->lock);
+
+	return (0);
+}
+
+void probe_worker_pool_block_begin(probe_worker_pool_t *pool)
+{
+	pthread_mutex_lock(&pool->lock);
+	pool->stats.blocked++;
+	probe_worker_pool_spawn(pool);
+	pthread_mutex_unlock(&pool->lock);
+}
+
+void probe_worker_pool_block_end(probe_worker_pool_t *pool)
+{
+	pthread_mutex_lock(&pool->lock);
+	pool->stats.blocked--;
+	pthread_mutex_unlock(&pool->lock);
+}
+
+void probe_worker_pool_get_stats(probe_worker_pool_t *pool, probe_worker_pool_stats_t *stats)
+{
+	pthread_mutex_lock(&pool->lock);
+	*stats = pool->stats;
+	pthread_mutex_unlock(&pool->lock);
+}
+
+void probe_worker_pool_free(probe_worker_pool_t *pool)
+{
+	probe_pwpair_t *pair;
+	uint32_t i;
+
+	if (pool == NULL)
+		return;
+
+	pthread_mutex_lock(&pool->lock);
+
+	while ((pair = pool->head) != NULL) {
+		pool->head = pair->next;
+		dD("dropping queued request (ID=%u)", pair->pth->sid);
+
+		if (rbt_i32_del(pool->probe->workers, pair->pth->sid, NULL) != 0)
+			dW("rbt_i32_del: failed to remove worker thread (ID=%u)", pair->pth->sid);
+
+		SEAP_msg_free(pair->pth->msg);
+		free(pair->pth);
+		free(pair);
+	}
+
+	pool->tail = NULL;
+	pool->stats.queued = 0;
+	pool->shutdown = true;
+
+	pthread_cond_broadcast(&pool->cond);
+	pthread_mutex_unlock(&pool->lock);
+
+	for (i = 0; i < pool->stats.threads; ++i)
+		pthread_join(pool->threads[i], NULL);
+
+	dI("%s probe worker pool: size=%u, threads=%u, processed=%"PRIu64", queue peak=%u, utilisation=%.1f%%",
+	   oval_subtype_get_text(pool->probe->subtype), pool->stats.size, pool->stats.threads,
+	   pool->stats.processed, pool->stats.queue_peak,
+	   pool->stats.alive_usec > 0 ? 100.0 * pool->stats.busy_usec / pool->stats.alive_usec : 0.0);
+
+	/* The S-exp pool counters are shared by all the probes of the process */
+	struct alloc_memusage mu;
+	if (oscap_alloc_memusage(&mu) == 0) {
+		dI("S-exp pool (all probes, so far): allocated=%zu, reused=%zu, freed=%zu, cached=%zu bytes",
+		   mu.mu_allocs, mu.mu_reused, mu.mu_frees, mu.mu_cached);
+	}
+
+	pthread_cond_destroy(&pool->cond);
+	pthread_mutex_destroy(&pool->lock);
+	free(pool->threads);
+	free(pool);
+}
+
 probe_worker_t *probe_worker_new(void)
 {
 	probe_worker_t *pth = malloc(sizeof(probe_worker_t));
@@ -411,8 +656,18 @@ static SEXP_t *probe_obj_eval(probe_t *probe, SEXP_t *id)
 {
 	SEXP_t *res, *rid;
 
+	/*
+	 * The library will send the object back to this probe, so don't hold
+	 * a slot in the worker pool while waiting for the result.
+	 */
+	if (probe->pool != NULL)
+		probe_worker_pool_block_begin(probe->pool);
+
 	res = SEAP_cmd_exec(probe->SEAP_ctx, probe->sd, 0, PROBECMD_OBJ_EVAL, id, SEAP_CMDTYPE_SYNC, NULL, NULL);
 
+	if (probe->pool != NULL)
+		probe_worker_pool_block_end(probe->pool);
+
 	rid = SEXP_list_first(res);
 	if (SEXP_string_cmp(id, rid) != 0) {
 		SEXP_free(res);
@@ -1057,6 +1312,9 @@ SEXP_t *probe_worker(probe_t *probe, SEAP_msg_t *msg_in, int *ret)
 		probe_main_function_t probe_main_function = probe_table_get_main_function(subtype);
 		const char *subtype_str = oval_subtype_get_text(subtype);
 
+		oscap_prof_timer_t timer;
+		oscap_prof_start(&timer);
+
 		if (varrefs == NULL || !OSCAP_GSYM(varref_handling)) {
                         /*
                          * Prepare the collected object
@@ -1082,11 +1340,6 @@ SEXP_t *probe_worker(probe_t *probe, SEAP_msg_t *msg_in, int *ret)
 
 			pthread_setcanceltype(PTHREAD_CANCEL_DEFERRED, &__unused_oldstate);
 
-                        /*
-                         * Synchronize
-                         */
-                        probe_icache_nop(probe->icache);
-
 			probe_cobj_compute_flag(probe_out);
 		} else {
 			/*
@@ -1123,11 +1376,6 @@ SEXP_t *probe_worker(probe_t *probe, SEAP_msg_t *msg_in, int *ret)
 			dI("I will run %s_probe_main:", subtype_str);
 			*ret = probe_main_function(&pctx, probe->probe_arg);
 
-                                /*
-                                 * Synchronize
-                                 */
-                                probe_icache_nop(probe->icache);
-
 				probe_cobj_compute_flag(cobj);
 				r0 = probe_out;
 				probe_out = probe_set_combine(r0, cobj, OVAL_SET_OPERATION_UNION);
@@ -1140,6 +1388,12 @@ SEXP_t *probe_worker(probe_t *probe, SEAP_msg_t *msg_in, int *ret)
 			probe_varref_destroy_ctx(ctx);
 		}
 
+		if (timer.running) {
+			SEXP_t *items = probe_cobj_get_items(probe_out);
+			oscap_prof_stop(&timer, OSCAP_PROF_PROBE, subtype_str, SEXP_list_length(items));
+			SEXP_free(items);
+		}
+
                 SEXP_free(pctx.filters);
 	}
 
@@ -31,6 +31,10 @@
 # define PROBE_WORKER_DEFAULT_MAX_THREADS 64 /**< maximum number of worker threads that will be created */
 #endif
 
+#ifndef PROBE_WORKER_POOL_ENV
+# define PROBE_WORKER_POOL_ENV "OSCAP_PROBE_WORKERS" /**< environment variable overriding the worker pool size */
+#endif
+
 #ifndef PROBE_WORKER_DEFAULT_MAX_CHDEPTH
 # define PROBE_WORKER_DEFAULT_MAX_CHDEPTH 8 /**< maximum depth of a worker thread chain */
 #endif
@@ -42,13 +46,61 @@ typedef struct {
 	SEAP_msg_t  *msg; /**< the message being handled */
 } probe_worker_t;
 
-typedef struct {
+typedef struct probe_pwpair {
 	probe_t        *probe;
 	probe_worker_t *pth;
+	struct probe_pwpair *next; /**< next request in the worker pool queue */
 } probe_pwpair_t;
 
+/**
+ * Snapshot of the worker pool counters.
+ */
+typedef struct {
+	uint32_t size;       /**< number of workers allowed to run concurrently */
+	uint32_t threads;    /**< number of started worker threads */
+	uint32_t busy;       /**< workers handling a request */
+	uint32_t blocked;    /**< busy workers waiting for a nested object evaluation */
+	uint32_t queued;     /**< requests waiting for a free worker */
+	uint32_t queue_peak; /**< maximal observed queue depth */
+	uint64_t processed;  /**< number of handled requests */
+	uint64_t busy_usec;  /**< total time spent handling requests */
+	uint64_t alive_usec; /**< total lifetime of the worker threads */
+} probe_worker_pool_stats_t;
+
 probe_worker_t *probe_worker_new(void);
-void *probe_worker_runfn(void *arg);
+
+/**
+ * Create a pool of persistent worker threads. Threads are started lazily
+ * as requests arrive, at most `size' of them run concurrently. Workers
+ * waiting for a nested object evaluation (see probe_worker_pool_block_begin)
+ * are not counted against `size' so that set evaluation can't deadlock the
+ * pool, but the total number of threads never exceeds `max'.
+ * @param probe probe owning the pool
+ * @param size number of concurrently running workers, 0 means autodetect
+ * @param max hard limit of the number of worker threads
+ */
+probe_worker_pool_t *probe_worker_pool_new(probe_t *probe, uint32_t size, uint32_t max);
+
+/**
+ * Queue a request for evaluation. The pool takes over the ownership of the pair.
+ * @retval 0 the request was queued
+ * @retval -1 no worker thread is available to handle the request
+ */
+int probe_worker_pool_submit(probe_worker_pool_t *pool, probe_pwpair_t *pair);
+
+/**
+ * Mark the calling worker as waiting for another request handled by the same pool.
+ */
+void probe_worker_pool_block_begin(probe_worker_pool_t *pool);
+void probe_worker_pool_block_end(probe_worker_pool_t *pool);
+
+void probe_worker_pool_get_stats(probe_worker_pool_t *pool, probe_worker_pool_stats_t *stats);
+
+/**
+ * Drop the queued requests, wait for the running ones and join the worker threads.
+ */
+void probe_worker_pool_free(probe_worker_pool_t *pool);
+
 SEXP_t *probe_worker(probe_t *probe, SEAP_msg_t *msg_in, int *ret);
 
 #endif /* WORKER_H */
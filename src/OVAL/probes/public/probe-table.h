@@ -31,11 +31,13 @@ typedef void *(*probe_init_function_t)(void);
 typedef int (*probe_main_function_t)(probe_ctx *ctx, void *arg);
 typedef void (*probe_fini_function_t)(void *probe_arg);
 typedef int (*probe_offline_mode_function_t)(void);
+typedef void (*probe_reset_function_t)(void *probe_arg);
 
 OSCAP_API probe_init_function_t probe_table_get_init_function(oval_subtype_t type);
 OSCAP_API probe_main_function_t probe_table_get_main_function(oval_subtype_t type);
 OSCAP_API probe_fini_function_t probe_table_get_fini_function(oval_subtype_t type);
 OSCAP_API probe_offline_mode_function_t probe_table_get_offline_mode_function(oval_subtype_t type);
+OSCAP_API probe_reset_function_t probe_table_get_reset_function(oval_subtype_t type);
 
 OSCAP_API void probe_table_list(FILE *output);
 OSCAP_API int probe_table_size(void);
@@ -39,7 +39,6 @@
 #include <stdlib.h>
 #include <string.h>
 #include <sys/stat.h>
-#include <pthread.h>
 #include <errno.h>
 #include <limits.h>
 
@@ -326,7 +325,7 @@ static int file_cb(const char *prefix, const char *p, const char *f, void *ptr,
 	}
 
 	char *st_path_with_prefix = oscap_path_join(prefix, st_path);
-	if (lstat(st_path_with_prefix, &st) == -1) {
+	if (fscache_lstat(st_path_with_prefix, &st) == -1) {
                 dD("lstat failed when processing %s: errno=%u, %s.", st_path, errno, strerror (errno));
 		/*
 		 * Whatever the reason of this lstat error (for example the file may
@@ -421,36 +420,7 @@ int file_probe_offline_mode_supported()
 	return PROBE_OFFLINE_OWN;
 }
 
-void *file_probe_init(void)
-{
-        /*
-         * Initialize mutex.
-         */
-	pthread_mutex_t *file_probe_mutex = malloc(sizeof(pthread_mutex_t));
-	switch (pthread_mutex_init (file_probe_mutex, NULL)) {
-        case 0:
-		return ((void *)file_probe_mutex);
-        default:
-		free(file_probe_mutex);
-                dD("Can't initialize mutex: errno=%u, %s.", errno, strerror (errno));
-        }
-#if 0
-	probe_setoption(PROBEOPT_VARREF_HANDLING, false, "path");
-	probe_setoption(PROBEOPT_VARREF_HANDLING, false, "filename");
-#endif
-        return (NULL);
-}
-
-void file_probe_fini(void *arg)
-{
-        /*
-         * Destroy mutex.
-         */
-	(void) pthread_mutex_destroy((pthread_mutex_t *)arg);
-	free(arg);
-}
-
-int file_probe_main(probe_ctx *ctx, void *mutex)
+int file_probe_main(probe_ctx *ctx, void *arg)
 {
         SEXP_t *path, *filename, *behaviors, *filepath, *probe_in;
 	int err;
@@ -458,10 +428,6 @@ int file_probe_main(probe_ctx *ctx, void *mutex)
 	OVAL_FTS    *ofts;
 	OVAL_FTSENT *ofts_ent;
 
-        if (mutex == NULL) {
-                return PROBE_EINIT;
-	}
-
         probe_in  = probe_ctx_getobject(ctx);
 
 	oval_schema_version_t over = probe_obj_get_platform_schema_version(probe_in);
@@ -482,20 +448,10 @@ int file_probe_main(probe_ctx *ctx, void *mutex)
 
 	probe_filebehaviors_canonicalize(&behaviors);
 
-        switch (pthread_mutex_lock (mutex)) {
-        case 0:
-                break;
-        default:
-                dD("Can't lock mutex(%p): %u, %s.", mutex, errno, strerror (errno));
-
-		SEXP_free(path);
-		SEXP_free(filename);
-		SEXP_free(filepath);
-		SEXP_free(behaviors);
-
-                return PROBE_EFATAL;
-        }
-
+	/*
+	 * All the state of the traversal (ID cache, group cache, last path)
+	 * is local to this call, so objects are collected concurrently.
+	 */
         cbargs.ctx     = ctx;
 	cbargs.error   = 0;
 
@@ -528,14 +484,5 @@ int file_probe_main(probe_ctx *ctx, void *mutex)
 	SEXP_free(filepath);
 	SEXP_free(behaviors);
 
-        switch (pthread_mutex_unlock (mutex)) {
-        case 0:
-                break;
-        default:
-                dD("Can't unlock mutex(%p): %u, %s.", mutex, errno, strerror (errno));
-
-                return PROBE_EFATAL;
-        }
-
         return err;
 }
@@ -26,8 +26,6 @@
 #include "probe-api.h"
 
 int file_probe_offline_mode_supported(void);
-void *file_probe_init(void);
 int file_probe_main(probe_ctx *ctx, void *arg);
-void file_probe_fini(void *arg);
 
 #endif /* OPENSCAP_FILE_PROBE_H */
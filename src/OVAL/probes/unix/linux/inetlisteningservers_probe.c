@@ -64,6 +64,7 @@
 #include "probe-api.h"
 #include "probe/entcmp.h"
 #include "common/debug_priv.h"
+#include "probe/proctable.h"
 #include "inetlisteningservers_probe.h"
 
 /* This structure contains the information OVAL is asking or requesting */
@@ -173,71 +174,35 @@ static lnode *list_find_inode(llist *l, unsigned long i)
 
 static int collect_process_info(llist *l)
 {
-	DIR *d, *f;
+	DIR *f;
 	struct dirent *ent;
+	probe_proctable_t *table;
+	size_t i, count;
 
-	d = opendir("/proc");
-	if (d == NULL)
+	table = probe_proctable_get();
+	if (table == NULL)
 		return 1;
 
-	while (( ent = readdir(d) )) {
-		FILE *sf;
-		int pid, ppid;
+	count = probe_proctable_count(table);
+	for (i = 0; i < count; ++i) {
+		probe_proc_t *proc = probe_proctable_at(table, i);
+		int pid = proc->pid;
 		char buf[100];
-		char *tmp, cmd[16], state, *text = NULL;
-		int fd, len, euid = 0;
+		char *text = NULL;
+		int euid = 0;
 
-		// Skip non-process dir entries
-		if(*ent->d_name<'0' || *ent->d_name>'9')
-			continue;
-		errno = 0;
-		pid = strtol(ent->d_name, NULL, 10);
-		if (errno)
+		// Skip the processes whose stat file wasn't read
+		if (!(proc->loaded & PROBE_PROC_STAT))
 			continue;
 
-		// Parse up the stat file for the proc
-		snprintf(buf, 32, "/proc/%d/stat", pid);
-		fd = open(buf, O_RDONLY, 0);
-		if (fd < 0)
-			continue;
-		len = read(fd, buf, sizeof buf - 1);
-		close(fd);
-		if (len < 40)
-			continue;
-		buf[len] = 0;
-		tmp = strrchr(buf, ')');
-		if (tmp)
-			*tmp = 0;
-		else
-			continue;
-		memset(cmd, 0, sizeof(cmd));
-		sscanf(buf, "%d (%15c", &ppid, cmd);
-		sscanf(tmp+2, "%c %d", &state, &ppid);
-
 		// Skip kthreads
-		if (pid == 2 || ppid == 2)
+		if (pid == 2 || proc->ppid == 2)
 			continue;
 
 		// Get the effective uid
-		snprintf(buf, 32, "/proc/%d/status", pid);
-		sf = fopen(buf, "rt");
-		if (sf) {
-			int line = 0;
-			__fsetlocking(sf, FSETLOCKING_BYCALLER);
-			while (fgets(buf, sizeof(buf), sf)) {
-				if (line == 0) {
-					line++;
-					continue;
-				}
-				if (memcmp(buf, "Uid:", 4) == 0) {
-					int id;
-					sscanf(buf, "Uid: %d %d",
-						&id, &euid);
-					break;
-				}
-			}
-			fclose(sf);
-		}
+		probe_proctable_load(table, proc, PROBE_PROC_STATUS);
+		if (proc->euid != -1)
+			euid = proc->euid;
 
 		// Now lets get the inodes each process has open
 		snprintf(buf, 32, "/proc/%d/fd", pid);
@@ -292,7 +257,7 @@ static int collect_process_info(llist *l)
 				continue;
 			node.pid = pid;
 			node.uid = euid;
-			node.cmd = strdup(cmd);
+			node.cmd = strdup(proc->comm);
 			node.inode = inode;
 			// We make one entry for each socket inode
 			list_append(l, &node);
@@ -300,7 +265,7 @@ static int collect_process_info(llist *l)
 		closedir(f);
 		free(text);
 	}
-	closedir(d);
+	probe_proctable_release(table);
 	return 0;
 }
 
@@ -24,6 +24,15 @@
 #include <config.h>
 #endif
 
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <regex.h>
+
+#include <probe-api.h>
+#include "probe/entcmp.h"
+#include "oscap_helpers.h"
+
 #ifdef RPM46_FOUND
 int rpmErrorCb (rpmlogRec rec, rpmlogCallbackData data)
 {
@@ -51,3 +60,369 @@ void rpmLibsPreload()
 	const char* rcfiles = "";
 	rpmReadConfigFiles(rcfiles, NULL);
 }
+
+static struct {
+	pthread_mutex_t lock;
+	unsigned int refcnt;
+	struct rpm_pkgindex *index;
+} rpm_pkgindex_global = { .lock = PTHREAD_MUTEX_INITIALIZER };
+
+static const char g_keyid_regex_string[] = "Key ID [a-fA-F0-9]{16}";
+
+static unsigned int rpm_pkgindex_hash(const char *name)
+{
+	unsigned int h = 0;
+	const unsigned char *p;
+
+	for (p = (const unsigned char *)name; *p != '\0'; p++)
+		h = (31 * h) + *p;
+
+	return h;
+}
+
+static void rpm_pkginfo_fill(Header h, struct rpm_pkginfo *r, regex_t *keyid_regex)
+{
+	errmsg_t rpmerr;
+	char *str, *sid;
+	const char *epoch_override;
+	regmatch_t keyid_match[1];
+
+	r->name = headerFormat(h, "%{NAME}", &rpmerr);
+	r->arch = headerFormat(h, "%{ARCH}", &rpmerr);
+	r->epoch = headerFormat(h, "%{EPOCH}", &rpmerr);
+	r->release = headerFormat(h, "%{RELEASE}", &rpmerr);
+	r->version = headerFormat(h, "%{VERSION}", &rpmerr);
+	epoch_override = oscap_streq(r->epoch, "(none)") ? "0" : r->epoch;
+	r->evr = oscap_sprintf("%s:%s-%s", epoch_override, r->version, r->release);
+	r->extended_name = oscap_sprintf("%s-%s:%s-%s.%s", r->name, epoch_override, r->version, r->release, r->arch);
+
+	str = headerFormat(h, "%|SIGGPG?{%{SIGGPG:pgpsig}}:{%{SIGPGP:pgpsig}}|", &rpmerr);
+
+	sid = NULL;
+	if (str != NULL && regexec(keyid_regex, str, 1, keyid_match, 0) == 0 &&
+	    keyid_match[0].rm_so >= 0 && keyid_match[0].rm_eo >= 0) {
+		size_t keyid_start, keyid_length;
+
+		keyid_start = keyid_match[0].rm_so + strlen("Key ID ");
+		keyid_length = keyid_match[0].rm_eo - keyid_start;
+		sid = str + keyid_start;
+		sid[keyid_length] = '\0';
+	} else {
+		dD("Failed to extract the Key ID value: regex=\"%s\", string=\"%s\"",
+		   g_keyid_regex_string, str);
+	}
+
+	r->signature_keyid = strdup(sid != NULL ? sid : "0");
+	free(str);
+}
+
+static void rpm_pkginfo_free(struct rpm_pkginfo *r)
+{
+	free(r->name);
+	free(r->arch);
+	free(r->epoch);
+	free(r->release);
+	free(r->version);
+	free(r->evr);
+	free(r->signature_keyid);
+	free(r->extended_name);
+}
+
+static void rpm_pkgindex_free(struct rpm_pkgindex *index)
+{
+	size_t i;
+
+	if (index == NULL)
+		return;
+
+	for (i = 0; i < index->count; ++i)
+		rpm_pkginfo_free(&index->pkgs[i]);
+
+	free(index->pkgs);
+	free(index->table);
+	free(index);
+}
+
+static struct rpm_pkgindex *rpm_pkgindex_build(rpmts ts)
+{
+	struct rpm_pkgindex *index;
+	rpmdbMatchIterator match;
+	Header pkgh;
+	regex_t keyid_regex;
+	size_t i, alloc = 0;
+
+	if (regcomp(&keyid_regex, g_keyid_regex_string, REG_EXTENDED) != 0) {
+		dE("regcomp(%s) failed.", g_keyid_regex_string);
+		return NULL;
+	}
+
+	match = rpmtsInitIterator(ts, RPMDBI_PACKAGES, NULL, 0);
+	if (match == NULL) {
+		regfree(&keyid_regex);
+		return NULL;
+	}
+
+	index = calloc(1, sizeof(struct rpm_pkgindex));
+	if (index == NULL)
+		goto fail;
+
+	while ((pkgh = rpmdbNextIterator(match)) != NULL) {
+		if (index->count == alloc) {
+			struct rpm_pkginfo *pkgs;
+
+			alloc = alloc == 0 ? 512 : alloc * 2;
+			pkgs = realloc(index->pkgs, alloc * sizeof(struct rpm_pkginfo));
+			if (pkgs == NULL)
+				goto fail;
+			index->pkgs = pkgs;
+		}
+
+		struct rpm_pkginfo *r = &index->pkgs[index->count++];
+		memset(r, 0, sizeof(struct rpm_pkginfo));
+		r->instance = rpmdbGetIteratorOffset(match);
+		rpm_pkginfo_fill(pkgh, r, &keyid_regex);
+	}
+
+	rpmdbFreeIterator(match);
+	regfree(&keyid_regex);
+
+	/* twice as many buckets as packages, rounded to a power of two */
+	index->table_size = 64;
+	while (index->table_size < index->count * 2)
+		index->table_size <<= 1;
+	index->table = calloc(index->table_size, sizeof(struct rpm_pkginfo *));
+	if (index->table == NULL) {
+		rpm_pkgindex_free(index);
+		return NULL;
+	}
+
+	/* insert in reverse so that the chains keep the rpmdb order */
+	for (i = index->count; i > 0; --i) {
+		struct rpm_pkginfo *r = &index->pkgs[i - 1];
+		size_t b = rpm_pkgindex_hash(r->name) & (index->table_size - 1);
+
+		r->next_name = index->table[b];
+		index->table[b] = r;
+	}
+
+	dI("Indexed %zu installed packages.", index->count);
+	return index;
+fail:
+	dE("Can't allocate the index of the installed packages.");
+	rpmdbFreeIterator(match);
+	regfree(&keyid_regex);
+	rpm_pkgindex_free(index);
+	return NULL;
+}
+
+static void rpm_pkgindex_reset_locked(void)
+{
+	struct rpm_pkgindex *index = rpm_pkgindex_global.index;
+
+	rpm_pkgindex_global.index = NULL;
+	if (index != NULL && --index->refs == 0)
+		rpm_pkgindex_free(index);
+}
+
+void rpm_pkgindex_ref(void)
+{
+	pthread_mutex_lock(&rpm_pkgindex_global.lock);
+	++rpm_pkgindex_global.refcnt;
+	pthread_mutex_unlock(&rpm_pkgindex_global.lock);
+}
+
+void rpm_pkgindex_unref(void)
+{
+	pthread_mutex_lock(&rpm_pkgindex_global.lock);
+	if (rpm_pkgindex_global.refcnt > 0 && --rpm_pkgindex_global.refcnt == 0)
+		rpm_pkgindex_reset_locked();
+	pthread_mutex_unlock(&rpm_pkgindex_global.lock);
+}
+
+void rpm_pkgindex_reset(void)
+{
+	pthread_mutex_lock(&rpm_pkgindex_global.lock);
+	rpm_pkgindex_reset_locked();
+	pthread_mutex_unlock(&rpm_pkgindex_global.lock);
+}
+
+const struct rpm_pkgindex *rpm_pkgindex_get(rpmts ts)
+{
+	struct rpm_pkgindex *index;
+
+	pthread_mutex_lock(&rpm_pkgindex_global.lock);
+	if (rpm_pkgindex_global.index == NULL) {
+		rpm_pkgindex_global.index = rpm_pkgindex_build(ts);
+		if (rpm_pkgindex_global.index != NULL)
+			rpm_pkgindex_global.index->refs = 1; /* the index of the current scan */
+	}
+	index = rpm_pkgindex_global.index;
+	if (index != NULL)
+		index->refs++;
+	pthread_mutex_unlock(&rpm_pkgindex_global.lock);
+
+	return index;
+}
+
+void rpm_pkgindex_release(const struct rpm_pkgindex *index)
+{
+	struct rpm_pkgindex *i = (struct rpm_pkgindex *)index;
+	bool last;
+
+	if (i == NULL)
+		return;
+
+	pthread_mutex_lock(&rpm_pkgindex_global.lock);
+	last = --i->refs == 0;
+	pthread_mutex_unlock(&rpm_pkgindex_global.lock);
+
+	if (last)
+		rpm_pkgindex_free(i);
+}
+
+static bool rpm_pkginfo_cmp(SEXP_t *ent, const char *value)
+{
+	SEXP_t *val;
+	bool match;
+
+	if (ent == NULL)
+		return true;
+
+	val = probe_entval_from_cstr(probe_ent_getdatatype(ent), value, strlen(value));
+	if (val == NULL)
+		return false;
+
+	match = probe_entobj_cmp(ent, val) == OVAL_RESULT_TRUE;
+	SEXP_free(val);
+
+	return match;
+}
+
+static bool rpm_pkginfo_match(const struct rpm_pkginfo *r,
+                              SEXP_t *name_ent, SEXP_t *epoch_ent, SEXP_t *version_ent,
+                              SEXP_t *release_ent, SEXP_t *arch_ent)
+{
+	return rpm_pkginfo_cmp(name_ent, r->name) &&
+	       rpm_pkginfo_cmp(epoch_ent, r->epoch) &&
+	       rpm_pkginfo_cmp(version_ent, r->version) &&
+	       rpm_pkginfo_cmp(release_ent, r->release) &&
+	       rpm_pkginfo_cmp(arch_ent, r->arch);
+}
+
+/*
+ * Can the packages matching the name entity be found by looking up
+ * the entity's values?
+ */
+static bool rpm_pkgindex_lookup_possible(SEXP_t *name_ent)
+{
+	SEXP_t *stmp;
+	oval_check_t ochk;
+
+	if (name_ent == NULL || probe_ent_getoperation(name_ent, OVAL_OPERATION_EQUALS) != OVAL_OPERATION_EQUALS)
+		return false;
+	if (!probe_ent_attrexists(name_ent, "var_ref"))
+		return true;
+
+	stmp = probe_ent_getattrval(name_ent, "var_check");
+	if (stmp == NULL)
+		return true;
+	ochk = SEXP_number_geti_32(stmp);
+	SEXP_free(stmp);
+
+	return ochk == OVAL_CHECK_ALL || ochk == OVAL_CHECK_AT_LEAST_ONE || ochk == OVAL_CHECK_ONLY_ONE;
+}
+
+static int rpm_pkgindex_append(const struct rpm_pkginfo ***res, int count, const struct rpm_pkginfo *r)
+{
+	const struct rpm_pkginfo **tmp;
+
+	tmp = realloc(*res, (count + 1) * sizeof(struct rpm_pkginfo *));
+	if (tmp == NULL)
+		return -1;
+
+	tmp[count] = r;
+	*res = tmp;
+	return 0;
+}
+
+int rpm_pkgindex_select(const struct rpm_pkgindex *index,
+                        SEXP_t *name_ent, SEXP_t *epoch_ent, SEXP_t *version_ent,
+                        SEXP_t *release_ent, SEXP_t *arch_ent,
+                        const struct rpm_pkginfo ***pkgs)
+{
+	const struct rpm_pkginfo **res = NULL;
+	int count = 0;
+	size_t i;
+
+	if (index == NULL || pkgs == NULL)
+		return -1;
+
+	if (rpm_pkgindex_lookup_possible(name_ent)) {
+		SEXP_t *vals, *val;
+
+		probe_ent_getvals(name_ent, &vals);
+		SEXP_list_foreach(val, vals) {
+			char *name = SEXP_string_cstr(val);
+			const struct rpm_pkginfo *r;
+
+			if (name == NULL)
+				continue;
+
+			r = index->table[rpm_pkgindex_hash(name) & (index->table_size - 1)];
+			for (; r != NULL; r = r->next_name) {
+				if (strcmp(r->name, name) != 0)
+					continue;
+				if (!rpm_pkginfo_match(r, name_ent, epoch_ent, version_ent, release_ent, arch_ent))
+					continue;
+				if (rpm_pkgindex_append(&res, count, r) != 0) {
+					free(name);
+					SEXP_free(vals);
+					free(res);
+					return -1;
+				}
+				++count;
+			}
+			free(name);
+		}
+		SEXP_free(vals);
+	} else {
+		for (i = 0; i < index->count; ++i) {
+			const struct rpm_pkginfo *r = &index->pkgs[i];
+
+			if (!rpm_pkginfo_match(r, name_ent, epoch_ent, version_ent, release_ent, arch_ent))
+				continue;
+			if (rpm_pkgindex_append(&res, count, r) != 0) {
+				free(res);
+				return -1;
+			}
+			++count;
+		}
+	}
+
+	*pkgs = res;
+	return count;
+}
+
+rpmdbMatchIterator rpm_pkgindex_iterator(rpmts ts, const struct rpm_pkginfo **pkgs, int count)
+{
+	rpmdbMatchIterator match;
+	unsigned int *instances;
+	int i;
+
+	if (count <= 0)
+		return NULL;
+
+	instances = malloc(count * sizeof(unsigned int));
+	if (instances == NULL)
+		return NULL;
+	for (i = 0; i < count; ++i)
+		instances[i] = pkgs[i]->instance;
+
+	/* the first package opens the iterator, the rest is appended to it */
+	match = rpmtsInitIterator(ts, RPMDBI_PACKAGES, &instances[0], sizeof(instances[0]));
+	if (match != NULL && count > 1)
+		rpmdbAppendIterator(match, &instances[1], count - 1);
+
+	free(instances);
+	return match;
+}
@@ -33,6 +33,7 @@
 #include <rpm/header.h>
 
 #include <pthread.h>
+#include <sexp.h>
 #include "common/util.h"
 #include "common/debug_priv.h"
 #include "pthread.h"
@@ -42,6 +43,76 @@ struct rpm_probe_global {
 	pthread_mutex_t mutex;
 };
 
+/**
+ * Summary of an installed package stored in the package index
+ */
+struct rpm_pkginfo {
+	unsigned int instance; /**< rpmdb header instance */
+	char *name;
+	char *arch;
+	char *epoch;           /**< "(none)" if the package has no epoch */
+	char *release;
+	char *version;
+	char *evr;             /**< epoch:version-release, epoch defaults to 0 */
+	char *signature_keyid; /**< "0" if the package isn't signed */
+	char *extended_name;   /**< name-epoch:version-release.arch */
+	struct rpm_pkginfo *next_name; /**< next package with the same name */
+};
+
+/**
+ * Read-only index of the installed packages. It's built from the rpmdb on
+ * first use and shared by all the rpm probes of the session.
+ */
+struct rpm_pkgindex {
+	struct rpm_pkginfo  *pkgs;
+	size_t               count;
+	struct rpm_pkginfo **table; /**< packages hashed by name */
+	size_t               table_size;
+	unsigned int         refs;  /**< protected by the lock of the global index */
+};
+
+/**
+ * Take a reference to the package index. Every rpm probe holds one
+ * reference from its init to its fini function, the index is freed when
+ * the last probe finishes.
+ */
+void rpm_pkgindex_ref(void);
+void rpm_pkgindex_unref(void);
+
+/**
+ * Get the package index, build it using the transaction set if it doesn't
+ * exist yet. The caller has to hold a reference and the lock of the
+ * transaction set. Release the index by rpm_pkgindex_release when the
+ * packages selected from it aren't needed anymore.
+ * @return the index or NULL if the rpmdb can't be read
+ */
+const struct rpm_pkgindex *rpm_pkgindex_get(rpmts ts);
+void rpm_pkgindex_release(const struct rpm_pkgindex *index);
+
+/**
+ * Drop the index of the current scan, the next rpm_pkgindex_get builds
+ * a new one from the rpmdb.
+ */
+void rpm_pkgindex_reset(void);
+
+/**
+ * Select the packages matching the object's entities, NULL entities match
+ * all packages. Packages are looked up by name if the name entity uses the
+ * equals operation.
+ * @param pkgs where to store the array of matching packages, free() it
+ * @return number of packages in *pkgs or -1 on error
+ */
+int rpm_pkgindex_select(const struct rpm_pkgindex *index,
+                        SEXP_t *name_ent, SEXP_t *epoch_ent, SEXP_t *version_ent,
+                        SEXP_t *release_ent, SEXP_t *arch_ent,
+                        const struct rpm_pkginfo ***pkgs);
+
+/**
+ * Create an rpmdb iterator over the headers of the given packages
+ * @return the iterator or NULL if there are no packages
+ */
+rpmdbMatchIterator rpm_pkgindex_iterator(rpmts ts, const struct rpm_pkginfo **pkgs, int count);
+
 #ifndef HAVE_HEADERFORMAT
 # define HAVE_LIBRPM44 1 /* hack */
 # define headerFormat(_h, _fmt, _emsg) headerSprintf((_h),( _fmt), rpmTagTable, rpmHeaderFormats, (_emsg))
@@ -57,7 +57,6 @@
 #include <sys/types.h>
 #include <sys/stat.h>
 #include <fcntl.h>
-#include <regex.h>
 
 /* RPM headers */
 #include "rpm-helper.h"
@@ -77,197 +76,36 @@ struct rpminfo_req {
         oval_operation_t op;
 };
 
-struct rpminfo_rep {
-        char *name;
-        char *arch;
-        char *epoch;
-        char *release;
-        char *version;
-        char *evr;
-        char *signature_keyid;
-	char extended_name[1024];
-};
-
 #define RPMINFO_LOCK	RPM_MUTEX_LOCK(&g_rpm->mutex)
 
 #define RPMINFO_UNLOCK	RPM_MUTEX_UNLOCK(&g_rpm->mutex)
 
-static const char g_keyid_regex_string[] = "Key ID [a-fA-F0-9]{16}";
-
-static void __rpminfo_rep_free (struct rpminfo_rep *ptr)
-{
-        free (ptr->name);
-        free (ptr->arch);
-        free (ptr->epoch);
-        free (ptr->release);
-        free (ptr->version);
-        free (ptr->evr);
-        free (ptr->signature_keyid);
-}
-
-static void pkgh2rep(Header h, struct rpminfo_rep *r, regex_t *keyid_regex)
-{
-        errmsg_t rpmerr;
-        char *str, *sid;
-	char *epoch_override = NULL;
-        size_t len;
-	regmatch_t keyid_match[1];
-
-	if (h == NULL || r == NULL) {
-		return;
-	}
-
-        r->name = headerFormat (h, "%{NAME}", &rpmerr);
-        r->arch = headerFormat (h, "%{ARCH}", &rpmerr);
-        r->epoch = headerFormat (h, "%{EPOCH}", &rpmerr);
-        r->release = headerFormat (h, "%{RELEASE}", &rpmerr);
-        r->version = headerFormat (h, "%{VERSION}", &rpmerr);
-	epoch_override = oscap_streq(r->epoch, "(none)") ? "0" : r->epoch;
-	snprintf(r->extended_name, 1024, "%s-%s:%s-%s.%s", r->name, epoch_override, r->version, r->release, r->arch);
-
-	len = (strlen(epoch_override) +
-               strlen (r->release) +
-               strlen (r->version) + 2);
-
-        str = malloc (sizeof (char) * (len + 1));
-        snprintf (str, len + 1, "%s:%s-%s",
-		epoch_override,
-                  r->version,
-                  r->release);
-
-        r->evr = str;
-
-        str = headerFormat (h, "%|SIGGPG?{%{SIGGPG:pgpsig}}:{%{SIGPGP:pgpsig}}|", &rpmerr);
-
-	if (regexec(keyid_regex, str, 1, keyid_match, 0) != 0) {
-		sid = NULL;
-		dD("Failed to extract the Key ID value: regex=\"%s\", string=\"%s\"",
-		   g_keyid_regex_string, str);
-	} else {
-		size_t keyid_start, keyid_length;
-
-		if (keyid_match[0].rm_so < 0 || keyid_match[0].rm_eo < 0)
-			sid = NULL;
-		else {
-			keyid_start = keyid_match[0].rm_so + strlen("Key ID ");
-			keyid_length = keyid_match[0].rm_eo - keyid_start;
-			sid = str + keyid_start;
-			sid[keyid_length] = '\0';
-		}
-	}
-
-        r->signature_keyid = strdup(sid != NULL ? sid : "0");
-        free (str);
-}
-
 /*
- * req - Structure containing the name of the package.
- * rep - Pointer to rpminfo_rep structure pointer. An
- *       array of rpminfo_rep structures will be allocated
- *       here.
+ * name_ent - The name entity of the object.
+ * index    - The package index the packages are selected from,
+ *            release it by rpm_pkgindex_release.
+ * rep      - Pointer to an array of package pointers. The
+ *            array will be allocated here, the packages are
+ *            owned by the package index.
  *
  * The return value on error is -1. Otherwise the number of
- * rpminfo_rep structures allocated in *rep is returned.
+ * packages in *rep is returned.
  */
-static int get_rpminfo(struct rpminfo_req *req, struct rpminfo_rep **rep, struct rpm_probe_global *g_rpm)
+static int get_rpminfo(SEXP_t *name_ent, const struct rpm_pkgindex **index, const struct rpm_pkginfo ***rep, struct rpm_probe_global *g_rpm)
 {
-	rpmdbMatchIterator match;
-	Header pkgh;
-	int ret = 0, i;
-	regex_t keyid_regex;
-
-	if (regcomp(&keyid_regex, g_keyid_regex_string, REG_EXTENDED) != 0) {
-		dE("regcomp(%s) failed.", g_keyid_regex_string);
-		return -1;
-	}
-
-        RPMINFO_LOCK;
-
-        ret = -1;
-
-        switch (req->op) {
-        case OVAL_OPERATION_EQUALS:
-		match = rpmtsInitIterator(g_rpm->rpmts, RPMTAG_NAME, (const void *)req->name, 0);
-
-                if (match == NULL) {
-                        ret = 0;
-                        goto ret;
-                }
-
-                ret = rpmdbGetIteratorCount (match);
-
-                break;
-	case OVAL_OPERATION_NOT_EQUAL:
-		match = rpmtsInitIterator(g_rpm->rpmts, RPMDBI_PACKAGES, NULL, 0);
-                if (match == NULL) {
-                        ret = 0;
-                        goto ret;
-                }
-
-                if (rpmdbSetIteratorRE (match, RPMTAG_NAME, RPMMIRE_GLOB, "*") != 0)
-                {
-                        ret = -1;
-                        goto ret;
-                }
-
-                break;
-        case OVAL_OPERATION_PATTERN_MATCH:
-		match = rpmtsInitIterator(g_rpm->rpmts, RPMDBI_PACKAGES, NULL, 0);
-
-                if (match == NULL) {
-                        ret = 0;
-                        goto ret;
-                }
+	int ret;
 
-                if (rpmdbSetIteratorRE (match, RPMTAG_NAME, RPMMIRE_REGEX,
-                                        (const char *)req->name) != 0)
-                {
-                        ret = -1;
-                        goto ret;
-                }
+	RPMINFO_LOCK;
 
-                break;
-        default:
-                /* not supported */
-                ret = -1;
-                goto ret;
-        }
-
-        if (ret != -1) {
-                /*
-                 * We can allocate all memory needed now because we know the number
-                 * of results.
-                 */
-                (*rep) = realloc (*rep, sizeof (struct rpminfo_rep) * ret);
-
-                for (i = 0; i < ret; ++i) {
-                        pkgh = rpmdbNextIterator (match);
-
-                        if (pkgh != NULL)
-			pkgh2rep(pkgh, (*rep) + i, &keyid_regex);
-                        else {
-                                /* XXX: emit warning */
-                                break;
-                        }
-                }
-        } else {
-                ret = 0;
-
-                while ((pkgh = rpmdbNextIterator (match)) != NULL) {
-                        (*rep) = realloc (*rep, sizeof (struct rpminfo_rep) * ++ret);
-			if (*rep == NULL) {
-					return -1;
-			}
-			pkgh2rep(pkgh, (*rep) + (ret - 1), &keyid_regex);
-                }
-        }
+	*index = rpm_pkgindex_get(g_rpm->rpmts);
+	if (*index == NULL)
+		ret = -1;
+	else
+		ret = rpm_pkgindex_select(*index, name_ent, NULL, NULL, NULL, NULL, rep);
 
-	match = rpmdbFreeIterator (match);
-ret:
-        RPMINFO_UNLOCK;
+	RPMINFO_UNLOCK;
 
-	regfree(&keyid_regex);
-        return (ret);
+	return (ret);
 }
 
 int rpminfo_probe_offline_mode_supported()
@@ -289,6 +127,7 @@ void *rpminfo_probe_init(void)
 
 	g_rpm->rpmts = rpmtsCreate();
 	pthread_mutex_init (&(g_rpm->mutex), NULL);
+	rpm_pkgindex_ref();
 
 	return ((void *)g_rpm);
 }
@@ -309,6 +148,7 @@ void rpminfo_probe_fini (void *ptr)
 	if (r->rpmts == NULL)
 		return;
 
+	rpm_pkgindex_unref();
         rpmtsFree(r->rpmts);
         pthread_mutex_destroy (&(r->mutex));
 
@@ -316,42 +156,30 @@ void rpminfo_probe_fini (void *ptr)
         return;
 }
 
-static int collect_rpm_files(SEXP_t *item, const struct rpminfo_rep *rep, struct rpm_probe_global *g_rpm)
+void rpminfo_probe_reset(void *ptr)
+{
+	(void)ptr;
+	rpm_pkgindex_reset();
+}
+
+static int collect_rpm_files(SEXP_t *item, const struct rpm_pkginfo *rep, struct rpm_probe_global *g_rpm)
 {
 	SEXP_t *value;
 	rpmdbMatchIterator ts;
 	Header pkgh;
 	rpmfi fi;
 	rpmTag tag[2] = { RPMTAG_BASENAMES, RPMTAG_DIRNAMES };
-	int i, ret = 0;
+	int i;
+
+	RPMINFO_LOCK;
 
-	ts = rpmtsInitIterator(g_rpm->rpmts, RPMDBI_PACKAGES, NULL, 0);
+	/* the package's header is looked up directly by its instance */
+	ts = rpm_pkgindex_iterator(g_rpm->rpmts, &rep, 1);
 	if (ts == NULL) {
+		RPMINFO_UNLOCK;
 		return -1;
 	}
 
-	if (rpmdbSetIteratorRE(ts, RPMTAG_NAME, RPMMIRE_STRCMP, rep->name) != 0) {
-		ret = -1;
-		goto cleanup;
-	}
-	char *epoch_override = oscap_streq(rep->epoch, "(none)") ? "0" : rep->epoch;
-	if (rpmdbSetIteratorRE(ts, RPMTAG_EPOCH, RPMMIRE_STRCMP, epoch_override) != 0) {
-		ret = -1;
-		goto cleanup;
-	}
-	if (rpmdbSetIteratorRE(ts, RPMTAG_VERSION, RPMMIRE_STRCMP, rep->version) != 0) {
-		ret = -1;
-		goto cleanup;
-	}
-	if (rpmdbSetIteratorRE(ts, RPMTAG_RELEASE, RPMMIRE_STRCMP, rep->release) != 0) {
-		ret = -1;
-		goto cleanup;
-	}
-	if (rpmdbSetIteratorRE(ts, RPMTAG_ARCH, RPMMIRE_STRCMP, rep->arch) != 0) {
-		ret = -1;
-		goto cleanup;
-	}
-
 	while ((pkgh = rpmdbNextIterator(ts)) != NULL) {
 		/*
 		 * Inspect package files & directories
@@ -376,9 +204,10 @@ static int collect_rpm_files(SEXP_t *item, const struct rpminfo_rep *rep, struct
 		}
 
 	}
-cleanup:
+
 	ts = rpmdbFreeIterator(ts);
-	return ret;
+	RPMINFO_UNLOCK;
+	return 0;
 }
 
 int rpminfo_probe_main(probe_ctx *ctx, void *arg)
@@ -388,7 +217,8 @@ int rpminfo_probe_main(probe_ctx *ctx, void *arg)
 	int rpmret, i;
 
         struct rpminfo_req request_st;
-        struct rpminfo_rep *reply_st;
+        const struct rpm_pkginfo **reply_st;
+	const struct rpm_pkgindex *index = NULL;
 
 	// arg is NULL if regex compilation failed
 	if (arg == NULL) {
@@ -472,7 +302,7 @@ int rpminfo_probe_main(probe_ctx *ctx, void *arg)
         reply_st  = NULL;
 
         /* get info from RPM db */
-	switch (rpmret = get_rpminfo(&request_st, &reply_st, g_rpm)) {
+	switch (rpmret = get_rpminfo(ent, &index, &reply_st, g_rpm)) {
         case 0: /* Not found */
                 dI("Package \"%s\" not found.", request_st.name);
                 break;
@@ -493,21 +323,17 @@ int rpminfo_probe_main(probe_ctx *ctx, void *arg)
                         SEXP_t *name;
 
                         for (i = 0; i < rpmret; ++i) {
-				name = SEXP_string_newf("%s", reply_st[i].name);
-
-				if (probe_entobj_cmp(ent, name) != OVAL_RESULT_TRUE) {
-					SEXP_free(name);
-					continue;
-				}
+				/* the index returns only packages matching the name entity */
+				name = SEXP_string_newf("%s", reply_st[i]->name);
 
                                 item = probe_item_create(OVAL_LINUX_RPM_INFO, NULL,
                                                          "name",    OVAL_DATATYPE_SEXP, name,
-                                                         "arch",    OVAL_DATATYPE_STRING, reply_st[i].arch,
-                                                         "epoch",   OVAL_DATATYPE_STRING, reply_st[i].epoch,
-                                                         "release", OVAL_DATATYPE_STRING, reply_st[i].release,
-                                                         "version", OVAL_DATATYPE_STRING, reply_st[i].version,
-                                                         "evr",     OVAL_DATATYPE_EVR_STRING, reply_st[i].evr,
-                                                         "signature_keyid", OVAL_DATATYPE_STRING, reply_st[i].signature_keyid,
+                                                         "arch",    OVAL_DATATYPE_STRING, reply_st[i]->arch,
+                                                         "epoch",   OVAL_DATATYPE_STRING, reply_st[i]->epoch,
+                                                         "release", OVAL_DATATYPE_STRING, reply_st[i]->release,
+                                                         "version", OVAL_DATATYPE_STRING, reply_st[i]->version,
+                                                         "evr",     OVAL_DATATYPE_EVR_STRING, reply_st[i]->evr,
+                                                         "signature_keyid", OVAL_DATATYPE_STRING, reply_st[i]->signature_keyid,
                                                          NULL);
 
 				/* OVAL 5.10 added extended_name and filepaths behavior */
@@ -515,8 +341,8 @@ int rpminfo_probe_main(probe_ctx *ctx, void *arg)
 					SEXP_t *value, *bh_value;
 					value = probe_entval_from_cstr(
 							OVAL_DATATYPE_STRING,
-							reply_st[i].extended_name,
-							strlen(reply_st[i].extended_name)
+							reply_st[i]->extended_name,
+							strlen(reply_st[i]->extended_name)
 					);
 					probe_item_ent_add(item, "extended_name", NULL, value);
 					SEXP_free(value);
@@ -530,7 +356,7 @@ int rpminfo_probe_main(probe_ctx *ctx, void *arg)
 						if (bh_value != NULL) {
 							if (SEXP_strcmp(bh_value, "true") == 0) {
 								/* collect package files */
-								collect_rpm_files(item, &reply_st[i], g_rpm);
+								collect_rpm_files(item, reply_st[i], g_rpm);
 
 							}
 							SEXP_free(bh_value);
@@ -542,10 +368,12 @@ int rpminfo_probe_main(probe_ctx *ctx, void *arg)
 
 
 				SEXP_free(name);
-                                __rpminfo_rep_free (&(reply_st[i]));
 
 				if (probe_item_collect(ctx, item) < 0) {
+					free(reply_st);
+					rpm_pkgindex_release(index);
 					SEXP_free(ent);
+					free(request_st.name);
 					return PROBE_EUNKNOWN;
 				}
                         }
@@ -554,6 +382,7 @@ int rpminfo_probe_main(probe_ctx *ctx, void *arg)
                 }
         }
 
+	rpm_pkgindex_release(index);
 	SEXP_free(ent);
         free(request_st.name);
 
@@ -261,6 +261,12 @@ void rpmverify_probe_fini(void *ptr)
         return;
 }
 
+void rpmverify_probe_reset(void *ptr)
+{
+	(void)ptr;
+	rpm_pkgindex_reset();
+}
+
 static void rpmverify_additem(probe_ctx *ctx, struct rpmverify_res *res)
 {
         SEXP_t *item;
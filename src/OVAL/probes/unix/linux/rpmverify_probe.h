@@ -29,5 +29,6 @@ int rpmverify_probe_offline_mode_supported(void);
 void *rpmverify_probe_init(void);
 int rpmverify_probe_main(probe_ctx *ctx, void *arg);
 void rpmverify_probe_fini(void *arg);
+void rpmverify_probe_reset(void *arg);
 
 #endif /* OPENSCAP_RPMVERIFY_PROBE_H */
@@ -159,33 +159,54 @@ static int rpmverify_collect(probe_ctx *ctx,
 		 * the package which provides this file, similar to `rpm -q -f`.
 		 */
 		match = rpmtsInitIterator(g_rpm->rpmts, RPMDBI_INSTFILENAMES, file, 0);
+		if (match == NULL) {
+			ret = 0;
+			goto ret;
+		}
+
+		if ((ret = adjust_filter(match, name_ent, RPMTAG_NAME)) == -1) {
+			dE("can't adjust filter with name");
+			goto ret;
+		}
+		if ((ret = adjust_filter(match, epoch_ent, RPMTAG_EPOCH)) == -1) {
+			dE("can't adjust filter with epoch");
+			goto ret;
+		}
+		if ((ret = adjust_filter(match, version_ent, RPMTAG_VERSION)) == -1) {
+			dE("can't adjust filter with version");
+			goto ret;
+		}
+		if ((ret = adjust_filter(match, release_ent, RPMTAG_RELEASE)) == -1) {
+			dE("can't adjust filter with version");
+			goto ret;
+		}
+		if ((ret = adjust_filter(match, arch_ent, RPMTAG_ARCH)) == -1) {
+			dE("can't adjust filter with version");
+			goto ret;
+		}
 	} else {
-		match = rpmtsInitIterator(g_rpm->rpmts, RPMDBI_PACKAGES, NULL, 0);
-	}
-	if (match == NULL) {
-		ret = 0;
-		goto ret;
-	}
+		/*
+		 * Otherwise the packages are selected in the package index
+		 * and only their headers are read from the rpmdb.
+		 */
+		const struct rpm_pkgindex *index = rpm_pkgindex_get(g_rpm->rpmts);
+		const struct rpm_pkginfo **pkgs = NULL;
+		int pkg_cnt;
 
-	if ((ret = adjust_filter(match, name_ent, RPMTAG_NAME)) == -1) {
-		dE("can't adjust filter with name");
-		goto ret;
-	}
-	if ((ret = adjust_filter(match, epoch_ent, RPMTAG_EPOCH)) == -1) {
-		dE("can't adjust filter with epoch");
-		goto ret;
-	}
-	if ((ret = adjust_filter(match, version_ent, RPMTAG_VERSION)) == -1) {
-		dE("can't adjust filter with version");
-		goto ret;
-	}
-	if ((ret = adjust_filter(match, release_ent, RPMTAG_RELEASE)) == -1) {
-		dE("can't adjust filter with version");
-		goto ret;
-	}
-	if ((ret = adjust_filter(match, arch_ent, RPMTAG_ARCH)) == -1) {
-		dE("can't adjust filter with version");
-		goto ret;
+		if (index == NULL) {
+			ret = -1;
+			goto ret;
+		}
+
+		pkg_cnt = rpm_pkgindex_select(index, name_ent, epoch_ent, version_ent, release_ent, arch_ent, &pkgs);
+		match = rpm_pkgindex_iterator(g_rpm->rpmts, pkgs, pkg_cnt);
+		free(pkgs);
+		rpm_pkgindex_release(index);
+
+		if (match == NULL) {
+			ret = 0;
+			goto ret;
+		}
 	}
 
 	if (RPMTAG_BASENAMES == 0 || RPMTAG_DIRNAMES == 0) {
@@ -346,6 +367,7 @@ void *rpmverifyfile_probe_init(void)
 	g_rpm->rpmts = rpmtsCreate();
 
 	pthread_mutex_init(&(g_rpm->mutex), NULL);
+	rpm_pkgindex_ref();
 
 	return ((void *)g_rpm);
 }
@@ -363,6 +385,7 @@ void rpmverifyfile_probe_fini(void *ptr)
 	if (r == NULL)
 		return;
 
+	rpm_pkgindex_unref();
 	rpmtsFree(r->rpmts);
 	pthread_mutex_destroy (&(r->mutex));
 	free(r);
@@ -370,6 +393,12 @@ void rpmverifyfile_probe_fini(void *ptr)
 	return;
 }
 
+void rpmverifyfile_probe_reset(void *ptr)
+{
+	(void)ptr;
+	rpm_pkgindex_reset();
+}
+
 static void _add_ent_from_cstr(SEXP_t *item, const char *name, const char *value)
 {
 	SEXP_t *sexp_str = SEXP_string_new(value, strlen(value));
@@ -29,5 +29,6 @@ int rpmverifyfile_probe_offline_mode_supported(void);
 void *rpmverifyfile_probe_init(void);
 int rpmverifyfile_probe_main(probe_ctx *ctx, void *arg);
 void rpmverifyfile_probe_fini(void *arg);
+void rpmverifyfile_probe_reset(void *arg);
 
 #endif /* OPENSCAP_RPMVERIFYFILE_PROBE_H */
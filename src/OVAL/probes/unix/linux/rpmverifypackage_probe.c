@@ -114,46 +114,15 @@ static struct poptOption optionsTable[] = {
 
 #define CHROOT_PATH() probe_chroot_get_path(&g_rpm->chr)
 
-/* modify passed-in iterator to test also given entity */
-static int adjust_filter(rpmdbMatchIterator iterator, SEXP_t *ent, rpmTag rpm_tag) {
-	oval_operation_t ent_op;
-	char ent_str[1024] = "";
-	int ret = 0;
-
-	if (ent) {
-		ent_op = probe_ent_getoperation(ent, OVAL_OPERATION_EQUALS);
-		PROBE_ENT_STRVAL(ent, ent_str, sizeof ent_str, /* void */, strcpy(ent_str, ""););
-		if (rpm_tag == RPMTAG_EPOCH && strcmp(ent_str, "(none)") == 0) {
-			return ret;
-		}
-
-		switch (ent_op) {
-		case OVAL_OPERATION_EQUALS:
-			if (rpmdbSetIteratorRE (iterator, rpm_tag, RPMMIRE_STRCMP, ent_str) != 0)
-				ret = -1;
-
-			break;
-		case OVAL_OPERATION_PATTERN_MATCH:
-			if (rpmdbSetIteratorRE (iterator, rpm_tag, RPMMIRE_REGEX,
-						(const char *)ent_str) != 0)
-				ret = -1;
-
-			break;
-		default:
-			ret = 0;
-		}
-	}
-	return ret;
-}
-
 static int rpmverify_collect(probe_ctx *ctx,
 			     SEXP_t *name_ent, SEXP_t *epoch_ent, SEXP_t *version_ent, SEXP_t *release_ent, SEXP_t *arch_ent,
 			     uint64_t flags,
 			int (*callback)(probe_ctx *, struct rpmverify_res *),
 			struct verifypackage_global *g_rpm)
 {
-	rpmdbMatchIterator match;
-	Header pkgh;
+	const struct rpm_pkgindex *index = NULL;
+	const struct rpm_pkginfo **pkgs = NULL;
+	int  pkg_cnt, k;
 	int  ret = -1;
 	unsigned int i, j, rpmcli_argc = 0;
 	const char * rpmcli_argv[10];
@@ -162,73 +131,35 @@ static int rpmverify_collect(probe_ctx *ctx,
 
 	RPMVERIFY_LOCK;
 
-	match = rpmtsInitIterator (g_rpm->rpm.rpmts, RPMDBI_PACKAGES, NULL, 0);
-	if (match == NULL) {
-		ret = 0;
+	/*
+	 * The packages are selected in the package index, the rpmdb
+	 * headers aren't needed at all.
+	 */
+	index = rpm_pkgindex_get(g_rpm->rpm.rpmts);
+	if (index == NULL) {
+		ret = -1;
 		goto ret;
 	}
 
-	if ((ret = adjust_filter(match, name_ent, RPMTAG_NAME)) == -1) {
-		dE("can't adjust filter with name");
-		goto ret;
-	}
-	if ((ret = adjust_filter(match, epoch_ent, RPMTAG_EPOCH)) == -1) {
-		dE("can't adjust filter with epoch");
-		goto ret;
-	}
-	if ((ret = adjust_filter(match, version_ent, RPMTAG_VERSION)) == -1) {
-		dE("can't adjust filter with version");
-		goto ret;
-	}
-	if ((ret = adjust_filter(match, release_ent, RPMTAG_RELEASE)) == -1) {
-		dE("can't adjust filter with version");
+	pkg_cnt = rpm_pkgindex_select(index, name_ent, epoch_ent, version_ent, release_ent, arch_ent, &pkgs);
+	if (pkg_cnt <= 0) {
+		ret = pkg_cnt;
 		goto ret;
 	}
-	if ((ret = adjust_filter(match, arch_ent, RPMTAG_ARCH)) == -1) {
-		dE("can't adjust filter with version");
-		goto ret;
-	}
-
-	if (RPMTAG_BASENAMES == 0 || RPMTAG_DIRNAMES == 0) {
-		return -1;
-	}
 
 	rpmcli_argv[0] = "probe_rpmverifypackage";
 	rpmcli_argv[1] = "--quiet";
 	rpmcli_argv[2] = "--nofiles";
 
-	while ((pkgh = rpmdbNextIterator (match)) != NULL) {
-		SEXP_t *ent;
+	for (k = 0; k < pkg_cnt; ++k) {
 		struct rpmverify_res res;
-		errmsg_t rpmerr;
-
-#define COMPARE_ENT(XXX) \
-		if (XXX ## _ent != NULL) { \
-			ent = probe_entval_from_cstr( \
-				probe_ent_getdatatype(XXX ## _ent), res.XXX, strlen(res.XXX) \
-			); \
-			if (ent != NULL && probe_entobj_cmp(XXX ## _ent, ent) != OVAL_RESULT_TRUE) { \
-				SEXP_free(ent); \
-				continue; \
-			} \
-			SEXP_free(ent); \
-		}
-
-		res.name = headerFormat(pkgh, "%{NAME}", &rpmerr);
-		COMPARE_ENT(name);
-
-		res.epoch = headerFormat(pkgh, "%{EPOCH}", &rpmerr);
-		COMPARE_ENT(epoch);
 
-		res.version = headerFormat(pkgh, "%{VERSION}", &rpmerr);
-		COMPARE_ENT(version);
-		res.release = headerFormat(pkgh, "%{RELEASE}", &rpmerr);
-		COMPARE_ENT(release);
-		res.arch = headerFormat(pkgh, "%{ARCH}", &rpmerr);
-		COMPARE_ENT(arch);
-		snprintf(res.extended_name, 1024, "%s-%s:%s-%s.%s", res.name,
-			oscap_streq(res.epoch, "(none)") ? "0" : res.epoch,
-			res.version, res.release, res.arch);
+		res.name = pkgs[k]->name;
+		res.epoch = pkgs[k]->epoch;
+		res.version = pkgs[k]->version;
+		res.release = pkgs[k]->release;
+		res.arch = pkgs[k]->arch;
+		snprintf(res.extended_name, 1024, "%s", pkgs[k]->extended_name);
 
 		/*
 		 * Verify package
@@ -296,16 +227,12 @@ static int rpmverify_collect(probe_ctx *ctx,
 			ret = 1;
 			goto ret;
 		}
-		free(res.name);
-		free(res.epoch);
-		free(res.version);
-		free(res.release);
-		free(res.arch);
 	}
 
-	match = rpmdbFreeIterator (match);
 	ret   = 0;
 ret:
+	free(pkgs);
+	rpm_pkgindex_release(index);
 	RPMVERIFY_UNLOCK;
 	return (ret);
 }
@@ -357,6 +284,7 @@ void *rpmverifypackage_probe_init(void)
 	}
 
 	pthread_mutex_init(&(g_rpm->rpm.mutex), NULL);
+	rpm_pkgindex_ref();
 	return ((void *)g_rpm);
 }
 
@@ -380,6 +308,7 @@ void rpmverifypackage_probe_fini(void *ptr)
 	if (r->rpm.rpmts == NULL)
 		return;
 
+	rpm_pkgindex_unref();
 	rpmtsFree(r->rpm.rpmts);
 	pthread_mutex_destroy (&(r->rpm.mutex));
 
@@ -387,6 +316,12 @@ void rpmverifypackage_probe_fini(void *ptr)
 	return;
 }
 
+void rpmverifypackage_probe_reset(void *ptr)
+{
+	(void)ptr;
+	rpm_pkgindex_reset();
+}
+
 static int rpmverifypackage_additem(probe_ctx *ctx, struct rpmverify_res *res)
 {
 	SEXP_t *item, *value;
@@ -29,5 +29,6 @@ int rpmverifypackage_probe_offline_mode_supported(void);
 void *rpmverifypackage_probe_init(void);
 int rpmverifypackage_probe_main(probe_ctx *ctx, void *arg);
 void rpmverifypackage_probe_fini(void *arg);
+void rpmverifypackage_probe_reset(void *arg);
 
 #endif /* OPENSCAP_RPMVERIFYPACKAGE_PROBE_H */
@@ -0,0 +1,922 @@
+/**
+ * @file   systemdshared.c
+ * @brief  functionality shared between systemdunitproperty and systemdunitdependency tests
+ * @author
+ */
+
+/*
+ * Copyright 2014 Red Hat Inc., Durham, North Carolina.
+ * All Rights Reserved.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ *
+ * Authors:
+ *
+ */
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+
+#include <pthread.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
+#include <dbus/dbus.h>
+#include "common/debug_priv.h"
+#include "common/list.h"
+#include "common/util.h"
+#include "oscap_helpers.h"
+#include "systemdshared.h"
+
+// Old versions of libdbus API don't have DBusBasicValue and DBus8ByteStruct
+// as a public typedefs.
+// These two typedefs were copied from libdbus 1.8 branch, see
+// http://cgit.freedesktop.org/dbus/dbus/tree/dbus/dbus-types.h?h=dbus-1.8#n137
+typedef struct
+{
+	dbus_uint32_t first32;
+	dbus_uint32_t second32;
+} _DBus8ByteStruct;
+
+typedef union
+{
+	unsigned char bytes[8]; /**< as 8 individual bytes */
+	dbus_int16_t  i16;   /**< as int16 */
+	dbus_uint16_t u16;   /**< as int16 */
+	dbus_int32_t  i32;   /**< as int32 */
+	dbus_uint32_t u32;   /**< as int32 */
+	dbus_bool_t   bool_val; /**< as boolean */
+#ifdef DBUS_HAVE_INT64
+	dbus_int64_t  i64;   /**< as int64 */
+	dbus_uint64_t u64;   /**< as int64 */
+#endif
+	_DBus8ByteStruct eight; /**< as 8-byte struct */
+	double dbl;          /**< as double */
+	unsigned char byt;   /**< as byte */
+	char *str;           /**< as char* (string, object path or signature) */
+	int fd;              /**< as Unix file descriptor */
+} _DBusBasicValue;
+
+static char *get_path_by_unit(DBusConnection *conn, const char *unit)
+{
+	DBusMessage *msg = NULL;
+	DBusPendingCall *pending = NULL;
+	_DBusBasicValue path;
+	char *ret = NULL;
+
+	msg = dbus_message_new_method_call(
+		"org.freedesktop.systemd1",
+		"/org/freedesktop/systemd1",
+		"org.freedesktop.systemd1.Manager",
+		// LoadUnit is similar to GetUnit except it will load the unit file
+		// if it hasn't been loaded yet.
+		"LoadUnit"
+	);
+	if (msg == NULL) {
+		dD("Failed to create dbus_message via dbus_message_new_method_call!");
+		goto cleanup;
+	}
+
+	DBusMessageIter args;
+
+	dbus_message_iter_init_append(msg, &args);
+	if (!dbus_message_iter_append_basic(&args, DBUS_TYPE_STRING, &unit)) {
+		dD("Failed to append unit '%s' string parameter to dbus message!", unit);
+		goto cleanup;
+	}
+
+	if (!dbus_connection_send_with_reply(conn, msg, &pending, -1)) {
+		dD("Failed to send message via dbus!");
+		goto cleanup;
+	}
+	if (pending == NULL) {
+		dD("Invalid dbus pending call!");
+		goto cleanup;
+	}
+
+	dbus_connection_flush(conn);
+	dbus_message_unref(msg); msg = NULL;
+
+	dbus_pending_call_block(pending);
+	msg = dbus_pending_call_steal_reply(pending);
+	if (msg == NULL) {
+		dD("Failed to steal dbus pending call reply.");
+		goto cleanup;
+	}
+	dbus_pending_call_unref(pending); pending = NULL;
+
+	if (!dbus_message_iter_init(msg, &args)) {
+		dD("Failed to initialize iterator over received dbus message.");
+		goto cleanup;
+	}
+
+	if (dbus_message_iter_get_arg_type(&args) != DBUS_TYPE_OBJECT_PATH) {
+		dD("Expected string argument in reply. Instead received: %s.", dbus_message_type_to_string(dbus_message_iter_get_arg_type(&args)));
+		goto cleanup;
+	}
+
+	dbus_message_iter_get_basic(&args, &path);
+	ret = oscap_strdup(path.str);
+	dbus_message_unref(msg); msg = NULL;
+
+cleanup:
+	if (pending != NULL)
+		dbus_pending_call_unref(pending);
+
+	if (msg != NULL)
+		dbus_message_unref(msg);
+
+	return ret;
+}
+
+static int get_all_systemd_units(DBusConnection* conn, int(*callback)(const char *, void *), void *cbarg)
+{
+	DBusMessage *msg = NULL;
+	DBusPendingCall *pending = NULL;
+	char ret = 1;
+
+	msg = dbus_message_new_method_call(
+		"org.freedesktop.systemd1",
+		"/org/freedesktop/systemd1",
+		"org.freedesktop.systemd1.Manager",
+		"ListUnits"
+	);
+	if (msg == NULL) {
+		dD("Failed to create dbus_message via dbus_message_new_method_call!");
+		goto cleanup;
+	}
+
+	DBusMessageIter args, unit_iter;
+
+	// the args should be empty for this call
+	dbus_message_iter_init_append(msg, &args);
+
+	if (!dbus_connection_send_with_reply(conn, msg, &pending, -1)) {
+		dD("Failed to send message via dbus!");
+		goto cleanup;
+	}
+	if (pending == NULL) {
+		dD("Invalid dbus pending call!");
+		goto cleanup;
+	}
+
+	dbus_connection_flush(conn);
+	dbus_message_unref(msg); msg = NULL;
+
+	dbus_pending_call_block(pending);
+	msg = dbus_pending_call_steal_reply(pending);
+	if (msg == NULL) {
+		dD("Failed to steal dbus pending call reply.");
+		goto cleanup;
+	}
+	dbus_pending_call_unref(pending); pending = NULL;
+
+	if (!dbus_message_iter_init(msg, &args)) {
+		dD("Failed to initialize iterator over received dbus message.");
+		goto cleanup;
+	}
+
+	if (dbus_message_iter_get_arg_type(&args) != DBUS_TYPE_ARRAY) {
+		dD("Expected array of structs in reply. Instead received: %s.", dbus_message_type_to_string(dbus_message_iter_get_arg_type(&args)));
+		goto cleanup;
+	}
+
+	dbus_message_iter_recurse(&args, &unit_iter);
+	do {
+		if (dbus_message_iter_get_arg_type(&unit_iter) != DBUS_TYPE_STRUCT) {
+			dD("Expected unit struct as elements in returned array. Instead received: %s.", dbus_message_type_to_string(dbus_message_iter_get_arg_type(&unit_iter)));
+			goto cleanup;
+		}
+
+		DBusMessageIter unit_name;
+		dbus_message_iter_recurse(&unit_iter, &unit_name);
+
+		if (dbus_message_iter_get_arg_type(&unit_name) != DBUS_TYPE_STRING) {
+			dD("Expected string as the first element in the unit struct. Instead received: %s.", dbus_message_type_to_string(dbus_message_iter_get_arg_type(&unit_name)));
+			goto cleanup;
+		}
+
+		_DBusBasicValue value;
+		dbus_message_iter_get_basic(&unit_name, &value);
+		char *unit_name_s = oscap_strdup(value.str);
+		int cbret = callback(unit_name_s, cbarg);
+		free(unit_name_s);
+		if (cbret != 0) {
+			goto cleanup;
+		}
+	}
+	while (dbus_message_iter_next(&unit_iter));
+
+	dbus_message_unref(msg); msg = NULL;
+
+	ret = 0;
+
+cleanup:
+	if (pending != NULL)
+		dbus_pending_call_unref(pending);
+
+	if (msg != NULL)
+		dbus_message_unref(msg);
+
+	return ret;
+}
+
+static char *dbus_value_to_string(DBusMessageIter *iter)
+{
+	const int arg_type = dbus_message_iter_get_arg_type(iter);
+	if (dbus_type_is_basic(arg_type)) {
+		_DBusBasicValue value;
+		dbus_message_iter_get_basic(iter, &value);
+
+		switch (arg_type)
+		{
+			case DBUS_TYPE_BYTE:
+				return oscap_sprintf("%c", value.byt);
+
+			case DBUS_TYPE_BOOLEAN:
+				return oscap_strdup(value.bool_val ? "true" : "false");
+
+			case DBUS_TYPE_INT16:
+				return oscap_sprintf("%i", value.i16);
+
+			case DBUS_TYPE_UINT16:
+				return oscap_sprintf("%u", value.u16);
+
+			case DBUS_TYPE_INT32:
+				return oscap_sprintf("%i", value.i32);
+
+			case DBUS_TYPE_UINT32:
+				return oscap_sprintf("%u", value.u32);
+
+#ifdef DBUS_HAVE_INT64
+			case DBUS_TYPE_INT64:
+				return oscap_sprintf("%lli", value.i64);
+
+			case DBUS_TYPE_UINT64:
+				return oscap_sprintf("%llu", value.u64);
+#endif
+
+			case DBUS_TYPE_DOUBLE:
+				return oscap_sprintf("%g", value.dbl);
+
+			case DBUS_TYPE_STRING:
+			case DBUS_TYPE_OBJECT_PATH:
+			case DBUS_TYPE_SIGNATURE:
+				return oscap_strdup(value.str);
+
+			// non-basic types
+			//case DBUS_TYPE_ARRAY:
+			//case DBUS_TYPE_STRUCT:
+			//case DBUS_TYPE_DICT_ENTRY:
+			//case DBUS_TYPE_VARIANT:
+
+			//case DBUS_TYPE_UNIX_FD:
+			//	return oscap_sprintf("%i", value.fd);
+
+			default:
+				dD("Encountered unknown dbus basic type!");
+				return oscap_strdup("error, unknown basic type!");
+		}
+	}
+	else if (arg_type == DBUS_TYPE_ARRAY) {
+		DBusMessageIter array;
+		dbus_message_iter_recurse(iter, &array);
+
+		char *ret = NULL;
+		do {
+			char *element = dbus_value_to_string(&array);
+
+			if (element == NULL)
+				continue;
+
+			char *old_ret = ret;
+			if (old_ret == NULL)
+				ret = oscap_sprintf("%s", element);
+			else
+				ret = oscap_sprintf("%s, %s", old_ret, element);
+
+			free(old_ret);
+			free(element);
+		}
+		while (dbus_message_iter_next(&array));
+
+		return ret;
+	}/*
+	else if (arg_type == DBUS_TYPE_VARIANT) {
+		DBusMessageIter inner;
+		dbus_message_iter_recurse(iter, &inner);
+		return dbus_value_to_string(&inner);
+	}*/
+
+	return NULL;
+}
+
+static DBusConnection *connect_dbus()
+{
+	DBusConnection *conn = NULL;
+
+	DBusError err;
+	dbus_error_init(&err);
+
+	conn = dbus_bus_get(DBUS_BUS_SYSTEM, &err);
+	if (dbus_error_is_set(&err)) {
+		dD("Failed to get DBUS_BUS_SYSTEM connection - %s", err.message);
+		goto cleanup;
+	}
+	if (conn == NULL) {
+		dD("DBusConnection == NULL!");
+		goto cleanup;
+	}
+
+	dbus_bus_register(conn, &err);
+	if (dbus_error_is_set(&err)) {
+		dD("Failed to register on dbus - %s", err.message);
+		goto cleanup;
+	}
+
+cleanup:
+	dbus_error_free(&err);
+
+	return conn;
+}
+
+static void disconnect_dbus(DBusConnection *conn)
+{
+	// Connections retrieved via dbus_bus_get shall not be closed,
+	// these connections are shared. Only release our reference.
+	dbus_connection_unref(conn);
+}
+
+static int get_all_properties_by_unit_path(DBusConnection *conn, const char *unit_path, int(*callback)(const char *name, const char *value, void *arg), void *cbarg)
+{
+	int ret = 1;
+	DBusMessage *msg = NULL;
+	DBusPendingCall *pending = NULL;
+
+	msg = dbus_message_new_method_call(
+		"org.freedesktop.systemd1",
+		unit_path,
+		"org.freedesktop.DBus.Properties",
+		"GetAll"
+	);
+	if (msg == NULL) {
+		dD("Failed to create dbus_message via dbus_message_new_method_call!");
+		goto cleanup;
+	}
+
+	DBusMessageIter args, property_iter;
+
+	const char *interface = "org.freedesktop.systemd1.Unit";
+
+	dbus_message_iter_init_append(msg, &args);
+	if (!dbus_message_iter_append_basic(&args, DBUS_TYPE_STRING, &interface)) {
+		dD("Failed to append interface '%s' string parameter to dbus message!", interface);
+		goto cleanup;
+	}
+
+	if (!dbus_connection_send_with_reply(conn, msg, &pending, -1)) {
+		dD("Failed to send message via dbus!");
+		goto cleanup;
+	}
+	if (pending == NULL) {
+		dD("Invalid dbus pending call!");
+		goto cleanup;
+	}
+
+	dbus_connection_flush(conn);
+	dbus_message_unref(msg); msg = NULL;
+
+	dbus_pending_call_block(pending);
+	msg = dbus_pending_call_steal_reply(pending);
+	if (msg == NULL) {
+		dD("Failed to steal dbus pending call reply.");
+		goto cleanup;
+	}
+	dbus_pending_call_unref(pending); pending = NULL;
+
+	if (!dbus_message_iter_init(msg, &args)) {
+		dD("Failed to initialize iterator over received dbus message.");
+		goto cleanup;
+	}
+
+	if (dbus_message_iter_get_arg_type(&args) != DBUS_TYPE_ARRAY && dbus_message_iter_get_element_type(&args) != DBUS_TYPE_DICT_ENTRY) {
+		dD("Expected array of dict_entry argument in reply. Instead received: %s.", dbus_message_type_to_string(dbus_message_iter_get_arg_type(&args)));
+		goto cleanup;
+	}
+
+	dbus_message_iter_recurse(&args, &property_iter);
+	do {
+		DBusMessageIter dict_entry, value_variant;
+		dbus_message_iter_recurse(&property_iter, &dict_entry);
+
+		if (dbus_message_iter_get_arg_type(&dict_entry) != DBUS_TYPE_STRING) {
+			dD("Expected string as key in dict_entry. Instead received: %s.", dbus_message_type_to_string(dbus_message_iter_get_arg_type(&dict_entry)));
+			goto cleanup;
+		}
+
+		_DBusBasicValue value;
+		dbus_message_iter_get_basic(&dict_entry, &value);
+		char *property_name = oscap_strdup(value.str);
+
+		if (dbus_message_iter_next(&dict_entry) == false) {
+			dW("Expected another field in dict_entry.");
+			free(property_name);
+			goto cleanup;
+		}
+
+		if (dbus_message_iter_get_arg_type(&dict_entry) != DBUS_TYPE_VARIANT) {
+			dD("Expected variant as value in dict_entry. Instead received: %s.", dbus_message_type_to_string(dbus_message_iter_get_arg_type(&dict_entry)));
+			free(property_name);
+			goto cleanup;
+		}
+
+		dbus_message_iter_recurse(&dict_entry, &value_variant);
+
+		int cbret = 0;
+		const int arg_type = dbus_message_iter_get_arg_type(&value_variant);
+		// DBUS_TYPE_ARRAY is a special case, we report each element as one value entry
+		if (arg_type == DBUS_TYPE_ARRAY) {
+			DBusMessageIter array;
+			dbus_message_iter_recurse(&value_variant, &array);
+
+			do {
+				char *element = dbus_value_to_string(&array);
+				if (element == NULL)
+					continue;
+
+				const int elementcbret = callback(property_name, element, cbarg);
+				if (elementcbret > cbret)
+					cbret = elementcbret;
+
+				free(element);
+			}
+			while (dbus_message_iter_next(&array));
+		}
+		else {
+			char *property_value = dbus_value_to_string(&value_variant);
+			cbret = callback(property_name, property_value, cbarg);
+			free(property_value);
+		}
+
+		free(property_name);
+		if (cbret != 0) {
+			goto cleanup;
+		}
+	}
+	while (dbus_message_iter_next(&property_iter));
+
+	dbus_message_unref(msg); msg = NULL;
+	ret = 0;
+
+cleanup:
+	if (pending != NULL)
+		dbus_pending_call_unref(pending);
+
+	if (msg != NULL)
+		dbus_message_unref(msg);
+
+	return ret;
+}
+
+static bool is_unit_name_a_target(const char *unit)
+{
+	const char *suffix = ".target";
+	const size_t suffix_len = strlen(suffix);
+
+	if (!unit)
+		return false;
+
+	const size_t len = strlen(unit);
+	if (suffix_len >  len)
+		return false;
+
+	return strncmp(unit + len - suffix_len, suffix, suffix_len) == 0;
+}
+
+
+/*
+ * Cache
+ */
+
+struct systemd_property {
+	char *name;
+	char *value;           /**< NULL for values of unsupported types */
+};
+
+/*
+ * The units and their dependencies are read over DBus without the lock of
+ * the cache, then installed under the lock by the first thread to finish.
+ * Another thread discards its copy. Nothing changes once it's installed,
+ * so the installed members are read without the lock.
+ */
+struct systemd_unit {
+	char *path;            /**< DBus object path, NULL if the unit can't be loaded */
+	struct systemd_property *props;
+	size_t props_count;
+	char **deps;
+	size_t deps_count;
+	bool deps_loaded;      /**< guarded by the lock of the cache */
+};
+
+struct systemd_cache {
+	unsigned int refs;     /**< guarded by systemd_lock */
+	pthread_mutex_t lock;  /**< guards the installing of the members below */
+	DBusConnection *conn;
+	char **units;
+	size_t units_count;
+	bool units_loaded;     /**< only a complete list is installed */
+	struct oscap_htable *unit_table; /**< struct systemd_unit by the unit name */
+};
+
+static pthread_mutex_t systemd_lock = PTHREAD_MUTEX_INITIALIZER;
+static systemd_cache_t *systemd_current = NULL;
+static DBusConnection *systemd_conn = NULL;
+static unsigned int systemd_users = 0;
+
+static void systemd_unit_free(void *ptr)
+{
+	struct systemd_unit *u = ptr;
+
+	if (u == NULL)
+		return;
+
+	for (size_t i = 0; i < u->props_count; ++i) {
+		free(u->props[i].name);
+		free(u->props[i].value);
+	}
+	for (size_t i = 0; i < u->deps_count; ++i)
+		free(u->deps[i]);
+	free(u->props);
+	free(u->deps);
+	free(u->path);
+	free(u);
+}
+
+static systemd_cache_t *systemd_cache_new(DBusConnection *conn)
+{
+	systemd_cache_t *cache = calloc(1, sizeof(systemd_cache_t));
+
+	if (cache == NULL)
+		return NULL;
+
+	cache->unit_table = oscap_htable_new();
+	if (cache->unit_table == NULL) {
+		free(cache);
+		return NULL;
+	}
+	pthread_mutex_init(&cache->lock, NULL);
+	cache->conn = dbus_connection_ref(conn);
+
+	return cache;
+}
+
+static void systemd_cache_free(systemd_cache_t *cache)
+{
+	dI("Systemd cache: %zu units listed.", cache->units_count);
+
+	for (size_t i = 0; i < cache->units_count; ++i)
+		free(cache->units[i]);
+	free(cache->units);
+	oscap_htable_free(cache->unit_table, systemd_unit_free);
+	pthread_mutex_destroy(&cache->lock);
+	disconnect_dbus(cache->conn);
+	free(cache);
+}
+
+systemd_cache_t *systemd_cache_get(void)
+{
+	systemd_cache_t *cache;
+
+	pthread_mutex_lock(&systemd_lock);
+	if (systemd_conn == NULL)
+		systemd_conn = connect_dbus();
+	if (systemd_current == NULL && systemd_conn != NULL) {
+		systemd_current = systemd_cache_new(systemd_conn);
+		if (systemd_current != NULL)
+			systemd_current->refs = 1; /* the cache of the current scan */
+	}
+	cache = systemd_current;
+	if (cache != NULL)
+		cache->refs++;
+	pthread_mutex_unlock(&systemd_lock);
+
+	return cache;
+}
+
+void systemd_cache_release(systemd_cache_t *cache)
+{
+	bool last;
+
+	if (cache == NULL)
+		return;
+
+	pthread_mutex_lock(&systemd_lock);
+	last = --cache->refs == 0;
+	pthread_mutex_unlock(&systemd_lock);
+
+	if (last)
+		systemd_cache_free(cache);
+}
+
+static void systemd_cache_reset_locked(void)
+{
+	systemd_cache_t *cache = systemd_current;
+
+	systemd_current = NULL;
+	if (cache != NULL && --cache->refs == 0)
+		systemd_cache_free(cache);
+}
+
+void systemd_cache_reset(void)
+{
+	pthread_mutex_lock(&systemd_lock);
+	systemd_cache_reset_locked();
+	pthread_mutex_unlock(&systemd_lock);
+}
+
+void systemd_cache_hold(void)
+{
+	pthread_mutex_lock(&systemd_lock);
+	systemd_users++;
+	pthread_mutex_unlock(&systemd_lock);
+}
+
+void systemd_cache_drop(void)
+{
+	pthread_mutex_lock(&systemd_lock);
+	if (systemd_users > 0 && --systemd_users == 0) {
+		systemd_cache_reset_locked();
+		if (systemd_conn != NULL) {
+			disconnect_dbus(systemd_conn);
+			systemd_conn = NULL;
+		}
+	}
+	pthread_mutex_unlock(&systemd_lock);
+}
+
+struct unit_list {
+	char **units;
+	size_t count;
+};
+
+static int unit_list_callback(const char *unit, void *arg)
+{
+	struct unit_list *list = arg;
+	char **units = realloc(list->units, (list->count + 1) * sizeof(char *));
+
+	if (units == NULL)
+		return 1;
+	list->units = units;
+	list->units[list->count] = oscap_strdup(unit);
+	if (list->units[list->count] == NULL)
+		return 1;
+	list->count++;
+	return 0;
+}
+
+static void unit_list_free(struct unit_list *list)
+{
+	for (size_t i = 0; i < list->count; ++i)
+		free(list->units[i]);
+	free(list->units);
+}
+
+int systemd_cache_units(systemd_cache_t *cache, int (*callback)(const char *unit, void *arg), void *arg)
+{
+	bool loaded;
+
+	pthread_mutex_lock(&cache->lock);
+	loaded = cache->units_loaded;
+	pthread_mutex_unlock(&cache->lock);
+
+	if (!loaded) {
+		struct unit_list list = { NULL, 0 };
+
+		if (get_all_systemd_units(cache->conn, unit_list_callback, &list) != 0) {
+			/*
+			 * A failed listing isn't cached, the next object asks
+			 * systemd again. The units listed so far are reported.
+			 */
+			dW("Systemd cache: listing the units failed after %zu units.", list.count);
+			for (size_t i = 0; i < list.count; ++i) {
+				if (callback(list.units[i], arg) != 0)
+					break;
+			}
+			unit_list_free(&list);
+			return -1;
+		}
+
+		pthread_mutex_lock(&cache->lock);
+		if (!cache->units_loaded) {
+			cache->units = list.units;
+			cache->units_count = list.count;
+			cache->units_loaded = true;
+			list.units = NULL;
+			list.count = 0;
+		}
+		pthread_mutex_unlock(&cache->lock);
+
+		unit_list_free(&list);
+	}
+
+	/* the list doesn't change once it's loaded */
+	for (size_t i = 0; i < cache->units_count; ++i) {
+		if (callback(cache->units[i], arg) != 0)
+			return 1;
+	}
+
+	return 0;
+}
+
+static int unit_property_callback(const char *name, const char *value, void *arg)
+{
+	struct systemd_unit *u = arg;
+	struct systemd_property *props = realloc(u->props, (u->props_count + 1) * sizeof(struct systemd_property));
+
+	if (props == NULL)
+		return 1;
+	u->props = props;
+	u->props[u->props_count].name = oscap_strdup(name);
+	u->props[u->props_count].value = oscap_strdup(value);
+	u->props_count++;
+	return 0;
+}
+
+/*
+ * Load the path of the unit and all its properties with one GetAll call.
+ */
+static struct systemd_unit *systemd_unit_load(DBusConnection *conn, const char *unit)
+{
+	struct systemd_unit *u = calloc(1, sizeof(struct systemd_unit));
+
+	if (u == NULL)
+		return NULL;
+
+	u->path = get_path_by_unit(conn, unit);
+	if (u->path != NULL)
+		get_all_properties_by_unit_path(conn, u->path, unit_property_callback, u);
+
+	return u;
+}
+
+/*
+ * Get the unit from the cache, load it on the first use.
+ */
+static struct systemd_unit *systemd_cache_unit(systemd_cache_t *cache, const char *unit)
+{
+	struct systemd_unit *u, *loaded;
+
+	pthread_mutex_lock(&cache->lock);
+	u = oscap_htable_get(cache->unit_table, unit);
+	pthread_mutex_unlock(&cache->lock);
+
+	if (u != NULL)
+		return u;
+
+	loaded = systemd_unit_load(cache->conn, unit);
+	if (loaded == NULL)
+		return NULL;
+
+	pthread_mutex_lock(&cache->lock);
+	u = oscap_htable_get(cache->unit_table, unit);
+	if (u == NULL && oscap_htable_add(cache->unit_table, unit, loaded)) {
+		u = loaded;
+		loaded = NULL;
+	}
+	pthread_mutex_unlock(&cache->lock);
+
+	/* another thread loaded the unit first */
+	systemd_unit_free(loaded);
+
+	return u;
+}
+
+int systemd_cache_unit_properties(systemd_cache_t *cache, const char *unit,
+                                  int (*callback)(const char *property, const char *value, void *arg), void *arg)
+{
+	struct systemd_unit *u = systemd_cache_unit(cache, unit);
+
+	if (u == NULL || u->path == NULL)
+		return -1;
+
+	for (size_t i = 0; i < u->props_count; ++i) {
+		if (callback(u->props[i].name, u->props[i].value, arg) != 0)
+			return 1;
+	}
+
+	return 0;
+}
+
+struct unit_dependencies {
+	char **deps;
+	size_t count;
+	struct oscap_htable *visited;
+};
+
+static void resolve_unit_dependencies(systemd_cache_t *cache, const char *unit, struct unit_dependencies *result);
+
+static void resolve_unit_property(systemd_cache_t *cache, struct systemd_unit *u, const char *property, struct unit_dependencies *result)
+{
+	for (size_t i = 0; i < u->props_count; ++i) {
+		const char *dependency = u->props[i].value;
+
+		if (strcmp(u->props[i].name, property) != 0 || dependency == NULL || *dependency == '\0')
+			continue;
+		if (oscap_htable_get(result->visited, dependency) != NULL)
+			continue;
+
+		char **deps = realloc(result->deps, (result->count + 1) * sizeof(char *));
+		if (deps == NULL)
+			return;
+		result->deps = deps;
+		result->deps[result->count] = oscap_strdup(dependency);
+		if (result->deps[result->count] == NULL)
+			return;
+		result->count++;
+		oscap_htable_add(result->visited, dependency, (void *) true);
+
+		resolve_unit_dependencies(cache, dependency, result);
+	}
+}
+
+static void resolve_unit_dependencies(systemd_cache_t *cache, const char *unit, struct unit_dependencies *result)
+{
+	if (strcmp(unit, "(null)") == 0)
+		return;
+
+	// systemctl list-dependencies only recurses into target units
+	if (!is_unit_name_a_target(unit))
+		return;
+
+	struct systemd_unit *u = systemd_cache_unit(cache, unit);
+	if (u == NULL)
+		return;
+
+	resolve_unit_property(cache, u, "Requires", result);
+	resolve_unit_property(cache, u, "Wants", result);
+}
+
+int systemd_cache_unit_dependencies(systemd_cache_t *cache, const char *unit,
+                                    int (*callback)(const char *dependency, void *arg), void *arg)
+{
+	struct systemd_unit *u;
+	bool loaded;
+
+	/*
+	 * Non-target units have no dependencies to report, don't load them.
+	 * The dependencies of a target are resolved once and stored with it.
+	 */
+	if (!is_unit_name_a_target(unit))
+		return 0;
+
+	u = systemd_cache_unit(cache, unit);
+	if (u == NULL)
+		return 0;
+
+	pthread_mutex_lock(&cache->lock);
+	loaded = u->deps_loaded;
+	pthread_mutex_unlock(&cache->lock);
+
+	if (!loaded) {
+		struct unit_dependencies result = { .visited = oscap_htable_new() };
+
+		if (result.visited != NULL) {
+			resolve_unit_dependencies(cache, unit, &result);
+			oscap_htable_free(result.visited, NULL);
+		}
+
+		pthread_mutex_lock(&cache->lock);
+		if (!u->deps_loaded) {
+			u->deps = result.deps;
+			u->deps_count = result.count;
+			u->deps_loaded = true;
+			result.deps = NULL;
+			result.count = 0;
+		}
+		pthread_mutex_unlock(&cache->lock);
+
+		for (size_t i = 0; i < result.count; ++i)
+			free(result.deps[i]);
+		free(result.deps);
+	}
+
+	for (size_t i = 0; i < u->deps_count; ++i) {
+		if (callback(u->deps[i], arg) != 0)
+			return 1;
+	}
+
+	return 0;
+}
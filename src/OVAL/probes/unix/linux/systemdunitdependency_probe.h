@@ -25,6 +25,9 @@
 
 #include "probe-api.h"
 
+void *systemdunitdependency_probe_init(void);
 int systemdunitdependency_probe_main(probe_ctx *ctx, void *arg);
+void systemdunitdependency_probe_fini(void *arg);
+void systemdunitdependency_probe_reset(void *arg);
 
 #endif /* OPENSCAP_SYSTEMDUNITDEPENDENCY_PROBE_H */
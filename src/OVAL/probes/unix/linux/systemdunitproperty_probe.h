@@ -25,6 +25,9 @@
 
 #include "probe-api.h"
 
+void *systemdunitproperty_probe_init(void);
 int systemdunitproperty_probe_main(probe_ctx *ctx, void *arg);
+void systemdunitproperty_probe_fini(void *arg);
+void systemdunitproperty_probe_reset(void *arg);
 
 #endif /* OPENSCAP_SYSTEMDUNITPROPERTY_PROBE_H */
@@ -100,12 +100,10 @@ extern char const *_cap_names[];
 #include "probe/entcmp.h"
 #include "common/debug_priv.h"
 #include <ctype.h>
-#include "common/oscap_buffer.h"
+#include "probe/proctable.h"
 #include "process58_probe.h"
 #include "oscap_helpers.h"
 
-#define CHUNK_SIZE 1024
-
 /* Convenience structure for the results being reported */
 struct result_info {
         const char *command_line;
@@ -154,69 +152,12 @@ static void report_finding(struct result_info *res, probe_ctx *ctx)
 
 static unsigned long ticks, boot;
 
-static void get_boot_time(void)
+static void get_uids(probe_proctable_t *table, probe_proc_t *proc, struct result_info *r)
 {
-	char buf[100];
-	FILE *sf;
-	int line;
-
-	boot = 0;
-	sf = fopen("/proc/stat", "rt");
-	if (sf == NULL)
-		return;
-
-	line = 0;
-	__fsetlocking(sf, FSETLOCKING_BYCALLER);
-	while (fgets(buf, sizeof(buf), sf)) {
-		if (line == 0) {
-			line++;
-			continue;
-		}
-		if (memcmp(buf, "btime", 5) == 0) {
-			sscanf(buf, "btime %lu", &boot);
-			break;
-		}
-	}
-	fclose(sf);
-}
-
-static int get_uids(int pid, struct result_info *r)
-{
-	char buf[100];
-	FILE *sf;
-
-	r->ruid = -1;
-	r->user_id = -1;
-	r->loginuid = -1;
-
-	snprintf(buf, sizeof(buf), "/proc/%d/status", pid);
-	sf = fopen(buf, "rt");
-	if (sf) {
-		int line = 0;
-		__fsetlocking(sf, FSETLOCKING_BYCALLER);
-		while (fgets(buf, sizeof(buf), sf)) {
-			if (line == 0) {
-				line++;
-				continue;
-			}
-			if (memcmp(buf, "Uid:", 4) == 0) {
-				sscanf(buf, "Uid: %d %d", &r->ruid, &r->user_id);
-				break;
-			}
-		}
-		fclose(sf);
-	}
-
-	snprintf(buf, sizeof(buf), "/proc/%d/loginuid", pid);
-	sf = fopen(buf, "rt");
-	if (sf) {
-		if (fscanf(sf, "%u", &r->loginuid) < 1) {
-			dW("fscanf failed from %s", buf);
-		}
-		fclose(sf);
-	}
-
-	return 0;
+	probe_proctable_load(table, proc, PROBE_PROC_STATUS | PROBE_PROC_LOGINUID);
+	r->ruid = proc->ruid;
+	r->user_id = proc->euid;
+	r->loginuid = proc->loginuid;
 }
 
 static char *convert_time(unsigned long long t, char *tbuf, int tb_size)
@@ -238,70 +179,51 @@ static char *convert_time(unsigned long long t, char *tbuf, int tb_size)
 }
 
 #ifdef SELINUX_FOUND
-static char *get_selinux_label(int pid) {
+static char *get_selinux_label(probe_proctable_t *table, probe_proc_t *proc) {
 	char *selinux_label;
-	security_context_t pid_context;
 	context_t context;
 
 	if (is_selinux_enabled() == 1) {
-		if (getpidcon(pid, &pid_context) == -1) {
+		probe_proctable_load(table, proc, PROBE_PROC_SELINUX);
+		if (proc->selinux_label == NULL) {
 			/* error getting pid selinux context */
-			dW("Can't get selinux context for process %d", pid);
+			dW("Can't get selinux context for process %d", proc->pid);
 			return NULL;
 		}
-		context = context_new(pid_context);
+		context = context_new(proc->selinux_label);
 		if (context == NULL) {
 			// There must be 3 or 4 colon-separated components and no
 			// whitespace in any component other than the MLS
 			// component.
-			freecon(pid_context);
 			return NULL;
 		}
 		selinux_label = strdup(context_type_get(context));
 		context_free(context);
-		freecon(pid_context);
 		return selinux_label;
 	} else {
 		return NULL;
 	}
 }
 #else
-static char *get_selinux_label(int pid) {
+static char *get_selinux_label(probe_proctable_t *table, probe_proc_t *proc) {
 	return NULL;
 }
 #endif /* SELINUX_FOUND */
 
-static char **get_posix_capability(int pid, int max_cap_id) {
+static char **get_posix_capability(probe_proctable_t *table, probe_proc_t *proc, int max_cap_id) {
 #ifdef CAP_FOUND
-	cap_t pid_caps;
 	char *cap_name, **ret = NULL;
 	unsigned cap_value, ret_index = 0;
-	cap_flag_value_t cap_flag;
 	int cap_id;
 
-#if LIBCAP_VERSION == 1
-	pid_caps = cap_init();
-	if (capgetp(pid, pid_caps) == -1) {
-		dW("Can't get capabilities for process %d", pid);
-		cap_free(pid_caps);
+	probe_proctable_load(table, proc, PROBE_PROC_STATUS);
+	if (!proc->cap_eff_known) {
+		dW("Can't get capabilities for process %d", proc->pid);
 		return NULL;
 	}
-#elif LIBCAP_VERSION == 2
-	pid_caps = cap_get_pid(pid);
-#else
-	dW("Can't detect libcap version");
-	return NULL;
-#endif
 
-	if (pid_caps == NULL) {
-		dW("Can't get capabilities for process %d", pid);
-		return NULL;
-	}
-
-	for (cap_value = 0; cap_value < CAP_LAST_CAP; cap_value++) {
-		if (cap_get_flag(pid_caps, cap_value, CAP_EFFECTIVE, &cap_flag) == -1)
-			continue;
-		if (cap_flag == CAP_SET) {
+	for (cap_value = 0; cap_value < CAP_LAST_CAP && cap_value < 64; cap_value++) {
+		if (proc->cap_eff & (UINT64_C(1) << cap_value)) {
 #if LIBCAP_VERSION == 2
 			cap_name = cap_to_name(cap_value);
 #else
@@ -327,139 +249,26 @@ static char **get_posix_capability(int pid, int max_cap_id) {
 	ret = realloc(ret, (ret_index + 1) * sizeof(char *));
 	ret[ret_index] = NULL;
 
-	cap_free(pid_caps);
 	return ret;
 #else
 	return NULL;
 #endif
 }
 
-/* get exec shield status according to http://people.redhat.com/sgrubb/files/lsexec
- * return value: -1 - not detected, 0 - disabled, 1 - enabled */
-static int get_exec_shield_status(int pid) {
-	char buf[501];
-	FILE *sf;
-	long unsigned low, high, inode;
-	long long unsigned offset;
-	int dev_min, dev_maj;
-	char perm[3], trim;
-	int ret = -1, read_items;
-
-	snprintf(buf, sizeof(buf), "/proc/%d/maps", pid);
-	sf = fopen(buf, "rt");
-	if (sf) {
-		while (fgets(buf, 500, sf)) {
-			read_items = sscanf(
-				buf, "%lx-%lx rw%s %llx %x:%x %lu %c\n",
-				&low, &high, perm, &offset, &dev_min,
-				&dev_maj, &inode, &trim
-			);
-			if (read_items == 7) {
-				if (perm[0] == 'x' && offset != 0) {
-					ret = 0;
-				}
-				else {
-					ret = 1;
-				}
-			}
-		}
-		fclose(sf);
-	}
-
-	return ret;
-}
-
-/**
- * Parse /proc/%d/cmdline file
- * @param filepath Path to file ~ use preallocated buffer for the path
- * @param buffer output buffer with non-zero size
- * @return ps-like command info or NULL
- */
-static inline bool get_process_cmdline(const char* filepath, struct oscap_buffer* const buffer){
-
-	int fd = open(filepath, O_RDONLY, 0);
-
-	if (fd < 0) {
-		return false;
-	}
-
-	oscap_buffer_clear(buffer);
-
-
-
-	for(;;) {
-		char chunk[CHUNK_SIZE];
-		// Read data, store to buffer
-		ssize_t read_size = read(fd, chunk, CHUNK_SIZE);
-		if (read_size < 0) {
-			close(fd);
-			return false;
-		}
-		oscap_buffer_append_binary_data(buffer, chunk, read_size);
-
-		// If reach end of file, then end the loop
-		if (CHUNK_SIZE != read_size) {
-			break;
-		}
-	}
-
-	close(fd);
-
-	int length = oscap_buffer_get_length(buffer);
-	char* buffer_mem = oscap_buffer_get_raw(buffer);
-
-	if ( length == 0 ) { // empty file
-		return false;
-	} else {
-
-		// Skip multiple trailing zeros
-		int i = length - 1;
-		while ( (i > 0) && (buffer_mem[i] == '\0') ) {
-			--i;
-		}
-
-		// Program and args are separated by '\0'
-		// Replace them with spaces ' '
-		while( i >= 0 ){
-			char chr = buffer_mem[i];
-			if ( ( chr == '\0') || ( chr == '\n' ) ) {
-				buffer_mem[i] = ' ';
-			} else if ( !isprint(chr) ) { // "ps" replace non-printable characters with '.' (LC_ALL=C)
-				buffer_mem[i] = '.';
-			}
-			--i;
-		}
-	}
-	return true;
-}
-
-/**
- * Make "[%s] <defunct>" from cmd string - inplace
- * @param cmd_buffer @see read_process() > cmd_buffer
- * @return pointer to start of string
- */
-static inline char *make_defunc_str(char* const cmd_buffer){
-	static const char DEFUNC_STR[] = "] <defunct>";
-
-	size_t len = strlen(cmd_buffer);
-	memcpy(cmd_buffer + len, DEFUNC_STR, sizeof(DEFUNC_STR));
-	return cmd_buffer;
-}
-
 static int read_process(SEXP_t *cmd_ent, SEXP_t *pid_ent, probe_ctx *ctx)
 {
 	int err = 1, max_cap_id;
-	DIR *d;
-	struct dirent *ent;
+	probe_proctable_t *table;
+	size_t i, count;
 	oval_schema_version_t oval_version;
 
-	d = opendir("/proc");
-	if (d == NULL)
+	table = probe_proctable_get();
+	if (table == NULL)
 		return err;
 
 	// Get the time tick hertz
 	ticks = (unsigned long)sysconf(_SC_CLK_TCK);
-	get_boot_time();
+	boot = probe_proctable_boot_time(table);
 
 	oval_version = probe_obj_get_platform_schema_version(probe_ctx_getobject(ctx));
 	if (oval_schema_version_cmp(oval_version, OVAL_SCHEMA_VERSION(5.11)) < 0) {
@@ -468,71 +277,34 @@ static int read_process(SEXP_t *cmd_ent, SEXP_t *pid_ent, probe_ctx *ctx)
 		max_cap_id = OVAL_5_11_MAX_CAP_ID;
 	}
 
-	struct oscap_buffer *cmdline_buffer = oscap_buffer_new();
-	
 	char cmd_buffer[1 + 15 + 11 + 1]; // Format:" [ cmd:15 ] <defunc>"
-	cmd_buffer[0] = '[';
 
-	// Scan the directories
-	while (( ent = readdir(d) )) {
-		int fd, len;
-		char buf[256];
-		char *tmp, state, tty_dev[128];
-		int pid, ppid, pgrp, session, tty_nr, tpgid;
-		unsigned flags, sched_policy;
-		unsigned long minflt, cminflt, majflt, cmajflt, uutime, ustime;
-		long cutime, cstime, priority, cnice, nthreads, itrealvalue;
-		unsigned long long start;
+	// Scan the processes
+	count = probe_proctable_count(table);
+	for (i = 0; i < count; ++i) {
+		probe_proc_t *p = probe_proctable_at(table, i);
+		char tty_dev[128];
+		unsigned sched_policy;
 		SEXP_t *cmd_sexp = NULL, *pid_sexp = NULL;
 
-		// Skip non-process58 dir entries
-		if(*ent->d_name<'0' || *ent->d_name>'9')
+		// Skip the processes whose stat file wasn't read
+		if (!(p->loaded & PROBE_PROC_STAT))
 			continue;
-		errno = 0;
-		pid = strtol(ent->d_name, NULL, 10);
-		if (errno || pid == 2) // skip err & kthreads
-			continue;
-
-		// Parse up the stat file for the proc
-		snprintf(buf, 32, "/proc/%d/stat", pid);
-		fd = open(buf, O_RDONLY, 0);
-		if (fd < 0)
-			continue;
-		len = read(fd, buf, sizeof buf - 1);
-		close(fd);
-		if (len < 40)
-			continue;
-		buf[len] = 0;
-		tmp = strrchr(buf, ')');
-		if (tmp)
-			*tmp = 0;
-		else
-			continue;
-		memset(cmd_buffer + 1, 0, sizeof(cmd_buffer)-1); // clear cmd after starting '['
-		sscanf(buf, "%d (%15c", &ppid, cmd_buffer + 1);
-		sscanf(tmp+2,	"%c %d %d %d %d %d "
-				"%u %lu %lu %lu %lu "
-				"%lu %lu %lu %ld %ld "
-				"%ld %ld %ld %llu",
-			&state, &ppid, &pgrp, &session, &tty_nr, &tpgid,
-			&flags, &minflt, &cminflt, &majflt, &cmajflt,
-			&uutime, &ustime, &cutime, &cstime, &priority,
-			&cnice, &nthreads, &itrealvalue, &start
-		);
 
 		// Skip kthreads
-		if (ppid == 2)
+		if (p->pid == 2 || p->ppid == 2)
 			continue;
 
 		const char* cmd;
-		if (state == 'Z') { // zombie
-			cmd = make_defunc_str(cmd_buffer);
+		if (p->state == 'Z') { // zombie
+			snprintf(cmd_buffer, sizeof(cmd_buffer), "[%s] <defunct>", p->comm);
+			cmd = cmd_buffer;
 		} else {
-			snprintf(buf, 32, "/proc/%d/cmdline", pid);
-			if (get_process_cmdline(buf, cmdline_buffer)) {
-				cmd = oscap_buffer_get_raw(cmdline_buffer); // use full cmdline
+			probe_proctable_load(table, p, PROBE_PROC_CMDLINE);
+			if (p->cmdline != NULL) {
+				cmd = p->cmdline; // use full cmdline
 			} else {
-				cmd = cmd_buffer + 1;
+				cmd = p->comm;
 			}
 		}
 
@@ -540,12 +312,12 @@ static int read_process(SEXP_t *cmd_ent, SEXP_t *pid_ent, probe_ctx *ctx)
 		err = 0; // If we get this far, no permission problems
 		dI("Have command: %s", cmd);
 		cmd_sexp = SEXP_string_newf("%s", cmd);
-		pid_sexp = SEXP_number_newu_32(pid);
+		pid_sexp = SEXP_number_newu_32(p->pid);
 		if ((cmd_sexp == NULL || probe_entobj_cmp(cmd_ent, cmd_sexp) == OVAL_RESULT_TRUE) &&
 		    (pid_sexp == NULL || probe_entobj_cmp(pid_ent, pid_sexp) == OVAL_RESULT_TRUE)
 		) {
 			struct result_info r;
-			unsigned long t = uutime/ticks + ustime/ticks;
+			unsigned long t = p->utime/ticks + p->stime/ticks;
 			char tbuf[32], sbuf[32], *selinux_domain_label, **posix_capabilities;
 			int tday,tyear;
 			time_t s_time;
@@ -553,7 +325,7 @@ static int read_process(SEXP_t *cmd_ent, SEXP_t *pid_ent, probe_ctx *ctx)
 			const char *fmt;
 
 			// Now get scheduler policy
-			sched_policy = sched_getscheduler(pid);
+			sched_policy = sched_getscheduler(p->pid);
 			switch (sched_policy) {
 				case SCHED_OTHER:
 					r.scheduling_class = "TS";
@@ -582,7 +354,7 @@ static int read_process(SEXP_t *cmd_ent, SEXP_t *pid_ent, probe_ctx *ctx)
 			now = localtime(&s_time);
 			tyear = now->tm_year;
 			tday = now->tm_yday;
-			s_time = boot + (start / ticks);
+			s_time = boot + (p->start / ticks);
 			proc = localtime(&s_time);
 
 			// Select format based on how long we've been running
@@ -600,25 +372,26 @@ static int read_process(SEXP_t *cmd_ent, SEXP_t *pid_ent, probe_ctx *ctx)
 
 			r.command_line = cmd;
 			r.exec_time = convert_time(t, tbuf, sizeof(tbuf));
-			r.pid = pid;
-			r.ppid = ppid;
-			r.priority = priority;
+			r.pid = p->pid;
+			r.ppid = p->ppid;
+			r.priority = p->priority;
 			r.start_time = sbuf;
 
-			dev_to_tty(tty_dev, sizeof(tty_dev), (dev_t) tty_nr, pid, ABBREV_DEV);
+			dev_to_tty(tty_dev, sizeof(tty_dev), (dev_t) p->tty_nr, p->pid, ABBREV_DEV);
 			r.tty = tty_dev;
 
-			r.exec_shield = (get_exec_shield_status(pid) > 0);
+			probe_proctable_load(table, p, PROBE_PROC_MAPS);
+			r.exec_shield = (p->exec_shield > 0);
 
-			selinux_domain_label = get_selinux_label(pid);
+			selinux_domain_label = get_selinux_label(table, p);
 			r.selinux_domain_label = selinux_domain_label;
 
-			posix_capabilities = get_posix_capability(pid, max_cap_id);
+			posix_capabilities = get_posix_capability(table, p, max_cap_id);
 			r.posix_capability = posix_capabilities;
 
-			r.session_id = session;
+			r.session_id = p->session;
 
-			get_uids(pid, &r);
+			get_uids(table, p, &r);
 			report_finding(&r, ctx);
 
 			if (selinux_domain_label != NULL)
@@ -634,8 +407,7 @@ static int read_process(SEXP_t *cmd_ent, SEXP_t *pid_ent, probe_ctx *ctx)
 		SEXP_free(cmd_sexp);
 		SEXP_free(pid_sexp);
 	}
-        closedir(d);
-	oscap_buffer_free(cmdline_buffer);
+	probe_proctable_release(table);
 	return err;
 }
 
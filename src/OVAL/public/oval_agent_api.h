@@ -73,6 +73,17 @@ OSCAP_API struct oval_definition_model* oval_agent_get_definition_model(oval_age
  */
 OSCAP_API void oval_agent_set_product_name(oval_agent_session_t *, char *);
 
+/**
+ * Set number of worker threads used by \ref oval_agent_eval_system to
+ * evaluate the definitions. Objects are still collected before the
+ * evaluation starts and the callback is called from the calling thread
+ * in the order of the definitions, the results are the same as with
+ * the serial evaluation.
+ * @param ag_sess an agent session
+ * @param jobs number of worker threads, 0 or 1 (default) means serial evaluation
+ */
+OSCAP_API void oval_agent_set_jobs(oval_agent_session_t *ag_sess, unsigned int jobs);
+
 /**
  * Probe the system and evaluate specified definition
  * @return 0 on success; -1 error; 1 warning
@@ -153,6 +153,16 @@ OSCAP_API void oval_session_set_report_export(struct oval_session *session, cons
  */
 OSCAP_API void oval_session_set_xml_reporter(struct oval_session *session, xml_reporter fn);
 
+/**
+ * Set number of worker threads used by \ref oval_session_evaluate to
+ * evaluate the OVAL Definitions.
+ *
+ * @memberof oval_session
+ * @param session an \ref oval_session
+ * @param jobs number of worker threads, 0 or 1 (default) means serial evaluation
+ */
+OSCAP_API void oval_session_set_jobs(struct oval_session *session, unsigned int jobs);
+
 /**
  * Load OVAL Definitions and bind OVAL Variables to it if provided. Validation
  * if performed automatically if you've set it with \ref
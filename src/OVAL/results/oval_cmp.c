@@ -94,6 +94,11 @@ __attribute__((nonnull(1,2))) static bool cstr_to_double(const char *cstr, doubl
 	return true;
 }
 
+static inline bool cstr_to_bool(const char *cstr)
+{
+	return strcmp(cstr, "true") == 0 || strcmp(cstr, "1") == 0;
+}
+
 oval_result_t oval_str_cmp_str(char *state_data, oval_datatype_t state_data_type, const char *sys_data, oval_operation_t operation)
 {
 	// finally, we have gotten to the point of comparing system data with a state
@@ -135,11 +140,7 @@ oval_result_t oval_str_cmp_str(char *state_data, oval_datatype_t state_data_type
 		}
 		return oval_float_cmp(state_val, sys_val, operation);
 	} else if (state_data_type == OVAL_DATATYPE_BOOLEAN) {
-		int state_int;
-		int sys_int;
-		state_int = (((strcmp(state_data, "true")) == 0) || ((strcmp(state_data, "1")) == 0)) ? 1 : 0;
-		sys_int = (((strcmp(sys_data, "true")) == 0) || ((strcmp(sys_data, "1")) == 0)) ? 1 : 0;
-		return oval_boolean_cmp(state_int, sys_int, operation);
+		return oval_boolean_cmp(cstr_to_bool(state_data), cstr_to_bool(sys_data), operation);
 	} else if (state_data_type == OVAL_DATATYPE_BINARY) {
 		return oval_binary_cmp(state_data, sys_data, operation);
 	} else if (state_data_type == OVAL_DATATYPE_EVR_STRING) {
@@ -167,3 +168,62 @@ oval_result_t oval_ent_cmp_str(char *state_data, oval_datatype_t state_data_type
 	const char *sys_data = oval_sysent_get_value(sysent);
 	return oval_str_cmp_str(state_data, state_data_type, sys_data, operation);
 }
+
+void oval_cmp_operand_init(struct oval_cmp_operand *operand, char *text, oval_datatype_t datatype)
+{
+	operand->text = text;
+	operand->datatype = datatype;
+	operand->parsed = false;
+
+	/* Values which can't be converted are compared by oval_str_cmp_str()
+	 * which reports the error for every comparison, as before. */
+	switch (datatype) {
+	case OVAL_DATATYPE_INTEGER:
+		operand->parsed = cstr_to_intmax(text, &operand->value.integer);
+		break;
+	case OVAL_DATATYPE_FLOAT:
+		operand->parsed = cstr_to_double(text, &operand->value.real);
+		break;
+	case OVAL_DATATYPE_BOOLEAN:
+		operand->value.boolean = cstr_to_bool(text);
+		operand->parsed = true;
+		break;
+	default:
+		break;
+	}
+}
+
+oval_result_t oval_operand_cmp_str(const struct oval_cmp_operand *operand, const char *sys_data, oval_operation_t operation)
+{
+	if (!operand->parsed)
+		return oval_str_cmp_str(operand->text, operand->datatype, sys_data, operation);
+
+	switch (operand->datatype) {
+	case OVAL_DATATYPE_INTEGER: {
+		intmax_t syschar_val;
+
+		if (!cstr_to_intmax(sys_data, &syschar_val)) {
+			oscap_seterr(OSCAP_EFAMILY_OVAL,
+				"Conversion of the string \"%s\" to an integer (%u bits) failed: %s",
+				sys_data, sizeof(intmax_t)*8, strerror(errno));
+			return OVAL_RESULT_ERROR;
+		}
+		return oval_int_cmp(operand->value.integer, syschar_val, operation);
+	}
+	case OVAL_DATATYPE_FLOAT: {
+		double sys_val;
+
+		if (!cstr_to_double(sys_data, &sys_val)) {
+			oscap_seterr(OSCAP_EFAMILY_OVAL,
+				"Conversion of the string \"%s\" to a floating type (double) failed: %s",
+				sys_data, strerror(errno));
+			return OVAL_RESULT_ERROR;
+		}
+		return oval_float_cmp(operand->value.real, sys_val, operation);
+	}
+	case OVAL_DATATYPE_BOOLEAN:
+		return oval_boolean_cmp(operand->value.boolean, cstr_to_bool(sys_data), operation);
+	default:
+		return oval_str_cmp_str(operand->text, operand->datatype, sys_data, operation);
+	}
+}
@@ -23,6 +23,7 @@
 #ifndef OSCAP_OVAL_CMP_IMPL_H_
 #define OSCAP_OVAL_CMP_IMPL_H_
 
+#include <stdint.h>
 #include "../common/util.h"
 #include "oval_definitions.h"
 #include "oval_types.h"
@@ -50,5 +51,31 @@ oval_result_t oval_ent_cmp_str(char *state_data, oval_datatype_t state_data_type
  */
 oval_result_t oval_str_cmp_str(char *state_data, oval_datatype_t state_data_type, const char *sys_data, oval_operation_t operation);
 
+/**
+ * State value (or variable value) prepared for repeated comparisons with
+ * the collected data. Integer, float and boolean values are converted
+ * only once, when the operand is initialized.
+ */
+struct oval_cmp_operand {
+	char *text;
+	oval_datatype_t datatype;
+	bool parsed;
+	union {
+		intmax_t integer;
+		double real;
+		bool boolean;
+	} value;
+};
+
+/**
+ * Prepare the operand. The text isn't copied, it has to outlive the operand.
+ */
+void oval_cmp_operand_init(struct oval_cmp_operand *operand, char *text, oval_datatype_t datatype);
+
+/**
+ * Same as oval_str_cmp_str(), but with a prepared state value.
+ */
+oval_result_t oval_operand_cmp_str(const struct oval_cmp_operand *operand, const char *sys_data, oval_operation_t operation);
+
 
 #endif
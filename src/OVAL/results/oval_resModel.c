@@ -249,7 +249,8 @@ int oval_results_model_eval(struct oval_results_model *res_model)
 
 static xmlNode *oval_results_to_dom(struct oval_results_model *results_model,
 				    struct oval_directives_model *directives_model, 
-				    xmlDocPtr doc, xmlNode * parent)
+				    xmlDocPtr doc, xmlNode * parent,
+				    struct oscap_xml_stream *stream)
 {
 	xmlNode *root_node;
 	struct oval_result_directives * dirs;
@@ -285,15 +286,23 @@ static xmlNode *oval_results_to_dom(struct oval_results_model *results_model,
 		oval_definition_model_to_dom(definition_model, doc, root_node);
 	}
 
+	/* The definitions may declare additional namespaces on the root element,
+	 * so the start tag can't be written any sooner. */
+	oscap_xml_stream_start_element(stream, root_node);
+	oscap_xml_stream_flush(stream, root_node);
+
 	xmlNode *results_node = xmlNewTextChild(root_node, ns_results, BAD_CAST "results", NULL);
+	oscap_xml_stream_start_element(stream, results_node);
 	struct oval_result_system_iterator *systems = oval_results_model_get_systems(results_model);
 	while (oval_result_system_iterator_has_more(systems)) {
 		struct oval_result_system *sys = oval_result_system_iterator_next(systems);
-		oval_result_system_to_dom(sys, results_model, dirs_model, doc, results_node);
+		oval_result_system_to_dom(sys, results_model, dirs_model, doc, results_node, stream);
 	}
 	oval_result_system_iterator_free(systems);
+	oscap_xml_stream_end_element(stream, results_node);
 
-	return root_node;
+	oscap_xml_stream_end_element(stream, root_node);
+	return stream ? NULL : root_node;
 }
 
 struct oscap_source *oval_results_model_export_source(struct oval_results_model *results_model, struct oval_directives_model *directives_model, const char *name)
@@ -306,7 +315,7 @@ struct oscap_source *oval_results_model_export_source(struct oval_results_model
 		return NULL;
 	}
 
-	oval_results_to_dom(results_model, directives_model, doc, NULL);
+	oval_results_to_dom(results_model, directives_model, doc, NULL, NULL);
 	return oscap_source_new_from_xmlDoc(doc, name);
 }
 
@@ -314,13 +323,25 @@ int oval_results_model_export(struct oval_results_model *results_model,
 			      struct oval_directives_model *directives_model,
 			      const char *file)
 {
-	struct oscap_source *source = oval_results_model_export_source(results_model, directives_model, file);
-	if (source == NULL) {
+	__attribute__nonnull__(results_model);
+
+	xmlDocPtr doc = xmlNewDoc(BAD_CAST "1.0");
+	if (doc == NULL) {
+		oscap_setxmlerr(xmlGetLastError());
 		return -1;
 	}
-	int ret = oscap_source_save_as(source, NULL);
-	oscap_source_free(source);
-	return ret;
+
+	/* Tests and items are written out as soon as they are serialized,
+	 * the whole document is never kept in memory. */
+	struct oscap_xml_stream *stream = oscap_xml_stream_new(file);
+	if (stream == NULL) {
+		xmlFreeDoc(doc);
+		return -1;
+	}
+
+	oval_results_to_dom(results_model, directives_model, doc, NULL, stream);
+	xmlFreeDoc(doc);
+	return oscap_xml_stream_free(stream) == 1 ? 0 : -1;
 }
 
 int oval_results_model_parse(xmlTextReaderPtr reader, struct oval_parser_context *context) {
@@ -35,6 +35,7 @@
 #include <stdlib.h>
 #include <stdio.h>
 #include <string.h>
+#include <pthread.h>
 
 #include "oval_agent_api_impl.h"
 #include "results/oval_results_impl.h"
@@ -42,6 +43,7 @@
 #include "public/oval_agent_api.h"
 #include "common/util.h"
 #include "common/debug_priv.h"
+#include "common/profiler_priv.h"
 
 typedef struct oval_result_definition {
 	struct oval_definition *definition;
@@ -51,6 +53,7 @@ typedef struct oval_result_definition {
 	struct oval_collection *messages;
 	int instance;
 	int variable_instance_hint;			///< A next possible variable_instance attribute
+	pthread_mutex_t lock;				///< Held while the definition is evaluated
 } oval_result_definition_t;
 
 struct oval_result_definition *oval_result_definition_new(struct oval_result_system *sys, char *definition_id) {
@@ -68,6 +71,7 @@ struct oval_result_definition *oval_result_definition_new(struct oval_result_sys
 	definition->messages = oval_collection_new();
 	definition->variable_instance_hint = 1;
 	definition->instance = 1;
+	pthread_mutex_init(&definition->lock, NULL);
 	return definition;
 }
 
@@ -110,6 +114,7 @@ void oval_result_definition_free(struct oval_result_definition *definition)
 	definition->messages = NULL;
 	definition->result = OVAL_RESULT_NOT_EVALUATED;
 	definition->instance = 1;
+	pthread_mutex_destroy(&definition->lock);
 	free(definition);
 }
 
@@ -151,17 +156,28 @@ oval_result_t oval_result_definition_eval(struct oval_result_definition * defini
 	const char *title = oval_definition_get_title(oval_result_definition_get_definition(definition));
 	dI("Evaluating definition '%s': %s.", id, title);
 
+	/* Other threads may evaluate the same definition, e.g. when it is
+	 * extended by several definitions. Extended definitions are locked
+	 * after the extending ones, the extend_definition references
+	 * can't form a cycle. */
+	pthread_mutex_lock(&definition->lock);
 	if (definition->result == OVAL_RESULT_NOT_EVALUATED) {
 		struct oval_result_criteria_node *criteria = oval_result_definition_get_criteria(definition);
 		if (criteria != NULL) {
+			oscap_prof_timer_t timer;
+
+			oscap_prof_start(&timer);
 			dIndent(1);
 			definition->result = oval_result_criteria_node_eval(criteria);
 			dIndent(-1);
+			oscap_prof_stop(&timer, OSCAP_PROF_DEFINITION, id, 0);
 		}
 	}
+	oval_result_t result = definition->result;
+	pthread_mutex_unlock(&definition->lock);
 
-	dI("Definition '%s' evaluated as %s.", id, oval_result_get_text(definition->result));
-	return definition->result;
+	dI("Definition '%s' evaluated as %s.", id, oval_result_get_text(result));
+	return result;
 }
 
 oval_result_t oval_result_definition_get_result(const struct oval_result_definition * definition)
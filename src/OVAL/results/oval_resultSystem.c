@@ -36,6 +36,7 @@
 #include <stdlib.h>
 #include <stdio.h>
 #include <string.h>
+#include <pthread.h>
 
 #include "oval_definitions.h"
 #include "oval_agent_api.h"
@@ -56,6 +57,8 @@ typedef struct oval_result_system {
 	struct oval_smc *definitions;			///< Map contains lists of oval_result_definition
 	struct oval_smc *tests;				///< Map contains lists of oval_result_test
 	struct oval_syschar_model *syschar_model;
+	struct oval_string_map *state_plans;		///< Evaluation plans of states by state id
+	pthread_mutex_t lock;				///< Serializes the changes of shared data during the evaluation
 } oval_result_system_t;
 
 
@@ -115,7 +118,9 @@ struct oval_result_system *oval_result_system_new(struct oval_results_model *mod
 	sys->definitions = oval_smc_new();
 	sys->tests = oval_smc_new();
 	sys->syschar_model = syschar_model;
+	sys->state_plans = oval_string_map_new();
 	sys->model = model;
+	pthread_mutex_init(&sys->lock, NULL);
 
 	oval_results_model_add_system(model, sys);
 
@@ -144,10 +149,13 @@ void oval_result_system_free(struct oval_result_system *sys)
 
 	oval_smc_free(sys->definitions, (oscap_destruct_func) oval_result_definition_free);
 	oval_smc_free(sys->tests, (oscap_destruct_func) oval_result_test_free);
+	oval_string_map_free(sys->state_plans, (oscap_destruct_func) oval_state_plan_free);
 
 	sys->definitions = NULL;
 	sys->syschar_model = NULL;
 	sys->tests = NULL;
+	sys->state_plans = NULL;
+	pthread_mutex_destroy(&sys->lock);
 
 	free(sys);
 }
@@ -235,6 +243,35 @@ struct oval_result_test *oval_result_system_get_new_test(struct oval_result_syst
 	return rslt_testtest;
 }
 
+struct oval_state_plan *oval_result_system_get_state_plan(struct oval_result_system *sys, struct oval_state *state)
+{
+	__attribute__nonnull__(sys);
+
+	const char *id = oval_state_get_id(state);
+	oval_result_system_lock(sys);
+	struct oval_state_plan *plan = oval_string_map_get_value(sys->state_plans, id);
+	if (plan == NULL) {
+		plan = oval_state_plan_new(state);
+		oval_string_map_put(sys->state_plans, id, plan);
+	}
+	oval_result_system_unlock(sys);
+	return plan;
+}
+
+void oval_result_system_lock(struct oval_result_system *sys)
+{
+	__attribute__nonnull__(sys);
+
+	pthread_mutex_lock(&sys->lock);
+}
+
+void oval_result_system_unlock(struct oval_result_system *sys)
+{
+	__attribute__nonnull__(sys);
+
+	pthread_mutex_unlock(&sys->lock);
+}
+
 struct oval_results_model *oval_result_system_get_results_model(struct oval_result_system *sys) {
 	__attribute__nonnull__(sys);
 
@@ -262,6 +299,16 @@ void oval_result_system_add_definition(struct oval_result_system *sys, struct ov
 	}
 }
 
+void oval_result_system_drop_definition(struct oval_result_system *sys, struct oval_result_definition *definition)
+{
+	__attribute__nonnull__(sys);
+	if (definition) {
+		const char *id = oval_result_definition_get_id(definition);
+		if (oval_smc_remove(sys->definitions, id, definition))
+			oval_result_definition_free(definition);
+	}
+}
+
 void oval_result_system_add_test(struct oval_result_system *sys, struct oval_result_test *test) 
 {
 	__attribute__nonnull__(sys);
@@ -415,7 +462,8 @@ static void _oval_result_definition_to_dom_based_on_directives(struct oval_resul
 xmlNode *oval_result_system_to_dom(struct oval_result_system * sys,
 				   struct oval_results_model * results_model,
 				   struct oval_directives_model * directives_model, 
-				   xmlDocPtr doc, xmlNode * parent) {
+				   xmlDocPtr doc, xmlNode * parent,
+				   struct oscap_xml_stream *stream) {
 
 	struct oval_result_directives * directives;
 	struct oval_result_directives * class_dirs;
@@ -423,6 +471,7 @@ xmlNode *oval_result_system_to_dom(struct oval_result_system * sys,
 
 	xmlNs *ns_results = xmlSearchNsByHref(doc, parent, OVAL_RESULTS_NAMESPACE);
 	xmlNode *system_node = xmlNewTextChild(parent, ns_results, BAD_CAST "system", NULL);
+	oscap_xml_stream_start_element(stream, system_node);
 
 	struct oval_smc *tstmap = oval_smc_new();
 
@@ -430,6 +479,7 @@ xmlNode *oval_result_system_to_dom(struct oval_result_system * sys,
 	struct oval_definition_iterator *oval_definitions = oval_definition_model_get_definitions(definition_model);
 	if(oval_definition_iterator_has_more(oval_definitions)) {
 		xmlNode *definitions_node = xmlNewTextChild(system_node, ns_results, BAD_CAST "definitions", NULL);
+		oscap_xml_stream_start_element(stream, definitions_node);
 		while(oval_definition_iterator_has_more(oval_definitions)) {
 			struct oval_definition *oval_definition = oval_definition_iterator_next(oval_definitions);
 
@@ -453,7 +503,9 @@ xmlNode *oval_result_system_to_dom(struct oval_result_system * sys,
 					_oval_result_definition_to_dom_based_on_directives(rslt_definition, directives, doc, definitions_node, tstmap);
 				}
 			}
+			oscap_xml_stream_flush(stream, definitions_node);
 		}
+		oscap_xml_stream_end_element(stream, definitions_node);
 	}
 	oval_definition_iterator_free(oval_definitions);
 
@@ -466,11 +518,13 @@ xmlNode *oval_result_system_to_dom(struct oval_result_system * sys,
 	struct oval_smc_iterator *result_tests = oval_smc_iterator_new(tstmap);
 	if (oval_smc_iterator_has_more(result_tests)) {
 		xmlNode *tests_node = xmlNewTextChild(system_node, ns_results, BAD_CAST "tests", NULL);
+		oscap_xml_stream_start_element(stream, tests_node);
 		while (oval_smc_iterator_has_more(result_tests)) {
 			struct oval_state_iterator *ste_itr;
 			struct oval_result_test *result_test = oval_smc_iterator_next(result_tests);
 			/* report the test */
 			oval_result_test_to_dom(result_test, doc, tests_node);
+			oscap_xml_stream_flush(stream, tests_node);
 			struct oval_test *oval_test = oval_result_test_get_test(result_test);
 			/* collect the objects that are referenced from reported test */
 			/* look for objects in path: test->object ...  */
@@ -505,12 +559,14 @@ xmlNode *oval_result_system_to_dom(struct oval_result_system * sys,
 			}
 			oval_state_iterator_free(ste_itr);
 		}
+		oscap_xml_stream_end_element(stream, tests_node);
 	}
 	oval_smc_iterator_free(result_tests);
 
 	bool export_sys_char = oval_results_model_get_export_system_characteristics(results_model);
 	oval_syschar_model_to_dom(syschar_model, doc, system_node, 
-				  (oval_syschar_resolver *) _oval_result_system_resolve_syschar, sysmap, export_sys_char);
+				  (oval_syschar_resolver *) _oval_result_system_resolve_syschar, sysmap, export_sys_char,
+				  stream);
 
 	oval_string_map_free(sysmap, NULL);
 	oval_string_map_free(objmap, NULL);
@@ -518,7 +574,8 @@ xmlNode *oval_result_system_to_dom(struct oval_result_system * sys,
 	oval_string_map_free(varmap, NULL);
 	oval_smc_free0(tstmap);
 
-	return system_node;
+	oscap_xml_stream_end_element(stream, system_node);
+	return stream ? NULL : system_node;
 }
 
 
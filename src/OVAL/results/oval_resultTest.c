@@ -35,6 +35,7 @@
 
 #include <string.h>
 #include <ctype.h>
+#include <pthread.h>
 #include "oval_agent_api_impl.h"
 #ifdef OVAL_PROBES_ENABLED
 #include "oval_probe_impl.h"
@@ -48,6 +49,7 @@
 #include "public/oval_types.h"
 #include "common/util.h"
 #include "common/debug_priv.h"
+#include "common/profiler_priv.h"
 #include "common/_error.h"
 
 typedef struct oval_result_test {
@@ -59,6 +61,7 @@ typedef struct oval_result_test {
 	struct oval_collection *bindings;
 	int instance;
 	bool bindings_initialized;
+	pthread_mutex_t lock;		///< Held while the test is evaluated
 } oval_result_test_t;
 
 struct oval_result_test *oval_result_test_new(struct oval_result_system *sys, char *tstid)
@@ -78,6 +81,7 @@ struct oval_result_test *oval_result_test_new(struct oval_result_system *sys, ch
 	test->items = oval_collection_new();
 	test->bindings = oval_collection_new();
 	test->bindings_initialized = false;
+	pthread_mutex_init(&test->lock, NULL);
 	return test;
 }
 
@@ -139,6 +143,7 @@ void oval_result_test_free(struct oval_result_test *test)
 	test->items = NULL;
 	test->bindings = NULL;
 	test->instance = 1;
+	pthread_mutex_destroy(&test->lock);
 	free(test);
 }
 
@@ -381,68 +386,132 @@ oval_result_t ores_get_result_byopr(struct oresults *ores, oval_operator_t op)
 	return result;
 }
 
-static inline oval_result_t _evaluate_sysent_with_variable(struct oval_syschar_model *syschar_model, struct oval_entity *state_entity, struct oval_sysent *item_entity, oval_operation_t state_entity_operation, struct oval_state_content *content)
+/*
+ * Evaluation plan of a state. The state contents are compiled once per
+ * result system into a flat array of entries, with the datatype of the
+ * values resolved and numeric values converted, so that evaluating many
+ * items against the same state doesn't interpret the state again for
+ * every item. Values of variables are resolved on first use and kept in
+ * the variable slots of the evaluating call for the following items of
+ * the same test, the plan itself is never modified after it is compiled
+ * and it can be shared by tests evaluated in parallel.
+ */
+typedef enum {
+	OVAL_STATE_PLAN_VALUE,		///< Compare with the value of the state entity
+	OVAL_STATE_PLAN_VARIABLE,	///< Compare with the values of a variable
+	OVAL_STATE_PLAN_RECORD,		///< Compare the record fields
+	OVAL_STATE_PLAN_INVALID		///< Internal error, reported when the entity is evaluated
+} oval_state_plan_kind_t;
+
+struct oval_state_plan_entry {
+	struct oval_state_content *content;
+	struct oval_entity *entity;
+	const char *name;
+	oval_state_plan_kind_t kind;
+	oval_operation_t operation;
+	oval_check_t entity_check;
+	oval_existence_t check_existence;
+	bool mask;
+	const char *error;			///< Error message of an invalid entry
+	struct oval_cmp_operand value;		///< Value of a plain entity
+	struct oval_variable *variable;		///< Variable of a var_ref entity
+	oval_check_t var_check;
+};
+
+/* Resolved values of the variable of a plan entry */
+struct oval_state_plan_var {
+	bool resolved;
+	oval_result_t status;			///< -1 or OVAL_RESULT_ERROR when the variable has no usable values
+	bool null_text;				///< A value without text follows the resolved values
+	int count;
+	struct oval_cmp_operand *values;
+};
+
+struct oval_state_plan {
+	struct oval_state *state;
+	int count;
+	struct oval_state_plan_entry *entries;
+};
+
+static void _oval_state_plan_resolve_variable(struct oval_result_system *sys, struct oval_state_plan_entry *entry, struct oval_state_plan_var *var)
 {
 	oval_syschar_collection_flag_t flag;
-	oval_result_t ent_val_res;
 
-	struct oval_variable *state_entity_var;
-	if ((state_entity_var = oval_entity_get_variable(state_entity)) == NULL) {
-		oscap_seterr(OSCAP_EFAMILY_OVAL, "OVAL internal error: found NULL variable");
-		return -1;
-	}
+	var->resolved = true;
 
-	if (0 != oval_syschar_model_compute_variable(syschar_model, state_entity_var)) {
-		return -1;
+	/* The variable is computed on its first use, possibly by another thread */
+	oval_result_system_lock(sys);
+	if (0 != oval_syschar_model_compute_variable(oval_result_system_get_syschar_model(sys), entry->variable)) {
+		oval_result_system_unlock(sys);
+		var->status = -1;
+		return;
 	}
 
-	flag = oval_variable_get_collection_flag(state_entity_var);
+	flag = oval_variable_get_collection_flag(entry->variable);
 	switch (flag) {
 	case SYSCHAR_FLAG_COMPLETE:
 	case SYSCHAR_FLAG_INCOMPLETE:{
-		struct oresults var_ores;
 		struct oval_value_iterator *val_itr;
+		int capacity;
 
-		ores_clear(&var_ores);
-
-		val_itr = oval_variable_get_values(state_entity_var);
+		var->status = OVAL_RESULT_TRUE;
+		val_itr = oval_variable_get_values(entry->variable);
+		capacity = oval_value_iterator_remaining(val_itr);
+		var->values = capacity > 0 ? malloc(capacity * sizeof(struct oval_cmp_operand)) : NULL;
 		while (oval_value_iterator_has_more(val_itr)) {
-			struct oval_value *var_val;
-			char *state_entity_val_text = NULL;
-			oval_result_t var_val_res;
-
-			var_val = oval_value_iterator_next(val_itr);
-			state_entity_val_text = oval_value_get_text(var_val);
-			if (state_entity_val_text == NULL) {
-				dE("Found NULL variable value text.");
-				ores_add_res(&var_ores, OVAL_RESULT_ERROR);
-				break;
-			}
-			oval_datatype_t state_entity_val_datatype = oval_value_get_datatype(var_val);
+			struct oval_value *var_val = oval_value_iterator_next(val_itr);
+			char *text = oval_value_get_text(var_val);
 
-			var_val_res = oval_ent_cmp_str(state_entity_val_text, state_entity_val_datatype, item_entity, state_entity_operation);
-			if (var_val_res == OVAL_RESULT_ERROR) {
-				dE("Error occured when comparing a variable '%s' value '%s' with collected item entity = '%s'",
-					oval_variable_get_id(state_entity_var), state_entity_val_text, oval_sysent_get_value(item_entity));
+			if (text == NULL) {
+				var->null_text = true;
+				break;
 			}
-			ores_add_res(&var_ores, var_val_res);
+			oval_cmp_operand_init(&var->values[var->count++], text, oval_value_get_datatype(var_val));
 		}
 		oval_value_iterator_free(val_itr);
-
-		oval_check_t var_check = oval_state_content_get_var_check(content);
-		ent_val_res = ores_get_result_bychk(&var_ores, var_check);
 		} break;
 	case SYSCHAR_FLAG_ERROR:
 	case SYSCHAR_FLAG_DOES_NOT_EXIST:
 	case SYSCHAR_FLAG_NOT_COLLECTED:
 	case SYSCHAR_FLAG_NOT_APPLICABLE:
-		ent_val_res = OVAL_RESULT_ERROR;
+		var->status = OVAL_RESULT_ERROR;
 		break;
 	default:
-		ent_val_res = -1;
+		var->status = -1;
+	}
+	oval_result_system_unlock(sys);
+}
+
+static inline oval_result_t _evaluate_sysent_with_variable(struct oval_result_system *sys, struct oval_state_plan_entry *entry, struct oval_state_plan_var *var, struct oval_sysent *item_entity)
+{
+	struct oresults var_ores;
+	int i;
+
+	if (!var->resolved)
+		_oval_state_plan_resolve_variable(sys, entry, var);
+
+	if (var->status != OVAL_RESULT_TRUE)
+		return var->status;
+
+	ores_clear(&var_ores);
+
+	for (i = 0; i < var->count; i++) {
+		const struct oval_cmp_operand *var_val = &var->values[i];
+		oval_result_t var_val_res;
+
+		var_val_res = oval_operand_cmp_str(var_val, oval_sysent_get_value(item_entity), entry->operation);
+		if (var_val_res == OVAL_RESULT_ERROR) {
+			dE("Error occured when comparing a variable '%s' value '%s' with collected item entity = '%s'",
+				oval_variable_get_id(entry->variable), var_val->text, oval_sysent_get_value(item_entity));
+		}
+		ores_add_res(&var_ores, var_val_res);
+	}
+	if (var->null_text) {
+		dE("Found NULL variable value text.");
+		ores_add_res(&var_ores, OVAL_RESULT_ERROR);
 	}
 
-	return ent_val_res;
+	return ores_get_result_bychk(&var_ores, entry->var_check);
 }
 
 struct record_field_instance {
@@ -505,98 +574,175 @@ static oval_result_t _evaluate_sysent_record(struct oval_state_content *state_co
 	return ores_get_result_byopr(&record_ores, OVAL_OPERATOR_AND);
 }
 
-static inline oval_result_t _evaluate_sysent(struct oval_syschar_model *syschar_model, struct oval_sysent *item_entity, struct oval_entity *state_entity, oval_operation_t state_entity_operation, struct oval_state_content *content)
+static void _oval_state_plan_entry_compile(struct oval_state *state, struct oval_state_content *content, struct oval_state_plan_entry *entry)
 {
-	if (oval_sysent_get_status(item_entity) == SYSCHAR_STATUS_DOES_NOT_EXIST) {
-		return OVAL_RESULT_FALSE;
-	} else if (oval_entity_get_varref_type(state_entity) == OVAL_ENTITY_VARREF_ATTRIBUTE) {
+	struct oval_entity *state_entity;
+	struct oval_value *state_entity_val;
+	char *state_entity_name;
+	char *state_entity_val_text;
 
-		return _evaluate_sysent_with_variable(syschar_model,
-				state_entity, item_entity,
-				state_entity_operation, content);
-	} else {
-		struct oval_value *state_entity_val;
-		char *state_entity_val_text;
-		oval_datatype_t state_entity_val_datatype;
-
-		oval_datatype_t state_entity_type = oval_entity_get_datatype(state_entity);
-		if (state_entity_type == OVAL_DATATYPE_RECORD) {
-			if (state_entity_operation != OVAL_OPERATION_EQUALS) {
-				dE("The only allowed operation for comparing record types is 'equals'.");
-				return OVAL_RESULT_ERROR;
-			}
-			return _evaluate_sysent_record(content, item_entity);
-		} else {
-			if ((state_entity_val = oval_entity_get_value(state_entity)) == NULL) {
-				oscap_seterr(OSCAP_EFAMILY_OVAL, "OVAL internal error: found NULL entity value");
-				return -1;
-			}
-			if ((state_entity_val_text = oval_value_get_text(state_entity_val)) == NULL) {
-				oscap_seterr(OSCAP_EFAMILY_OVAL, "OVAL internal error: found NULL entity value text");
-				return -1;
-			}
-			state_entity_val_datatype = oval_value_get_datatype(state_entity_val);
+	entry->content = content;
+	entry->kind = OVAL_STATE_PLAN_INVALID;
+
+	if ((state_entity = oval_state_content_get_entity(content)) == NULL) {
+		entry->error = "OVAL internal error: found NULL entity";
+		return;
+	}
+	if ((state_entity_name = oval_entity_get_name(state_entity)) == NULL) {
+		entry->error = "OVAL internal error: found NULL entity name";
+		return;
+	}
 
-			return oval_ent_cmp_str(state_entity_val_text, state_entity_val_datatype, item_entity, state_entity_operation);
+	if (oscap_streq(state_entity_name, "line") &&
+		oval_state_get_subtype(state) == (oval_subtype_t) OVAL_INDEPENDENT_TEXT_FILE_CONTENT) {
+		/* Hack: textfilecontent_state/line shall be compared against textfilecontent_item/text.
+		 *
+		 * textfilecontent_test and textfilecontent54_test share the same syschar
+		 * (textfilecontent_item). In OVAL 5.3 and below this syschar did not hold any usable
+		 * information ('text' ent). In OVAL 5.4 textfilecontent_test was deprecated. But the
+		 * 'text' ent has been added to textfilecontent_item, making it potentially usable. */
+		oval_schema_version_t over = oval_state_get_platform_schema_version(state);
+		if (oval_schema_version_cmp(over, OVAL_SCHEMA_VERSION(5.4)) >= 0) {
+			/* The OVAL-5.3 does not have textfilecontent_item/text */
+			state_entity_name = "text";
+		}
+	}
+
+	entry->entity = state_entity;
+	entry->name = state_entity_name;
+	entry->entity_check = oval_state_content_get_ent_check(content);
+	entry->check_existence = oval_state_content_get_check_existence(content);
+	entry->operation = oval_entity_get_operation(state_entity);
+	entry->mask = oval_entity_get_mask(state_entity);
+
+	if (oval_entity_get_varref_type(state_entity) == OVAL_ENTITY_VARREF_ATTRIBUTE) {
+		if ((entry->variable = oval_entity_get_variable(state_entity)) == NULL) {
+			entry->error = "OVAL internal error: found NULL variable";
+			return;
+		}
+		entry->var_check = oval_state_content_get_var_check(content);
+		entry->kind = OVAL_STATE_PLAN_VARIABLE;
+	} else if (oval_entity_get_datatype(state_entity) == OVAL_DATATYPE_RECORD) {
+		entry->kind = OVAL_STATE_PLAN_RECORD;
+	} else {
+		if ((state_entity_val = oval_entity_get_value(state_entity)) == NULL) {
+			entry->error = "OVAL internal error: found NULL entity value";
+			return;
 		}
+		if ((state_entity_val_text = oval_value_get_text(state_entity_val)) == NULL) {
+			entry->error = "OVAL internal error: found NULL entity value text";
+			return;
+		}
+		oval_cmp_operand_init(&entry->value, state_entity_val_text, oval_value_get_datatype(state_entity_val));
+		entry->kind = OVAL_STATE_PLAN_VALUE;
 	}
 }
 
-static oval_result_t eval_item(struct oval_syschar_model *syschar_model, struct oval_sysitem *cur_sysitem, struct oval_state *state)
+struct oval_state_plan *oval_state_plan_new(struct oval_state *state)
 {
 	struct oval_state_content_iterator *state_contents_itr;
+	struct oval_state_plan *plan;
+
+	plan = calloc(1, sizeof(struct oval_state_plan));
+	plan->state = state;
+
+	state_contents_itr = oval_state_get_contents(state);
+	while (oval_state_content_iterator_has_more(state_contents_itr)) {
+		struct oval_state_content *content = oval_state_content_iterator_next(state_contents_itr);
+		struct oval_state_plan_entry *entry;
+
+		plan->entries = realloc(plan->entries, (plan->count + 1) * sizeof(struct oval_state_plan_entry));
+		entry = &plan->entries[plan->count++];
+		memset(entry, 0, sizeof(struct oval_state_plan_entry));
+
+		if (content == NULL) {
+			entry->kind = OVAL_STATE_PLAN_INVALID;
+			entry->error = "OVAL internal error: found NULL state content";
+			/* The content is a hard error, the rest of the state is never evaluated */
+			break;
+		}
+		_oval_state_plan_entry_compile(state, content, entry);
+	}
+	oval_state_content_iterator_free(state_contents_itr);
+
+	return plan;
+}
+
+void oval_state_plan_free(struct oval_state_plan *plan)
+{
+	if (plan == NULL)
+		return;
+
+	free(plan->entries);
+	free(plan);
+}
+
+/* Values of the variables may change between evaluations of the tests,
+ * e.g. when the external variables are bound to other values, so they
+ * are resolved again by every evaluation of a test. */
+static struct oval_state_plan_var *oval_state_plan_vars_new(struct oval_state_plan *plan)
+{
+	return plan->count > 0 ? calloc(plan->count, sizeof(struct oval_state_plan_var)) : NULL;
+}
+
+static void oval_state_plan_vars_free(struct oval_state_plan *plan, struct oval_state_plan_var *vars)
+{
+	int i;
+
+	if (vars == NULL)
+		return;
+
+	for (i = 0; i < plan->count; i++)
+		free(vars[i].values);
+	free(vars);
+}
+
+static inline oval_result_t _evaluate_sysent(struct oval_result_system *sys, struct oval_sysent *item_entity, struct oval_state_plan_entry *entry, struct oval_state_plan_var *var)
+{
+	if (oval_sysent_get_status(item_entity) == SYSCHAR_STATUS_DOES_NOT_EXIST)
+		return OVAL_RESULT_FALSE;
+
+	switch (entry->kind) {
+	case OVAL_STATE_PLAN_VARIABLE:
+		return _evaluate_sysent_with_variable(sys, entry, var, item_entity);
+	case OVAL_STATE_PLAN_RECORD:
+		if (entry->operation != OVAL_OPERATION_EQUALS) {
+			dE("The only allowed operation for comparing record types is 'equals'.");
+			return OVAL_RESULT_ERROR;
+		}
+		return _evaluate_sysent_record(entry->content, item_entity);
+	case OVAL_STATE_PLAN_VALUE:
+		return oval_operand_cmp_str(&entry->value, oval_sysent_get_value(item_entity), entry->operation);
+	default:
+		oscap_seterr(OSCAP_EFAMILY_OVAL, "%s", entry->error);
+		return -1;
+	}
+}
+
+static oval_result_t eval_item(struct oval_result_system *sys, struct oval_sysitem *cur_sysitem, struct oval_state_plan *plan, struct oval_state_plan_var *vars)
+{
+	struct oval_state *state = plan->state;
 	struct oresults ste_ores;
 	oval_operator_t operator;
 	oval_result_t result = OVAL_RESULT_ERROR;
+	int i;
 
 	ores_clear(&ste_ores);
 
-	state_contents_itr = oval_state_get_contents(state);
-	while (oval_state_content_iterator_has_more(state_contents_itr)) {
-		struct oval_state_content *content;
-		struct oval_entity *state_entity;
-		char *state_entity_name;
-		oval_operation_t state_entity_operation;
-		oval_check_t entity_check;
-		oval_existence_t check_existence;
+	for (i = 0; i < plan->count; i++) {
+		struct oval_state_plan_entry *entry = &plan->entries[i];
 		oval_result_t ste_ent_res;
 		struct oval_sysent_iterator *item_entities_itr;
 		struct oresults ent_ores;
 		struct oval_status_counter counter;
 		bool found_matching_item;
 
-		if ((content = oval_state_content_iterator_next(state_contents_itr)) == NULL) {
-			oscap_seterr(OSCAP_EFAMILY_OVAL, "OVAL internal error: found NULL state content");
-			goto fail;
-		}
-		if ((state_entity = oval_state_content_get_entity(content)) == NULL) {
-			oscap_seterr(OSCAP_EFAMILY_OVAL, "OVAL internal error: found NULL entity");
-			goto fail;
-		}
-		if ((state_entity_name = oval_entity_get_name(state_entity)) == NULL) {
-			oscap_seterr(OSCAP_EFAMILY_OVAL, "OVAL internal error: found NULL entity name");
-			goto fail;
-		}
-
-		if (oscap_streq(state_entity_name, "line") &&
-			oval_state_get_subtype(state) == (oval_subtype_t) OVAL_INDEPENDENT_TEXT_FILE_CONTENT) {
-			/* Hack: textfilecontent_state/line shall be compared against textfilecontent_item/text.
-			 *
-			 * textfilecontent_test and textfilecontent54_test share the same syschar
-			 * (textfilecontent_item). In OVAL 5.3 and below this syschar did not hold any usable
-			 * information ('text' ent). In OVAL 5.4 textfilecontent_test was deprecated. But the
-			 * 'text' ent has been added to textfilecontent_item, making it potentially usable. */
-			oval_schema_version_t over = oval_state_get_platform_schema_version(state);
-			if (oval_schema_version_cmp(over, OVAL_SCHEMA_VERSION(5.4)) >= 0) {
-				/* The OVAL-5.3 does not have textfilecontent_item/text */
-				state_entity_name = "text";
-			}
+		if (entry->entity == NULL) {
+			/* NULL state content, entity or entity name */
+			oscap_seterr(OSCAP_EFAMILY_OVAL, "%s", entry->error);
+			return OVAL_RESULT_ERROR;
 		}
 
-		entity_check = oval_state_content_get_ent_check(content);
-		check_existence = oval_state_content_get_check_existence(content);
-		state_entity_operation = oval_entity_get_operation(state_entity);
-
 		ores_clear(&ent_ores);
 		found_matching_item = false;
 		oval_status_counter_clear(&counter);
@@ -612,23 +758,25 @@ static oval_result_t eval_item(struct oval_syschar_model *syschar_model, struct
 			if (item_entity == NULL) {
 				oscap_seterr(OSCAP_EFAMILY_OVAL, "OVAL internal error: found NULL sysent");
 				oval_sysent_iterator_free(item_entities_itr);
-				goto fail;
+				return OVAL_RESULT_ERROR;
 			}
 			item_status = oval_sysent_get_status(item_entity);
 			oval_status_counter_add_status(&counter, item_status);
 
 			item_entity_name = oval_sysent_get_name(item_entity);
-			if (strcmp(item_entity_name, state_entity_name))
+			if (strcmp(item_entity_name, entry->name))
 				continue;
 
 			found_matching_item = true;
 
-			/* copy mask attribute from state to item */
-			if (oval_entity_get_mask(state_entity))
+			/* copy mask attribute from state to item, items are shared by the tests */
+			if (entry->mask) {
+				oval_result_system_lock(sys);
 				oval_sysent_set_mask(item_entity,1);
+				oval_result_system_unlock(sys);
+			}
 
-			ent_val_res = _evaluate_sysent(syschar_model, item_entity, state_entity,
-					state_entity_operation, content);
+			ent_val_res = _evaluate_sysent(sys, item_entity, entry, &vars[i]);
 			if (ent_val_res == OVAL_RESULT_TRUE) {
 				dI("Entity '%s'='%s' of item '%s' matches corresponding entity in state '%s'.",
 						oval_sysent_get_name(item_entity),
@@ -643,7 +791,7 @@ static oval_result_t eval_item(struct oval_syschar_model *syschar_model, struct
 			}
 			if (((signed) ent_val_res) == -1) {
 				oval_sysent_iterator_free(item_entities_itr);
-				goto fail;
+				return OVAL_RESULT_ERROR;
 			}
 
 			ores_add_res(&ent_ores, ent_val_res);
@@ -652,14 +800,13 @@ static oval_result_t eval_item(struct oval_syschar_model *syschar_model, struct
 
 		if (!found_matching_item)
 			dW("Entity name '%s' from state (id: '%s') not found in item (id: '%s').",
-			   state_entity_name, oval_state_get_id(state), oval_sysitem_get_id(cur_sysitem));
+			   entry->name, oval_state_get_id(state), oval_sysitem_get_id(cur_sysitem));
 
-		ste_ent_res = ores_get_result_bychk(&ent_ores, entity_check);
+		ste_ent_res = ores_get_result_bychk(&ent_ores, entry->entity_check);
 		ores_add_res(&ste_ores, ste_ent_res);
-		oval_result_t cres = oval_status_counter_get_result(&counter, check_existence);
+		oval_result_t cres = oval_status_counter_get_result(&counter, entry->check_existence);
 		ores_add_res(&ste_ores, cres);
 	}
-	oval_state_content_iterator_free(state_contents_itr);
 
 	operator = oval_state_get_operator(state);
 	result = ores_get_result_byopr(&ste_ores, operator);
@@ -668,11 +815,6 @@ static oval_result_t eval_item(struct oval_syschar_model *syschar_model, struct
 			   oval_result_get_text(result));
 
 	return result;
-
- fail:
-	oval_state_content_iterator_free(state_contents_itr);
-
-	return OVAL_RESULT_ERROR;
 }
 
 #define ITEMMAP (struct oval_string_map    *)args[2]
@@ -693,8 +835,11 @@ static void _oval_test_item_consumer(struct oval_result_item *item, void **args)
 
 static oval_result_t eval_check_state(struct oval_test *test, void **args)
 {
-	struct oval_syschar_model *syschar_model;
 	struct oval_result_item_iterator *ritems_itr;
+	struct oval_state_iterator *ste_itr;
+	struct oval_state_plan **ste_plans = NULL;
+	struct oval_state_plan_var **ste_vars = NULL;
+	int ste_count = 0;
 	struct oresults item_ores;
 	oval_result_t result;
 	oval_check_t ste_check;
@@ -702,7 +847,6 @@ static oval_result_t eval_check_state(struct oval_test *test, void **args)
 
 	ste_check = oval_test_get_check(test);
 	ste_opr = oval_test_get_state_operator(test);
-	syschar_model = oval_result_system_get_syschar_model(SYSTEM);
 	ores_clear(&item_ores);
 
 	char *state_names = oval_test_get_state_names(test);
@@ -712,14 +856,25 @@ static oval_result_t eval_check_state(struct oval_test *test, void **args)
 		free(state_names);
 	}
 
+	ste_itr = oval_test_get_states(test);
+	while (oval_state_iterator_has_more(ste_itr)) {
+		struct oval_state_plan *plan = oval_result_system_get_state_plan(SYSTEM, oval_state_iterator_next(ste_itr));
+
+		ste_plans = realloc(ste_plans, (ste_count + 1) * sizeof(struct oval_state_plan *));
+		ste_vars = realloc(ste_vars, (ste_count + 1) * sizeof(struct oval_state_plan_var *));
+		ste_plans[ste_count] = plan;
+		ste_vars[ste_count++] = oval_state_plan_vars_new(plan);
+	}
+	oval_state_iterator_free(ste_itr);
+
 	ritems_itr = oval_result_test_get_items(TEST);
 	while (oval_result_item_iterator_has_more(ritems_itr)) {
 		struct oval_result_item *ritem;
 		struct oval_sysitem *item;
 		oval_syschar_status_t item_status;
 		struct oresults ste_ores;
-		struct oval_state_iterator *ste_itr;
 		oval_result_t item_res;
+		int i;
 
 		ritem = oval_result_item_iterator_next(ritems_itr);
 		item = oval_result_item_get_sysitem(ritem);
@@ -743,22 +898,22 @@ static oval_result_t eval_check_state(struct oval_test *test, void **args)
 
 		ores_clear(&ste_ores);
 
-		ste_itr = oval_test_get_states(test);
-		while (oval_state_iterator_has_more(ste_itr)) {
-			struct oval_state *ste;
+		for (i = 0; i < ste_count; i++) {
 			oval_result_t ste_res;
 
-			ste = oval_state_iterator_next(ste_itr);
-			ste_res = eval_item(syschar_model, item, ste);
+			ste_res = eval_item(SYSTEM, item, ste_plans[i], ste_vars[i]);
 			ores_add_res(&ste_ores, ste_res);
 		}
-		oval_state_iterator_free(ste_itr);
 
 		item_res = ores_get_result_byopr(&ste_ores, ste_opr);
 		ores_add_res(&item_ores, item_res);
 		oval_result_item_set_result(ritem, item_res);
 	}
 	oval_result_item_iterator_free(ritems_itr);
+	for (int i = 0; i < ste_count; i++)
+		oval_state_plan_vars_free(ste_plans[i], ste_vars[i]);
+	free(ste_plans);
+	free(ste_vars);
 
 	result = ores_get_result_bychk(&item_ores, ste_check);
 
@@ -865,7 +1020,9 @@ _oval_result_test_evaluate_items(struct oval_test *test, struct oval_syschar *sy
 			error_cnt++;
 
 		item_id = oval_sysitem_get_id(item);
+		oval_result_system_lock(SYSTEM);
 		ritem = oval_result_item_new(SYSTEM, item_id);
+		oval_result_system_unlock(SYSTEM);
 		oval_result_item_set_result(ritem, OVAL_RESULT_NOT_EVALUATED);
 		_oval_test_item_consumer(ritem, args);
 	}
@@ -1010,17 +1167,20 @@ static oval_result_t _oval_result_test_result(struct oval_result_test *rtest, vo
 	struct oval_result_system *sys = oval_result_test_get_system(rtest);
 	struct oval_results_model *results_model = oval_result_system_get_results_model(sys);
 	struct oval_probe_session *probe_session = oval_results_model_get_probe_session(results_model);
+	struct oval_syschar_model *syschar_model = oval_result_system_get_syschar_model(sys);
+
+	/* Late queries of the other threads add syschars to the model */
+	oval_result_system_lock(sys);
 	if (probe_session != NULL) {
-		/* probe test */
+		/* probe test, the objects are usually collected already */
 		int ret = oval_probe_query_test(probe_session, test);
 		if (ret != 0) {
+			oval_result_system_unlock(sys);
 			return ret;
 		}
 	}
-
-	struct oval_syschar_model *syschar_model = oval_result_system_get_syschar_model(sys);
-
 	struct oval_syschar * syschar = oval_syschar_model_get_syschar(syschar_model, object_id);
+	oval_result_system_unlock(sys);
 	if (syschar == NULL) {
 		dW("No syschar for object: %s", object_id);
 		return OVAL_RESULT_UNKNOWN;
@@ -1128,26 +1288,40 @@ oval_result_t oval_result_test_eval(struct oval_result_test *rtest)
 	const char *comment = oval_test_get_comment(test);
 	dI("Evaluating %s test '%s': %s.", type, test_id, comment);
 
+	/* The test may be referenced by definitions evaluated in parallel */
+	pthread_mutex_lock(&rtest->lock);
 	if (rtest->result == OVAL_RESULT_NOT_EVALUATED) {
 		if ((oval_independent_subtype_t)oval_test_get_subtype(oval_result_test_get_test(rtest)) != OVAL_INDEPENDENT_UNKNOWN ) {
 			struct oval_string_map *tmp_map = oval_string_map_new();
 			void *args[] = { rtest->system, rtest, tmp_map };
+			oscap_prof_timer_t timer;
+
+			oscap_prof_start(&timer);
 			dIndent(1);
 			rtest->result = _oval_result_test_result(rtest, args);
 			dIndent(-1);
+			if (timer.running) {
+				struct oval_iterator *items = oval_collection_iterator(rtest->items);
+				oscap_prof_stop(&timer, OSCAP_PROF_TEST, test_id, oval_collection_iterator_remaining(items));
+				oval_collection_iterator_free(items);
+			}
 			oval_string_map_free(tmp_map, NULL);
 
 			if (!rtest->bindings_initialized) {
+				oval_result_system_lock(rtest->system);
 				_oval_result_test_initialize_bindings(rtest);
+				oval_result_system_unlock(rtest->system);
 			}
 		}
 		else
 			rtest->result = OVAL_RESULT_UNKNOWN;
 	}
+	oval_result_t result = rtest->result;
+	pthread_mutex_unlock(&rtest->lock);
 
-	dI("Test '%s' evaluated as %s.", test_id, oval_result_get_text(rtest->result));
+	dI("Test '%s' evaluated as %s.", test_id, oval_result_get_text(result));
 
-	return rtest->result;
+	return result;
 }
 
 oval_result_t oval_result_test_get_result(struct oval_result_test * rtest)
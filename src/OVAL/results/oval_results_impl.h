@@ -42,7 +42,7 @@
 
 
 int oval_result_system_parse_tag(xmlTextReaderPtr, struct oval_parser_context *, void *);
-xmlNode *oval_result_system_to_dom(struct oval_result_system *, struct oval_results_model *, struct oval_directives_model *, xmlDocPtr, xmlNode *);
+xmlNode *oval_result_system_to_dom(struct oval_result_system *, struct oval_results_model *, struct oval_directives_model *, xmlDocPtr, xmlNode *, struct oscap_xml_stream *);
 
 struct oval_result_test *oval_result_system_get_new_test(struct oval_result_system *, struct oval_test *, int variable_instance);
 
@@ -76,6 +76,25 @@ struct oval_result_definition *oval_result_system_get_new_definition(struct oval
 								     int variable_instance);
 struct oval_result_test *oval_result_system_get_test(struct oval_result_system *, char *);
 
+struct oval_state_plan;
+struct oval_state_plan *oval_state_plan_new(struct oval_state *state);
+void oval_state_plan_free(struct oval_state_plan *plan);
+/**
+ * Get the evaluation plan of the state, it is compiled on the first use
+ * and kept until the result system is freed.
+ */
+struct oval_state_plan *oval_result_system_get_state_plan(struct oval_result_system *sys, struct oval_state *state);
+/**
+ * Lock the data shared by the tests of the result system: the system
+ * characteristics (syschars created by late probe queries, items, values
+ * of computed variables) and the cache of state plans. Definitions and
+ * tests may be evaluated by several threads at once, each of them holds
+ * its own lock while being evaluated (see oval_result_definition_eval()
+ * and oval_result_test_eval()). This lock is always taken last.
+ */
+void oval_result_system_lock(struct oval_result_system *sys);
+void oval_result_system_unlock(struct oval_result_system *sys);
+
 struct oresults {
 	int true_cnt;
 	int false_cnt;
@@ -103,6 +122,10 @@ const char *oval_result_test_get_id(const struct oval_result_test *test);
 
 
 struct oval_result_definition *oval_result_system_prepare_definition(struct oval_result_system *sys, const char *id);
+/**
+ * Remove the result definition from the system and free it.
+ */
+void oval_result_system_drop_definition(struct oval_result_system *sys, struct oval_result_definition *definition);
 
 
 #endif				/* OVAL_RESULTS_IMPL_H_ */
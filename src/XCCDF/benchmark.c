@@ -233,18 +233,28 @@ int xccdf_benchmark_export(struct xccdf_benchmark *benchmark, const char *file)
 
 	LIBXML_TEST_VERSION;
 
-	struct oscap_source *source = xccdf_benchmark_export_source(benchmark, file);
-	if (source == NULL) {
+	xmlDocPtr doc = xmlNewDoc(BAD_CAST "1.0");
+	if (doc == NULL) {
+		oscap_setxmlerr(xmlGetLastError());
 		return -1;
 	}
-	int ret = oscap_source_save_as(source, NULL);
-	oscap_source_free(source);;
-	return ret;
+
+	/* Rules, groups and rule results are written out as soon as they are
+	 * serialized, the whole document is never kept in memory. */
+	struct oscap_xml_stream *stream = oscap_xml_stream_new(file);
+	if (stream == NULL) {
+		xmlFreeDoc(doc);
+		return -1;
+	}
+
+	xccdf_benchmark_to_dom(benchmark, doc, NULL, stream);
+	xmlFreeDoc(doc);
+	return oscap_xml_stream_free(stream) == 1 ? 0 : -1;
 }
 
 #define OSCAP_XML_XSI BAD_CAST "http://www.w3.org/XML/1998/namespace"
 xmlNode *xccdf_benchmark_to_dom(struct xccdf_benchmark *benchmark, xmlDocPtr doc,
-				xmlNode *parent, void *user_args)
+				xmlNode *parent, struct oscap_xml_stream *stream)
 {
 	const struct xccdf_version_info *version_info = xccdf_benchmark_get_schema_version(benchmark);
 
@@ -344,10 +354,15 @@ xmlNode *xccdf_benchmark_to_dom(struct xccdf_benchmark *benchmark, xmlDocPtr doc
 		xmlNewProp(model_node, BAD_CAST "system", BAD_CAST xccdf_model_get_system(model));
 	}
 
+	/* All attributes and namespaces of the root element are set by now */
+	oscap_xml_stream_start_element(stream, root_node);
+	oscap_xml_stream_flush(stream, root_node);
+
 	struct xccdf_profile_iterator *profiles = xccdf_benchmark_get_profiles(benchmark);
 	while (xccdf_profile_iterator_has_more(profiles)) {
 		struct xccdf_profile *profile = xccdf_profile_iterator_next(profiles);
 		xccdf_item_to_dom(XITEM(profile), doc, root_node, version_info);
+		oscap_xml_stream_flush(stream, root_node);
 	}
 	xccdf_profile_iterator_free(profiles);
 
@@ -355,25 +370,31 @@ xmlNode *xccdf_benchmark_to_dom(struct xccdf_benchmark *benchmark, xmlDocPtr doc
 	while (xccdf_value_iterator_has_more(values)) {
 		struct xccdf_value *value = xccdf_value_iterator_next(values);
 		xccdf_item_to_dom(XITEM(value), doc, root_node, version_info);
+		oscap_xml_stream_flush(stream, root_node);
 	}
 	xccdf_value_iterator_free(values);
 
 	struct xccdf_item_iterator *items = xccdf_benchmark_get_content(benchmark);
 	while (xccdf_item_iterator_has_more(items)) {
 		struct xccdf_item *item = xccdf_item_iterator_next(items);
-		if (XBENCHMARK(xccdf_item_get_parent(item)) == benchmark)
+		if (XBENCHMARK(xccdf_item_get_parent(item)) == benchmark) {
 			xccdf_item_to_dom(item, doc, root_node, version_info);
+			oscap_xml_stream_flush(stream, root_node);
+		}
 	}
 	xccdf_item_iterator_free(items);
 
 	struct xccdf_result_iterator *results = xccdf_benchmark_get_results(benchmark);
 	while (xccdf_result_iterator_has_more(results)) {
 		struct xccdf_result *result = xccdf_result_iterator_next(results);
-		xccdf_item_to_dom(XITEM(result), doc, root_node, version_info);
+		xmlNode *result_node = xccdf_item_to_dom(XITEM(result), doc, root_node, version_info);
+		xccdf_result_to_dom(result, result_node, doc, root_node, false, stream);
+		oscap_xml_stream_end_element(stream, result_node);
 	}
 	xccdf_result_iterator_free(results);
 
-	return root_node;
+	oscap_xml_stream_end_element(stream, root_node);
+	return stream ? NULL : root_node;
 }
 
 void xccdf_benchmark_dump(struct xccdf_benchmark *benchmark)
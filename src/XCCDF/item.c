@@ -486,8 +486,8 @@ xmlNode *xccdf_item_to_dom(struct xccdf_item *item, xmlDoc *doc, xmlNode *parent
 			xccdf_profile_to_dom(XPROFILE(item), item_node, doc, parent, version_info);
 			break;
 		case XCCDF_RESULT:
+			/* The rest is filled in by xccdf_result_to_dom() */
 			xmlNodeSetName(item_node,BAD_CAST "TestResult");
-			if (parent) xccdf_result_to_dom(XRESULT(item), item_node, doc, parent, false);
 			break;
 		case XCCDF_GROUP:
 			xmlNodeSetName(item_node,BAD_CAST "Group");
@@ -104,6 +104,14 @@ OSCAP_API bool xccdf_session_is_sds(const struct xccdf_session *session);
  */
 OSCAP_API void xccdf_session_set_rule(struct xccdf_session *session, const char *rule);
 
+/**
+ * Set number of worker threads used to evaluate the XCCDF rules.
+ * @memberof xccdf_session
+ * @param session XCCDF Session
+ * @param jobs number of worker threads, 0 or 1 (default) means serial evaluation
+ */
+OSCAP_API void xccdf_session_set_jobs(struct xccdf_session *session, unsigned int jobs);
+
 /**
  * Set XSD validation level to one of three possibilities:
  *	- None: 	All XSD validations will be skipped.
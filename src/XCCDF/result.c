@@ -26,6 +26,7 @@
 
 #include <math.h>
 #include <string.h>
+#include <pthread.h>
 
 #ifdef OS_WINDOWS
  /* By defining WIN32_LEAN_AND_MEAN we ensure that Windows.h won't include
@@ -889,7 +890,7 @@ struct oscap_source *xccdf_result_export_source(struct xccdf_result *result, con
 		return NULL;
 	}
 
-	xccdf_result_to_dom(result, NULL, doc, NULL, false);
+	xccdf_result_to_dom(result, NULL, doc, NULL, false, NULL);
 	return oscap_source_new_from_xmlDoc(doc, filepath);
 }
 
@@ -901,11 +902,11 @@ struct oscap_source *xccdf_result_stig_viewer_export_source(struct xccdf_result
 		return NULL;
 	}
 
-	xccdf_result_to_dom(result, NULL, doc, NULL, true);
+	xccdf_result_to_dom(result, NULL, doc, NULL, true, NULL);
 	return oscap_source_new_from_xmlDoc(doc, filepath);
 }
 
-void xccdf_result_to_dom(struct xccdf_result *result, xmlNode *result_node, xmlDoc *doc, xmlNode *parent, bool use_stig_rule_id)
+void xccdf_result_to_dom(struct xccdf_result *result, xmlNode *result_node, xmlDoc *doc, xmlNode *parent, bool use_stig_rule_id, struct oscap_xml_stream *stream)
 {
         xmlNs *ns_xccdf = NULL;
 	struct xccdf_benchmark *associated_benchmark = xccdf_result_get_benchmark(result);
@@ -1133,9 +1134,13 @@ void xccdf_result_to_dom(struct xccdf_result *result, xmlNode *result_node, xmlD
 		}
 		xccdf_rule_result_iterator_reset(rule_results);
 	}
+	/* Attributes are complete, rule results can be written out one by one */
+	oscap_xml_stream_start_element(stream, result_node);
+	oscap_xml_stream_flush(stream, result_node);
 	while (xccdf_rule_result_iterator_has_more(rule_results)) {
 		struct xccdf_rule_result *rule_result = xccdf_rule_result_iterator_next(rule_results);
 		xccdf_rule_result_to_dom(rule_result, doc, result_node, version_info, associated_benchmark, use_stig_rule_id, nodes_by_rule_id);
+		oscap_xml_stream_flush(stream, result_node);
 	}
 	xccdf_rule_result_iterator_free(rule_results);
 
@@ -1577,21 +1582,25 @@ void xccdf_result_dump(struct xccdf_result *res, int depth)
 	}
 }
 
+#define XCCDF_TIMESTAMP_TEMPLATE "yyyy-mm-ddThh:mm:ss+zz:zz"
+
+/* localtime(3) and the timezone variable are shared by all threads */
+static pthread_mutex_t _timestamp_lock = PTHREAD_MUTEX_INITIALIZER;
+
 /*
  * @returns pointer to text representation of the current local time
- * and NULL on failure. The string is statically allocated and might
- * be overwritten on subsequent calls to this function
+ * stored in the given buffer and NULL on failure.
  */
-static inline const char *_get_timestamp(void)
+static inline const char *_get_timestamp(char *timestamp, size_t size)
 {
-	static char timestamp[] = "yyyy-mm-ddThh:mm:ss+zz:zz";
 	time_t tm;
-	struct tm *lt;
+	struct tm lt;
 	int tz_diff;
 	char tz_sign;
 
 	tm = time(NULL);
-	lt = localtime(&tm);
+	pthread_mutex_lock(&_timestamp_lock);
+	lt = *localtime(&tm);
 	/* timezone is a global variable set by localtime(3) */
 	if (timezone <= 0) {
 		tz_sign = '+';
@@ -1600,10 +1609,11 @@ static inline const char *_get_timestamp(void)
 		tz_sign = '-';
 		tz_diff = timezone;
 	}
+	pthread_mutex_unlock(&_timestamp_lock);
 	tz_diff /= 60;
-	int ret = snprintf(timestamp, sizeof(timestamp), "%4d-%02d-%02dT%02d:%02d:%02d%c%02d:%02d",
-		1900 + lt->tm_year, 1 + lt->tm_mon, lt->tm_mday,
-		lt->tm_hour, lt->tm_min, lt->tm_sec, tz_sign, tz_diff / 60, tz_diff % 60);
+	int ret = snprintf(timestamp, size, "%4d-%02d-%02dT%02d:%02d:%02d%c%02d:%02d",
+		1900 + lt.tm_year, 1 + lt.tm_mon, lt.tm_mday,
+		lt.tm_hour, lt.tm_min, lt.tm_sec, tz_sign, tz_diff / 60, tz_diff % 60);
 	if (ret < 0) {
 		return NULL;
 	}
@@ -1612,7 +1622,10 @@ static inline const char *_get_timestamp(void)
 
 #define XCCDF_CURRENT_TIME_SETTER(TYPE, BOUND) \
 	int xccdf_##TYPE##_set##BOUND##time_current(struct xccdf_##TYPE *r) \
-	{ return xccdf_##TYPE##_set##BOUND##time(r, _get_timestamp()); }
+	{ \
+		char timestamp[sizeof(XCCDF_TIMESTAMP_TEMPLATE)]; \
+		return xccdf_##TYPE##_set##BOUND##time(r, _get_timestamp(timestamp, sizeof(timestamp))); \
+	}
 
 XCCDF_CURRENT_TIME_SETTER(rule_result,_)
 XCCDF_CURRENT_TIME_SETTER(result,_start_)
@@ -68,6 +68,7 @@ struct oval_content_resource {
 struct xccdf_session {
 	const char *filename;				///< File name of SCAP (SDS or XCCDF) file for this session.
 	const char *rule;				///< Single-rule feature: if not NULL, the session will work only with this one rule.
+	unsigned int jobs;				///< Number of worker threads evaluating the rules.
 	struct oscap_source *source;                    ///< Main source assigned with the main file (SDS or XCCDF)
 	char *temp_dir;					///< Temp directory used for decomposed component files.
 	struct {
@@ -77,6 +78,7 @@ struct xccdf_session {
 		struct xccdf_result *result;		///< XCCDF Result model.
 		float base_score;			///< Basec score of the latest evaluation.
 		struct oscap_source *result_source;     ///< oscap_source for the exported XCCDF result
+		bool result_exported;                   ///< The result was added to the benchmark and exported, possibly without result_source
 	} xccdf;
 	struct {
 		struct ds_sds_session *session;         ///< SDS Registry abstract structure
@@ -223,21 +225,22 @@ static int _xccdf_session_autonegotiate_tailoring_file(struct xccdf_session *ses
 
 static void xccdf_session_unload_check_engine_plugins(struct xccdf_session *session);
 
+static struct oscap_source *_xccdf_session_get_sds_source(struct xccdf_session *session)
+{
+	if (xccdf_session_is_sds(session)) {
+		return session->source;
+	}
+	xmlDocPtr sds_doc = ds_sds_compose_xmlDoc_from_xccdf_source(session->source);
+	return oscap_source_new_from_xmlDoc(sds_doc, NULL);
+}
+
 static struct oscap_source* xccdf_session_create_arf_source(struct xccdf_session *session)
 {
 	if (session->oval.arf_report != NULL) {
 		return session->oval.arf_report;
 	}
 
-	struct oscap_source *sds_source = NULL;
-
-	if (xccdf_session_is_sds(session)) {
-		sds_source = session->source;
-	} else {
-		xmlDocPtr sds_doc = ds_sds_compose_xmlDoc_from_xccdf_source(session->source);
-		sds_source = oscap_source_new_from_xmlDoc(sds_doc, NULL);
-	}
-
+	struct oscap_source *sds_source = _xccdf_session_get_sds_source(session);
 	session->oval.arf_report = ds_rds_create_source(sds_source, session->tailoring.user_file, session->xccdf.result_source, session->oval.result_sources, session->oval.results_mapping, session->oval.arf_report_mapping, session->export.arf_file);
 	if (!xccdf_session_is_sds(session)) {
 		oscap_source_free(sds_source);
@@ -245,6 +248,16 @@ static struct oscap_source* xccdf_session_create_arf_source(struct xccdf_session
 	return session->oval.arf_report;
 }
 
+static int xccdf_session_export_arf_file(struct xccdf_session *session)
+{
+	struct oscap_source *sds_source = _xccdf_session_get_sds_source(session);
+	int ret = ds_rds_export(sds_source, session->tailoring.user_file, session->xccdf.result_source, session->oval.result_sources, session->oval.results_mapping, session->oval.arf_report_mapping, session->export.arf_file);
+	if (!xccdf_session_is_sds(session)) {
+		oscap_source_free(sds_source);
+	}
+	return ret;
+}
+
 void xccdf_session_free(struct xccdf_session *session)
 {
 	if (session == NULL)
@@ -295,6 +308,11 @@ void xccdf_session_set_rule(struct xccdf_session *session, const char *rule)
 	session->rule = rule;
 }
 
+void xccdf_session_set_jobs(struct xccdf_session *session, unsigned int jobs)
+{
+	session->jobs = jobs;
+}
+
 void xccdf_session_set_validation(struct xccdf_session *session, bool validate, bool full_validation)
 {
 	session->validate = validate;
@@ -1190,6 +1208,7 @@ int xccdf_session_evaluate(struct xccdf_session *session)
 		return 1;
 	}
 	policy->rule = session->rule;
+	xccdf_policy_set_jobs(policy, session->jobs);
 
 	session->xccdf.result = xccdf_policy_evaluate(policy);
 	if (session->xccdf.result == NULL)
@@ -1269,7 +1288,7 @@ static inline int _xccdf_gen_report(struct oscap_source *infile, const char *id,
 
 static int _build_xccdf_result_source(struct xccdf_session *session)
 {
-	if (session->xccdf.result_source != NULL) {
+	if (session->xccdf.result_source != NULL || session->xccdf.result_exported) {
 		return 0;
 	}
 
@@ -1284,9 +1303,22 @@ static int _build_xccdf_result_source(struct xccdf_session *session)
 		}
 		struct xccdf_result* cloned_result = xccdf_result_clone(session->xccdf.result);
 		xccdf_benchmark_add_result(benchmark, cloned_result);
-		session->xccdf.result_source = xccdf_benchmark_export_source(benchmark, session->export.xccdf_file);
+		session->xccdf.result_exported = true;
+
+		if (session->export.report_file == NULL && session->export.arf_file == NULL &&
+				!(session->validate && session->full_validation)) {
+			/* Nothing else needs the document, write it out while it's being built */
+			if (session->export.xccdf_file != NULL &&
+					xccdf_benchmark_export(benchmark, session->export.xccdf_file) != 0) {
+				oscap_seterr(OSCAP_EFAMILY_OSCAP, "Could not save file: %s",
+						session->export.xccdf_file);
+				return -1;
+			}
+		} else {
+			session->xccdf.result_source = xccdf_benchmark_export_source(benchmark, session->export.xccdf_file);
+		}
 
-		if (session->export.xccdf_file != NULL) {
+		if (session->xccdf.result_source != NULL && session->export.xccdf_file != NULL) {
 			// Export XCCDF result file only when explicitly requested
 			if (oscap_source_save_as(session->xccdf.result_source, NULL) != 0) {
 				oscap_seterr(OSCAP_EFAMILY_OSCAP, "Could not save file: %s",
@@ -1602,7 +1634,13 @@ int xccdf_session_export_check_engine_plugins(struct xccdf_session *session)
 
 int xccdf_session_export_arf(struct xccdf_session *session)
 {
-	if (session->export.arf_file != NULL) {
+	if (session->export.arf_file != NULL && session->oval.arf_report == NULL && !session->full_validation) {
+		/* Nothing else needs the document, write it out while it's being built */
+		if (xccdf_session_export_arf_file(session) != 0) {
+			return 1;
+		}
+	}
+	else if (session->export.arf_file != NULL) {
 		struct oscap_source* arf_source = xccdf_session_create_arf_source(session);
 		if (arf_source == NULL) {
 			return 1;
@@ -239,6 +239,20 @@ OSCAP_API struct oscap_htable_iterator *xccdf_policy_model_get_cpe_oval_sessions
  */
 OSCAP_API bool xccdf_policy_model_register_engine_and_query_callback(struct xccdf_policy_model *model, char *sys, xccdf_policy_engine_eval_fn eval_fn, void *usr, xccdf_policy_engine_query_fn query_fn);
 
+/**
+ * Function to register callback for checking system which can be called by
+ * several threads at once. Calls of the other checking engines are serialized
+ * when the policy is evaluated by more than one job, see xccdf_policy_set_jobs.
+ * @param model XCCDF Policy Model
+ * @param sys String representing given checking system
+ * @param eval_fn Reentrant callback - pointer to function called by XCCDF Policy system when rule parsed
+ * @param usr optional parameter for passing user data to callback
+ * @param query_fn - optional parameter for providing xccdf_policy_engine_query_fn implementation for given system.
+ * @memberof xccdf_policy_model
+ * @return true if callback registered succesfully, false otherwise
+ */
+OSCAP_API bool xccdf_policy_model_register_reentrant_engine_and_query_callback(struct xccdf_policy_model *model, char *sys, xccdf_policy_engine_eval_fn eval_fn, void *usr, xccdf_policy_engine_query_fn query_fn);
+
 typedef int (*policy_reporter_output)(struct xccdf_rule_result *, void *);
 
 /**
@@ -346,6 +360,13 @@ OSCAP_API struct xccdf_profile * xccdf_policy_get_profile(const struct xccdf_pol
  */
 OSCAP_API struct xccdf_select_iterator * xccdf_policy_get_selects(const struct xccdf_policy *);
 
+/**
+ * Get number of worker threads used to evaluate the rules of the Policy
+ * @memberof xccdf_policy
+ * @return number of jobs, 0 or 1 means that rules are evaluated serially
+ */
+OSCAP_API unsigned int xccdf_policy_get_jobs(const struct xccdf_policy *);
+
 /**
  * Get variable name from value bindings
  * @memberof xccdf_value_binding
@@ -449,6 +470,19 @@ OSCAP_API bool xccdf_policy_add_result(struct xccdf_policy * policy, struct xccd
  */
 OSCAP_API bool xccdf_policy_add_value(struct xccdf_policy *, struct xccdf_value_binding *);
 
+/**
+ * Set number of worker threads used to evaluate the rules of the Policy.
+ * With more than one job the rules are evaluated in parallel, calls of
+ * each checking engine which isn't registered as reentrant and of the
+ * reporting callbacks are still serialized and the TestResult lists
+ * rule-results in the document order.
+ * @memberof xccdf_policy
+ * @param policy XCCDF Policy
+ * @param jobs number of worker threads, 0 or 1 means serial evaluation
+ * @return true on success
+ */
+OSCAP_API bool xccdf_policy_set_jobs(struct xccdf_policy *policy, unsigned int jobs);
+
 /**
  * Get the selection settings of the item.
  * @memberof xccdf_policy
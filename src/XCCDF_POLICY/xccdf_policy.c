@@ -30,6 +30,8 @@
 #include <stdlib.h>
 #include <stdio.h>
 #include <string.h>
+#include <errno.h>
+#include <pthread.h>
 
 #include "xccdf_policy_priv.h"
 #include "xccdf_policy_model_priv.h"
@@ -51,6 +53,7 @@
 #include "common/_error.h"
 #include "common/debug_priv.h"
 #include "common/text_priv.h"
+#include "common/profiler_priv.h"
 #include "XCCDF/result_scoring_priv.h"
 #include "xccdf_policy_resolve.h"
 #include "oscap_helpers.h"
@@ -62,6 +65,7 @@ OSCAP_IGETINS_GEN(xccdf_policy, xccdf_policy_model, policies, policy)
 /* Macros to generate iterators, getters and setters */
 OSCAP_GETTER(struct xccdf_policy_model *, xccdf_policy, model)
 OSCAP_GETTER(struct xccdf_profile *, xccdf_policy, profile)
+OSCAP_ACCESSOR_SIMPLE(unsigned int, xccdf_policy, jobs)
 OSCAP_IGETTER(xccdf_select, xccdf_policy, selects)
 OSCAP_IGETINS_GEN(xccdf_value_binding, xccdf_policy, values, value)
 OSCAP_IGETINS(xccdf_result, xccdf_policy, results, result)
@@ -694,19 +698,81 @@ static struct xccdf_rule_result * _xccdf_rule_result_new_from_rule(const struct
 	return rule_ritem;
 }
 
+/**
+ * Report postponed by a worker thread of parallel evaluation. Reporting
+ * callbacks are not required to be thread safe, so the workers only record
+ * them and the main thread replays them in the document order.
+ */
+struct xccdf_policy_report_event {
+	const char *sysname;			///< identifier of the reporting callback
+	void *data;				///< xccdf:Rule, xccdf:rule-result or oval_definition
+	bool report;				///< false if the rule-result shall only be added to TestResult
+};
+
+/**
+ * Evaluation of a single xccdf:Rule scheduled for a worker thread.
+ */
+struct xccdf_policy_rule_job {
+	const struct xccdf_rule *rule;
+	struct oscap_list *events;		///< postponed reports (xccdf_policy_report_event)
+	pthread_mutex_t *lock;			///< serializes the non-reentrant parts of rule evaluation
+	pthread_mutex_t *sched_lock;		///< lock of the scheduler, protects the policy state
+	int ret;				///< return value of the rule evaluation
+	char *error;				///< error raised in the worker thread
+	bool done;
+	bool failed;				///< a report couldn't be recorded, the rule has to be evaluated again
+};
+
+static int _xccdf_policy_rule_job_report(struct xccdf_policy *policy, struct xccdf_policy_rule_job *job,
+					const char *sysname, void *data, bool report)
+{
+	if (job == NULL)
+		return report ? xccdf_policy_report_cb(policy, sysname, data) : 0;
+
+	struct xccdf_policy_report_event *event = NULL;
+	if (job->events != NULL && !job->failed)
+		event = malloc(sizeof(struct xccdf_policy_report_event));
+	if (event == NULL) {
+		/* Out of memory, the main thread evaluates the rule again */
+		job->failed = true;
+		if (strcmp(sysname, XCCDF_POLICY_OUTCB_END) == 0)
+			xccdf_rule_result_free((struct xccdf_rule_result *) data);
+		return 0;
+	}
+	event->sysname = sysname;
+	event->data = data;
+	event->report = report;
+	oscap_list_add(job->events, event);
+	return 0;
+}
+
 static int _xccdf_policy_report_rule_result(struct xccdf_policy *policy,
 					    struct xccdf_result *result,
+					    struct xccdf_policy_rule_job *job,
 					    const struct xccdf_rule *rule,
 					    struct xccdf_check *check,
 					    int res,
 					    const char *message)
 {
 	struct xccdf_rule_result * rule_result = NULL;
-	int ret=0;
 
 	if (res == -1)
 		return res;
 
+	/* If policy selects only one rule, skip reporting for the other
+	 * unselected rules - only the selected rule will be reported. */
+	bool report = true;
+	if (policy->rule != NULL) {
+		const char* rule_id = xccdf_rule_get_id(rule);
+		report = strcmp(policy->rule, rule_id) == 0;
+	}
+
+	if (job != NULL) {
+		/* The main thread adds the rule-result to TestResult */
+		rule_result = _xccdf_rule_result_new_from_rule(policy, rule, check, res, message);
+		return _xccdf_policy_rule_job_report(policy, job, XCCDF_POLICY_OUTCB_END, rule_result, report);
+	}
+
 	if (result != NULL) {
 		/* Add result to policy */
 		/* TODO: instance */
@@ -715,15 +781,7 @@ static int _xccdf_policy_report_rule_result(struct xccdf_policy *policy,
 	} else
 		xccdf_check_free(check);
 
-	/* If policy selects only one rule, skip reporting for the other
-	 * unselected rules - only the selected rule will be reported. */
-	if (policy->rule != NULL) {
-		const char* rule_id = xccdf_rule_get_id(rule);
-		if (strcmp(policy->rule, rule_id) != 0)
-			return ret;
-	}
-	ret = xccdf_policy_report_cb(policy, XCCDF_POLICY_OUTCB_END, (void *) rule_result);
-	return ret;
+	return _xccdf_policy_rule_job_report(policy, NULL, XCCDF_POLICY_OUTCB_END, rule_result, report);
 }
 
 struct cpe_check_cb_usr
@@ -978,7 +1036,7 @@ bool xccdf_policy_model_item_is_applicable(struct xccdf_policy_model *model, str
  * which is (in general) not predictable in any way.
  */
 static inline int
-_xccdf_policy_rule_evaluate(struct xccdf_policy * policy, const struct xccdf_rule *rule, struct xccdf_result *result)
+_xccdf_policy_rule_evaluate(struct xccdf_policy * policy, const struct xccdf_rule *rule, struct xccdf_result *result, struct xccdf_policy_rule_job *job)
 {
 	const char* rule_id = xccdf_rule_get_id(rule);
 	const bool is_selected = xccdf_policy_is_item_selected(policy, rule_id);
@@ -990,12 +1048,16 @@ _xccdf_policy_rule_evaluate(struct xccdf_policy * policy, const struct xccdf_rul
 	 * mark it as notselected. */
 	if (policy->rule != NULL) {
 		if (strcmp(policy->rule, rule_id) != 0) {
-			return _xccdf_policy_report_rule_result(policy, result, rule, NULL, XCCDF_RESULT_NOT_SELECTED, NULL);
+			return _xccdf_policy_report_rule_result(policy, result, job, rule, NULL, XCCDF_RESULT_NOT_SELECTED, NULL);
 		}
+		if (job != NULL)
+			pthread_mutex_lock(job->sched_lock);
 		policy->rule_found = 1;
+		if (job != NULL)
+			pthread_mutex_unlock(job->sched_lock);
 	}
 	/* Otherwise start reporting */
-	report = xccdf_policy_report_cb(policy, XCCDF_POLICY_OUTCB_START, (void *) rule);
+	report = _xccdf_policy_rule_job_report(policy, job, XCCDF_POLICY_OUTCB_START, (void *) rule, true);
 	if (report)
 		return report;
 
@@ -1003,28 +1065,33 @@ _xccdf_policy_rule_evaluate(struct xccdf_policy * policy, const struct xccdf_rul
 	xccdf_role_t role = xccdf_get_final_role(rule, r_rule);
 
 	if (!is_selected) {
-		return _xccdf_policy_report_rule_result(policy, result, rule, NULL, XCCDF_RESULT_NOT_SELECTED, NULL);
+		return _xccdf_policy_report_rule_result(policy, result, job, rule, NULL, XCCDF_RESULT_NOT_SELECTED, NULL);
 	}
 	dI("Evaluating XCCDF rule '%s'.", rule_id);
 
 	if (role == XCCDF_ROLE_UNCHECKED)
-		return _xccdf_policy_report_rule_result(policy, result, rule, NULL, XCCDF_RESULT_NOT_CHECKED, NULL);
+		return _xccdf_policy_report_rule_result(policy, result, job, rule, NULL, XCCDF_RESULT_NOT_CHECKED, NULL);
 
+	/* CPE applicability checks share caches of the policy model */
+	if (job != NULL)
+		pthread_mutex_lock(job->lock);
 	const bool is_applicable = xccdf_policy_model_item_is_applicable(policy->model, (struct xccdf_item*)rule);
+	if (job != NULL)
+		pthread_mutex_unlock(job->lock);
 	if (!is_applicable) {
 		dI("Rule '%s' is not applicable.", rule_id);
-		return _xccdf_policy_report_rule_result(policy, result, rule, NULL, XCCDF_RESULT_NOT_APPLICABLE, NULL);
+		return _xccdf_policy_report_rule_result(policy, result, job, rule, NULL, XCCDF_RESULT_NOT_APPLICABLE, NULL);
 	}
 
 	const struct xccdf_check *orig_check = _xccdf_policy_rule_get_applicable_check(policy, (struct xccdf_item *) rule);
 	if (orig_check == NULL)
 		// No candidate or applicable check found.
-		return _xccdf_policy_report_rule_result(policy, result, rule, NULL, XCCDF_RESULT_NOT_CHECKED, "No candidate or applicable check found.");
+		return _xccdf_policy_report_rule_result(policy, result, job, rule, NULL, XCCDF_RESULT_NOT_CHECKED, "No candidate or applicable check found.");
 
 	// we need to clone the check to avoid changing the original content
 	struct xccdf_check *check = xccdf_check_clone(orig_check);
 	if (xccdf_check_get_complex(check))
-		return _xccdf_policy_report_rule_result(policy, result, rule, check, xccdf_policy_check_evaluate(policy, check), NULL);
+		return _xccdf_policy_report_rule_result(policy, result, job, rule, check, xccdf_policy_check_evaluate(policy, check), NULL);
 
 	// Now we are evaluating single simple xccdf:check within xccdf:rule.
 	// Since the fact that a check will yield multi-check is not predictable in general
@@ -1035,7 +1102,7 @@ _xccdf_policy_rule_evaluate(struct xccdf_policy * policy, const struct xccdf_rul
 	const char *system_name = xccdf_check_get_system(check);
 	struct oscap_list *bindings = xccdf_policy_check_get_value_bindings(policy, xccdf_check_get_exports(check));
 	if (bindings == NULL)
-		return _xccdf_policy_report_rule_result(policy, result, rule, check, XCCDF_RESULT_UNKNOWN, "Value bindings not found.");
+		return _xccdf_policy_report_rule_result(policy, result, job, rule, check, XCCDF_RESULT_UNKNOWN, "Value bindings not found.");
 
 
 	struct xccdf_check_content_ref_iterator *content_it = xccdf_check_get_content_refs(check);
@@ -1058,7 +1125,7 @@ _xccdf_policy_rule_evaluate(struct xccdf_policy * policy, const struct xccdf_rul
 				if (!oscap_iterator_has_more(oval_definition_iterator)) {
 					// Super special case when oval file contains no definitions
 					// thus multi-check shall yield zero rule-results.
-					report = _xccdf_policy_report_rule_result(policy, result, rule, check, XCCDF_RESULT_UNKNOWN, "No definitions found for @multi-check.");
+					report = _xccdf_policy_report_rule_result(policy, result, job, rule, check, XCCDF_RESULT_UNKNOWN, "No definitions found for @multi-check.");
 					oscap_iterator_free(oval_definition_iterator);
 					oscap_list_free(oval_definition_list, NULL);
 					xccdf_check_content_ref_iterator_free(content_it);
@@ -1067,7 +1134,7 @@ _xccdf_policy_rule_evaluate(struct xccdf_policy * policy, const struct xccdf_rul
 				}
 				while (oscap_iterator_has_more(oval_definition_iterator)) {
 					struct oval_definition *oval_definition = oscap_iterator_next(oval_definition_iterator);
-					if ((report = xccdf_policy_report_cb(policy, XCCDF_POLICY_OUTCB_MULTICHECK, (void *) oval_definition)) != 0) {
+					if ((report = _xccdf_policy_rule_job_report(policy, job, XCCDF_POLICY_OUTCB_MULTICHECK, (void *) oval_definition, true)) != 0) {
 						break;
 					}
 					struct xccdf_check *cloned_check = xccdf_check_clone(check);
@@ -1078,10 +1145,10 @@ _xccdf_policy_rule_evaluate(struct xccdf_policy * policy, const struct xccdf_rul
 						report = inner_ret;
 						break;
 					}
-					if ((report = _xccdf_policy_report_rule_result(policy, result, rule, cloned_check, inner_ret, NULL)) != 0)
+					if ((report = _xccdf_policy_report_rule_result(policy, result, job, rule, cloned_check, inner_ret, NULL)) != 0)
 						break;
 					if (oscap_iterator_has_more(oval_definition_iterator)) {
-						if ((report = xccdf_policy_report_cb(policy, XCCDF_POLICY_OUTCB_START, (void *) rule)) != 0)
+						if ((report = _xccdf_policy_rule_job_report(policy, job, XCCDF_POLICY_OUTCB_START, (void *) rule, true)) != 0)
 							break;
 					}
 				}
@@ -1119,7 +1186,26 @@ _xccdf_policy_rule_evaluate(struct xccdf_policy * policy, const struct xccdf_rul
 	oscap_list_free(bindings, (oscap_destruct_func) xccdf_value_binding_free);
 	/* Negate only once */
 	ret = _resolve_negate(ret, check);
-	return _xccdf_policy_report_rule_result(policy, result, rule, check, ret, message);
+	return _xccdf_policy_report_rule_result(policy, result, job, rule, check, ret, message);
+}
+
+/**
+ * Evaluate the rule and record the time spent by the profiler.
+ * Rules which aren't selected are not recorded.
+ */
+static int
+_xccdf_policy_rule_evaluate_profiled(struct xccdf_policy * policy, const struct xccdf_rule *rule, struct xccdf_result *result, struct xccdf_policy_rule_job *job)
+{
+	oscap_prof_timer_t timer;
+	const char *rule_id = xccdf_rule_get_id(rule);
+
+	oscap_prof_start(&timer);
+	int ret = _xccdf_policy_rule_evaluate(policy, rule, result, job);
+	if (timer.running && xccdf_policy_is_item_selected(policy, rule_id)
+	    && (policy->rule == NULL || strcmp(policy->rule, rule_id) == 0))
+		oscap_prof_stop(&timer, OSCAP_PROF_RULE, rule_id, 0);
+
+	return ret;
 }
 
 /** 
@@ -1137,7 +1223,7 @@ static int xccdf_policy_item_evaluate(struct xccdf_policy * policy, struct xccdf
 
     switch (itype) {
         case XCCDF_RULE:{
-			return _xccdf_policy_rule_evaluate(policy, (struct xccdf_rule *) item, result);
+			return _xccdf_policy_rule_evaluate_profiled(policy, (struct xccdf_rule *) item, result, NULL);
         } break;
 
         case XCCDF_GROUP:{
@@ -1161,6 +1247,232 @@ static int xccdf_policy_item_evaluate(struct xccdf_policy * policy, struct xccdf
     return ret;
 }
 
+/**
+ * Collect the rules of the given item in the document order.
+ */
+static void _xccdf_policy_item_collect_rules(struct xccdf_item *item, struct oscap_list *rules)
+{
+	switch (xccdf_item_get_type(item)) {
+	case XCCDF_RULE:
+		oscap_list_add(rules, item);
+		break;
+	case XCCDF_GROUP: {
+		struct xccdf_item_iterator *child_it = xccdf_group_get_content((const struct xccdf_group *) item);
+		while (xccdf_item_iterator_has_more(child_it))
+			_xccdf_policy_item_collect_rules(xccdf_item_iterator_next(child_it), rules);
+		xccdf_item_iterator_free(child_it);
+		} break;
+	default:
+		assert(false);
+		break;
+	}
+}
+
+/**
+ * Scheduler of parallel rule evaluation. Workers pick the rules in the
+ * document order while the main thread commits the finished ones in the
+ * same order, so that the TestResult and the output of the reporting
+ * callbacks are the same as in the serial evaluation.
+ */
+struct xccdf_policy_scheduler {
+	struct xccdf_policy *policy;
+	struct xccdf_policy_rule_job *jobs;
+	size_t count;
+	size_t next;				///< index of the next job to be picked by a worker
+	bool cancel;				///< set by the main thread to stop the workers
+	pthread_mutex_t lock;			///< protects next, cancel and done flags of the jobs
+	pthread_cond_t done_cond;		///< signalled whenever a job is finished
+	pthread_mutex_t eval_lock;		///< see xccdf_policy_rule_job.lock
+};
+
+static void *_xccdf_policy_scheduler_worker(void *arg)
+{
+	struct xccdf_policy_scheduler *sched = (struct xccdf_policy_scheduler *) arg;
+
+#if defined(HAVE_PTHREAD_SETNAME_NP)
+# if defined(OS_APPLE)
+	pthread_setname_np("xccdf_worker");
+# else
+	pthread_setname_np(pthread_self(), "xccdf_worker");
+# endif
+#endif
+	for (;;) {
+		pthread_mutex_lock(&sched->lock);
+		if (sched->cancel || sched->next >= sched->count) {
+			pthread_mutex_unlock(&sched->lock);
+			break;
+		}
+		struct xccdf_policy_rule_job *job = &sched->jobs[sched->next++];
+		pthread_mutex_unlock(&sched->lock);
+
+		job->ret = _xccdf_policy_rule_evaluate_profiled(sched->policy, job->rule, NULL, job);
+		/* The error queue is thread local, hand the errors over to the main thread */
+		job->error = oscap_err_get_full_error();
+
+		pthread_mutex_lock(&sched->lock);
+		job->done = true;
+		pthread_cond_broadcast(&sched->done_cond);
+		pthread_mutex_unlock(&sched->lock);
+	}
+	return NULL;
+}
+
+static void _xccdf_policy_rule_job_free_events(struct xccdf_policy_rule_job *job)
+{
+	struct oscap_iterator *it = oscap_iterator_new(job->events);
+	while (oscap_iterator_has_more(it)) {
+		struct xccdf_policy_report_event *event = oscap_iterator_next(it);
+		if (strcmp(event->sysname, XCCDF_POLICY_OUTCB_END) == 0)
+			xccdf_rule_result_free((struct xccdf_rule_result *) event->data);
+	}
+	oscap_iterator_free(it);
+	oscap_list_free(job->events, free);
+	job->events = NULL;
+}
+
+/**
+ * Commit the finished job: add its rule-results to the TestResult and
+ * replay the postponed reports.
+ */
+static int _xccdf_policy_rule_job_commit(struct xccdf_policy *policy, struct xccdf_policy_rule_job *job, struct xccdf_result *result)
+{
+	int ret = 0;
+
+	if (job->error != NULL) {
+		oscap_seterr(OSCAP_EFAMILY_XCCDF, "%s", job->error);
+		free(job->error);
+		job->error = NULL;
+	}
+
+	struct oscap_iterator *it = oscap_iterator_new(job->events);
+	while (oscap_iterator_has_more(it)) {
+		struct xccdf_policy_report_event *event = oscap_iterator_next(it);
+		const bool is_result = strcmp(event->sysname, XCCDF_POLICY_OUTCB_END) == 0;
+		if (ret != 0) {
+			/* The user has interrupted the evaluation, drop the remaining reports */
+			if (is_result)
+				xccdf_rule_result_free((struct xccdf_rule_result *) event->data);
+			continue;
+		}
+		if (is_result)
+			xccdf_result_add_rule_result(result, (struct xccdf_rule_result *) event->data);
+		if (event->report)
+			ret = xccdf_policy_report_cb(policy, event->sysname, event->data);
+	}
+	oscap_iterator_free(it);
+	oscap_list_free(job->events, free);
+	job->events = NULL;
+
+	return ret != 0 ? ret : job->ret;
+}
+
+/**
+ * Evaluate all rules of the benchmark by the worker threads.
+ * @returns the same value as xccdf_policy_item_evaluate would return in the
+ * serial evaluation of the first item which has not returned zero.
+ */
+static int _xccdf_policy_evaluate_parallel(struct xccdf_policy *policy, struct xccdf_benchmark *benchmark, struct xccdf_result *result)
+{
+	struct oscap_list *rules = oscap_list_new();
+	struct xccdf_item_iterator *item_it = xccdf_benchmark_get_content(benchmark);
+	while (xccdf_item_iterator_has_more(item_it))
+		_xccdf_policy_item_collect_rules(xccdf_item_iterator_next(item_it), rules);
+	xccdf_item_iterator_free(item_it);
+
+	struct xccdf_policy_scheduler sched = {
+		.policy = policy,
+		.count = oscap_list_get_itemcount(rules),
+		.next = 0,
+		.cancel = false,
+	};
+	sched.jobs = calloc(sched.count + 1, sizeof(struct xccdf_policy_rule_job));
+	if (sched.jobs == NULL) {
+		dW("Not enough memory for the parallel evaluation, evaluating the rules serially.");
+		int ret = 0;
+		struct oscap_iterator *rule_it = oscap_iterator_new(rules);
+		while (ret == 0 && oscap_iterator_has_more(rule_it))
+			ret = _xccdf_policy_rule_evaluate_profiled(policy, oscap_iterator_next(rule_it), result, NULL);
+		oscap_iterator_free(rule_it);
+		oscap_list_free0(rules);
+		return ret;
+	}
+	pthread_mutex_init(&sched.lock, NULL);
+	pthread_cond_init(&sched.done_cond, NULL);
+	pthread_mutex_init(&sched.eval_lock, NULL);
+
+	struct oscap_iterator *rule_it = oscap_iterator_new(rules);
+	for (size_t i = 0; oscap_iterator_has_more(rule_it); ++i) {
+		sched.jobs[i].rule = oscap_iterator_next(rule_it);
+		sched.jobs[i].events = oscap_list_new();
+		sched.jobs[i].lock = &sched.eval_lock;
+		sched.jobs[i].sched_lock = &sched.lock;
+	}
+	oscap_iterator_free(rule_it);
+	oscap_list_free0(rules);
+
+	size_t workers = policy->jobs < sched.count ? policy->jobs : sched.count;
+	pthread_t *threads = malloc((workers + 1) * sizeof(pthread_t));
+	if (threads == NULL)
+		workers = 0;
+	size_t started = 0;
+	while (started < workers) {
+		if (pthread_create(&threads[started], NULL, _xccdf_policy_scheduler_worker, &sched) != 0) {
+			dW("Failed to start the XCCDF worker thread: %s", strerror(errno));
+			break;
+		}
+		++started;
+	}
+	dI("Evaluating %zu rules by %zu worker threads.", sched.count, started);
+	if (started == 0) {
+		/* Fall back to the evaluation in the main thread */
+		_xccdf_policy_scheduler_worker(&sched);
+	}
+
+	int ret = 0;
+	size_t committed = 0;
+	while (committed < sched.count && ret == 0) {
+		struct xccdf_policy_rule_job *job = &sched.jobs[committed];
+		pthread_mutex_lock(&sched.lock);
+		while (!job->done)
+			pthread_cond_wait(&sched.done_cond, &sched.lock);
+		pthread_mutex_unlock(&sched.lock);
+
+		if (job->failed)
+			break;
+		ret = _xccdf_policy_rule_job_commit(policy, job, result);
+		++committed;
+	}
+
+	pthread_mutex_lock(&sched.lock);
+	sched.cancel = true;
+	pthread_mutex_unlock(&sched.lock);
+	for (size_t i = 0; i < started; ++i)
+		pthread_join(threads[i], NULL);
+	free(threads);
+
+	if (ret == 0 && committed < sched.count) {
+		/*
+		 * A worker ran out of memory, evaluate this rule and the rest
+		 * in the main thread now that the workers have stopped.
+		 */
+		dW("Not enough memory for the parallel evaluation, evaluating the remaining %zu rules serially.",
+		   sched.count - committed);
+		for (size_t i = committed; i < sched.count && ret == 0; ++i)
+			ret = _xccdf_policy_rule_evaluate_profiled(policy, sched.jobs[i].rule, result, NULL);
+	}
+
+	for (size_t i = 0; i < sched.count; ++i) {
+		if (sched.jobs[i].events != NULL)
+			_xccdf_policy_rule_job_free_events(&sched.jobs[i]);
+		free(sched.jobs[i].error);
+	}
+	free(sched.jobs);
+	pthread_mutex_destroy(&sched.eval_lock);
+	pthread_cond_destroy(&sched.done_cond);
+	pthread_mutex_destroy(&sched.lock);
+	return ret;
+}
+
 struct oscap_file_entry {
 	char* system_name;
 	char* file;
@@ -1562,7 +1874,15 @@ bool
 xccdf_policy_model_register_engine_and_query_callback(struct xccdf_policy_model *model, char *sys, xccdf_policy_engine_eval_fn eval_fn, void *usr, xccdf_policy_engine_query_fn query_fn)
 {
         __attribute__nonnull__(model);
-	struct xccdf_policy_engine *engine = xccdf_policy_engine_new(sys, eval_fn, usr, query_fn);
+	struct xccdf_policy_engine *engine = xccdf_policy_engine_new(sys, eval_fn, usr, query_fn, false);
+	return oscap_list_add(model->engines, engine);
+}
+
+bool
+xccdf_policy_model_register_reentrant_engine_and_query_callback(struct xccdf_policy_model *model, char *sys, xccdf_policy_engine_eval_fn eval_fn, void *usr, xccdf_policy_engine_query_fn query_fn)
+{
+	__attribute__nonnull__(model);
+	struct xccdf_policy_engine *engine = xccdf_policy_engine_new(sys, eval_fn, usr, query_fn, true);
 	return oscap_list_add(model->engines, engine);
 }
 
@@ -1570,14 +1890,14 @@ void xccdf_policy_model_unregister_engines(struct xccdf_policy_model *model, con
 {
 	__attribute__nonnull__(model);
 	if (sys == NULL)
-		oscap_list_free(model->engines, (oscap_destruct_func) free);
+		oscap_list_free(model->engines, (oscap_destruct_func) xccdf_policy_engine_free);
 	else {
 		struct oscap_list *rest = oscap_list_new();
 		struct oscap_iterator *cb_it = oscap_iterator_new(model->engines);
 		while (oscap_iterator_has_more(cb_it)) {
 			struct xccdf_policy_engine *engine = oscap_iterator_next(cb_it);
 			if (xccdf_policy_engine_filter(engine, sys))
-				free(engine);
+				xccdf_policy_engine_free(engine);
 			else
 				oscap_list_add(rest, engine);
 		}
@@ -2039,19 +2359,30 @@ struct xccdf_result * xccdf_policy_evaluate(struct xccdf_policy * policy)
 
 	/** We need to process document top-down order.
 	 * See conflicts/requires and Item Processing Algorithm */
-	struct xccdf_item_iterator *item_it = xccdf_benchmark_get_content(benchmark);
-	while (xccdf_item_iterator_has_more(item_it)) {
-		struct xccdf_item *item = xccdf_item_iterator_next(item_it);
-		ret = xccdf_policy_item_evaluate(policy, item, result);
+	if (policy->jobs > 1) {
+		/* Selection (including conflicts/requires) has been already resolved
+		 * by xccdf_policy_new, so the rules can be evaluated in any order as
+		 * long as the results are committed in the document order. */
+		ret = _xccdf_policy_evaluate_parallel(policy, benchmark, result);
 		if (ret == -1) {
-			xccdf_item_iterator_free(item_it);
 			xccdf_result_free(result);
 			return NULL;
 		}
-		if (ret != 0)
-			break;
+	} else {
+		struct xccdf_item_iterator *item_it = xccdf_benchmark_get_content(benchmark);
+		while (xccdf_item_iterator_has_more(item_it)) {
+			struct xccdf_item *item = xccdf_item_iterator_next(item_it);
+			ret = xccdf_policy_item_evaluate(policy, item, result);
+			if (ret == -1) {
+				xccdf_item_iterator_free(item_it);
+				xccdf_result_free(result);
+				return NULL;
+			}
+			if (ret != 0)
+				break;
+		}
+		xccdf_item_iterator_free(item_it);
 	}
-	xccdf_item_iterator_free(item_it);
 
 	if (policy->rule != NULL && !policy->rule_found) {
 		oscap_seterr(OSCAP_EFAMILY_XCCDF,
@@ -24,6 +24,8 @@
 #include <config.h>
 #endif
 
+#include <pthread.h>
+
 #include "common/util.h"
 #include "common/list.h"
 #include "common/_error.h"
@@ -35,9 +37,11 @@ struct xccdf_policy_engine {
 	xccdf_policy_engine_eval_fn callback;   ///< format of callback function
 	void * usr;                             ///< User data structure
 	xccdf_policy_engine_query_fn query_fn;  ///< query callback function
+	pthread_mutex_t lock;                   ///< serializes callbacks during parallel evaluation
+	bool reentrant;                         ///< callback may be called by several threads at once
 };
 
-struct xccdf_policy_engine *xccdf_policy_engine_new(char *sys, xccdf_policy_engine_eval_fn eval_fn, void *usr, xccdf_policy_engine_query_fn query_fn)
+struct xccdf_policy_engine *xccdf_policy_engine_new(char *sys, xccdf_policy_engine_eval_fn eval_fn, void *usr, xccdf_policy_engine_query_fn query_fn, bool reentrant)
 {
 	struct xccdf_policy_engine *engine = malloc(sizeof(struct xccdf_policy_engine));
         if (engine != NULL) {
@@ -45,10 +49,20 @@ struct xccdf_policy_engine *xccdf_policy_engine_new(char *sys, xccdf_policy_engi
 		engine->callback = eval_fn;
 		engine->usr = usr;
 		engine->query_fn = query_fn;
+		engine->reentrant = reentrant;
+		pthread_mutex_init(&engine->lock, NULL);
 	}
 	return engine;
 }
 
+void xccdf_policy_engine_free(struct xccdf_policy_engine *engine)
+{
+	if (engine == NULL)
+		return;
+	pthread_mutex_destroy(&engine->lock);
+	free(engine);
+}
+
 bool xccdf_policy_engine_filter(struct xccdf_policy_engine *engine, const char *sysname)
 {
 	return oscap_strcmp(engine->system, sysname) == 0;
@@ -61,8 +75,16 @@ xccdf_test_result_type_t xccdf_policy_engine_eval(struct xccdf_policy_engine *en
 		oscap_seterr(OSCAP_EFAMILY_XCCDF, "Unknown callback for given checking system. Set callback first");
 	}
 	else {
+		/* Checking engines are not required to be reentrant. When rules are
+		 * evaluated by several worker threads each engine which isn't
+		 * registered as reentrant still sees only one caller at a time. */
+		const bool serialize = !engine->reentrant && xccdf_policy_get_jobs(policy) > 1;
 		struct xccdf_value_binding_iterator * binding_it = (struct xccdf_value_binding_iterator *) oscap_iterator_new(value_bindings);
+		if (serialize)
+			pthread_mutex_lock(&engine->lock);
 		ret = engine->callback(policy, NULL, definition_id, href_id, binding_it, check_import_it, engine->usr);
+		if (serialize)
+			pthread_mutex_unlock(&engine->lock);
 		if (binding_it != NULL)
 			xccdf_value_binding_iterator_free(binding_it);
 	}
@@ -73,5 +95,8 @@ struct oscap_list *xccdf_policy_engine_query(struct xccdf_policy_engine *engine,
 {
 	if (engine->query_fn == NULL)
 		return NULL;
-	return (struct oscap_list *) engine->query_fn(engine->usr, query_type, query_data);
+	pthread_mutex_lock(&engine->lock);
+	struct oscap_list *result = (struct oscap_list *) engine->query_fn(engine->usr, query_type, query_data);
+	pthread_mutex_unlock(&engine->lock);
+	return result;
 }
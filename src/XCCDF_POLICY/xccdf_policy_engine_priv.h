@@ -43,9 +43,17 @@ struct xccdf_policy_engine;
  * @param eval_fn The eval function of newly created checking engine
  * @param usr User data structure
  * @param query_fn The query function of newly created checking engine
+ * @param reentrant Whether the eval function may be called by several threads at once
  * @returns newly created checking engine
  */
-struct xccdf_policy_engine *xccdf_policy_engine_new(char *sys, xccdf_policy_engine_eval_fn eval_fn, void *usr, xccdf_policy_engine_query_fn query_fn);
+struct xccdf_policy_engine *xccdf_policy_engine_new(char *sys, xccdf_policy_engine_eval_fn eval_fn, void *usr, xccdf_policy_engine_query_fn query_fn, bool reentrant);
+
+/**
+ * Free the checking engine structure
+ * @memberof xccdf_policy_engine
+ * @param engine Checking engine
+ */
+void xccdf_policy_engine_free(struct xccdf_policy_engine *engine);
 
 /**
  * Filter function returning true if given callback is for the given checking engine,
@@ -54,7 +62,9 @@ struct xccdf_policy_engine *xccdf_policy_engine_new(char *sys, xccdf_policy_engi
 bool xccdf_policy_engine_filter(struct xccdf_policy_engine *cb, const char *sysname);
 
 /**
- * Execute the eval function of the given checking engine
+ * Execute the eval function of the given checking engine. When the policy
+ * is evaluated by more than one job, calls of the engine are serialized
+ * unless the engine is reentrant.
  * @memberof xccdf_policy_engine
  * @param engine Checking engine
  * @param policy XCCDF Policy
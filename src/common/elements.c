@@ -275,3 +275,196 @@ xmlNs *lookup_xsi_ns(xmlDoc *doc)
 	}
 	return ns_xsi;
 }
+
+struct oscap_xml_stream {
+	xmlTextWriter *writer;
+	int fd;			///< file descriptor of the output, -1 for the standard output
+	int depth;		///< number of open elements
+	int size;		///< allocated size of has_content
+	bool *has_content;	///< whether the open elements have any children written
+	bool failed;
+};
+
+struct oscap_xml_stream *oscap_xml_stream_new(const char *filename)
+{
+	xmlOutputBuffer *buff;
+	int fd = -1;
+
+	if (strcmp(filename, "-") == 0) {
+		buff = xmlOutputBufferCreateFile(stdout, NULL);
+	} else {
+#ifdef OS_WINDOWS
+		fd = open(filename, O_CREAT|O_TRUNC|O_WRONLY, S_IREAD|S_IWRITE);
+#else
+		fd = open(filename, O_CREAT|O_TRUNC|O_WRONLY,
+				S_IRUSR|S_IWUSR|S_IRGRP|S_IWGRP|S_IROTH|S_IWOTH);
+#endif
+		if (fd < 0) {
+			oscap_seterr(OSCAP_EFAMILY_GLIBC, "%s '%s'", strerror(errno), filename);
+			return NULL;
+		}
+		buff = xmlOutputBufferCreateFd(fd, NULL);
+	}
+	if (buff == NULL) {
+		if (fd >= 0)
+			close(fd);
+		oscap_setxmlerr(xmlGetLastError());
+		return NULL;
+	}
+
+	xmlTextWriter *writer = xmlNewTextWriter(buff);
+	if (writer == NULL) {
+		xmlOutputBufferClose(buff);
+		if (fd >= 0)
+			close(fd);
+		oscap_setxmlerr(xmlGetLastError());
+		return NULL;
+	}
+
+	struct oscap_xml_stream *stream = calloc(1, sizeof(struct oscap_xml_stream));
+	if (stream == NULL) {
+		xmlFreeTextWriter(writer);
+		if (fd >= 0)
+			close(fd);
+		oscap_seterr(OSCAP_EFAMILY_GLIBC, "%s", strerror(errno));
+		return NULL;
+	}
+	stream->writer = writer;
+	stream->fd = fd;
+	if (xmlTextWriterStartDocument(writer, NULL, "UTF-8", NULL) < 0)
+		stream->failed = true;
+	return stream;
+}
+
+static char *oscap_xml_stream_qname(const xmlNs *ns, const xmlChar *name)
+{
+	if (ns != NULL && ns->prefix != NULL)
+		return oscap_sprintf("%s:%s", (const char *) ns->prefix, (const char *) name);
+	return oscap_strdup((const char *) name);
+}
+
+static void oscap_xml_stream_indent(struct oscap_xml_stream *stream)
+{
+	char indent[2 * stream->depth + 2];
+
+	indent[0] = '\n';
+	memset(indent + 1, ' ', 2 * stream->depth);
+	indent[2 * stream->depth + 1] = '\0';
+	if (xmlTextWriterWriteRaw(stream->writer, BAD_CAST indent) < 0)
+		stream->failed = true;
+}
+
+int oscap_xml_stream_start_element(struct oscap_xml_stream *stream, xmlNode *node)
+{
+	if (stream == NULL)
+		return 0;
+
+	if (stream->depth > 0) {
+		stream->has_content[stream->depth - 1] = true;
+		oscap_xml_stream_indent(stream);
+	}
+
+	char *qname = oscap_xml_stream_qname(node->ns, node->name);
+	if (xmlTextWriterStartElement(stream->writer, BAD_CAST qname) < 0)
+		stream->failed = true;
+	free(qname);
+
+	for (xmlNs *ns = node->nsDef; ns != NULL; ns = ns->next) {
+		char *attr = ns->prefix != NULL ? oscap_sprintf("xmlns:%s", (const char *) ns->prefix) : oscap_strdup("xmlns");
+		if (xmlTextWriterWriteAttribute(stream->writer, BAD_CAST attr, ns->href) < 0)
+			stream->failed = true;
+		free(attr);
+	}
+	for (xmlAttr *attr = node->properties; attr != NULL; attr = attr->next) {
+		xmlChar *value = xmlNodeListGetString(node->doc, attr->children, 1);
+		qname = oscap_xml_stream_qname(attr->ns, attr->name);
+		if (xmlTextWriterWriteAttribute(stream->writer, BAD_CAST qname, value != NULL ? value : BAD_CAST "") < 0)
+			stream->failed = true;
+		free(qname);
+		xmlFree(value);
+	}
+
+	if (stream->depth == stream->size) {
+		int size = stream->size ? 2 * stream->size : 8;
+		bool *has_content = realloc(stream->has_content, size * sizeof(bool));
+		if (has_content == NULL) {
+			stream->failed = true;
+			return -1;
+		}
+		stream->has_content = has_content;
+		stream->size = size;
+	}
+	stream->has_content[stream->depth++] = false;
+
+	return stream->failed ? -1 : 0;
+}
+
+int oscap_xml_stream_flush(struct oscap_xml_stream *stream, xmlNode *node)
+{
+	if (stream == NULL || stream->depth == 0)
+		return 0;
+
+	xmlNode *child = node->children;
+	while (child != NULL) {
+		xmlNode *next = child->next;
+		xmlOutputBuffer *buff = xmlAllocOutputBuffer(NULL);
+
+		if (buff != NULL) {
+			xmlNodeDumpOutput(buff, node->doc, child, stream->depth, 1, "UTF-8");
+			oscap_xml_stream_indent(stream);
+			if (xmlTextWriterWriteRawLen(stream->writer, xmlOutputBufferGetContent(buff), xmlOutputBufferGetSize(buff)) < 0)
+				stream->failed = true;
+			xmlOutputBufferClose(buff);
+		} else {
+			stream->failed = true;
+		}
+		stream->has_content[stream->depth - 1] = true;
+
+		xmlUnlinkNode(child);
+		xmlFreeNode(child);
+		child = next;
+	}
+
+	return stream->failed ? -1 : 0;
+}
+
+int oscap_xml_stream_end_element(struct oscap_xml_stream *stream, xmlNode *node)
+{
+	if (stream == NULL || stream->depth == 0)
+		return 0;
+
+	oscap_xml_stream_flush(stream, node);
+
+	stream->depth--;
+	if (stream->has_content[stream->depth])
+		oscap_xml_stream_indent(stream);
+	if (xmlTextWriterEndElement(stream->writer) < 0)
+		stream->failed = true;
+
+	xmlUnlinkNode(node);
+	xmlFreeNode(node);
+
+	return stream->failed ? -1 : 0;
+}
+
+int oscap_xml_stream_free(struct oscap_xml_stream *stream)
+{
+	if (stream == NULL)
+		return -1;
+
+	if (xmlTextWriterEndDocument(stream->writer) < 0 || xmlTextWriterFlush(stream->writer) < 0)
+		stream->failed = true;
+	xmlFreeTextWriter(stream->writer);
+	if (stream->fd >= 0 && close(stream->fd) != 0)
+		stream->failed = true;
+
+	bool failed = stream->failed;
+	free(stream->has_content);
+	free(stream);
+
+	if (failed) {
+		oscap_setxmlerr(xmlGetLastError());
+		dW("Failed to write the XML document.");
+	}
+	return failed ? -1 : 1;
+}
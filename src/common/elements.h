@@ -78,4 +78,43 @@ int oscap_xml_save_filename_free(const char *filename, xmlDocPtr doc);
 
 xmlNs *lookup_xsi_ns(xmlDoc *doc);
 
+/**
+ * Writer serializing a document while it is being built. Complete subtrees
+ * are written out and freed, so that only the elements on the path from
+ * the root to the element being built are kept in memory. All functions
+ * accept NULL stream and do nothing then, the document is kept whole.
+ */
+struct oscap_xml_stream;
+
+/**
+ * Open the file and write the XML declaration.
+ * @param filename path to the file or "-" for the standard output
+ * @return new stream or NULL on failure (oscap_seterr is set appropriately)
+ */
+struct oscap_xml_stream *oscap_xml_stream_new(const char *filename);
+
+/**
+ * Write the start tag of the element, including its attributes and namespace
+ * declarations. The element has to be created with all of them set, but no
+ * children yet.
+ */
+int oscap_xml_stream_start_element(struct oscap_xml_stream *stream, xmlNode *node);
+
+/**
+ * Write out all children of the element started last and free them.
+ */
+int oscap_xml_stream_flush(struct oscap_xml_stream *stream, xmlNode *node);
+
+/**
+ * Write out all children of the element started last and its end tag.
+ * The element is freed.
+ */
+int oscap_xml_stream_end_element(struct oscap_xml_stream *stream, xmlNode *node);
+
+/**
+ * Finish the document and close the file.
+ * @return 1 on success, -1 on failure of any of the previous writes
+ */
+int oscap_xml_stream_free(struct oscap_xml_stream *stream);
+
 #endif
@@ -31,6 +31,7 @@
 #include <ctype.h>
 #include <errno.h>
 #include <stdint.h>
+#include <pthread.h>
 
 #include "debug_priv.h"
 #include "memusage.h"
@@ -211,3 +212,28 @@ int oscap_proc_memusage(struct proc_memusage *mu)
 #endif
 	return 0;
 }
+
+static struct alloc_memusage __alloc_memusage;
+static pthread_mutex_t __alloc_memusage_lock = PTHREAD_MUTEX_INITIALIZER;
+
+void oscap_alloc_memusage_add(const struct alloc_memusage *mu)
+{
+	pthread_mutex_lock(&__alloc_memusage_lock);
+	__alloc_memusage.mu_allocs += mu->mu_allocs;
+	__alloc_memusage.mu_reused += mu->mu_reused;
+	__alloc_memusage.mu_frees  += mu->mu_frees;
+	__alloc_memusage.mu_cached += mu->mu_cached;
+	pthread_mutex_unlock(&__alloc_memusage_lock);
+}
+
+int oscap_alloc_memusage(struct alloc_memusage *mu)
+{
+	if (mu == NULL)
+		return -1;
+
+	pthread_mutex_lock(&__alloc_memusage_lock);
+	*mu = __alloc_memusage;
+	pthread_mutex_unlock(&__alloc_memusage_lock);
+
+	return 0;
+}
@@ -30,7 +30,23 @@ struct sys_memusage {
 	size_t mu_inactive;
 };
 
+/* Counters of the S-exp allocator pool */
+struct alloc_memusage {
+	size_t mu_allocs;  /* blocks allocated from the system */
+	size_t mu_reused;  /* allocations served from the free lists */
+	size_t mu_frees;   /* blocks given back to the system */
+	size_t mu_cached;  /* bytes kept on the free lists */
+};
+
 int oscap_proc_memusage(struct proc_memusage *mu);
 int oscap_sys_memusage(struct sys_memusage *mu);
 
+/*
+ * Add the counters collected by a thread to the process-wide ones. The
+ * fields are deltas, mu_cached may wrap around if the thread reused
+ * more memory than it cached since the last update.
+ */
+void oscap_alloc_memusage_add(const struct alloc_memusage *mu);
+int oscap_alloc_memusage(struct alloc_memusage *mu);
+
 #endif /* MEMUSAGE_H */
@@ -0,0 +1,262 @@
+/*
+ * Copyright 2026 Red Hat Inc., Durham, North Carolina.
+ * All Rights Reserved.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+
+#include "util.h"
+#include "debug_priv.h"
+#include "oscap_pcre_cache.h"
+
+#ifdef PCRE_STUDY_JIT_COMPILE
+# define OSCAP_PCRE_STUDY_OPTIONS PCRE_STUDY_JIT_COMPILE
+# define oscap_pcre_free_study(extra) pcre_free_study(extra)
+#else
+# define OSCAP_PCRE_STUDY_OPTIONS 0
+# define oscap_pcre_free_study(extra) pcre_free(extra)
+#endif
+
+#define OSCAP_PCRE_CACHE_HSIZE 389
+
+struct oscap_pcre_entry {
+	struct oscap_pcre regex; /* has to be the first member */
+	char *pattern;
+	int options;
+	unsigned int hash;
+	unsigned int refcnt;  /* number of users holding the entry */
+	bool cached;          /* false if the entry was evicted while in use */
+	struct oscap_pcre_entry *hnext;    /* next entry in the hash bucket */
+	struct oscap_pcre_entry *lru_prev; /* more recently used entry */
+	struct oscap_pcre_entry *lru_next; /* less recently used entry */
+};
+
+static struct {
+	pthread_mutex_t lock;
+	struct oscap_pcre_entry *table[OSCAP_PCRE_CACHE_HSIZE];
+	struct oscap_pcre_entry *lru_head;
+	struct oscap_pcre_entry *lru_tail;
+	size_t count;
+	unsigned long hits;
+	unsigned long misses;
+} pcre_cache = { .lock = PTHREAD_MUTEX_INITIALIZER };
+
+static unsigned int oscap_pcre_hash(const char *pattern, int options)
+{
+	unsigned int h = (unsigned int)options;
+	const unsigned char *p;
+
+	for (p = (const unsigned char *)pattern; *p != '\0'; p++)
+		h = (97 * h) + *p;
+
+	return h;
+}
+
+static struct oscap_pcre_entry *oscap_pcre_cache_lookup(unsigned int hash, const char *pattern, int options)
+{
+	struct oscap_pcre_entry *e;
+
+	for (e = pcre_cache.table[hash % OSCAP_PCRE_CACHE_HSIZE]; e != NULL; e = e->hnext) {
+		if (e->hash == hash && e->options == options && strcmp(e->pattern, pattern) == 0)
+			return e;
+	}
+
+	return NULL;
+}
+
+static void oscap_pcre_lru_unlink(struct oscap_pcre_entry *e)
+{
+	if (e->lru_prev != NULL)
+		e->lru_prev->lru_next = e->lru_next;
+	else
+		pcre_cache.lru_head = e->lru_next;
+
+	if (e->lru_next != NULL)
+		e->lru_next->lru_prev = e->lru_prev;
+	else
+		pcre_cache.lru_tail = e->lru_prev;
+
+	e->lru_prev = e->lru_next = NULL;
+}
+
+static void oscap_pcre_lru_push(struct oscap_pcre_entry *e)
+{
+	e->lru_prev = NULL;
+	e->lru_next = pcre_cache.lru_head;
+
+	if (pcre_cache.lru_head != NULL)
+		pcre_cache.lru_head->lru_prev = e;
+	else
+		pcre_cache.lru_tail = e;
+
+	pcre_cache.lru_head = e;
+}
+
+static void oscap_pcre_entry_free(struct oscap_pcre_entry *e)
+{
+	if (e->regex.extra != NULL)
+		oscap_pcre_free_study(e->regex.extra);
+	pcre_free(e->regex.re);
+	free(e->pattern);
+	free(e);
+}
+
+/* Remove the entry from the cache; it's freed when its last user releases it */
+static void oscap_pcre_cache_remove(struct oscap_pcre_entry *e)
+{
+	struct oscap_pcre_entry **p;
+
+	for (p = &pcre_cache.table[e->hash % OSCAP_PCRE_CACHE_HSIZE]; *p != NULL; p = &(*p)->hnext) {
+		if (*p == e) {
+			*p = e->hnext;
+			break;
+		}
+	}
+
+	oscap_pcre_lru_unlink(e);
+	e->hnext  = NULL;
+	e->cached = false;
+	--pcre_cache.count;
+
+	if (e->refcnt == 0)
+		oscap_pcre_entry_free(e);
+}
+
+struct oscap_pcre *oscap_pcre_cache_get(const char *pattern, int options, const char **errptr, int *erroffset)
+{
+	struct oscap_pcre_entry *e, *found;
+	const char *err = NULL, *study_err = NULL;
+	int errofs = -1;
+	unsigned int hash;
+
+	if (pattern == NULL)
+		return NULL;
+
+	hash = oscap_pcre_hash(pattern, options);
+
+	pthread_mutex_lock(&pcre_cache.lock);
+	e = oscap_pcre_cache_lookup(hash, pattern, options);
+	if (e != NULL) {
+		++e->refcnt;
+		++pcre_cache.hits;
+		oscap_pcre_lru_unlink(e);
+		oscap_pcre_lru_push(e);
+		pthread_mutex_unlock(&pcre_cache.lock);
+		return &e->regex;
+	}
+	++pcre_cache.misses;
+	pthread_mutex_unlock(&pcre_cache.lock);
+
+	/* Compile outside of the lock so that other patterns can be looked up meanwhile */
+	e = calloc(1, sizeof(struct oscap_pcre_entry));
+	if (e == NULL) {
+		if (errptr != NULL)
+			*errptr = "out of memory";
+		if (erroffset != NULL)
+			*erroffset = -1;
+		return NULL;
+	}
+	e->regex.re = pcre_compile(pattern, options, &err, &errofs, NULL);
+	if (e->regex.re == NULL) {
+		if (errptr != NULL)
+			*errptr = err;
+		if (erroffset != NULL)
+			*erroffset = errofs;
+		free(e);
+		return NULL;
+	}
+	e->regex.extra = pcre_study(e->regex.re, OSCAP_PCRE_STUDY_OPTIONS, &study_err);
+	if (study_err != NULL)
+		dD("pcre_study() failed on pattern '%s': %s.", pattern, study_err);
+	e->pattern = oscap_strdup(pattern);
+	e->options = options;
+	e->hash    = hash;
+	e->refcnt  = 1;
+	e->cached  = e->pattern != NULL;
+
+	if (!e->cached) {
+		/* Out of memory, the caller gets a private copy freed on release */
+		return &e->regex;
+	}
+
+	pthread_mutex_lock(&pcre_cache.lock);
+	found = oscap_pcre_cache_lookup(hash, pattern, options);
+	if (found != NULL) {
+		/* another thread was faster */
+		++found->refcnt;
+		pthread_mutex_unlock(&pcre_cache.lock);
+		oscap_pcre_entry_free(e);
+		return &found->regex;
+	}
+
+	while (pcre_cache.count >= OSCAP_PCRE_CACHE_SIZE && pcre_cache.lru_tail != NULL)
+		oscap_pcre_cache_remove(pcre_cache.lru_tail);
+
+	e->hnext = pcre_cache.table[hash % OSCAP_PCRE_CACHE_HSIZE];
+	pcre_cache.table[hash % OSCAP_PCRE_CACHE_HSIZE] = e;
+	oscap_pcre_lru_push(e);
+	++pcre_cache.count;
+	pthread_mutex_unlock(&pcre_cache.lock);
+
+	return &e->regex;
+}
+
+void oscap_pcre_cache_release(struct oscap_pcre *regex)
+{
+	struct oscap_pcre_entry *e = (struct oscap_pcre_entry *)regex;
+
+	if (e == NULL)
+		return;
+
+	pthread_mutex_lock(&pcre_cache.lock);
+	if (--e->refcnt == 0 && !e->cached)
+		oscap_pcre_entry_free(e);
+	pthread_mutex_unlock(&pcre_cache.lock);
+}
+
+int oscap_pcre_exec(const struct oscap_pcre *regex, const char *subject, int length, int startoffset, int options, int *ovector, int ovecsize)
+{
+	int ret;
+
+	ret = pcre_exec(regex->re, regex->extra, subject, length, startoffset, options, ovector, ovecsize);
+#ifdef PCRE_ERROR_JIT_STACKLIMIT
+	if (ret == PCRE_ERROR_JIT_STACKLIMIT) {
+		dD("JIT stack limit reached, falling back to the interpreter.");
+		ret = pcre_exec(regex->re, NULL, subject, length, startoffset, options, ovector, ovecsize);
+	}
+#endif
+	return ret;
+}
+
+void oscap_pcre_cache_clear(void)
+{
+	pthread_mutex_lock(&pcre_cache.lock);
+	if (pcre_cache.hits + pcre_cache.misses > 0) {
+		dI("Regex cache: %lu hits, %lu misses, %zu patterns cached.",
+		   pcre_cache.hits, pcre_cache.misses, pcre_cache.count);
+	}
+	while (pcre_cache.lru_head != NULL)
+		oscap_pcre_cache_remove(pcre_cache.lru_head);
+	pcre_cache.hits = pcre_cache.misses = 0;
+	pthread_mutex_unlock(&pcre_cache.lock);
+}
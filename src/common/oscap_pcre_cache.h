@@ -0,0 +1,71 @@
+/*
+ * Copyright 2026 Red Hat Inc., Durham, North Carolina.
+ * All Rights Reserved.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+#ifndef OSCAP_PCRE_CACHE_H
+#define OSCAP_PCRE_CACHE_H
+
+#include <pcre.h>
+#include "util.h"
+
+/*
+ * Maximum number of compiled patterns kept in the cache. The least
+ * recently used pattern is evicted when the cache is full.
+ */
+#define OSCAP_PCRE_CACHE_SIZE 512
+
+/*
+ * A compiled pattern owned by the cache
+ */
+struct oscap_pcre {
+	pcre       *re;    /* compiled pattern */
+	pcre_extra *extra; /* result of pcre_study(), may be NULL */
+};
+
+/*
+ * Get the compiled form of a pattern. The pattern is compiled and studied
+ * (JIT compiled if supported) only if it isn't in the cache yet. The returned
+ * pattern stays valid until it's released by oscap_pcre_cache_release(), even
+ * if it's evicted from the cache in the meantime.
+ * @param pattern the regular expression
+ * @param options pcre_compile() options
+ * @param errptr where to store the pcre_compile() error message, may be NULL
+ * @param erroffset where to store the pcre_compile() error offset, may be NULL
+ * @return compiled pattern or NULL if the pattern can't be compiled or there
+ * isn't enough memory, errptr is set in both cases
+ */
+struct oscap_pcre *oscap_pcre_cache_get(const char *pattern, int options, const char **errptr, int *erroffset);
+
+/*
+ * Release a pattern obtained by oscap_pcre_cache_get()
+ */
+void oscap_pcre_cache_release(struct oscap_pcre *regex);
+
+/*
+ * Match a compiled pattern against a subject. Same as pcre_exec(), except
+ * that the matching falls back to the interpreter if the JIT stack is
+ * exhausted.
+ */
+int oscap_pcre_exec(const struct oscap_pcre *regex, const char *subject, int length, int startoffset, int options, int *ovector, int ovecsize);
+
+/*
+ * Drop all the patterns which aren't used at the moment
+ */
+void oscap_pcre_cache_clear(void);
+
+#endif /* OSCAP_PCRE_CACHE_H */
@@ -0,0 +1,317 @@
+/*
+ * Copyright 2026 Red Hat Inc., Durham, North Carolina.
+ * All Rights Reserved.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <pthread.h>
+
+#include "_error.h"
+#include "util.h"
+#include "debug_priv.h"
+#include "profiler_priv.h"
+
+#define OSCAP_PROF_HSIZE 4093
+
+struct oscap_prof_entry {
+	oscap_prof_kind_t kind;
+	char *id;
+	unsigned int hash;
+	uint64_t calls;
+	uint64_t wall_ns;
+	uint64_t cpu_ns;
+	uint64_t items;
+	struct oscap_prof_entry *next; /* next entry in the hash bucket */
+};
+
+static const char *const oscap_prof_kind_names[OSCAP_PROF_KIND_COUNT] = {
+	"rule", "definition", "test", "object", "probe", "roundtrip"
+};
+
+static struct {
+	pthread_mutex_t lock;
+	volatile bool enabled;
+	struct timespec started;
+	struct oscap_prof_entry *table[OSCAP_PROF_HSIZE];
+	size_t count;
+} profiler = { .lock = PTHREAD_MUTEX_INITIALIZER };
+
+static inline void oscap_prof_clock(clockid_t clock, struct timespec *ts)
+{
+	if (clock_gettime(clock, ts) != 0)
+		ts->tv_sec = ts->tv_nsec = 0;
+}
+
+static inline uint64_t oscap_prof_elapsed(const struct timespec *from, const struct timespec *to)
+{
+	int64_t ns = (int64_t)(to->tv_sec - from->tv_sec) * 1000000000 + (to->tv_nsec - from->tv_nsec);
+
+	return ns > 0 ? (uint64_t)ns : 0;
+}
+
+static unsigned int oscap_prof_hash(oscap_prof_kind_t kind, const char *id)
+{
+	unsigned int h = (unsigned int)kind;
+	const unsigned char *p;
+
+	for (p = (const unsigned char *)id; *p != '\0'; p++)
+		h = (97 * h) + *p;
+
+	return h;
+}
+
+static void oscap_prof_clear(void)
+{
+	size_t i;
+
+	for (i = 0; i < OSCAP_PROF_HSIZE; ++i) {
+		struct oscap_prof_entry *e = profiler.table[i];
+
+		while (e != NULL) {
+			struct oscap_prof_entry *next = e->next;
+
+			free(e->id);
+			free(e);
+			e = next;
+		}
+		profiler.table[i] = NULL;
+	}
+	profiler.count = 0;
+}
+
+void oscap_profiler_enable(bool enable)
+{
+	pthread_mutex_lock(&profiler.lock);
+	if (enable) {
+		oscap_prof_clear();
+		oscap_prof_clock(CLOCK_MONOTONIC, &profiler.started);
+	}
+	profiler.enabled = enable;
+	pthread_mutex_unlock(&profiler.lock);
+}
+
+bool oscap_profiler_is_enabled(void)
+{
+	return profiler.enabled;
+}
+
+void oscap_prof_start(oscap_prof_timer_t *timer)
+{
+	timer->running = profiler.enabled;
+	if (!timer->running)
+		return;
+
+	oscap_prof_clock(CLOCK_MONOTONIC, &timer->wall);
+#ifdef CLOCK_THREAD_CPUTIME_ID
+	oscap_prof_clock(CLOCK_THREAD_CPUTIME_ID, &timer->cpu);
+#endif
+}
+
+void oscap_prof_stop(oscap_prof_timer_t *timer, oscap_prof_kind_t kind, const char *id, uint64_t items)
+{
+	struct timespec wall, cpu;
+	struct oscap_prof_entry *e;
+	unsigned int hash;
+	uint64_t cpu_ns = 0;
+
+	if (!timer->running || id == NULL)
+		return;
+	timer->running = false;
+
+	oscap_prof_clock(CLOCK_MONOTONIC, &wall);
+#ifdef CLOCK_THREAD_CPUTIME_ID
+	if (kind != OSCAP_PROF_ROUNDTRIP) {
+		oscap_prof_clock(CLOCK_THREAD_CPUTIME_ID, &cpu);
+		cpu_ns = oscap_prof_elapsed(&timer->cpu, &cpu);
+	}
+#else
+	(void)cpu;
+#endif
+	hash = oscap_prof_hash(kind, id);
+
+	pthread_mutex_lock(&profiler.lock);
+	if (!profiler.enabled) {
+		pthread_mutex_unlock(&profiler.lock);
+		return;
+	}
+
+	for (e = profiler.table[hash % OSCAP_PROF_HSIZE]; e != NULL; e = e->next) {
+		if (e->hash == hash && e->kind == kind && strcmp(e->id, id) == 0)
+			break;
+	}
+
+	if (e == NULL) {
+		e = calloc(1, sizeof(struct oscap_prof_entry));
+		if (e == NULL) {
+			pthread_mutex_unlock(&profiler.lock);
+			return;
+		}
+		e->kind = kind;
+		e->id   = oscap_strdup(id);
+		if (e->id == NULL) {
+			free(e);
+			pthread_mutex_unlock(&profiler.lock);
+			return;
+		}
+		e->hash = hash;
+		e->next = profiler.table[hash % OSCAP_PROF_HSIZE];
+		profiler.table[hash % OSCAP_PROF_HSIZE] = e;
+		++profiler.count;
+	}
+
+	++e->calls;
+	e->wall_ns += oscap_prof_elapsed(&timer->wall, &wall);
+	e->cpu_ns  += cpu_ns;
+	e->items   += items;
+	pthread_mutex_unlock(&profiler.lock);
+}
+
+static int oscap_prof_entry_cmp(const void *a, const void *b)
+{
+	const struct oscap_prof_entry *e1 = *(const struct oscap_prof_entry **)a;
+	const struct oscap_prof_entry *e2 = *(const struct oscap_prof_entry **)b;
+
+	if (e1->kind != e2->kind)
+		return e1->kind < e2->kind ? -1 : 1;
+	if (e1->wall_ns != e2->wall_ns)
+		return e1->wall_ns > e2->wall_ns ? -1 : 1;
+	return strcmp(e1->id, e2->id);
+}
+
+static void oscap_prof_write_json_string(FILE *f, const char *str)
+{
+	const unsigned char *p;
+
+	fputc('"', f);
+	for (p = (const unsigned char *)str; *p != '\0'; ++p) {
+		if (*p == '"' || *p == '\\')
+			fprintf(f, "\\%c", *p);
+		else if (*p < 0x20)
+			fprintf(f, "\\u%04x", *p);
+		else
+			fputc(*p, f);
+	}
+	fputc('"', f);
+}
+
+static void oscap_prof_write_csv_string(FILE *f, const char *str)
+{
+	const char *p;
+
+	fputc('"', f);
+	for (p = str; *p != '\0'; ++p) {
+		if (*p == '"')
+			fputc('"', f);
+		fputc(*p, f);
+	}
+	fputc('"', f);
+}
+
+static void oscap_prof_write_json(FILE *f, struct oscap_prof_entry **entries, size_t count, uint64_t total_ns)
+{
+	size_t i;
+	int kind = -1;
+
+	fprintf(f, "{\n  \"wall_ms\": %.3f", total_ns / 1e6);
+	for (i = 0; i < count; ++i) {
+		struct oscap_prof_entry *e = entries[i];
+
+		if ((int)e->kind != kind) {
+			fprintf(f, "%s,\n  \"%ss\": [\n", kind == -1 ? "" : "\n  ]", oscap_prof_kind_names[e->kind]);
+			kind = e->kind;
+		} else {
+			fputs(",\n", f);
+		}
+		fputs("    {\"id\": ", f);
+		oscap_prof_write_json_string(f, e->id);
+		fprintf(f, ", \"calls\": %llu, \"wall_ms\": %.3f, \"cpu_ms\": %.3f, \"items\": %llu}",
+		        (unsigned long long)e->calls, e->wall_ns / 1e6, e->cpu_ns / 1e6,
+		        (unsigned long long)e->items);
+	}
+	fprintf(f, "%s\n}\n", kind == -1 ? "" : "\n  ]");
+}
+
+static void oscap_prof_write_csv(FILE *f, struct oscap_prof_entry **entries, size_t count)
+{
+	size_t i;
+
+	fputs("type,id,calls,wall_ms,cpu_ms,items\n", f);
+	for (i = 0; i < count; ++i) {
+		struct oscap_prof_entry *e = entries[i];
+
+		fprintf(f, "%s,", oscap_prof_kind_names[e->kind]);
+		oscap_prof_write_csv_string(f, e->id);
+		fprintf(f, ",%llu,%.3f,%.3f,%llu\n",
+		        (unsigned long long)e->calls, e->wall_ns / 1e6, e->cpu_ns / 1e6,
+		        (unsigned long long)e->items);
+	}
+}
+
+int oscap_profiler_write(const char *filename)
+{
+	struct oscap_prof_entry **entries, *e;
+	struct timespec now;
+	size_t i, count = 0;
+	uint64_t total_ns;
+	size_t len;
+	FILE *f;
+	int ret = 0;
+
+	if (filename == NULL)
+		return -1;
+
+	f = fopen(filename, "w");
+	if (f == NULL) {
+		oscap_seterr(OSCAP_EFAMILY_GLIBC, "Failed to open the profiler output '%s': %s", filename, strerror(errno));
+		return -1;
+	}
+
+	pthread_mutex_lock(&profiler.lock);
+	oscap_prof_clock(CLOCK_MONOTONIC, &now);
+	total_ns = oscap_prof_elapsed(&profiler.started, &now);
+
+	entries = malloc((profiler.count + 1) * sizeof(struct oscap_prof_entry *));
+	for (i = 0; i < OSCAP_PROF_HSIZE; ++i) {
+		for (e = profiler.table[i]; e != NULL; e = e->next)
+			entries[count++] = e;
+	}
+	qsort(entries, count, sizeof(struct oscap_prof_entry *), oscap_prof_entry_cmp);
+
+	len = strlen(filename);
+	if (len >= 4 && oscap_strcasecmp(filename + len - 4, ".csv") == 0)
+		oscap_prof_write_csv(f, entries, count);
+	else
+		oscap_prof_write_json(f, entries, count, total_ns);
+	pthread_mutex_unlock(&profiler.lock);
+
+	free(entries);
+
+	if (fclose(f) != 0) {
+		oscap_seterr(OSCAP_EFAMILY_GLIBC, "Failed to write the profiler output '%s': %s", filename, strerror(errno));
+		ret = -1;
+	}
+
+	dI("Profiler output written to '%s', %zu records.", filename, count);
+	return ret;
+}
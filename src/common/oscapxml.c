@@ -49,6 +49,8 @@
 #include "debug_priv.h"
 #include "oscap_source.h"
 #include "oscapxml.h"
+#include "oscap_pcre_cache.h"
+#include "source/content_cache_priv.h"
 #include "source/schematron_priv.h"
 #include "source/validate_priv.h"
 #include "source/xslt_priv.h"
@@ -119,6 +121,8 @@ void oscap_init(void)
 void oscap_cleanup(void)
 {
 	oscap_clearerr();
+	oscap_pcre_cache_clear();
+	oscap_content_cache_clear_docs();
 	xsltCleanupGlobals();
 	xmlCleanupParser();
 }
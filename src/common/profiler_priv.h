@@ -0,0 +1,65 @@
+/*
+ * Copyright 2026 Red Hat Inc., Durham, North Carolina.
+ * All Rights Reserved.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+#ifndef OSCAP_PROFILER_PRIV_H_
+#define OSCAP_PROFILER_PRIV_H_
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <time.h>
+#include "public/oscap_profiler.h"
+
+/*
+ * Type of a profiled operation
+ */
+typedef enum {
+	OSCAP_PROF_RULE = 0,   /* XCCDF rule evaluation */
+	OSCAP_PROF_DEFINITION, /* OVAL definition evaluation */
+	OSCAP_PROF_TEST,       /* OVAL test evaluation */
+	OSCAP_PROF_OBJECT,     /* OVAL object collection, as seen by the caller */
+	OSCAP_PROF_PROBE,      /* probe main function, per object subtype */
+	OSCAP_PROF_ROUNDTRIP,  /* probe request and its reply, per object subtype */
+	OSCAP_PROF_KIND_COUNT
+} oscap_prof_kind_t;
+
+/*
+ * Measurement of a single operation, usually kept on the stack
+ */
+typedef struct {
+	struct timespec wall;
+	struct timespec cpu;
+	bool running;
+} oscap_prof_timer_t;
+
+/*
+ * Start the measurement. Does nothing if the profiler is disabled.
+ */
+void oscap_prof_start(oscap_prof_timer_t *timer);
+
+/*
+ * Stop the measurement and add it to the record of the given operation.
+ * CPU time is the time of the calling thread; it isn't recorded for round
+ * trips, which are mostly spent waiting for the probes.
+ * @param kind type of the operation
+ * @param id ID of the rule, definition, etc. or the name of the subtype
+ * @param items number of items produced by the operation
+ */
+void oscap_prof_stop(oscap_prof_timer_t *timer, oscap_prof_kind_t kind, const char *id, uint64_t items);
+
+#endif /* OSCAP_PROFILER_PRIV_H_ */
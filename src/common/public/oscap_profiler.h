@@ -0,0 +1,56 @@
+/*
+ * Copyright 2026 Red Hat Inc., Durham, North Carolina.
+ * All Rights Reserved.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+/**
+ * @file
+ * Scan profiler
+ *
+ * The profiler records the time spent evaluating XCCDF rules, OVAL
+ * definitions, tests and objects, and the time spent by the probes.
+ */
+
+#ifndef OSCAP_PROFILER_H_
+#define OSCAP_PROFILER_H_
+
+#include <stdbool.h>
+#include "oscap_export.h"
+
+/**
+ * Start or stop recording. Enabling the profiler discards the data
+ * recorded so far.
+ * @param enable true to start recording
+ */
+OSCAP_API void oscap_profiler_enable(bool enable);
+
+/**
+ * Check whether the profiler records data
+ */
+OSCAP_API bool oscap_profiler_is_enabled(void);
+
+/**
+ * Write the recorded data into a file. The records are grouped by their
+ * type (rule, definition, test, object, probe, roundtrip) and sorted by
+ * the wall time within each group. The report is written in CSV if the
+ * name of the file ends with ".csv", JSON is used otherwise.
+ * @param filename path of the report
+ * @return 0 on success, -1 on error
+ */
+OSCAP_API int oscap_profiler_write(const char *filename);
+
+#endif /* OSCAP_PROFILER_H_ */
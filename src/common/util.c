@@ -356,6 +356,19 @@ char *oscap_path_join(const char *path1, const char *path2)
 	return joined_path;
 }
 
+unsigned long oscap_pcre_exec_recursion_limit(void)
+{
+	unsigned long limit = OSCAP_PCRE_EXEC_RECURSION_LIMIT_DEFAULT;
+	char *limit_str = getenv("OSCAP_PCRE_EXEC_RECURSION_LIMIT");
+	if (limit_str != NULL) {
+		unsigned long env_limit;
+		if (sscanf(limit_str, "%lu", &env_limit) == 1) {
+			limit = env_limit;
+		}
+	}
+	return limit;
+}
+
 int oscap_get_substrings(char *str, int *ofs, pcre *re, int want_substrs, char ***substrings) {
 	int i, ret, rc;
 	int ovector[60], ovector_len = sizeof (ovector) / sizeof (ovector[0]);
@@ -368,14 +381,7 @@ int oscap_get_substrings(char *str, int *ofs, pcre *re, int want_substrs, char *
 	}
 
 	struct pcre_extra extra;
-	extra.match_limit_recursion = OSCAP_PCRE_EXEC_RECURSION_LIMIT_DEFAULT;
-	char *limit_str = getenv("OSCAP_PCRE_EXEC_RECURSION_LIMIT");
-	if (limit_str != NULL) {
-		unsigned long limit;
-		if (sscanf(limit_str, "%lu", &limit) == 1) {
-			extra.match_limit_recursion = limit;
-		}
-	}
+	extra.match_limit_recursion = oscap_pcre_exec_recursion_limit();
 	extra.flags = PCRE_EXTRA_MATCH_LIMIT_RECURSION;
 #if defined(OS_SOLARIS)
 	rc = pcre_exec(re, &extra, str, strlen(str), *ofs, PCRE_NO_UTF8_CHECK, ovector, ovector_len);
@@ -468,6 +468,12 @@ int oscap_strncasecmp(const char *s1, const char *s2, size_t n);
  */
 char *oscap_strerror_r(int errnum, char *buf, size_t buflen);
 
+/**
+ * Get the recursion limit of pcre_exec(). The default limit can be
+ * overridden by the OSCAP_PCRE_EXEC_RECURSION_LIMIT environment variable.
+ */
+unsigned long oscap_pcre_exec_recursion_limit(void);
+
 /**
  * Match a regular expression and return substrings.
  * Caller is responsible for freeing the returned array.
@@ -0,0 +1,344 @@
+/*
+ * Copyright 2026 Red Hat Inc., Durham, North Carolina.
+ * All Rights Reserved.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ *
+ */
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+
+#include <ctype.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+#include <libxml/tree.h>
+
+#include "common/debug_priv.h"
+#include "common/public/oscap.h"
+#include "common/public/oscap_helpers.h"
+#include "common/util.h"
+#include "content_cache_priv.h"
+
+#if defined(HAVE_MMAN_H) && (defined(HAVE_GCRYPT) || defined(HAVE_NSS3)) && !defined(OS_WINDOWS)
+#define OSCAP_CONTENT_CACHE_SUPPORTED
+#endif
+
+#define OSCAP_CONTENT_CACHE_DOCS 4
+
+/* Documents parsed by this process, replaced in turns */
+static struct {
+	pthread_mutex_t lock;
+	char *keys[OSCAP_CONTENT_CACHE_DOCS];
+	xmlDoc *docs[OSCAP_CONTENT_CACHE_DOCS];
+	unsigned int next;
+} content_cache_docs = {
+	.lock = PTHREAD_MUTEX_INITIALIZER,
+};
+
+xmlDoc *oscap_content_cache_get_doc(const char *key)
+{
+	xmlDoc *doc = NULL;
+	unsigned int i;
+
+	if (key == NULL)
+		return NULL;
+
+	pthread_mutex_lock(&content_cache_docs.lock);
+	for (i = 0; i < OSCAP_CONTENT_CACHE_DOCS; ++i) {
+		if (content_cache_docs.keys[i] != NULL && strcmp(content_cache_docs.keys[i], key) == 0) {
+			doc = xmlCopyDoc(content_cache_docs.docs[i], 1);
+			break;
+		}
+	}
+	pthread_mutex_unlock(&content_cache_docs.lock);
+
+	return doc;
+}
+
+void oscap_content_cache_add_doc(const char *key, xmlDoc *doc)
+{
+	xmlDoc *copy;
+	char *dup;
+	unsigned int i;
+
+	if (key == NULL || doc == NULL)
+		return;
+
+	copy = xmlCopyDoc(doc, 1);
+	dup = oscap_strdup(key);
+	if (copy == NULL || dup == NULL) {
+		xmlFreeDoc(copy);
+		free(dup);
+		return;
+	}
+
+	pthread_mutex_lock(&content_cache_docs.lock);
+	i = content_cache_docs.next;
+	content_cache_docs.next = (i + 1) % OSCAP_CONTENT_CACHE_DOCS;
+	free(content_cache_docs.keys[i]);
+	xmlFreeDoc(content_cache_docs.docs[i]);
+	content_cache_docs.keys[i] = dup;
+	content_cache_docs.docs[i] = copy;
+	pthread_mutex_unlock(&content_cache_docs.lock);
+}
+
+void oscap_content_cache_clear_docs(void)
+{
+	unsigned int i;
+
+	pthread_mutex_lock(&content_cache_docs.lock);
+	for (i = 0; i < OSCAP_CONTENT_CACHE_DOCS; ++i) {
+		free(content_cache_docs.keys[i]);
+		xmlFreeDoc(content_cache_docs.docs[i]);
+		content_cache_docs.keys[i] = NULL;
+		content_cache_docs.docs[i] = NULL;
+	}
+	content_cache_docs.next = 0;
+	pthread_mutex_unlock(&content_cache_docs.lock);
+}
+
+#ifdef OSCAP_CONTENT_CACHE_SUPPORTED
+
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/stat.h>
+
+#include "OVAL/probes/crapi/crapi.h"
+
+#define OSCAP_CONTENT_CACHE_MAGIC "openscap-content-cache 1"
+#define OSCAP_CONTENT_CACHE_SUFFIX ".valid"
+#define OSCAP_CONTENT_CACHE_ENTRY_MAX 1024
+
+static pthread_once_t crapi_once = PTHREAD_ONCE_INIT;
+static int crapi_status = -1;
+
+static void content_cache_crapi_init(void)
+{
+	crapi_status = crapi_init(NULL);
+}
+
+static const char *content_cache_dir(void)
+{
+	const char *dir = getenv("OSCAP_CONTENT_CACHE_DIR");
+
+	if (dir == NULL || *dir == '\0')
+		return NULL;
+
+	pthread_once(&crapi_once, content_cache_crapi_init);
+	if (crapi_status != 0) {
+		dW("Failed to initialize the crypto library, the content cache is disabled.");
+		return NULL;
+	}
+	return dir;
+}
+
+static char *content_cache_hex(const unsigned char *digest, size_t size)
+{
+	static const char hex[] = "0123456789abcdef";
+	char *str = malloc(size * 2 + 1);
+	size_t i;
+
+	for (i = 0; i < size; ++i) {
+		str[i * 2]     = hex[digest[i] >> 4];
+		str[i * 2 + 1] = hex[digest[i] & 0x0f];
+	}
+	str[size * 2] = '\0';
+	return str;
+}
+
+/*
+ * The verdicts are trusted only from a directory nobody else can write
+ * to, otherwise any user could mark invalid content as valid.
+ */
+static bool content_cache_owned(const struct stat *st, bool dir)
+{
+	if (dir ? !S_ISDIR(st->st_mode) : !S_ISREG(st->st_mode))
+		return false;
+	return st->st_uid == geteuid() && (st->st_mode & (S_IWGRP | S_IWOTH)) == 0;
+}
+
+static bool content_cache_dir_secure(const char *dir)
+{
+	struct stat st;
+
+	if (lstat(dir, &st) != 0)
+		return false;
+	if (!content_cache_owned(&st, true)) {
+		dW("The content cache directory '%s' isn't a directory writable only by its owner, "
+		   "the content cache is ignored.", dir);
+		return false;
+	}
+	return true;
+}
+
+/* Keep the schema in the name, the same content has an entry per schema */
+static char *content_cache_entry_path(const char *dir, const char *key, const char *type_name, const char *schema_version)
+{
+	char *path, *c;
+	size_t name;
+
+	path = oscap_sprintf("%s/%s-%s-%s%s", dir, key, type_name, schema_version, OSCAP_CONTENT_CACHE_SUFFIX);
+	for (name = strlen(dir) + 1, c = path + name; *c != '\0'; ++c) {
+		if (!isalnum((unsigned char)*c) && *c != '.' && *c != '-')
+			*c = '_';
+	}
+	return path;
+}
+
+static char *content_cache_entry(const char *type_name, const char *schema_version)
+{
+	return oscap_sprintf(OSCAP_CONTENT_CACHE_MAGIC "\nversion %s\ntype %s\nschema %s\n",
+			oscap_get_version(), type_name, schema_version);
+}
+
+bool oscap_content_cache_enabled(void)
+{
+	return content_cache_dir() != NULL;
+}
+
+char *oscap_content_cache_key_memory(const char *buffer, size_t size)
+{
+	unsigned char digest[32];
+	size_t digest_size = sizeof(digest);
+
+	if (buffer == NULL || content_cache_dir() == NULL)
+		return NULL;
+
+	if (crapi_digest_buf(buffer, size, CRAPI_DIGEST_SHA256, digest, &digest_size) != 0)
+		return NULL;
+
+	return content_cache_hex(digest, digest_size);
+}
+
+bool oscap_content_cache_is_valid(const char *key, const char *type_name, const char *schema_version)
+{
+	char buf[OSCAP_CONTENT_CACHE_ENTRY_MAX];
+	const char *dir = content_cache_dir();
+	char *path, *expected;
+	struct stat st;
+	ssize_t len;
+	bool valid;
+	int fd;
+
+	if (key == NULL || dir == NULL || !content_cache_dir_secure(dir))
+		return false;
+
+	path = content_cache_entry_path(dir, key, type_name, schema_version);
+	fd = open(path, O_RDONLY | O_NOFOLLOW);
+	if (fd < 0) {
+		free(path);
+		return false;
+	}
+	if (fstat(fd, &st) != 0 || !content_cache_owned(&st, false)) {
+		dW("Ignoring the content cache entry '%s' writable by other users.", path);
+		free(path);
+		close(fd);
+		return false;
+	}
+	free(path);
+
+	len = read(fd, buf, sizeof(buf) - 1);
+	close(fd);
+	if (len <= 0)
+		return false;
+	buf[len] = '\0';
+
+	/* Entries written by a different version of the library or for
+	 * a different schema are stale, they will be overwritten. */
+	expected = content_cache_entry(type_name, schema_version);
+	valid = strcmp(buf, expected) == 0;
+	free(expected);
+
+	return valid;
+}
+
+void oscap_content_cache_set_valid(const char *key, const char *type_name, const char *schema_version)
+{
+	const char *dir = content_cache_dir();
+	char *path, *tmp_path, *entry;
+	size_t len;
+	int fd;
+
+	if (key == NULL || dir == NULL)
+		return;
+
+	if (mkdir(dir, 0700) != 0 && errno != EEXIST) {
+		dW("Failed to create the content cache directory '%s': %s", dir, strerror(errno));
+		return;
+	}
+	if (!content_cache_dir_secure(dir))
+		return;
+
+	/* Write to a temporary file first, concurrent runs must never
+	 * see an incomplete entry. */
+	tmp_path = oscap_sprintf("%s/.%s.XXXXXX", dir, key);
+	fd = mkstemp(tmp_path);
+	if (fd < 0) {
+		dW("Failed to create a content cache entry in '%s': %s", dir, strerror(errno));
+		free(tmp_path);
+		return;
+	}
+
+	entry = content_cache_entry(type_name, schema_version);
+	len = strlen(entry);
+	if (write(fd, entry, len) != (ssize_t)len) {
+		dW("Failed to write the content cache entry '%s': %s", tmp_path, strerror(errno));
+		close(fd);
+		unlink(tmp_path);
+	} else if (close(fd) != 0) {
+		dW("Failed to write the content cache entry '%s': %s", tmp_path, strerror(errno));
+		unlink(tmp_path);
+	} else {
+		path = content_cache_entry_path(dir, key, type_name, schema_version);
+		if (rename(tmp_path, path) != 0) {
+			dW("Failed to store the content cache entry '%s': %s", path, strerror(errno));
+			unlink(tmp_path);
+		} else {
+			dD("Stored the content cache entry '%s'.", path);
+		}
+		free(path);
+	}
+
+	free(entry);
+	free(tmp_path);
+}
+
+#else
+
+bool oscap_content_cache_enabled(void)
+{
+	return false;
+}
+
+char *oscap_content_cache_key_memory(const char *buffer, size_t size)
+{
+	return NULL;
+}
+
+bool oscap_content_cache_is_valid(const char *key, const char *type_name, const char *schema_version)
+{
+	return false;
+}
+
+void oscap_content_cache_set_valid(const char *key, const char *type_name, const char *schema_version)
+{
+}
+
+#endif /* OSCAP_CONTENT_CACHE_SUPPORTED */
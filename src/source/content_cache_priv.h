@@ -0,0 +1,99 @@
+/*
+ * Copyright 2026 Red Hat Inc., Durham, North Carolina.
+ * All Rights Reserved.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ *
+ */
+#ifndef OSCAP_SOURCE_CONTENT_CACHE_H
+#define OSCAP_SOURCE_CONTENT_CACHE_H
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <libxml/tree.h>
+
+/*
+ * Cache of SCAP content enabled by the OSCAP_CONTENT_CACHE_DIR environment
+ * variable. The content is keyed by its SHA-256 digest.
+ *
+ * The schema validation verdicts persist in the directory, keyed by the
+ * digest, the document type and the schema version, and record the
+ * version of the library that validated the content. The directory and
+ * its entries are trusted only if they are owned by the user running the
+ * scan and nobody else can write to them, the content is validated again
+ * otherwise.
+ *
+ * The parsed documents of the last few contents loaded are kept in
+ * memory, loading the same content again in the process copies the
+ * parsed document instead of parsing it. The parsed documents don't
+ * persist across runs, they have no serialization other than XML.
+ */
+
+/**
+ * Check whether the cache is enabled.
+ */
+bool oscap_content_cache_enabled(void);
+
+/**
+ * Compute the cache key of a memory buffer.
+ * @param buffer the content
+ * @param size length of the content
+ * @returns hex encoded digest of the buffer (free by caller) or NULL if
+ * the cache is disabled
+ */
+char *oscap_content_cache_key_memory(const char *buffer, size_t size);
+
+/**
+ * Check whether the content was found valid by a previous run.
+ * @param key cache key of the content
+ * @param type_name type of the document
+ * @param schema_version version of the schema the content was validated against
+ * @returns true if there's a matching cache entry
+ */
+bool oscap_content_cache_is_valid(const char *key, const char *type_name, const char *schema_version);
+
+/**
+ * Record that the content passed the schema validation. Failures to
+ * write the entry are not reported, the cache is only an optimization.
+ * @param key cache key of the content
+ * @param type_name type of the document
+ * @param schema_version version of the schema the content was validated against
+ */
+void oscap_content_cache_set_valid(const char *key, const char *type_name, const char *schema_version);
+
+/**
+ * Get a copy of the document parsed from the content earlier.
+ * @param key cache key of the content, may be NULL
+ * @returns the copy (free by caller) or NULL if it isn't cached
+ */
+xmlDoc *oscap_content_cache_get_doc(const char *key);
+
+/**
+ * Keep a copy of the document parsed from the content.
+ * @param key cache key of the content, may be NULL
+ * @param doc the parsed document, may be NULL
+ */
+void oscap_content_cache_add_doc(const char *key, xmlDoc *doc);
+
+/**
+ * Free the parsed documents, called by oscap_cleanup.
+ */
+void oscap_content_cache_clear_docs(void);
+
+#endif
@@ -24,8 +24,11 @@
 #include <config.h>
 #endif
 
+#include <errno.h>
+#include <stdlib.h>
 #include <string.h>
 #include <fcntl.h>
+#include <sys/stat.h>
 #ifdef OS_WINDOWS
 #include <io.h>
 #else
@@ -50,6 +53,7 @@
 #include "OVAL/oval_parser_impl.h"
 #include "OVAL/public/oval_definitions.h"
 #include "source/bz2_priv.h"
+#include "source/content_cache_priv.h"
 #include "source/schematron_priv.h"
 #include "source/validate_priv.h"
 #include "XCCDF/elements.h"
@@ -71,6 +75,7 @@ struct oscap_source {
 		char *filepath;                         ///< Filepath (if originated from file)
 		char *memory;                           ///< Memory buffer (if originated from memory)
 		size_t memory_size;                     ///< Size of the memory buffer (if originated from memory)
+		char *digest;                           ///< Content cache key of the memory buffer (if computed)
 	} origin;                                       ///
 	struct {
 		xmlDoc *doc;                            /// DOM
@@ -145,6 +150,7 @@ void oscap_source_free(struct oscap_source *source)
 	if (source != NULL) {
 		free(source->origin.filepath);
 		free(source->origin.memory);
+		free(source->origin.digest);
 		if (source->xml.doc != NULL) {
 			xmlFreeDoc(source->xml.doc);
 		}
@@ -177,10 +183,69 @@ xmlTextReader *oscap_source_get_xmlTextReader(struct oscap_source *source)
 	return reader;
 }
 
+bool oscap_source_streaming_enabled(void)
+{
+	const char *env = getenv("OSCAP_SDS_STREAMING");
+
+	return env != NULL && strcmp(env, "1") == 0;
+}
+
+static void oscap_source_streaming_error(void *user, xmlErrorPtr error)
+{
+	// ignored, the errors are reported once the DOM is built
+}
+
+xmlTextReader *oscap_source_get_streaming_xmlTextReader(struct oscap_source *source)
+{
+	xmlTextReader *reader = NULL;
+
+	if (source->xml.doc != NULL || !oscap_source_streaming_enabled())
+		return NULL;
+
+	if (source->origin.memory != NULL) {
+		if (bz2_memory_is_bzip(source->origin.memory, source->origin.memory_size))
+			return NULL;
+		reader = xmlReaderForMemory(source->origin.memory, source->origin.memory_size, NULL, NULL, 0);
+	} else if (source->origin.type == OSCAP_SRC_FROM_USER_XML_FILE) {
+		int fd = open(source->origin.filepath, O_RDONLY);
+		if (fd == -1)
+			return NULL;
+		bool is_bzip = bz2_fd_is_bzip(fd);
+		close(fd);
+		if (is_bzip)
+			return NULL;
+		reader = xmlReaderForFile(source->origin.filepath, NULL, 0);
+	}
+
+	if (reader != NULL)
+		xmlTextReaderSetStructuredErrorHandler(reader, oscap_source_streaming_error, NULL);
+	return reader;
+}
+
+/**
+ * Get a reader of the content, preferably one which doesn't build the DOM.
+ */
+static xmlTextReader *oscap_source_get_any_xmlTextReader(struct oscap_source *source)
+{
+	xmlTextReader *reader = oscap_source_get_streaming_xmlTextReader(source);
+
+	return reader != NULL ? reader : oscap_source_get_xmlTextReader(source);
+}
+
 oscap_document_type_t oscap_source_get_scap_type(struct oscap_source *source)
 {
 	if (source->scap_type == OSCAP_DOCUMENT_UNKNOWN) {
-		xmlTextReader *reader = oscap_source_get_xmlTextReader(source);
+		xmlTextReader *reader = oscap_source_get_streaming_xmlTextReader(source);
+		if (reader != NULL) {
+			// the root element is enough to tell the type
+			if (oscap_determine_document_type_reader(reader, &(source->scap_type)) == -1)
+				source->scap_type = OSCAP_DOCUMENT_UNKNOWN;
+			xmlFreeTextReader(reader);
+			if (source->scap_type != OSCAP_DOCUMENT_UNKNOWN)
+				return source->scap_type;
+			// fall back to the DOM to report the error
+		}
+		reader = oscap_source_get_xmlTextReader(source);
 		if (reader == NULL) {
 			// the oscap error is already set
 			return OSCAP_DOCUMENT_UNKNOWN;
@@ -250,12 +315,21 @@ static bool memory_file_is_executable(const char* memory, const size_t size)
 	return true;
 }
 
+static const char *oscap_source_content_digest(struct oscap_source *source);
+
 xmlDoc *oscap_source_get_xmlDoc(struct oscap_source *source)
 {
 	// We check origin.memory first because even with it being non-NULL
 	// filepath will be non-NULL, it will contain the filepath hint.
 	struct oscap_string *xml_error_string = oscap_string_new();
 	xmlSetGenericErrorFunc(xml_error_string, (xmlGenericErrorFunc)xmlErrorCb);
+	const char *digest = NULL;
+
+	if (source->xml.doc == NULL) {
+		/* the same content loaded again is copied instead of parsed */
+		digest = oscap_source_content_digest(source);
+		source->xml.doc = oscap_content_cache_get_doc(digest);
+	}
 
 	if (source->xml.doc == NULL) {
 		if (source->origin.memory != NULL) {
@@ -267,7 +341,8 @@ xmlDoc *oscap_source_get_xmlDoc(struct oscap_source *source)
 #endif
 			} else
 			{
-				source->xml.doc = xmlReadMemory(source->origin.memory, source->origin.memory_size, NULL, NULL, 0);
+				source->xml.doc = xmlReadMemory(source->origin.memory, source->origin.memory_size,
+						oscap_source_readable_origin(source), NULL, 0);
 				if (source->xml.doc == NULL) {
 					if (memory_file_is_executable(source->origin.memory, source->origin.memory_size)) {
 						dI("oscap-source in memory was detected as executable file '%s'. Skipped XML parsing", oscap_source_readable_origin(source));
@@ -312,6 +387,7 @@ xmlDoc *oscap_source_get_xmlDoc(struct oscap_source *source)
 				close(fd);
 			}
 		}
+		oscap_content_cache_add_doc(digest, source->xml.doc);
 	}
 
 	xmlSetGenericErrorFunc(stderr, NULL);
@@ -325,6 +401,81 @@ xmlDoc *oscap_source_get_xmlDoc(struct oscap_source *source)
 	return source->xml.doc;
 }
 
+/**
+ * Read the whole file of the source into memory. The content is then parsed
+ * and validated from memory, so that the validation verdict cached for its
+ * digest belongs to exactly the bytes which were parsed.
+ */
+static int oscap_source_load_file(struct oscap_source *source)
+{
+	struct stat st;
+	char *buffer;
+	size_t size = 0;
+	ssize_t len;
+	int fd;
+
+	fd = open(source->origin.filepath, O_RDONLY);
+	if (fd == -1)
+		return -1;
+	if (fstat(fd, &st) != 0 || !S_ISREG(st.st_mode)) {
+		close(fd);
+		return -1;
+	}
+
+	buffer = malloc((size_t)st.st_size + 1);
+	if (buffer == NULL) {
+		close(fd);
+		return -1;
+	}
+
+	/* the file may change meanwhile, read at most the size known up front */
+	while (size < (size_t)st.st_size) {
+		len = read(fd, buffer + size, (size_t)st.st_size - size);
+		if (len < 0 && errno == EINTR)
+			continue;
+		if (len <= 0)
+			break;
+		size += len;
+	}
+	close(fd);
+
+	if (size != (size_t)st.st_size) {
+		free(buffer);
+		return -1;
+	}
+	buffer[size] = '\0';
+
+	source->origin.memory = buffer;
+	source->origin.memory_size = size;
+	return 0;
+}
+
+/**
+ * Get the content cache key of the source. Only the content supplied
+ * by the user is cached, documents extracted from a DataStream are covered
+ * by the validation of the DataStream. The key is the digest of the bytes
+ * which are validated and parsed, a file is therefore read into memory
+ * first. A file which was parsed already isn't cached.
+ */
+static const char *oscap_source_content_digest(struct oscap_source *source)
+{
+	if (source->origin.digest != NULL || !oscap_content_cache_enabled())
+		return source->origin.digest;
+
+	switch (source->origin.type) {
+	case OSCAP_SRC_FROM_USER_XML_FILE:
+		if (source->origin.memory == NULL &&
+		    (source->xml.doc != NULL || oscap_source_load_file(source) != 0))
+			return NULL;
+		/* fall through */
+	case OSCAP_SRC_FROM_USER_MEMORY:
+		source->origin.digest = oscap_content_cache_key_memory(source->origin.memory, source->origin.memory_size);
+		return source->origin.digest;
+	default:
+		return NULL;
+	}
+}
+
 int oscap_source_validate(struct oscap_source *source, xml_reporter reporter, void *user)
 {
 	int ret;
@@ -340,10 +491,17 @@ int oscap_source_validate(struct oscap_source *source, xml_reporter reporter, vo
 		}
 		const char *type_name = oscap_document_type_to_string(scap_type);
 		const char *origin = oscap_source_readable_origin(source);
+		const char *cache_key = oscap_source_content_digest(source);
+		if (oscap_content_cache_is_valid(cache_key, type_name, schema_version)) {
+			dD("Skipping validation of %s (%s) document from %s, it is valid according to the content cache.", type_name, schema_version, origin);
+			return 0;
+		}
 		dD("Validating %s (%s) document from %s.", type_name, schema_version, origin);
 		ret = oscap_source_validate_priv(source, scap_type, schema_version, reporter, user);
 		if (ret != 0) {
 			oscap_seterr(OSCAP_EFAMILY_OSCAP, "Invalid %s (%s) content in %s.", type_name, schema_version, origin);
+		} else {
+			oscap_content_cache_set_valid(cache_key, type_name, schema_version);
 		}
 	}
 	return ret;
@@ -358,7 +516,7 @@ int oscap_source_validate_schematron(struct oscap_source *source, const char *ou
 const char *oscap_source_get_schema_version(struct oscap_source *source)
 {
 	if (source->origin.version == NULL) {
-		xmlTextReader *reader = oscap_source_get_xmlTextReader(source);
+		xmlTextReader *reader = oscap_source_get_any_xmlTextReader(source);
 		if (reader == NULL) {
 			return NULL;
 		}
@@ -67,6 +67,25 @@ struct oscap_source *oscap_source_new_from_xmlDoc(xmlDoc *doc, const char *filep
  */
 xmlTextReader *oscap_source_get_xmlTextReader(struct oscap_source *source);
 
+/**
+ * Check whether the content should be loaded without building the DOM of
+ * the whole document whenever possible. Enabled by the OSCAP_SDS_STREAMING
+ * environment variable.
+ * @returns true if the streaming mode is enabled
+ */
+bool oscap_source_streaming_enabled(void);
+
+/**
+ * Get an xmlTextReader parsing the raw content of this resource without
+ * building its DOM. Parsing errors are not reported by the reader. The
+ * reader needs to be disposed by caller.
+ * @memberof oscap_source
+ * @param source Resource to read the content
+ * @returns xmlTextReader structure or NULL if the streaming mode is disabled,
+ * the DOM of the resource has already been built or the content is compressed
+ */
+xmlTextReader *oscap_source_get_streaming_xmlTextReader(struct oscap_source *source);
+
 /**
  * Get a DOM representation of this resource. The document ins still owned
  * by oscap_source.
@@ -90,6 +90,7 @@ static inline int oscap_validate_xml(struct oscap_source *source, const char *sc
 	xmlSchemaPtr schema = NULL;
 	xmlSchemaValidCtxtPtr ctxt = NULL;
 	xmlDocPtr doc = NULL;
+	xmlTextReader *reader = NULL;
 
 	struct ctxt context = { reporter, arg, (void*) oscap_source_readable_origin(source)};
 
@@ -127,11 +128,26 @@ static inline int oscap_validate_xml(struct oscap_source *source, const char *sc
 
 	xmlSchemaSetValidStructuredErrors(ctxt, oscap_xml_validity_handler, &context);
 
-	doc = oscap_source_get_xmlDoc(source);
-	if (!doc)
-		goto cleanup;
-
-	result = xmlSchemaValidateDoc(ctxt, doc);
+	reader = oscap_source_get_streaming_xmlTextReader(source);
+	if (reader != NULL) {
+		/* Validate the content while it's being parsed, the DOM might
+		 * not be needed at all. */
+		xmlTextReaderSetStructuredErrorHandler(reader, oscap_xml_validity_handler, &context);
+		if (xmlTextReaderSchemaValidateCtxt(reader, ctxt, 0) != 0) {
+			oscap_seterr(OSCAP_EFAMILY_XML, "Could not start the validation of '%s'", oscap_source_readable_origin(source));
+			goto cleanup;
+		}
+		while ((result = xmlTextReaderRead(reader)) == 1)
+			;
+		if (result == 0 && xmlTextReaderIsValid(reader) != 1)
+			result = 1;
+	} else {
+		doc = oscap_source_get_xmlDoc(source);
+		if (!doc)
+			goto cleanup;
+
+		result = xmlSchemaValidateDoc(ctxt, doc);
+	}
 
 	/*
 	 * xmlSchemaValidateFile() returns "-1" if document is not well formed
@@ -146,6 +162,8 @@ static inline int oscap_validate_xml(struct oscap_source *source, const char *sc
 	*/
 
 cleanup:
+	if (reader)
+		xmlFreeTextReader(reader);
 	if (ctxt)
 		xmlSchemaFreeValidCtxt(ctxt);
 	if (schema)
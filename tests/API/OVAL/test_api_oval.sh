@@ -30,6 +30,10 @@ function test_api_oval_results {
     cmp $srcdir/results-good.xml exported-results.xml
 }
 
+function test_api_oval_results_instances {
+    ./test_api_results_instances
+}
+
 function test_api_oval_directives {
     ./test_api_directives $srcdir/directives.xml exported-directives.xml
     cmp $srcdir/directives.xml exported-directives.xml
@@ -43,6 +47,7 @@ if [ -z ${CUSTOM_OSCAP+x} ] ; then
     test_run "test_api_oval_definition" test_api_oval_definition
     test_run "test_api_oval_syschar" test_api_oval_syschar
     test_run "test_api_oval_results" test_api_oval_results
+    test_run "test_api_oval_results_instances" test_api_oval_results_instances
     test_run "test_api_oval_directives" test_api_oval_directives
 fi
 
@@ -0,0 +1,67 @@
+/*
+ * Many result definitions with the same id, one per variable instance.
+ * Looking up the current (last) one used to copy the whole list of
+ * results with that id, which made building the results quadratic.
+ * The lookups are timed and checked.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <time.h>
+
+#include "oval_definitions.h"
+#include "oval_system_characteristics.h"
+#include "oval_results.h"
+#include "oscap.h"
+
+#define INSTANCES 20000
+#define MAX_SECONDS 10.0 /* orders of magnitude above the linear cost */
+
+static double now_s(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+int main(void)
+{
+	struct oval_definition_model *definition_model = oval_definition_model_new();
+	struct oval_syschar_model *syschar_model = oval_syschar_model_new(definition_model);
+	struct oval_results_model *results_model = oval_results_model_new(definition_model, NULL);
+	struct oval_result_system *sys = oval_result_system_new(results_model, syschar_model);
+	int ret = 0;
+
+	double t0 = now_s();
+	for (int i = 1; i <= INSTANCES; i++) {
+		struct oval_result_definition *definition = oval_result_definition_new(sys, "oval:x:def:1");
+		oval_result_definition_set_instance(definition, i);
+		oval_result_system_add_definition(sys, definition);
+
+		struct oval_result_definition *last = oval_result_system_get_definition(sys, "oval:x:def:1");
+		if (last != definition || oval_result_definition_get_instance(last) != i) {
+			fprintf(stderr, "FAIL: the last result definition isn't instance %d\n", i);
+			ret = 1;
+			break;
+		}
+	}
+	double elapsed = now_s() - t0;
+
+	printf("%d instances: %.1f ms, %.1f ns/lookup\n", INSTANCES, elapsed * 1e3, elapsed * 1e9 / INSTANCES);
+	if (elapsed > MAX_SECONDS) {
+		fprintf(stderr, "FAIL: the lookups took %.1f s\n", elapsed);
+		ret = 1;
+	}
+
+	oval_results_model_free(results_model);
+	oval_syschar_model_free(syschar_model);
+	oval_definition_model_free(definition_model);
+	oscap_cleanup();
+
+	return ret;
+}
@@ -34,4 +34,11 @@ test_run "test platform schema version" $srcdir/test_platform_version.sh
 test_run "state entity check_existence attribute" $srcdir/test_state_check_existence.sh
 test_run "skip validation" $srcdir/test_skip_valid.sh
 test_run "object component data type evaluation" $srcdir/test_object_component_type.sh
+test_run "nested set objects with a single probe worker" $srcdir/test_probe_worker_pool.sh
+test_run "asynchronous object submission" $srcdir/test_probe_async_submit.sh
+test_run "object collection in dependency waves" $srcdir/test_probe_collection_waves.sh
+test_run "pattern match with shared compiled patterns" $srcdir/test_pattern_match_cache.sh
+test_run "item cache deduplication" $srcdir/test_probe_icache.sh
+test_run "streamed export of OVAL results" $srcdir/test_results_streaming.sh
+test_run "parallel evaluation of definitions" $srcdir/test_parallel_eval.sh
 test_exit
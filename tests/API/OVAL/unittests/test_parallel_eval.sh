@@ -0,0 +1,47 @@
+#!/bin/bash
+
+# Definitions evaluated by several worker threads give the same output
+# and results as the serial evaluation.
+
+set -e -o pipefail
+
+name=$(basename $0 .sh)
+stderr=$(mktemp ${name}.err.XXXXXX)
+echo "stderr file: $stderr"
+log=$(mktemp ${name}.log.XXXXXX)
+echo "log file: $log"
+
+strip_times() {
+	sed 's/<\(oval:\)\?timestamp>[^<]*<\/\(oval:\)\?timestamp>//g' "$1"
+}
+
+serial_stdout=$(mktemp ${name}.out.XXXXXX)
+serial_result=$(mktemp ${name}.out.XXXXXX)
+$OSCAP oval eval --results $serial_result $srcdir/$name.oval.xml > $serial_stdout 2> $stderr
+[ -f $stderr ]; [ ! -s $stderr ]
+
+result=$serial_result
+assert_exists 8 '/oval_results/results/system/definitions/definition'
+assert_exists 1 '/oval_results/results/system/definitions/definition[@definition_id="oval:x:def:3" and @result="false"]'
+assert_exists 1 '/oval_results/results/system/definitions/definition[@definition_id="oval:x:def:5" and @result="false"]'
+assert_exists 1 '/oval_results/results/system/definitions/definition[@definition_id="oval:x:def:7" and @result="true"]'
+assert_exists 1 '/oval_results/results/system/definitions/definition[@definition_id="oval:x:def:8" and @result="false"]'
+
+for jobs in 2 4 16; do
+	parallel_stdout=$(mktemp ${name}.out.XXXXXX)
+	parallel_result=$(mktemp ${name}.out.XXXXXX)
+	$OSCAP oval eval --jobs $jobs --verbose INFO --verbose-log-file $log \
+		--results $parallel_result $srcdir/$name.oval.xml > $parallel_stdout 2> $stderr
+	[ -f $stderr ]; [ ! -s $stderr ]
+
+	grep -q "Evaluating 8 definitions by [0-9]* worker threads" $log
+	diff $serial_stdout $parallel_stdout
+	diff <(strip_times $serial_result) <(strip_times $parallel_result)
+	rm $parallel_stdout $parallel_result
+done
+
+# Invalid number of jobs
+$OSCAP oval eval --jobs 0 $srcdir/$name.oval.xml 2> $stderr && false
+grep -q "jobs" $stderr
+
+rm $serial_stdout $serial_result $stderr $log
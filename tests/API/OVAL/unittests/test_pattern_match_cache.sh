@@ -0,0 +1,30 @@
+#!/bin/bash
+
+# The same pattern is matched against many items and by several tests,
+# make sure the comparisons give the same results with compiled patterns
+# shared across them.
+
+set -e -o pipefail
+
+name=$(basename $0 .sh)
+result=$(mktemp ${name}.out.XXXXXX)
+echo "result file: $result"
+stderr=$(mktemp ${name}.err.XXXXXX)
+echo "stderr file: $stderr"
+
+echo "Analysing syschar content."
+$OSCAP oval analyse --results $result $srcdir/$name.oval.xml $srcdir/$name.syschar.xml 2> $stderr
+[ -f $stderr ]; [ ! -s $stderr ]; rm $stderr
+[ -f $result ]
+
+DEF='/oval_results/results/system/definitions/definition'
+assert_exists 1 $DEF'[@definition_id="oval:x:def:1" and @result="true"]'
+assert_exists 1 $DEF'[@definition_id="oval:x:def:2" and @result="false"]'
+assert_exists 1 $DEF'[@definition_id="oval:x:def:3" and @result="true"]'
+
+TST='/oval_results/results/system/tests/test'
+assert_exists 3 $TST'[@test_id="oval:x:tst:1"]/tested_item[@result="true"]'
+assert_exists 1 $TST'[@test_id="oval:x:tst:2"]/tested_item[@result="false"]'
+assert_exists 1 $TST'[@test_id="oval:x:tst:3"]/tested_item[@result="true"]'
+
+rm $result
@@ -0,0 +1,39 @@
+#!/bin/bash
+
+# Objects of a definition are submitted to the probes before the definition
+# is evaluated and their results are collected when the tests query them.
+# Check that the replies are matched with the right objects.
+
+set -e -o pipefail
+
+name=$(basename $0 .sh)
+result=$(mktemp ${name}.out.XXXXXX)
+echo "result file: $result"
+stderr=$(mktemp ${name}.err.XXXXXX)
+echo "stderr file: $stderr"
+log=$(mktemp ${name}.log.XXXXXX)
+echo "log file: $log"
+
+$OSCAP oval eval --verbose INFO --verbose-log-file $log --results $result $srcdir/$name.oval.xml 2> $stderr
+[ -f $stderr ]; [ ! -s $stderr ]; rm $stderr
+
+[ -s $result ]
+
+grep -q "Submitting textfilecontent54_object 'oval:x:obj:2' in advance" $log
+grep -q "Submitting file_object 'oval:x:obj:4' in advance" $log
+rm $log
+
+assert_exists 1 '/oval_results/results/system/definitions/definition[@definition_id="oval:x:def:1" and @result="true"]'
+assert_exists 1 '/oval_results/results/system/definitions/definition[@definition_id="oval:x:def:2" and @result="true"]'
+
+CO='/oval_results/results/system/oval_system_characteristics/collected_objects'
+assert_exists 1 $CO'/object[@id="oval:x:obj:1" and @flag="complete"]'
+assert_exists 1 $CO'/object[@id="oval:x:obj:2" and @flag="complete"]'
+assert_exists 1 $CO'/object[@id="oval:x:obj:3" and @flag="complete"]'
+assert_exists 1 $CO'/object[@id="oval:x:obj:4" and @flag="does not exist"]'
+
+SD='/oval_results/results/system/oval_system_characteristics/system_data'
+assert_exists 1 $SD'/ind-sys:textfilecontent_item[ind-sys:instance="1"]'
+assert_exists 1 $SD'/ind-sys:textfilecontent_item[ind-sys:instance="2"]'
+
+rm $result
@@ -0,0 +1,32 @@
+#!/bin/bash
+
+# All the objects are collected before the definitions are evaluated, in
+# waves ordered by the dependencies between the objects through variables.
+
+set -e -o pipefail
+
+name=$(basename $0 .sh)
+result=$(mktemp ${name}.out.XXXXXX)
+echo "result file: $result"
+stderr=$(mktemp ${name}.err.XXXXXX)
+echo "stderr file: $stderr"
+log=$(mktemp ${name}.log.XXXXXX)
+echo "log file: $log"
+
+$OSCAP oval eval --verbose INFO --verbose-log-file $log --results $result $srcdir/$name.oval.xml 2> $stderr
+[ -f $stderr ]; [ ! -s $stderr ]; rm $stderr
+
+[ -s $result ]
+
+grep -q "Collecting 4 objects in 3 waves" $log
+grep -q "Submitting textfilecontent54_object 'oval:x:obj:3' in advance" $log
+rm $log
+
+assert_exists 1 '/oval_results/results/system/definitions/definition[@definition_id="oval:x:def:1" and @result="true"]'
+
+CO='/oval_results/results/system/oval_system_characteristics/collected_objects'
+for i in 1 2 3 4; do
+	assert_exists 1 $CO'/object[@id="oval:x:obj:'$i'" and @flag="complete"]'
+done
+
+rm $result
@@ -0,0 +1,26 @@
+#!/bin/bash
+
+# Two different objects collect the same file. The item cache has to
+# deduplicate the item so that both objects reference a single item.
+
+set -e -o pipefail
+
+name=$(basename $0 .sh)
+result=$(mktemp ${name}.out.XXXXXX)
+echo "result file: $result"
+stderr=$(mktemp ${name}.err.XXXXXX)
+echo "stderr file: $stderr"
+
+$OSCAP oval eval --results $result $srcdir/$name.oval.xml 2> $stderr
+[ -f $stderr ]; [ ! -s $stderr ]; rm $stderr
+
+[ -s $result ]
+
+assert_exists 1 '/oval_results/results/system/definitions/definition[@definition_id="oval:x:def:1" and @result="true"]'
+
+SC='/oval_results/results/system/oval_system_characteristics'
+assert_exists 1 $SC'/system_data/unix-sys:file_item'
+ref=$($XPATH $result 'string('$SC'/collected_objects/object[@id="oval:x:obj:1"]/reference/@item_ref)')
+assert_exists 1 $SC'/collected_objects/object[@id="oval:x:obj:2"]/reference[@item_ref="'$ref'"]'
+
+rm $result
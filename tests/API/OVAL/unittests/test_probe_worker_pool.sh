@@ -0,0 +1,30 @@
+#!/bin/bash
+
+# Set objects are evaluated by sending their object references back to
+# the same probe. Check that this works even if the probe worker pool
+# has a single worker.
+
+set -e -o pipefail
+
+name=$(basename $0 .sh)
+result=$(mktemp ${name}.out.XXXXXX)
+echo "result file: $result"
+stderr=$(mktemp ${name}.err.XXXXXX)
+echo "stderr file: $stderr"
+
+OSCAP_PROBE_WORKERS=1 timeout 60 $OSCAP oval eval --results $result $srcdir/$name.oval.xml 2> $stderr
+# results of the referenced objects are sent back to the library as well
+sed -i -E "/^W: oscap:[ ]+Obtrusive data from probe!/d" "$stderr"
+[ -f $stderr ]; [ ! -s $stderr ]; rm $stderr
+
+[ -s $result ]
+
+assert_exists 1 '/oval_results/results/system/definitions/definition[@definition_id="oval:x:def:1" and @result="true"]'
+
+CO='/oval_results/results/system/oval_system_characteristics/collected_objects'
+assert_exists 1 $CO'/object[@id="oval:x:obj:3" and @flag="complete"]'
+assert_exists 2 $CO'/object[@id="oval:x:obj:3"]/reference'
+assert_exists 1 $CO'/object[@id="oval:x:obj:4" and @flag="complete"]'
+assert_exists 2 $CO'/object[@id="oval:x:obj:4"]/reference'
+
+rm $result
@@ -0,0 +1,36 @@
+#!/bin/bash
+
+# OVAL Results are written out while they are being serialized unless
+# the document is needed for something else, e.g. the HTML report or the
+# full validation. All ways have to produce the same document. The full
+# validation is turned on by test_common.sh, the streamed runs turn it off.
+
+set -e -o pipefail
+
+name=$(basename $0 .sh)
+result=$(mktemp ${name}.out.XXXXXX)
+echo "result file: $result"
+result_dom=$(mktemp ${name}.dom.XXXXXX)
+echo "result file (DOM): $result_dom"
+result_valid=$(mktemp ${name}.valid.XXXXXX)
+echo "result file (validated): $result_valid"
+report=$(mktemp ${name}.html.XXXXXX)
+stderr=$(mktemp ${name}.err.XXXXXX)
+echo "stderr file: $stderr"
+
+env -u OSCAP_FULL_VALIDATION $OSCAP oval eval --results $result $srcdir/test_probe_icache.oval.xml 2> $stderr
+[ -f $stderr ]; [ ! -s $stderr ]
+env -u OSCAP_FULL_VALIDATION $OSCAP oval eval --results $result_dom --report $report $srcdir/test_probe_icache.oval.xml 2> $stderr
+[ -f $stderr ]; [ ! -s $stderr ]
+OSCAP_FULL_VALIDATION=1 $OSCAP oval eval --results $result_valid $srcdir/test_probe_icache.oval.xml 2> $stderr
+[ -f $stderr ]; [ ! -s $stderr ]; rm $stderr
+
+$OSCAP oval validate $result
+
+assert_exists 1 '/oval_results/results/system/definitions/definition[@definition_id="oval:x:def:1" and @result="true"]'
+assert_exists 1 '/oval_results/results/system/oval_system_characteristics/system_data/unix-sys:file_item'
+
+diff <(grep -v "timestamp" $result) <(grep -v "timestamp" $result_dom)
+diff <(grep -v "timestamp" $result) <(grep -v "timestamp" $result_valid)
+
+rm $result $result_dom $result_valid $report
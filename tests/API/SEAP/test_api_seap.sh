@@ -32,6 +32,33 @@ function test_api_strto {
     ./test_api_strto
 }
 
+function test_api_seap_list_bench {
+    local ret_val=0;
+
+    # validation of every list operation would dominate the timings
+    export SEXP_VALIDATE_DISABLE="1"
+    ./test_api_seap_list_bench
+    ret_val=$?
+    unset SEXP_VALIDATE_DISABLE
+
+    return $ret_val
+}
+
+function test_api_seap_channel_bench {
+    local ret_val=0;
+
+    export SEXP_VALIDATE_DISABLE="1"
+    ./test_api_seap_channel_bench && OSCAP_SEAP_PACKET_SEXP=1 ./test_api_seap_channel_bench
+    ret_val=$?
+    unset SEXP_VALIDATE_DISABLE
+
+    return $ret_val
+}
+
+function test_api_seap_pool {
+    ./test_api_seap_pool && OSCAP_SEXP_POOL=0 ./test_api_seap_pool
+}
+
 # Testing.
 
 test_init
@@ -40,6 +67,9 @@ if [ -z ${CUSTOM_OSCAP+x} ] ; then
     test_run "test_api_seap_concurency"           test_api_seap_concurency
     test_run "test_api_seap_spb"                  ./test_api_seap_spb
     test_run "test_api_seap_list"                 ./test_api_seap_list
+    test_run "test_api_seap_list_bench"           test_api_seap_list_bench
+    test_run "test_api_seap_channel_bench"        test_api_seap_channel_bench
+    test_run "test_api_seap_pool"                 test_api_seap_pool
     test_run "test_api_seap_number_expression"    ./test_api_seap_number
     test_run "test_api_seap_string_expression"    ./test_api_seap_string
     test_run "test_api_SEXP_deepcmp"              ./test_api_SEXP_deepcmp
@@ -0,0 +1,136 @@
+/*
+ * Microbenchmark of the round trip of a message between the library and
+ * a probe thread. The probe thread is replaced by an echo loop, so only
+ * the cost of the channel is measured. Run it once as is and once with
+ * OSCAP_SEAP_PACKET_SEXP=1 to compare passing the packets by reference
+ * with the S-exp transport. The replies are checked too.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <pthread.h>
+#include <sexp.h>
+
+#include "_seap.h"
+#include "seap-descriptor.h"
+#include "probe/probe_main.h"
+
+#define FAIL(...)                                             \
+	do {                                                  \
+		fprintf(stderr, "FAIL: " __VA_ARGS__);        \
+		exit(1);                                      \
+	} while (0)
+
+static double now_ns(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+/* The debug log of the library isn't available to the SEAP sources built in */
+void __oscap_debuglog_object(const char *file, const char *fn, size_t line, int objtype, void *obj)
+{
+}
+
+/* Started by SEAP_connect in place of the probe */
+void *probe_common_main(void *arg)
+{
+	struct probe_common_main_argument *probe_argument = arg;
+	SEAP_CTX_t *ctx = SEAP_CTX_new();
+	SEAP_msg_t *req, *rep;
+	SEXP_t *obj;
+	int sd;
+
+	sd = SEAP_add_probe(ctx, probe_argument->queuedata);
+	if (sd < 0)
+		FAIL("SEAP_add_probe\n");
+	free(probe_argument);
+
+	while (SEAP_recvmsg(ctx, sd, &req) == 0) {
+		rep = SEAP_msg_new();
+		obj = SEAP_msg_get(req);
+		SEAP_msg_set(rep, obj);
+		SEXP_free(obj);
+		if (SEAP_reply(ctx, sd, rep, req) != 0)
+			FAIL("SEAP_reply\n");
+		SEAP_msg_free(rep);
+		SEAP_msg_free(req);
+	}
+
+	return NULL;
+}
+
+static void bench_roundtrip(SEAP_CTX_t *ctx, int sd, uint32_t size)
+{
+	uint32_t rounds = 1 + 1048576 / (size + 16);
+	uint32_t r, i;
+	SEAP_msg_t *req, *rep;
+	SEXP_t *obj, *memb, *rid, *val;
+	double t0;
+
+	obj = SEXP_list_new(NULL);
+	for (i = 0; i < size; ++i) {
+		memb = SEXP_string_newf("item %u", i);
+		SEXP_list_add(obj, memb);
+		SEXP_free(memb);
+	}
+
+	t0 = now_ns();
+	for (r = 0; r < rounds; ++r) {
+		req = SEAP_msg_new();
+		SEAP_msg_set(req, obj);
+		if (SEAP_sendmsg(ctx, sd, req) != 0)
+			FAIL("SEAP_sendmsg\n");
+		if (SEAP_recvmsg(ctx, sd, &rep) != 0)
+			FAIL("SEAP_recvmsg\n");
+
+		rid = SEAP_msgattr_get(rep, "reply-id");
+		if (rid == NULL || SEXP_number_getu_64(rid) != SEAP_msg_id(req))
+			FAIL("reply-id doesn't match the request\n");
+		if (r == 0) {
+			/* don't time the comparison, the payload is the same every time */
+			val = SEAP_msg_get(rep);
+			if (!SEXP_deepcmp(val, obj))
+				FAIL("reply doesn't match the request\n");
+			SEXP_free(val);
+		}
+
+		SEXP_free(rid);
+		SEAP_msg_free(rep);
+		SEAP_msg_free(req);
+	}
+	printf("round trip %6u members: %10.1f ns/op\n", size, (now_ns() - t0) / rounds);
+
+	SEXP_free(obj);
+}
+
+int main(void)
+{
+	SEAP_CTX_t *ctx;
+	uint32_t size;
+	int sd;
+
+	printf("transport: %s\n", getenv("OSCAP_SEAP_PACKET_SEXP") != NULL ? "s-exp" : "reference");
+
+	ctx = SEAP_CTX_new();
+	sd = SEAP_connect(ctx);
+	if (sd < 0)
+		FAIL("SEAP_connect\n");
+
+	for (size = 1; size <= 4096; size *= 16)
+		bench_roundtrip(ctx, sd, size);
+
+	if (SEAP_close(ctx, sd) != 0)
+		FAIL("SEAP_close\n");
+	SEAP_CTX_free(ctx);
+
+	return 0;
+}
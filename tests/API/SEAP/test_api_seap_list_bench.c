@@ -0,0 +1,157 @@
+/*
+ * Microbenchmark of the S-exp list operations. Lists up to 2^15 members
+ * are kept in one contiguous block, the members of longer lists past the
+ * first block are chained in blocks of 64. Both paths are timed, but the
+ * old layout of chained blocks of growing size no longer exists and is
+ * not compared. The results of the operations are checked too.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <sexp.h>
+#include <probe-api.h>
+
+#define FAIL(...)                                             \
+	do {                                                  \
+		fprintf(stderr, "FAIL: " __VA_ARGS__);        \
+		exit(1);                                      \
+	} while (0)
+
+static double now_ns(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+/* 2^SEXP_LBLK_CONTMAX, the longest list kept in one block */
+#define CONTIGUOUS_MAX 32768
+
+static void report(const char *op, uint32_t size, double t0, uint64_t ops)
+{
+	printf("%-12s %6u members %-12s %10.1f ns/op\n", op, size,
+	       size <= CONTIGUOUS_MAX ? "(contiguous)" : "(chained)",
+	       (now_ns() - t0) / ops);
+}
+
+static int numcmp(const SEXP_t *a, const SEXP_t *b)
+{
+	uint32_t na = SEXP_number_getu_32(a), nb = SEXP_number_getu_32(b);
+
+	return na < nb ? -1 : na > nb;
+}
+
+static void bench_list(uint32_t size)
+{
+	uint32_t rounds = 1 + 262144 / size;
+	uint32_t r, i;
+	double t0;
+	SEXP_t *list = NULL, *memb;
+
+	t0 = now_ns();
+	for (r = 0; r < rounds; ++r) {
+		SEXP_free(list);
+		list = SEXP_list_new(NULL);
+		for (i = 0; i < size; ++i) {
+			/* descending, so that there's something to sort */
+			memb = SEXP_number_newu_32(size - i);
+			SEXP_list_add(list, memb);
+			SEXP_free(memb);
+		}
+	}
+	report("list_add", size, t0, (uint64_t)rounds * size);
+
+	t0 = now_ns();
+	for (r = 0; r < rounds; ++r) {
+		if (SEXP_list_length(list) != size)
+			FAIL("length: %zu != %u\n", SEXP_list_length(list), size);
+	}
+	report("list_length", size, t0, rounds);
+
+	t0 = now_ns();
+	for (r = 0; r < rounds; ++r) {
+		for (i = 1; i <= size; ++i) {
+			memb = SEXP_list_nth(list, i);
+			if (SEXP_number_getu_32(memb) != size - i + 1)
+				FAIL("nth(%u): %u != %u\n", i, SEXP_number_getu_32(memb), size - i + 1);
+			SEXP_free(memb);
+		}
+	}
+	report("list_nth", size, t0, (uint64_t)rounds * size);
+
+	t0 = now_ns();
+	for (r = 0; r < rounds; ++r) {
+		SEXP_t *copy = SEXP_ref(list);
+
+		/* the list is shared, so it gets copied first */
+		memb = SEXP_number_newu_32(0);
+		SEXP_list_add(copy, memb);
+		SEXP_free(memb);
+		SEXP_free(copy);
+	}
+	report("list_copy", size, t0, (uint64_t)rounds * size);
+
+	t0 = now_ns();
+	SEXP_list_sort(list, numcmp);
+	report("list_sort", size, t0, size);
+
+	i = 0;
+	SEXP_list_foreach(memb, list) {
+		if (SEXP_number_getu_32(memb) != ++i)
+			FAIL("sort: %u != %u\n", SEXP_number_getu_32(memb), i);
+	}
+
+	SEXP_free(list);
+}
+
+static void bench_attrs(void)
+{
+	const char *names[] = { "operation", "datatype", "mask", "var_ref", "var_check" };
+	uint32_t rounds = 200000;
+	uint32_t r, i;
+	SEXP_t *ent, *val;
+	double t0;
+
+	ent = probe_ent_creat1("path", NULL, NULL);
+	for (i = 0; i < sizeof names / sizeof names[0]; ++i) {
+		val = SEXP_number_newu_32(i);
+		probe_ent_attr_add(ent, names[i], val);
+		SEXP_free(val);
+	}
+
+	t0 = now_ns();
+	for (r = 0; r < rounds; ++r) {
+		for (i = 0; i < sizeof names / sizeof names[0]; ++i) {
+			val = probe_ent_getattrval(ent, names[i]);
+			if (val == NULL || SEXP_number_getu_32(val) != i)
+				FAIL("getattrval(%s)\n", names[i]);
+			SEXP_free(val);
+		}
+		if (probe_ent_getattrval(ent, "entity_check") != NULL)
+			FAIL("getattrval(entity_check) != NULL\n");
+	}
+	report("getattrval", i, t0, (uint64_t)rounds * (i + 1));
+
+	SEXP_free(ent);
+}
+
+int main(void)
+{
+	uint32_t size;
+
+	for (size = 4; size <= 16384; size *= 16)
+		bench_list(size);
+	bench_list(CONTIGUOUS_MAX);
+	bench_list(CONTIGUOUS_MAX * 2);
+
+	bench_attrs();
+
+	return 0;
+}
@@ -0,0 +1,221 @@
+/*
+ * Test of the pool of the S-exp values. Run it once as is and once with
+ * OSCAP_SEXP_POOL=0: blocks are reused by the thread which freed them,
+ * also if another thread allocated them, a thread caches at most
+ * SEXP_POOL_CACHE_MAX bytes and everything is given back to the system
+ * when the thread exits. The disabled pool doesn't cache anything.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+#include <pthread.h>
+
+#include "_sexp-pool.h"
+#include "common/memusage.h"
+
+#define FAIL(...)                                             \
+	do {                                                  \
+		fprintf(stderr, "FAIL: " __VA_ARGS__);        \
+		exit(1);                                      \
+	} while (0)
+
+#define CROSS_BLOCKS 1000
+#define CROSS_SIZE   100
+#define CAP_BLOCKS   (3 * SEXP_POOL_CACHE_MAX / SEXP_POOL_MAXSIZE)
+
+static bool pool_enabled;
+static struct alloc_memusage mu_start;
+
+/* Counters accounted since the start of the test case */
+static struct alloc_memusage pool_delta(void)
+{
+	struct alloc_memusage mu;
+
+	if (oscap_alloc_memusage(&mu) != 0)
+		FAIL("oscap_alloc_memusage\n");
+
+	mu.mu_allocs -= mu_start.mu_allocs;
+	mu.mu_reused -= mu_start.mu_reused;
+	mu.mu_frees  -= mu_start.mu_frees;
+	mu.mu_cached -= mu_start.mu_cached;
+	return mu;
+}
+
+static void pool_start(void)
+{
+	if (oscap_alloc_memusage(&mu_start) != 0)
+		FAIL("oscap_alloc_memusage\n");
+}
+
+static void run(void *(*fn)(void *), void *arg)
+{
+	pthread_t th;
+
+	if (pthread_create(&th, NULL, fn, arg) != 0)
+		FAIL("pthread_create\n");
+	pthread_join(th, NULL);
+}
+
+static void *block_new(size_t size, uint8_t fill)
+{
+	void *p = SEXP_pool_alloc(size);
+
+	if (p == NULL)
+		FAIL("SEXP_pool_alloc(%zu)\n", size);
+	if ((uintptr_t)p % SEXP_POOL_ALIGN != 0)
+		FAIL("%p is not aligned to %d bytes\n", p, SEXP_POOL_ALIGN);
+	memset(p, fill, size);
+	return p;
+}
+
+static void *reuse_thread(void *arg)
+{
+	void *p, *q;
+
+	p = block_new(40, 0xaa);
+	SEXP_pool_free(p, 40);
+	q = block_new(40, 0xbb);
+
+	if (pool_enabled && q != p)
+		FAIL("reuse: the freed block wasn't reused\n");
+	SEXP_pool_free(q, 40);
+	return NULL;
+}
+
+static void test_reuse(void)
+{
+	struct alloc_memusage mu;
+
+	pool_start();
+	run(reuse_thread, NULL);
+	mu = pool_delta();
+
+	if (pool_enabled) {
+		if (mu.mu_allocs != 1 || mu.mu_reused != 1 || mu.mu_frees != 1 || mu.mu_cached != 0)
+			FAIL("reuse: allocs=%zu reused=%zu frees=%zu cached=%zu\n",
+			     mu.mu_allocs, mu.mu_reused, mu.mu_frees, mu.mu_cached);
+	} else if (mu.mu_allocs + mu.mu_reused + mu.mu_frees + mu.mu_cached != 0) {
+		FAIL("reuse: the disabled pool counted allocations\n");
+	}
+}
+
+static void *cross_alloc_thread(void *arg)
+{
+	void **blocks = arg;
+
+	for (size_t i = 0; i < CROSS_BLOCKS; ++i)
+		blocks[i] = block_new(CROSS_SIZE, (uint8_t)i);
+	return NULL;
+}
+
+static void *cross_free_thread(void *arg)
+{
+	void **blocks = arg;
+	struct alloc_memusage mu;
+
+	for (size_t i = 0; i < CROSS_BLOCKS; ++i) {
+		const uint8_t *b = blocks[i];
+
+		if (b[0] != (uint8_t)i || b[CROSS_SIZE - 1] != (uint8_t)i)
+			FAIL("cross: block %zu was overwritten\n", i);
+		SEXP_pool_free(blocks[i], CROSS_SIZE);
+	}
+
+	/* The blocks of the other thread are now cached by this one */
+	for (size_t i = 0; i < CROSS_BLOCKS; ++i)
+		blocks[i] = block_new(CROSS_SIZE, 0xcc);
+	SEXP_pool_release();
+
+	mu = pool_delta();
+	if (pool_enabled && mu.mu_reused != CROSS_BLOCKS)
+		FAIL("cross: reused=%zu, expected %d\n", mu.mu_reused, CROSS_BLOCKS);
+
+	for (size_t i = 0; i < CROSS_BLOCKS; ++i)
+		SEXP_pool_free(blocks[i], CROSS_SIZE);
+	return NULL;
+}
+
+static void test_cross_thread(void)
+{
+	void **blocks = calloc(CROSS_BLOCKS, sizeof(void *));
+	struct alloc_memusage mu;
+
+	if (blocks == NULL)
+		FAIL("calloc\n");
+
+	pool_start();
+	run(cross_alloc_thread, blocks);
+	run(cross_free_thread, blocks);
+	mu = pool_delta();
+
+	/* Both threads have exited, nothing may stay cached */
+	if (pool_enabled) {
+		if (mu.mu_allocs != CROSS_BLOCKS || mu.mu_frees != CROSS_BLOCKS || mu.mu_cached != 0)
+			FAIL("cross: allocs=%zu frees=%zu cached=%zu\n",
+			     mu.mu_allocs, mu.mu_frees, mu.mu_cached);
+	} else if (mu.mu_allocs + mu.mu_reused + mu.mu_frees + mu.mu_cached != 0) {
+		FAIL("cross: the disabled pool counted allocations\n");
+	}
+	free(blocks);
+}
+
+static void *cap_thread(void *arg)
+{
+	void **blocks = arg;
+	struct alloc_memusage mu;
+
+	for (size_t i = 0; i < CAP_BLOCKS; ++i)
+		blocks[i] = block_new(SEXP_POOL_MAXSIZE, 0xdd);
+	for (size_t i = 0; i < CAP_BLOCKS; ++i)
+		SEXP_pool_free(blocks[i], SEXP_POOL_MAXSIZE);
+
+	/* The free lists were trimmed while the blocks were being freed */
+	mu = pool_delta();
+	if (pool_enabled && mu.mu_frees == 0)
+		FAIL("cap: %d blocks cached without a trim\n", CAP_BLOCKS);
+
+	SEXP_pool_release();
+	mu = pool_delta();
+	if (mu.mu_cached > SEXP_POOL_CACHE_MAX)
+		FAIL("cap: %zu bytes cached, limit %d\n", mu.mu_cached, SEXP_POOL_CACHE_MAX);
+	return NULL;
+}
+
+static void test_cap(void)
+{
+	void **blocks = calloc(CAP_BLOCKS, sizeof(void *));
+	struct alloc_memusage mu;
+
+	if (blocks == NULL)
+		FAIL("calloc\n");
+
+	pool_start();
+	run(cap_thread, blocks);
+	mu = pool_delta();
+
+	if (mu.mu_cached != 0 || mu.mu_allocs != mu.mu_frees)
+		FAIL("cap: allocs=%zu frees=%zu cached=%zu after the thread exited\n",
+		     mu.mu_allocs, mu.mu_frees, mu.mu_cached);
+	free(blocks);
+}
+
+int main(void)
+{
+	const char *env = getenv("OSCAP_SEXP_POOL");
+
+	pool_enabled = env == NULL || strcmp(env, "0") != 0;
+	printf("S-exp pool: %s\n", pool_enabled ? "enabled" : "disabled");
+
+	test_reuse();
+	test_cross_thread();
+	test_cap();
+
+	return 0;
+}
@@ -0,0 +1,58 @@
+#!/bin/bash
+. $builddir/tests/test_common.sh
+
+# XCCDF results and ARF are written out while they are being serialized
+# unless the document is needed for something else, e.g. the HTML report
+# or the full validation. All ways have to produce the same documents.
+# test_common.sh turns the full validation on, so the streamed runs have
+# to turn it off again.
+
+set -e
+set -o pipefail
+set -x
+
+touch not_executable
+
+name=$(basename $0 .sh)
+xccdf=$srcdir/test_deriving_xccdf_result_from_oval.xccdf.xml
+
+result=$(mktemp -t ${name}.out.XXXXXX)
+result_dom=$(mktemp -t ${name}.dom.XXXXXX)
+result_valid=$(mktemp -t ${name}.valid.XXXXXX)
+arf=$(mktemp -t ${name}.arf.XXXXXX)
+arf_dom=$(mktemp -t ${name}.arf_dom.XXXXXX)
+report=$(mktemp -t ${name}.html.XXXXXX)
+stderr=$(mktemp -t ${name}.err.XXXXXX)
+
+# XCCDF results alone
+env -u OSCAP_FULL_VALIDATION $OSCAP xccdf eval --results $result $xccdf 2> $stderr
+[ -f $stderr ]; [ ! -s $stderr ]
+env -u OSCAP_FULL_VALIDATION $OSCAP xccdf eval --results $result_dom --report $report $xccdf 2> $stderr
+[ -f $stderr ]; [ ! -s $stderr ]
+$OSCAP xccdf eval --results $result_valid $xccdf 2> $stderr
+[ -f $stderr ]; [ ! -s $stderr ]
+
+$OSCAP xccdf validate $result
+assert_exists 1 '//TestResult'
+assert_exists 8 '//TestResult/rule-result'
+assert_exists 2 '//TestResult/score'
+diff <(grep -v "time" $result) <(grep -v "time" $result_dom)
+diff <(grep -v "time" $result) <(grep -v "time" $result_valid)
+
+# ARF
+env -u OSCAP_FULL_VALIDATION $OSCAP xccdf eval --results-arf $arf $xccdf 2> $stderr
+[ -f $stderr ]; [ ! -s $stderr ]
+env -u OSCAP_FULL_VALIDATION $OSCAP xccdf eval --results-arf $arf_dom --report $report $xccdf 2> $stderr
+[ -f $stderr ]; [ ! -s $stderr ]; rm $stderr
+
+$OSCAP ds rds-validate $arf
+rm $result
+result=$arf
+assert_exists 1 '/arf:asset-report-collection/core:relationships'
+assert_exists 1 '/arf:asset-report-collection/arf:report-requests/arf:report-request'
+assert_exists 1 '/arf:asset-report-collection/arf:assets/arf:asset'
+assert_exists 3 '/arf:asset-report-collection/arf:reports/arf:report'
+diff <(grep -v "time" $arf) <(grep -v "time" $arf_dom)
+
+rm $result_dom $result_valid $arf $arf_dom $report
+rm not_executable
@@ -0,0 +1,61 @@
+#!/bin/bash
+. $builddir/tests/test_common.sh
+
+set -e
+set -o pipefail
+
+name=test_multiple_oval_files_with_same_basename
+
+cache=$(mktemp -d -t ${name}.cache.XXXXXX)
+log=$(mktemp -t ${name}.log.XXXXXX)
+stderr=$(mktemp -t ${name}.out.XXXXXX)
+invalid=$(mktemp -t ${name}.invalid.XXXXXX)
+
+# The first run validates the content and fills the cache
+OSCAP_CONTENT_CACHE_DIR=$cache/sub $OSCAP xccdf eval --verbose DEVEL --verbose-log-file $log \
+	$srcdir/${name}.xccdf.xml > /dev/null 2> $stderr || [ $? == 2 ]
+[ -f $stderr ]; [ ! -s $stderr ]
+grep -q "Validating XCCDF" $log
+# the XCCDF and both OVAL files
+[ "$(ls $cache/sub/*.valid | wc -l)" == "3" ]
+# keyed by the digest, the document type and the schema version
+entry=$(basename $cache/sub/$(sha256sum $srcdir/${name}.xccdf.xml | cut -d' ' -f1)-XCCDF_Checklist-1.2.valid)
+head -n 1 $cache/sub/$entry | grep -q "^openscap-content-cache 1$"
+[ "$(stat -c %a $cache/sub)" == "700" ]
+
+# The second run skips the validation
+OSCAP_CONTENT_CACHE_DIR=$cache/sub $OSCAP xccdf eval --verbose DEVEL --verbose-log-file $log \
+	$srcdir/${name}.xccdf.xml > /dev/null 2> $stderr || [ $? == 2 ]
+[ -f $stderr ]; [ ! -s $stderr ]
+[ "$(grep -c "valid according to the content cache" $log)" == "3" ]
+! grep -q "Validating XCCDF" $log
+
+# A stale entry is ignored and rewritten
+sed -i 's/^version .*/version 0.0.0/' $cache/sub/$entry
+OSCAP_CONTENT_CACHE_DIR=$cache/sub $OSCAP xccdf eval --verbose DEVEL --verbose-log-file $log \
+	$srcdir/${name}.xccdf.xml > /dev/null 2> $stderr || [ $? == 2 ]
+grep -q "Validating XCCDF" $log
+! grep -q "^version 0.0.0$" $cache/sub/$entry
+
+# Invalid content is never cached
+sed 's|<status>|<invalid-element/><status>|' $srcdir/${name}.xccdf.xml > $invalid
+OSCAP_CONTENT_CACHE_DIR=$cache/sub $OSCAP xccdf validate $invalid > /dev/null 2>&1 && false
+OSCAP_CONTENT_CACHE_DIR=$cache/sub $OSCAP xccdf validate $invalid > /dev/null 2>&1 && false
+! ls $cache/sub/$(sha256sum $invalid | cut -d' ' -f1)-* > /dev/null 2>&1
+
+# Entries writable by other users aren't trusted
+chmod go+w $cache/sub/$entry
+OSCAP_CONTENT_CACHE_DIR=$cache/sub $OSCAP xccdf eval --verbose DEVEL --verbose-log-file $log \
+	$srcdir/${name}.xccdf.xml > /dev/null 2> $stderr || [ $? == 2 ]
+grep -q "Validating XCCDF" $log
+chmod go-w $cache/sub/$entry
+
+# Neither is a directory writable by other users
+chmod g+w $cache/sub
+OSCAP_CONTENT_CACHE_DIR=$cache/sub $OSCAP xccdf eval --verbose DEVEL --verbose-log-file $log \
+	$srcdir/${name}.xccdf.xml > /dev/null 2> $stderr || [ $? == 2 ]
+grep -q "Validating XCCDF" $log
+! grep -q "valid according to the content cache" $log
+
+rm -rf $cache
+rm $log $stderr $invalid
@@ -0,0 +1,65 @@
+#!/bin/bash
+. $builddir/tests/test_common.sh
+
+set -e
+set -o pipefail
+
+# Rules of this benchmark are checked by two different OVAL files,
+# so that they are evaluated by two checking engines concurrently.
+name=test_multiple_oval_files_with_same_basename
+
+serial_stdout=$(mktemp -t ${name}.out.XXXXXX)
+serial_result=$(mktemp -t ${name}.out.XXXXXX)
+parallel_stdout=$(mktemp -t ${name}.out.XXXXXX)
+parallel_result=$(mktemp -t ${name}.out.XXXXXX)
+stderr=$(mktemp -t ${name}.out.XXXXXX)
+
+$OSCAP xccdf eval --results $serial_result $srcdir/${name}.xccdf.xml > $serial_stdout 2> $stderr || [ $? == 2 ]
+[ -f $stderr ]; [ ! -s $stderr ]
+
+$OSCAP xccdf eval --jobs 4 --results $parallel_result $srcdir/${name}.xccdf.xml > $parallel_stdout 2> $stderr || [ $? == 2 ]
+[ -f $stderr ]; [ ! -s $stderr ]
+
+$OSCAP xccdf validate $parallel_result
+
+# The output and the rule-results are in the document order
+diff $serial_stdout $parallel_stdout
+strip_times() {
+	sed 's/\(start-\|end-\)\?time="[^"]*"//g' "$1"
+}
+diff <(strip_times $serial_result) <(strip_times $parallel_result)
+
+result=$parallel_result
+assert_exists 8 '//rule-result'
+assert_exists 8 '//rule-result/check/check-content-ref'
+
+# Invalid number of jobs
+$OSCAP xccdf eval --jobs 0 $srcdir/${name}.xccdf.xml 2> $stderr && false
+grep -q "jobs" $stderr
+
+rm $serial_stdout $serial_result $parallel_stdout $parallel_result $stderr
+
+# All rules of this benchmark are checked by a single OVAL file, some of them
+# with multi-check, so that the OVAL checks are evaluated concurrently by one
+# checking engine.
+name=test_xccdf_check_multi_check
+
+serial_stdout=$(mktemp -t ${name}.out.XXXXXX)
+serial_result=$(mktemp -t ${name}.out.XXXXXX)
+parallel_stdout=$(mktemp -t ${name}.out.XXXXXX)
+parallel_result=$(mktemp -t ${name}.out.XXXXXX)
+stderr=$(mktemp -t ${name}.out.XXXXXX)
+
+$OSCAP xccdf eval --results $serial_result $srcdir/${name}.xccdf.xml > $serial_stdout 2> $stderr || [ $? == 2 ]
+[ -f $stderr ]; [ ! -s $stderr ]
+
+for i in 1 2 3 4 5; do
+	$OSCAP xccdf eval --jobs 4 --results $parallel_result $srcdir/${name}.xccdf.xml > $parallel_stdout 2> $stderr || [ $? == 2 ]
+	[ -f $stderr ]; [ ! -s $stderr ]
+	diff $serial_stdout $parallel_stdout
+	diff <(strip_times $serial_result) <(strip_times $parallel_result)
+done
+
+$OSCAP xccdf validate $parallel_result
+
+rm $serial_stdout $serial_result $parallel_stdout $parallel_result $stderr
@@ -0,0 +1,36 @@
+#!/bin/bash
+. $builddir/tests/test_common.sh
+
+set -e
+set -o pipefail
+
+name=test_multiple_oval_files_with_same_basename
+
+json=$(mktemp -t ${name}.out.XXXXXX)
+csv=$(mktemp -t ${name}.out.XXXXXX).csv
+stderr=$(mktemp -t ${name}.out.XXXXXX)
+
+$OSCAP xccdf eval --profile-output $json $srcdir/${name}.xccdf.xml > /dev/null 2> $stderr || [ $? == 2 ]
+[ -f $stderr ]; [ ! -s $stderr ]
+
+grep -q '"wall_ms": ' $json
+grep -q '"rules": \[' $json
+grep -q '"definitions": \[' $json
+[ "$(grep -c '{"id": "xccdf_moc.elpmaxe.www_rule_[1-8]", "calls": 1,' $json)" == "8" ]
+
+# The same report in CSV, evaluated with parallel jobs
+$OSCAP xccdf eval --jobs 2 --profile-output $csv $srcdir/${name}.xccdf.xml > /dev/null 2> $stderr || [ $? == 2 ]
+[ -f $stderr ]; [ ! -s $stderr ]
+
+[ "$(head -n 1 $csv)" == "type,id,calls,wall_ms,cpu_ms,items" ]
+[ "$(grep -c '^rule,"xccdf_moc.elpmaxe.www_rule_[1-8]",1,' $csv)" == "8" ]
+# both OVAL files define the same definition IDs
+[ "$(grep -c '^definition,"oval:moc.elpmaxe.www:def:[1-4]",2,' $csv)" == "4" ]
+# the records are sorted by the wall time within each type
+grep '^rule,' $csv | cut -d, -f4 | sort -g -r -c
+
+# Unwritable output
+$OSCAP xccdf eval --profile-output /nonexistent/dir/profile.json $srcdir/${name}.xccdf.xml > /dev/null 2> $stderr && false
+grep -q "profiler output" $stderr
+
+rm $json $csv $stderr
@@ -6,8 +6,11 @@ test_init "test_api_probes.log"
 
 if [ -z ${CUSTOM_OSCAP+x} ] ; then
     test_run "fts test" $srcdir/fts.sh
+    test_run "fts pattern pruning benchmark" $srcdir/fts_bench.sh 10
+    test_run "fscache walker and prefetch test" $srcdir/fscache_fts.sh
     test_run "probe api smoke test" ./test_api_probes_smoke
     test_run "fsdev is_local_fs unit test" ./test_fsdev_is_local_fs $srcdir/fake_mtab
+    test_run "process table test" ./test_proctable
 fi
 
 test_exit
@@ -0,0 +1,31 @@
+#!/bin/bash
+#
+# Compares the walker of the filesystem cache with fts(3) on a tree with
+# symlinks to directories, symlink loops, dangling links, a symlink to
+# an ancestor and a skipped directory, without and with the prefetch.
+
+set -e -o pipefail
+
+name=$(basename $0 .sh)
+tmpdir=$(mktemp -t -d "${name}.XXXXXX")
+ROOT=${tmpdir}/ftsroot
+echo "Temp dir: ${tmpdir}."
+
+mkdir -p $ROOT/{d1/{d11/d111,d12,skip/d},d2/d21,empty}
+touch $ROOT/{d1/{d11/{d111/f1111,f111},d12/f121,skip/f,f11},d2/{d21/f211,f21}}
+ln -s ../d2 $ROOT/d1/l2
+ln -s ../.. $ROOT/d1/d12/up
+ln -s loop2 $ROOT/d2/loop1
+ln -s loop1 $ROOT/d2/loop2
+ln -s missing $ROOT/d2/dangling
+ln -s d1/f11 $ROOT/lf
+for i in $(seq 1 32); do
+	mkdir -p $ROOT/wide/$i/{a,b/c}
+	touch $ROOT/wide/$i/{a,b/c}/{x,y,z}
+done
+
+./test_fscache_fts $ROOT
+./test_fscache_fts $ROOT/d1/l2
+./test_fscache_prefetch $ROOT
+
+rm -rf $tmpdir
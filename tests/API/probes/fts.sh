@@ -41,6 +41,8 @@ set -e -o pipefail
 name=$(basename $0 .sh)
 tmpdir=$(mktemp -t -d "${name}.XXXXXX")
 ROOT=${tmpdir}/ftsroot
+# the root escaped for the patterns, so that its components are literals
+ROOT_RE=$(echo "$ROOT" | sed 's/[].[\*^$()+?{|]/\\&/g')
 echo "Temp dir: ${tmpdir}."
 gen_tree $ROOT
 
@@ -235,6 +237,28 @@ test20 \
 "-1" "directories" "down" "local" \
 d1/d11/d111/f1111,
 
+# directories skipped by the components of the pattern
+test21 \
+'' '' \
+'' '' \
+"pattern match" "^$ROOT_RE/d[12]/[^/]+/f[0-9]+$" \
+"-1" "symlinks and directories" "none" "all" \
+d1/d11/f111,d1/d11/f112,d1/d11/f113,d1/d12/f121,d2/d21/f211,
+
+test22 \
+"pattern match" "^$ROOT_RE/d1/d1[0-9]$" \
+"equals" "f111" \
+'' '' \
+"-1" "symlinks and directories" "none" "all" \
+d1/d11/f111,
+
+test23 \
+"pattern match" "^$ROOT_RE/d1/[^/]+$" \
+"equals" "" \
+'' '' \
+"-1" "symlinks and directories" "down" "all" \
+d1/d11/,d1/d11/d111/,d1/d12/,
+
 EOF
 
 rm -rf $tmpdir
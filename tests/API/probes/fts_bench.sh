@@ -0,0 +1,78 @@
+#!/bin/bash
+#
+# Benchmark of the traversal of pattern match filepaths on a synthetic
+# tree of <fanout>^3 files, a million by default. Every pattern is listed
+# with the directories skipped by the components of the pattern and with
+# OSCAP_FTS_NO_PATTERN_PRUNING set, both without the filesystem cache.
+# Both traversals have to find the same number of files. all.sh runs it
+# on a small tree to check that.
+#
+# Usage: fts_bench.sh [<fanout>]
+#
+# Run it in the build directory of tests/API/probes, where oval_fts_list
+# is built. The tree is generated once into ${FTS_BENCH_ROOT} if that is
+# set and kept for the next runs.
+
+FANOUT=${1:-100}
+
+if [ ! -x ./oval_fts_list ]; then
+	echo "oval_fts_list not found, run the benchmark in its build directory" >&2
+	exit 2
+fi
+
+if [ -n "$FTS_BENCH_ROOT" ]; then
+	ROOT=$FTS_BENCH_ROOT
+else
+	tmpdir=$(mktemp -t -d "fts_bench.XXXXXX")
+	ROOT=${tmpdir}/ftsroot
+fi
+ROOT_RE=$(echo "$ROOT" | sed 's/[].[\*^$()+?{|]/\\&/g')
+
+if [ ! -f "$ROOT/.complete" ]; then
+	echo "Generating a tree of $FANOUT^3 files in $ROOT" >&2
+	names=$(seq -f "f%g" 1 $FANOUT)
+	for d in $(seq 1 $FANOUT); do
+		for s in $(seq 1 $FANOUT); do
+			mkdir -p "$ROOT/d$d/s$s" || exit 2
+			(cd "$ROOT/d$d/s$s" && for f in $names; do
+				[ $((${f#f} % 2)) -eq 0 ] && echo -n "$f.conf " || echo -n "$f.txt "
+			done | xargs touch) || exit 2
+		done
+	done
+	touch "$ROOT/.complete"
+fi
+
+function bench {
+	local start end
+
+	start=$(date +%s.%N)
+	count=$(./oval_fts_list '' '' '' '' "pattern match" "$1" \
+		"-1" "symlinks and directories" "none" "all" 2>/dev/null | wc -l)
+	end=$(date +%s.%N)
+	awk "BEGIN { printf \"%8.3fs %8d files\\n\", $end - $start, $count }"
+}
+
+export OSCAP_FS_CACHE_SIZE=0
+ret=0
+
+while read -r pattern; do
+	echo "=== $pattern ==="
+	echo -n "  pruned:   "
+	bench "^$ROOT_RE/$pattern"
+	pruned=$count
+	echo -n "  unpruned: "
+	OSCAP_FTS_NO_PATTERN_PRUNING=1 bench "^$ROOT_RE/$pattern"
+	if [ "$pruned" -ne "$count" ]; then
+		echo "  pruning changed the result: $pruned != $count files" >&2
+		ret=1
+	fi
+done <<'EOF'
+d1/s[0-9]+/f2\.conf$
+d[0-9]+/s1/f[0-9]+\.conf$
+d[0-9]+/s[0-9]+/f2\.conf$
+d1[0-9]/[^/]+/[^/]+\.conf$
+.*/s1/f2\.conf$
+EOF
+
+[ -n "$tmpdir" ] && rm -rf "$tmpdir"
+exit $ret
@@ -0,0 +1,173 @@
+/*
+ * Copyright 2026 Red Hat Inc., Durham, North Carolina.
+ * All Rights Reserved.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+/*
+ * Compares the traversal of a tree by the walker of the filesystem cache
+ * with fts(3) using the options of oval_fts. Symlinks are followed and
+ * directories named "skip" are skipped, so that the fts_set instructions
+ * are compared as well. The walker traverses the tree with an empty
+ * cache, with the cache filled by the first traversal and with a cache
+ * too small to hold the tree.
+ *
+ * Usage: test_fscache_fts <root>
+ */
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <fts.h>
+#include "fscache.h"
+
+#define TEST_FTS_OPTIONS (FTS_PHYSICAL | FTS_COMFOLLOW | FTS_NOCHDIR | FTS_XDEV)
+
+struct listing {
+	char *buf;
+	size_t len;
+	FILE *fp;
+};
+
+static void listing_open(struct listing *l)
+{
+	l->buf = NULL;
+	l->len = 0;
+	l->fp = open_memstream(&l->buf, &l->len);
+}
+
+static void listing_close(struct listing *l)
+{
+	fclose(l->fp);
+}
+
+static int instr_of(const char *name, int info)
+{
+	if (info == FTS_SL)
+		return FTS_FOLLOW;
+	if (info == FTS_D && strcmp(name, "skip") == 0)
+		return FTS_SKIP;
+	return FTS_NOINSTR;
+}
+
+static int list_fts(const char *root, struct listing *l)
+{
+	char *paths[] = { (char *)root, NULL };
+	FTSENT *ent;
+	FTS *fts;
+
+	fts = fts_open(paths, TEST_FTS_OPTIONS, NULL);
+	if (fts == NULL) {
+		perror("fts_open");
+		return 1;
+	}
+	listing_open(l);
+	while ((ent = fts_read(fts)) != NULL) {
+		fprintf(l->fp, "%d %d %s %s %d\n", ent->fts_info, ent->fts_level,
+			ent->fts_path, ent->fts_name, ent->fts_errno);
+		fts_set(fts, ent, instr_of(ent->fts_name, ent->fts_info));
+	}
+	listing_close(l);
+	fts_close(fts);
+
+	return 0;
+}
+
+static int list_fscache(const char *root, struct listing *l)
+{
+	fscache_ftsent_t *ent;
+	fscache_fts_t *fts;
+
+	fts = fscache_fts_open(root, TEST_FTS_OPTIONS);
+	if (fts == NULL) {
+		perror("fscache_fts_open");
+		return 1;
+	}
+	listing_open(l);
+	while ((ent = fscache_fts_read(fts)) != NULL) {
+		fprintf(l->fp, "%d %d %s %s %d\n", ent->fts_info, ent->fts_level,
+			ent->fts_path, ent->fts_name, ent->fts_errno);
+		fscache_fts_set(fts, ent, instr_of(ent->fts_name, ent->fts_info));
+	}
+	listing_close(l);
+	fscache_fts_close(fts);
+
+	return 0;
+}
+
+static int compare(const char *what, struct listing *expected, struct listing *l)
+{
+	if (expected->len == l->len && memcmp(expected->buf, l->buf, l->len) == 0) {
+		free(l->buf);
+		return 0;
+	}
+
+	fprintf(stderr, "The walker %s differs from fts(3).\n"
+		"fts(3):\n%s\nwalker:\n%s\n", what, expected->buf, l->buf);
+	free(l->buf);
+	return 1;
+}
+
+int main(int argc, char *argv[])
+{
+	struct listing expected, l;
+	fscache_stats_t stats;
+	int ret = 0;
+
+	if (argc != 2) {
+		fprintf(stderr, "Usage: %s <root>\n", argv[0]);
+		return 2;
+	}
+
+	if (list_fts(argv[1], &expected) != 0)
+		return 2;
+
+	fscache_hold();
+
+	if (list_fscache(argv[1], &l) != 0)
+		return 1;
+	ret |= compare("with an empty cache", &expected, &l);
+
+	if (list_fscache(argv[1], &l) != 0)
+		return 1;
+	ret |= compare("with a filled cache", &expected, &l);
+
+	fscache_stats(&stats);
+	if (stats.dir_hits == 0 || stats.stat_hits == 0) {
+		fprintf(stderr, "The second traversal didn't hit the cache.\n");
+		ret = 1;
+	}
+
+	fscache_reset();
+	setenv("OSCAP_FS_CACHE_SIZE", "16", 1);
+	if (list_fscache(argv[1], &l) != 0)
+		return 1;
+	ret |= compare("with a small cache", &expected, &l);
+	if (list_fscache(argv[1], &l) != 0)
+		return 1;
+	ret |= compare("with a full cache", &expected, &l);
+
+	fscache_drop();
+	free(expected.buf);
+
+	return ret;
+}
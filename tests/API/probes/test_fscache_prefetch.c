@@ -0,0 +1,262 @@
+/*
+ * Copyright 2026 Red Hat Inc., Durham, North Carolina.
+ * All Rights Reserved.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+/*
+ * Traversals of a tree by several threads at once, each reading ahead
+ * by a prefetch on the shared pool, must list the same entries as fts(3).
+ * The prefetches are also stopped while they are reading, limited by the
+ * depth and by a small cache, a slow traversal must take directories
+ * read ahead beyond its share of the cache, and the pool is restarted
+ * after the last user drops the cache. Run it under ThreadSanitizer or
+ * AddressSanitizer to check the pool.
+ *
+ * Usage: test_fscache_prefetch <root>
+ */
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <fts.h>
+#include "fscache.h"
+
+#define TEST_FTS_OPTIONS (FTS_PHYSICAL | FTS_COMFOLLOW | FTS_NOCHDIR | FTS_XDEV)
+#define TEST_THREADS     8
+#define TEST_STOPS       64
+#define TEST_PAUSE_HITS  16 /* of the more than 100 directories of the tree */
+
+static const char *root;
+static char *expected;
+static size_t expected_len;
+
+static int instr_of(const char *name, int info)
+{
+	if (info == FTS_D && strcmp(name, "skip") == 0)
+		return FTS_SKIP;
+	return FTS_NOINSTR;
+}
+
+static bool descend(void *arg, const char *path, const struct stat *st)
+{
+	const char *name = strrchr(path, '/');
+
+	return name == NULL || strcmp(name + 1, "skip") != 0;
+}
+
+static int list_fts(void)
+{
+	char *paths[] = { (char *)root, NULL };
+	FTSENT *ent;
+	FTS *fts;
+	FILE *fp;
+
+	fts = fts_open(paths, TEST_FTS_OPTIONS, NULL);
+	if (fts == NULL) {
+		perror("fts_open");
+		return 1;
+	}
+	fp = open_memstream(&expected, &expected_len);
+	while ((ent = fts_read(fts)) != NULL) {
+		fprintf(fp, "%d %d %s\n", ent->fts_info, ent->fts_level, ent->fts_path);
+		fts_set(fts, ent, instr_of(ent->fts_name, ent->fts_info));
+	}
+	fclose(fp);
+	fts_close(fts);
+
+	return 0;
+}
+
+/*
+ * Traverse the tree with a prefetch reading up to the depth, -1 for all,
+ * sleeping for the microseconds in each directory
+ */
+static int list_prefetched(int max_depth, fscache_prefetch_descend_t filter, useconds_t delay)
+{
+	fscache_prefetch_t *pf;
+	fscache_ftsent_t *ent;
+	fscache_fts_t *fts;
+	char *buf = NULL;
+	size_t len = 0;
+	FILE *fp;
+	int ret = 0;
+
+	fts = fscache_fts_open(root, TEST_FTS_OPTIONS);
+	if (fts == NULL) {
+		perror("fscache_fts_open");
+		return 1;
+	}
+	pf = fscache_prefetch_start(fts, max_depth, filter, NULL);
+
+	fp = open_memstream(&buf, &len);
+	while ((ent = fscache_fts_read(fts)) != NULL) {
+		fprintf(fp, "%d %d %s\n", ent->fts_info, ent->fts_level, ent->fts_path);
+		fscache_fts_set(fts, ent, instr_of(ent->fts_name, ent->fts_info));
+		if (delay > 0 && ent->fts_info == FTS_D)
+			usleep(delay);
+	}
+	fclose(fp);
+
+	fscache_prefetch_stop(pf);
+	fscache_fts_close(fts);
+
+	if (len != expected_len || memcmp(buf, expected, len) != 0) {
+		fprintf(stderr, "The prefetched traversal differs from fts(3):\n%s\n", buf);
+		ret = 1;
+	}
+	free(buf);
+
+	return ret;
+}
+
+static void *traverse_thread(void *arg)
+{
+	int *ret = arg;
+
+	*ret = list_prefetched(-1, descend, 0);
+	return NULL;
+}
+
+static int test_concurrent(void)
+{
+	pthread_t threads[TEST_THREADS];
+	int rets[TEST_THREADS], ret = 0, i, started;
+
+	for (started = 0; started < TEST_THREADS; ++started) {
+		if (pthread_create(&threads[started], NULL, traverse_thread, &rets[started]) != 0) {
+			fprintf(stderr, "Can't start the test threads.\n");
+			ret = 1;
+			break;
+		}
+	}
+	for (i = 0; i < started; ++i) {
+		pthread_join(threads[i], NULL);
+		ret |= rets[i];
+	}
+
+	return ret;
+}
+
+/*
+ * Stop the prefetches right away, while the pool reads them, half of them
+ * by closing their traversals
+ */
+static int test_stop(void)
+{
+	fscache_fts_t *fts[TEST_STOPS];
+	fscache_prefetch_t *pf[TEST_STOPS];
+	int i, ret = 0;
+
+	for (i = 0; i < TEST_STOPS; ++i) {
+		fscache_reset();
+		fts[i] = fscache_fts_open(root, TEST_FTS_OPTIONS);
+		pf[i] = fscache_prefetch_start(fts[i], -1, descend, NULL);
+		if (pf[i] == NULL) {
+			fprintf(stderr, "The prefetch didn't start.\n");
+			fscache_fts_close(fts[i]);
+			ret = 1;
+			break;
+		}
+	}
+	while (i-- > 0) {
+		if (i % 2 == 0)
+			fscache_prefetch_stop(pf[i]);
+		fscache_fts_close(fts[i]);
+	}
+
+	return ret;
+}
+
+/*
+ * A traversal slower than the pool must keep taking the directories read
+ * ahead after they took its share of a small cache. The prefetch isn't
+ * told about the skipped directories, the traversal drops them.
+ */
+static int test_pause(void)
+{
+	fscache_stats_t stats;
+	int ret;
+
+	fscache_reset();
+	setenv("OSCAP_FS_CACHE_SIZE", "16", 1);
+	ret = list_prefetched(-1, NULL, 2000);
+	fscache_stats(&stats);
+	unsetenv("OSCAP_FS_CACHE_SIZE");
+
+	if (stats.prefetch_hits < TEST_PAUSE_HITS) {
+		fprintf(stderr, "Only %u directories were read ahead.\n", stats.prefetch_hits);
+		ret = 1;
+	}
+
+	return ret;
+}
+
+int main(int argc, char *argv[])
+{
+	fscache_stats_t stats;
+	int ret = 0;
+
+	if (argc != 2) {
+		fprintf(stderr, "Usage: %s <root>\n", argv[0]);
+		return 2;
+	}
+	root = argv[1];
+
+	/* the pool is used even on a single CPU */
+	setenv("OSCAP_FS_PREFETCH_THREADS", "4", 1);
+
+	if (list_fts() != 0)
+		return 2;
+
+	fscache_hold();
+
+	ret |= test_concurrent();
+	fscache_stats(&stats);
+	if (stats.dir_hits == 0) {
+		fprintf(stderr, "No directory lookup hit the cache.\n");
+		ret = 1;
+	}
+
+	fscache_reset();
+	ret |= list_prefetched(1, descend, 0);
+	ret |= test_stop();
+
+	fscache_reset();
+	setenv("OSCAP_FS_CACHE_SIZE", "16", 1);
+	ret |= list_prefetched(-1, descend, 0);
+	unsetenv("OSCAP_FS_CACHE_SIZE");
+
+	ret |= test_pause();
+
+	/* the pool is stopped with the last user and started again */
+	fscache_drop();
+	fscache_hold();
+	ret |= test_concurrent();
+	fscache_drop();
+
+	free(expected);
+
+	return ret;
+}
@@ -0,0 +1,237 @@
+/*
+ * Copyright 2026 Red Hat Inc., Durham, North Carolina.
+ * All Rights Reserved.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+/*
+ * The snapshot of /proc shared by the process probes. Checks that this
+ * process is in the table with its stat and status fields, that a child
+ * which exits keeps its entry until the snapshot is reset, that a table
+ * in use survives the reset and that threads loading the same files at
+ * once all see the copy which was published first.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <sys/wait.h>
+#include "proctable.h"
+
+static probe_proc_t *find_proc(probe_proctable_t *table, int pid)
+{
+	size_t i, count = probe_proctable_count(table);
+
+	for (i = 0; i < count; ++i) {
+		probe_proc_t *proc = probe_proctable_at(table, i);
+		if (proc->pid == pid)
+			return proc;
+	}
+	return NULL;
+}
+
+static int test_self(void)
+{
+	probe_proctable_t *table;
+	probe_proc_t *proc;
+	int ret = 0;
+
+	table = probe_proctable_get();
+	if (table == NULL) {
+		fprintf(stderr, "Can't read the process table\n");
+		return 1;
+	}
+
+	proc = find_proc(table, getpid());
+	if (proc == NULL) {
+		fprintf(stderr, "Process %d isn't in the table\n", getpid());
+		ret = 1;
+		goto cleanup;
+	}
+	if (!(proc->loaded & PROBE_PROC_STAT) || proc->ppid != getppid()
+	    || strcmp(proc->comm, "test_proctable") != 0) {
+		fprintf(stderr, "Wrong stat of process %d: ppid=%d, comm=%s\n",
+			proc->pid, proc->ppid, proc->comm);
+		ret = 1;
+	}
+
+	probe_proctable_load(table, proc, PROBE_PROC_STATUS | PROBE_PROC_ENVIRON);
+	if (proc->ruid != (int)getuid() || proc->euid != (int)geteuid()) {
+		fprintf(stderr, "Wrong uids: %d %d\n", proc->ruid, proc->euid);
+		ret = 1;
+	}
+	if (!proc->cap_eff_known) {
+		fprintf(stderr, "The capabilities of process %d are unknown\n", proc->pid);
+		ret = 1;
+	}
+	if (proc->environ == NULL) {
+		fprintf(stderr, "Can't read the environment: %s\n", strerror(proc->environ_errno));
+		ret = 1;
+	}
+	if (probe_proctable_boot_time(table) == 0) {
+		fprintf(stderr, "The boot time is unknown\n");
+		ret = 1;
+	}
+
+cleanup:
+	probe_proctable_release(table);
+	return ret;
+}
+
+static int test_snapshot(void)
+{
+	probe_proctable_t *table, *fresh;
+	probe_proc_t *proc;
+	int ret = 0;
+	pid_t child;
+
+	child = fork();
+	if (child < 0) {
+		perror("fork");
+		return 1;
+	}
+	if (child == 0)
+		_exit(0);
+
+	table = probe_proctable_get();
+	if (table == NULL) {
+		fprintf(stderr, "Can't read the process table\n");
+		waitpid(child, NULL, 0);
+		return 1;
+	}
+	/* The child was reaped, the snapshot still has it. */
+	waitpid(child, NULL, 0);
+
+	proc = find_proc(table, child);
+	if (proc == NULL) {
+		fprintf(stderr, "Child %d isn't in the table\n", child);
+		ret = 1;
+	} else {
+		/* Its files can't be read any more, the entry stays. */
+		probe_proctable_load(table, proc, PROBE_PROC_STATUS | PROBE_PROC_ENVIRON);
+		if (proc->cap_eff_known || proc->environ != NULL || proc->environ_errno == 0) {
+			fprintf(stderr, "Files of reaped child %d were read\n", child);
+			ret = 1;
+		}
+	}
+
+	probe_proctable_reset();
+
+	fresh = probe_proctable_get();
+	if (fresh == NULL || fresh == table) {
+		fprintf(stderr, "The table wasn't read again after the reset\n");
+		ret = 1;
+	} else if (find_proc(fresh, child) != NULL) {
+		fprintf(stderr, "Reaped child %d is in the new table\n", child);
+		ret = 1;
+	}
+	/* The old table is still usable. */
+	if (find_proc(table, child) != proc) {
+		fprintf(stderr, "The old table changed after the reset\n");
+		ret = 1;
+	}
+
+	probe_proctable_release(fresh);
+	probe_proctable_release(table);
+	return ret;
+}
+
+#define LOAD_THREADS 8
+#define LOAD_FILES (PROBE_PROC_STATUS | PROBE_PROC_CMDLINE | PROBE_PROC_ENVIRON | PROBE_PROC_MAPS)
+
+struct load_arg {
+	probe_proctable_t *table;
+	probe_proc_t *proc;
+	char *cmdline;
+	char *environ;
+};
+
+static void *load_thread(void *ptr)
+{
+	struct load_arg *arg = ptr;
+
+	probe_proctable_load(arg->table, arg->proc, LOAD_FILES);
+	arg->cmdline = arg->proc->cmdline;
+	arg->environ = arg->proc->environ;
+	return NULL;
+}
+
+static int test_concurrent_load(void)
+{
+	struct load_arg args[LOAD_THREADS];
+	pthread_t threads[LOAD_THREADS];
+	probe_proctable_t *table;
+	probe_proc_t *proc;
+	int i, started, ret = 0;
+
+	probe_proctable_reset();
+	table = probe_proctable_get();
+	if (table == NULL) {
+		fprintf(stderr, "Can't read the process table\n");
+		return 1;
+	}
+	proc = find_proc(table, getpid());
+	if (proc == NULL) {
+		fprintf(stderr, "Process %d isn't in the table\n", getpid());
+		probe_proctable_release(table);
+		return 1;
+	}
+
+	for (started = 0; started < LOAD_THREADS; ++started) {
+		args[started].table = table;
+		args[started].proc = proc;
+		if (pthread_create(&threads[started], NULL, load_thread, &args[started]) != 0) {
+			fprintf(stderr, "Can't start a thread\n");
+			ret = 1;
+			break;
+		}
+	}
+	for (i = 0; i < started; ++i)
+		pthread_join(threads[i], NULL);
+
+	if ((proc->loaded & LOAD_FILES) != LOAD_FILES || proc->environ == NULL) {
+		fprintf(stderr, "The files of process %d weren't loaded\n", proc->pid);
+		ret = 1;
+	}
+	for (i = 0; i < started; ++i) {
+		if (args[i].cmdline != proc->cmdline || args[i].environ != proc->environ) {
+			fprintf(stderr, "Thread %d saw another copy of the files\n", i);
+			ret = 1;
+		}
+	}
+
+	probe_proctable_release(table);
+	return ret;
+}
+
+int main(void)
+{
+	int ret = 0;
+
+	probe_proctable_hold();
+	ret |= test_self();
+	ret |= test_snapshot();
+	ret |= test_concurrent_load();
+	probe_proctable_drop();
+
+	return ret;
+}
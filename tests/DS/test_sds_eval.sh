@@ -100,6 +100,40 @@ function test_eval_complex()
 	rm $arf
 }
 
+function test_eval_streaming()
+{
+	local name=${FUNCNAME}
+	local stderr=$(mktemp -t ${name}.err.XXXXXX)
+	local dom=$(mktemp -t ${name}.out.XXXXXX)
+	local streamed=$(mktemp -t ${name}.out.XXXXXX)
+	local content=$srcdir/eval_xccdf_id/sds-complex.xml
+	local args="--datastream-id scap_org.open-scap_datastream_tst2 --xccdf-id scap_org.open-scap_cref_second-xccdf.xml2 --profile xccdf_moc.elpmaxe.www_profile_2"
+
+	$OSCAP xccdf eval $args $content 2> $stderr > $dom
+	[ -f $stderr ]; [ ! -s $stderr ]
+	OSCAP_SDS_STREAMING=1 $OSCAP xccdf eval $args $content 2> $stderr > $streamed
+	[ -f $stderr ]; [ ! -s $stderr ]
+
+	# The same rules are evaluated with the same results
+	grep ^Rule $dom | grep xccdf_moc.elpmaxe.www_rule_secon
+	diff <(grep -A 2 ^Rule $dom) <(grep -A 2 ^Rule $streamed)
+
+	# Tailoring component of the selected datastream
+	OSCAP_SDS_STREAMING=1 $OSCAP xccdf eval --datastream-id scap_com.example_datastream_with_tailoring \
+		--tailoring-id xccdf_com.example_cref_tailoring_01 --profile xccdf_com.example_profile_tailoring \
+		--results $streamed $srcdir/sds_tailoring/sds.ds.xml 2> $stderr
+	[ -f $stderr ]; [ ! -s $stderr ]
+	local result=$streamed
+	assert_exists 1 '//rule-result[@idref="xccdf_com.example_rule_1"]/result[text()="notselected"]'
+	assert_exists 1 '//rule-result[@idref="xccdf_com.example_rule_2"]/result[text()="pass"]'
+
+	# Invalid content is still refused
+	OSCAP_SDS_STREAMING=1 $OSCAP xccdf eval $srcdir/eval_invalid/sds.xml 2> $stderr && false
+	[ -s $stderr ]
+
+	rm $stderr $dom $streamed
+}
+
 function test_oval_eval {
 
     $OSCAP oval eval "${srcdir}/$1"
@@ -177,5 +211,6 @@ test_run "eval_oval_id2" test_oval_eval_id eval_oval_id/sds.xml scap_org.open-sc
 test_run "eval_cpe" test_eval_cpe eval_cpe/sds.xml
 
 test_run "test_eval_complex" test_eval_complex
+test_run "test_eval_streaming" test_eval_streaming
 
 test_exit
@@ -120,6 +120,54 @@ function test_probes_file_invalid_utf8 {
 	return $ret_val
 }
 
+function test_probes_file_concurrency {
+
+	probecheck "file" || return 255
+	probecheck "filehash58" || return 255
+
+	local ret_val=0
+	local DF="$srcdir/test_probes_file_concurrency.xml"
+	local workers
+	files_dir=$(mktemp -d)
+	DF_INJECTED=$(mktemp)
+
+	echo "Files dir:	${files_dir}"
+	echo "Content file:	${DF_INJECTED}"
+
+	for d in 1 2 3 4; do
+		mkdir "${files_dir}/d$d"
+		for i in $(seq 1 500); do
+			head -c 16384 /dev/urandom > "${files_dir}/d$d/file_$i"
+		done
+	done
+
+	sed "s;<!--injected-path -->;${files_dir};" "$DF" > $DF_INJECTED
+
+	# The objects don't depend on each other, so the collection time
+	# should go down with the number of probe workers while the
+	# collected items stay the same.
+	for workers in 1 8; do
+		result="results_$workers.xml"
+		start=$(date +%s%N)
+		OSCAP_PROBE_WORKERS=$workers $OSCAP oval eval --results $result $DF_INJECTED || ret_val=1
+		end=$(date +%s%N)
+		echo "$workers worker(s): $(( (end - start) / 1000000 )) ms"
+
+		assert_exists 1 '//results//definition[@definition_id="oval:1:def:1" and @result="true"]' || ret_val=1
+		assert_exists 2000 '//unix-sys:file_item' || ret_val=1
+		assert_exists 2000 '//ind-sys:filehash58_item' || ret_val=1
+	done
+
+	diff <($XPATH results_1.xml '//ind-sys:filehash58_item/ind-sys:hash' | sort) \
+	     <($XPATH results_8.xml '//ind-sys:filehash58_item/ind-sys:hash' | sort) > /dev/null || ret_val=1
+
+	rm -f results_1.xml results_8.xml
+	rm $DF_INJECTED
+	rm -rf "$files_dir"
+
+	return $ret_val
+}
+
 # Testing.
 
 test_init
@@ -128,5 +176,6 @@ test_run "test_probes_file with verbose mode" test_probes_file verbose
 test_run "test_probes_file" test_probes_file
 test_run "test_probes_file_filenames" test_probes_file_filenames
 test_run "test_probes_file_invalid_utf8" test_probes_file_invalid_utf8
+test_run "test_probes_file_concurrency" test_probes_file_concurrency
 
 test_exit
@@ -92,12 +92,57 @@ function test_probes_filehash58_chroot_fail {
 	return $ret_val
 }
 
+function test_probes_filehash58_multi {
+
+    probecheck "filehash58" || return 255
+
+    local ret_val=0
+    local DF="$srcdir/check_filehash_multi.xml"
+    local alg sum f expected
+    result="results.xml"
+    files_dir=$(mktemp -d)
+    DF_INJECTED=$(mktemp)
+
+    # a small file which is read and a large one which is mapped
+    echo foo > "$files_dir/file_small"
+    head -c 1048577 /dev/urandom > "$files_dir/file_large"
+
+    sed "s;<!--injected-path -->;${files_dir};" "$DF" > $DF_INJECTED
+
+    $OSCAP oval eval --results $result $DF_INJECTED || ret_val=1
+
+    assert_exists 1 '//results//definition[@definition_id="oval:1:def:1" and @result="true"]' || ret_val=1
+    # the items of the second object are equal to some of the first one's
+    assert_exists 12 '//ind-sys:filehash58_item' || ret_val=1
+
+    for alg in MD5:md5sum SHA-1:sha1sum SHA-224:sha224sum SHA-256:sha256sum SHA-384:sha384sum SHA-512:sha512sum; do
+        sum=${alg#*:}
+        alg=${alg%:*}
+        command -v $sum > /dev/null || continue
+        for f in file_small file_large; do
+            expected=$($sum "$files_dir/$f" | cut -d' ' -f1)
+            assert_exists 1 '//ind-sys:filehash58_item[ind-sys:filename="'$f'" and ind-sys:hash_type="'$alg'" and ind-sys:hash="'$expected'"]' || ret_val=1
+        done
+    done
+
+    # both objects reference the same SHA-256 items
+    assert_exists 2 '//collected_objects/object[@id="oval:1:obj:2"]/reference' || ret_val=1
+
+    rm $result
+    rm $DF_INJECTED
+    rm -rf "$files_dir"
+
+    return $ret_val
+}
+
 # Testing.
 
 test_init
 
 test_run "test_probes_filehash58" test_probes_filehash58
 
+test_run "test_probes_filehash58_multi" test_probes_filehash58_multi
+
 test_run "test_probes_filehash58_chroot_fail" test_probes_filehash58_chroot_fail
 
 test_run "test_probes_filehash58_chroot_pass" test_probes_filehash58_chroot_pass
@@ -50,4 +50,69 @@ function test_probes_rpminfo {
     rm -f $RF $DF
 
     return $ret_val
-}
\ No newline at end of file
+}
+function test_probes_rpminfo_index {
+    probecheck "rpminfo" || return 255
+    require "rpm" || return 255
+
+    local ret_val=0
+    local DF="test_probes_rpminfo_index.xml"
+    local name i count
+    result="results.xml"
+
+    # One object per installed package plus an object matching all of
+    # them. All of them are answered from a single package index.
+    names=$(rpm --qf "%{NAME}\n" -qa | sort -u | head -n 200)
+    count=$(echo "$names" | wc -l)
+
+    {
+        cat <<EOT
+<?xml version="1.0"?>
+<oval_definitions xmlns:oval="http://oval.mitre.org/XMLSchema/oval-common-5" xmlns:lin-def="http://oval.mitre.org/XMLSchema/oval-definitions-5#linux" xmlns="http://oval.mitre.org/XMLSchema/oval-definitions-5">
+  <generator>
+    <oval:schema_version>5.10</oval:schema_version>
+    <oval:timestamp>2026-01-01T00:00:00-00:00</oval:timestamp>
+  </generator>
+  <definitions>
+    <definition class="compliance" version="1" id="oval:1:def:1">
+      <metadata>
+        <title>rpminfo package index</title>
+        <description>All the installed packages are found.</description>
+      </metadata>
+      <criteria operator="AND">
+EOT
+        for i in $(seq 1 $((count + 1))); do
+            echo "        <criterion test_ref=\"oval:1:tst:$i\"/>"
+        done
+        echo "      </criteria>"
+        echo "    </definition>"
+        echo "  </definitions>"
+        echo "  <tests>"
+        for i in $(seq 1 $((count + 1))); do
+            echo "    <lin-def:rpminfo_test check=\"all\" check_existence=\"at_least_one_exists\" comment=\"x\" id=\"oval:1:tst:$i\" version=\"1\"><lin-def:object object_ref=\"oval:1:obj:$i\"/></lin-def:rpminfo_test>"
+        done
+        echo "  </tests>"
+        echo "  <objects>"
+        echo "    <lin-def:rpminfo_object id=\"oval:1:obj:1\" version=\"1\"><lin-def:name operation=\"pattern match\">.*</lin-def:name></lin-def:rpminfo_object>"
+        i=1
+        for name in $names; do
+            i=$((i + 1))
+            echo "    <lin-def:rpminfo_object id=\"oval:1:obj:$i\" version=\"1\"><lin-def:name>$name</lin-def:name></lin-def:rpminfo_object>"
+        done
+        echo "  </objects>"
+        echo "</oval_definitions>"
+    } > $DF
+
+    $OSCAP oval eval --results $result $DF || ret_val=1
+
+    assert_exists 1 '//results//definition[@definition_id="oval:1:def:1" and @result="true"]' || ret_val=1
+    # the objects looking up a single name share the items of the first one
+    assert_exists $(rpm -qa | wc -l) '//lin-sys:rpminfo_item' || ret_val=1
+    assert_exists $(rpm -qa | wc -l) '//collected_objects/object[@id="oval:1:obj:1"]/reference' || ret_val=1
+    name=$(echo "$names" | head -n 1)
+    assert_exists $(rpm -q "$name" | wc -l) '//collected_objects/object[@id="oval:1:obj:2"]/reference' || ret_val=1
+
+    rm -f $result $DF
+
+    return $ret_val
+}
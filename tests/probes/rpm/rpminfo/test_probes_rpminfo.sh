@@ -26,5 +26,6 @@ B_NAME=`rpm --qf "%{NAME}\n" -qa | sort | uniq -u | sed -n '2p'`
 test_init
 
 test_run "rpminfo probe test" test_probes_rpminfo $A_NAME $B_NAME
+test_run "rpminfo package index" test_probes_rpminfo_index
 
 test_exit
@@ -0,0 +1,44 @@
+#!/bin/bash
+
+set -e -o pipefail
+
+. $builddir/tests/test_common.sh
+
+probecheck "textfilecontent54" || exit 255
+
+name=$(basename $0 .sh)
+tmpdir=$(mktemp -t -d "${name}.XXXXXX")
+tpl=${srcdir}/${name}.xml.tpl
+input=${tmpdir}/${name}.xml
+result=${tmpdir}/${name}.results.xml
+echo "Temp dir: $tmpdir"
+
+# The file is larger than the part of a file which is matched at once
+# and the lines don't end on the window boundaries.
+echo "header" > "${tmpdir}/largefile"
+seq -f "line_%06g_end" 1 100000 >> "${tmpdir}/largefile"
+sed "s@%PATH%@${tmpdir}@" $tpl > $input
+
+echo "Evaluating content."
+$OSCAP oval eval --results $result $input
+echo "Validating results."
+$OSCAP oval validate --results $result
+
+assert_exists 1 '/oval_results/results/system/definitions/definition[@definition_id="oval:x:def:1" and @result="true"]'
+
+co='/oval_results/results/system/oval_system_characteristics/collected_objects'
+sd='/oval_results/results/system/oval_system_characteristics/system_data'
+assert_exists 4 $co'/object[@flag="complete"]'
+assert_exists 1 $sd'/ind-sys:textfilecontent_item[ind-sys:instance="65536" and ind-sys:subexpression="065536"]'
+assert_exists 1 $sd'/ind-sys:textfilecontent_item[ind-sys:instance="100000" and ind-sys:subexpression="100000"]'
+assert_exists 1 $sd'/ind-sys:textfilecontent_item[ind-sys:instance="65536" and ind-sys:subexpression="065537"]'
+assert_exists 1 $sd'/ind-sys:textfilecontent_item[ind-sys:instance="1" and ind-sys:text="header"]'
+
+echo "Evaluating content with a limit of the matched file size."
+OSCAP_PROBE_TFC54_MAX_FILE_SIZE=1000 $OSCAP oval eval --results $result $input || [ $? == 2 ]
+
+assert_exists 4 $co'/object[@flag="incomplete"]'
+assert_exists 4 $co'/object/message[@level="warning"]'
+assert_exists 1 $sd'/ind-sys:textfilecontent_item[ind-sys:text="header"]'
+
+rm -rf $tmpdir
@@ -103,6 +103,7 @@ static struct oscap_module OVAL_EVAL = {
     .help =
 	"Options:\n"
 	"   --id <definition-id>          - ID of the definition we want to evaluate.\n"
+	"   --jobs <n>                    - Evaluate definitions in n parallel worker threads.\n"
 	"   --variables <file>            - Provide external variables expected by OVAL Definitions.\n"
 	"   --directives <file>           - Use OVAL Directives content to specify desired results content.\n"
 	"   --without-syschar             - Don't provide system characteristic in result file.\n"
@@ -342,6 +343,7 @@ int app_evaluate_oval(const struct oscap_action *action)
 	oval_session_set_variables(session, action->f_variables);
 
 	oval_session_set_remote_resources(session, action->remote_resources, download_reporting_callback);
+	oval_session_set_jobs(session, action->jobs);
 	/* load all necesary OVAL Definitions and bind OVAL Variables if provided */
 	if ((oval_session_load(session)) != 0)
 		goto cleanup;
@@ -496,6 +498,7 @@ enum oval_opt {
     OVAL_OPT_DIRECTIVES,
     OVAL_OPT_DATASTREAM_ID,
     OVAL_OPT_OVAL_ID,
+    OVAL_OPT_JOBS,
 	OVAL_OPT_OUTPUT = 'o'
 };
 
@@ -514,6 +517,7 @@ bool getopt_oval_eval(int argc, char **argv, struct oscap_action *action)
 		{ "without-syschar",	no_argument, &action->without_sys_chars, 1},
 		{ "datastream-id",required_argument, NULL, OVAL_OPT_DATASTREAM_ID},
 		{ "oval-id",    required_argument, NULL, OVAL_OPT_OVAL_ID},
+		{ "jobs",	required_argument, NULL, OVAL_OPT_JOBS },
 		{ "skip-valid",	no_argument, &action->validate, 0 },
 		{ "fetch-remote-resources", no_argument, &action->remote_resources, 1},
 		{ 0, 0, 0, 0 }
@@ -529,6 +533,10 @@ bool getopt_oval_eval(int argc, char **argv, struct oscap_action *action)
 		case OVAL_OPT_DIRECTIVES: action->f_directives = optarg; break;
 		case OVAL_OPT_DATASTREAM_ID: action->f_datastream_id = optarg;	break;
 		case OVAL_OPT_OVAL_ID: action->f_oval_id = optarg;	break;
+		case OVAL_OPT_JOBS:
+			if (!getopt_jobs(action, optarg))
+				return false;
+			break;
 		case 0: break;
 		default: return oscap_module_usage(action->module, stderr, NULL);
 		}
@@ -428,6 +428,20 @@ bool check_verbose_options(struct oscap_action *action)
 	return true;
 }
 
+bool getopt_jobs(struct oscap_action *action, const char *arg)
+{
+	char *endptr = NULL;
+	long jobs = strtol(arg, &endptr, 10);
+
+	if (*arg == '\0' || *endptr != '\0' || jobs < 1 || jobs > 1024) {
+		oscap_module_usage(action->module, stderr,
+			"The --jobs option requires a number between 1 and 1024.");
+		return false;
+	}
+	action->jobs = (unsigned int) jobs;
+	return true;
+}
+
 void download_reporting_callback(bool warning, const char *format, ...)
 {
 	FILE *dest = stderr;
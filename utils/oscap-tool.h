@@ -132,6 +132,7 @@ struct oscap_action {
         char *f_report;
 	char *f_variables;
 	char *f_verbose_log;
+	char *f_profile_output;
 	/* others */
         char *profile;
 	const char *rule;
@@ -172,6 +173,7 @@ struct oscap_action {
         int list_dynamic;
 	char *verbosity_level;
 	char *fix_type;
+	unsigned int jobs;
 };
 
 int app_xslt(const char *infile, const char *xsltfile, const char *outfile, const char **params);
@@ -183,6 +185,7 @@ int oscap_module_call(struct oscap_action *action);
 
 void oscap_print_error(void);
 bool check_verbose_options(struct oscap_action *action);
+bool getopt_jobs(struct oscap_action *action, const char *arg);
 void download_reporting_callback(bool warning, const char *format, ...);
 
 void report_missing_profile(const char *profile_suffix, const char *source_file);
@@ -62,6 +62,7 @@
 #include "oscap.h"
 #include "oscap_source.h"
 #include <oscap_debug.h>
+#include <oscap_profiler.h>
 #include "oscap_helpers.h"
 
 #ifndef O_NOFOLLOW
@@ -150,6 +151,9 @@ static struct oscap_module XCCDF_EVAL = {
 		"Options:\n"
 		"   --profile <name>              - The name of Profile to be evaluated.\n"
 		"   --rule <name>                 - The name of a single rule to be evaluated.\n"
+		"   --jobs <n>                    - Evaluate rules in n parallel worker threads.\n"
+		"   --profile-output <file>       - Write the time spent on rules, definitions, tests, objects and probes\n"
+		"                                   into file (CSV if the file name ends with .csv, JSON otherwise).\n"
 		"   --tailoring-file <file>       - Use given XCCDF Tailoring file.\n"
 		"   --tailoring-id <component-id> - Use given DS component as XCCDF Tailoring file.\n"
 		"   --cpe <name>                  - Use given CPE dictionary or language (autodetected)\n"
@@ -562,6 +566,7 @@ int app_evaluate_xccdf(const struct oscap_action *action)
 	xccdf_session_set_custom_oval_files(session, action->f_ovals);
 	xccdf_session_set_product_cpe(session, OSCAP_PRODUCTNAME);
 	xccdf_session_set_rule(session, action->rule);
+	xccdf_session_set_jobs(session, action->jobs);
 
 	if (xccdf_session_load(session) != 0)
 		goto cleanup;
@@ -580,10 +585,23 @@ int app_evaluate_xccdf(const struct oscap_action *action)
 
 	_register_progress_callback(session, action->progress);
 
+	if (action->f_profile_output != NULL)
+		oscap_profiler_enable(true);
+
 	/* Perform evaluation */
 	if (xccdf_session_evaluate(session) != 0)
 		goto cleanup;
 
+	if (action->f_profile_output != NULL) {
+		oscap_profiler_enable(false);
+		/* The results are still exported, the profile is only a report */
+		if (oscap_profiler_write(action->f_profile_output) != 0) {
+			oscap_print_error();
+			fprintf(stderr, "Warning: The profile of the evaluation was not written to '%s'.\n",
+				action->f_profile_output);
+		}
+	}
+
 	xccdf_session_set_without_sys_chars_export(session, action->without_sys_chars);
 	xccdf_session_set_oval_results_export(session, action->oval_results);
 	xccdf_session_set_oval_variables_export(session, action->export_variables);
@@ -1104,7 +1122,9 @@ enum oval_opt {
     XCCDF_OPT_CPE_DICT,
     XCCDF_OPT_OUTPUT = 'o',
     XCCDF_OPT_RESULT_ID = 'i',
-	XCCDF_OPT_FIX_TYPE
+	XCCDF_OPT_FIX_TYPE,
+	XCCDF_OPT_JOBS,
+	XCCDF_OPT_PROFILE_OUTPUT
 };
 
 bool getopt_xccdf(int argc, char **argv, struct oscap_action *action)
@@ -1136,6 +1156,8 @@ bool getopt_xccdf(int argc, char **argv, struct oscap_action *action)
 		{"cpe-dict",	required_argument, NULL, XCCDF_OPT_CPE_DICT}, // DEPRECATED!
 		{"sce-template", 	required_argument, NULL, XCCDF_OPT_SCE_TEMPLATE},
 		{"fix-type", required_argument, NULL, XCCDF_OPT_FIX_TYPE},
+		{"jobs",		required_argument, NULL, XCCDF_OPT_JOBS},
+		{"profile-output",	required_argument, NULL, XCCDF_OPT_PROFILE_OUTPUT},
 	// flags
 		{"force",		no_argument, &action->force, 1},
 		{"oval-results",	no_argument, &action->oval_results, 1},
@@ -1185,6 +1207,11 @@ bool getopt_xccdf(int argc, char **argv, struct oscap_action *action)
 		case XCCDF_OPT_FIX_TYPE:
 			action->fix_type = optarg;
 			break;
+		case XCCDF_OPT_JOBS:
+			if (!getopt_jobs(action, optarg))
+				return false;
+			break;
+		case XCCDF_OPT_PROFILE_OUTPUT:	action->f_profile_output = optarg; break;
 		case 0: break;
 		default: return oscap_module_usage(action->module, stderr, NULL);
 		}